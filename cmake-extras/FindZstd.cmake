@@ -0,0 +1,42 @@
+# Locate zstd
+#
+# This module defines
+#  ZSTD_FOUND, if false, do not try to link to zstd
+#  ZSTD_LIBRARY, where to find zstd
+#  ZSTD_INCLUDE_DIR, where to find zstd.h
+#
+# If zstd is not installed in a standard path, you can use the ZSTD_DIR CMake variable
+# to tell CMake where zstd is.
+
+# find the zstd include directory
+find_path(ZSTD_INCLUDE_DIR zstd.h
+          PATH_SUFFIXES include
+          PATHS
+          ~/Library/Frameworks/zstd/include/
+          /Library/Frameworks/zstd/include/
+          /usr/local/include/
+          /usr/include/
+          /sw/zstd/         # Fink
+          /opt/local/zstd/  # DarwinPorts
+          /opt/csw/zstd/    # Blastwave
+          /opt/zstd/
+          ${ZSTD_DIR}/include/)
+
+# find the zstd library
+find_library(ZSTD_LIBRARY
+             NAMES zstd zstd_static
+             PATH_SUFFIXES lib64 lib
+             PATHS ~/Library/Frameworks
+                    /Library/Frameworks
+                    /usr/local
+                    /usr
+                    /sw
+                    /opt/local
+                    /opt/csw
+                    /opt
+                    ${ZSTD_DIR}/lib)
+
+# handle the QUIETLY and REQUIRED arguments and set ZSTD_FOUND to TRUE if all listed variables are TRUE
+include(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(ZSTD DEFAULT_MSG ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
+mark_as_advanced(ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
@@ -9,6 +9,7 @@
 #include <Audio/MusicComponent.hpp>
 
 #include <Core/ResourceManager.hpp>
+#include <Network/Archive.hpp>
 #include <Utils/Logger.hpp>
 
 #include <SFML/Audio/Listener.hpp>
@@ -53,7 +54,12 @@ void MusicComponent::onUpdate(double time_diff) {
 }
 
 void MusicComponent::onSerialize(IOPacket& packet) {
-    packet.stream(mMusicFileName, "music_file");
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void MusicComponent::streamFields(Archive& archive) {
+    archive.stream(mMusicFileName, "music_file");
 }
 
 void MusicComponent::setMusicFileName(const QString music_file_name) {
@@ -41,6 +41,14 @@ public:
     void onUpdate(double time_diff);
     void onSerialize(IOPacket& packet);
 
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
+
     /**
       * Sets the file to load music from.
       * @param music_file_name The file to load the music from.
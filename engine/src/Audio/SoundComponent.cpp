@@ -9,6 +9,7 @@
 #include <Audio/SoundComponent.hpp>
 
 #include <Core/ResourceManager.hpp>
+#include <Network/Archive.hpp>
 #include <Scene/Node.hpp>
 #include <Utils/Logger.hpp>
 
@@ -33,7 +34,12 @@ void SoundComponent::onUpdate(double time_diff) {
 }
 
 void SoundComponent::onSerialize(IOPacket& packet) {
-    packet.stream(mSoundFileName, "sound_file");
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void SoundComponent::streamFields(Archive& archive) {
+    archive.stream(mSoundFileName, "sound_file");
 }
 
 void SoundComponent::setSoundFileName(const QString sound_file_name) {
@@ -42,6 +42,14 @@ public:
     void onUpdate(double time_diff);
     void onSerialize(IOPacket& packet);
 
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
+
     /**
      * Plays the sound located in mSound.
      * @param sound_file The name of the sound file to play. To get sound in 3D, the format should be mono.
@@ -8,6 +8,7 @@
 
 #include <Graphics/BillboardSetComponent.hpp>
 
+#include <Network/Archive.hpp>
 #include <Scene/Node.hpp>
 #include <Scene/Scene.hpp>
 #include <Utils/Utils.hpp>
@@ -84,6 +85,16 @@ void BillboardSetComponent::onUpdate(double time_diff) {
     mSceneNode->setScale(getNode()->getScale(Node::SCENE));
 }
 
+void BillboardSetComponent::onSerialize(IOPacket& packet) {
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void BillboardSetComponent::streamFields(Archive& archive) {
+    archive.stream(mPoolSize, "pool_size", 20u);
+    archive.stream(mImageFile, "image_file");
+}
+
 Ogre::BillboardSet* BillboardSetComponent::getOgreBillboardSet() const {
     return mBillboardSet;
 }
@@ -28,7 +28,7 @@ namespace dt {
   * Component to add a billboard (sprite) to a node.
   */
 class DUCTTAPE_API BillboardSetComponent : public Component {
-//    Q_OBJECT
+    Q_OBJECT
 public:
     DT_SERIALIZABLE(BillboardSetComponent)
     /**
@@ -46,6 +46,15 @@ public:
     void onEnable();
     void onDisable();
     void onUpdate(double time_diff);
+    void onSerialize(IOPacket &packet);
+
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
 
     /**
       * Get the ogre BillboardSet.
@@ -8,6 +8,7 @@
 
 #include <Graphics/MeshComponent.hpp>
 
+#include <Network/Archive.hpp>
 #include <Scene/Node.hpp>
 #include <Scene/Scene.hpp>
 #include <Utils/Utils.hpp>
@@ -55,8 +56,13 @@ void MeshComponent::onUpdate(double time_diff) {
 }
 
 void MeshComponent::onSerialize(IOPacket& packet) {
-    packet.stream(mMeshHandle, "mesh");
-    packet.stream(mMaterialName, "material");
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void MeshComponent::streamFields(Archive& archive) {
+    archive.stream(mMeshHandle, "mesh");
+    archive.stream(mMaterialName, "material");
 }
 
 void MeshComponent::setMeshHandle(const QString mesh_handle) {
@@ -50,6 +50,14 @@ public:
     void onUpdate(double time_diff);
     void onSerialize(IOPacket &packet);
 
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
+
     /**
       * Sets the handle the mesh is being loaded from.
       * @param mesh_handle The handle of the mesh.
@@ -8,6 +8,7 @@
 
 #include <Graphics/ParticleSystemComponent.hpp>
 
+#include <Network/Archive.hpp>
 #include <Scene/Node.hpp>
 #include <Scene/Scene.hpp>
 #include <Utils/Utils.hpp>
@@ -129,4 +130,14 @@ void ParticleSystemComponent::onUpdate(double time_diff) {
     mSceneNode->setScale(mNode->getScale(Node::SCENE));
 }
 
+void ParticleSystemComponent::onSerialize(IOPacket& packet) {
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void ParticleSystemComponent::streamFields(Archive& archive) {
+    archive.stream(mParticleCountLimit, "particle_count_limit", 1000u);
+    archive.stream(mMaterialName, "material");
+}
+
 }
@@ -129,6 +129,15 @@ public:
     void onEnable();
     void onDisable();
     void onUpdate(double time_diff);
+    void onSerialize(IOPacket &packet);
+
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
 
 private:
     Ogre::SceneNode* mSceneNode;                //!< The Ogre::SceneNode this particle system is attached to.
@@ -9,6 +9,7 @@
 #include <Graphics/TextComponent.hpp>
 
 #include <Graphics/DisplayManager.hpp>
+#include <Network/Archive.hpp>
 #include <Scene/Node.hpp>
 #include <Utils/Utils.hpp>
 
@@ -130,6 +131,21 @@ void TextComponent::onUpdate(double time_diff) {
     mLabel->setDimensions(mTextWidth, mFontSize);
 }
 
+void TextComponent::onSerialize(IOPacket& packet) {
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void TextComponent::streamFields(Archive& archive) {
+    // the emitter would write an 8 bit integer as a character
+    uint32_t font_size = mFontSize;
+    archive.stream(mText, "text");
+    archive.stream(mFont, "font");
+    archive.stream(font_size, "font_size", 12u);
+    archive.stream(mBackgroundMaterial, "background_material");
+    mFontSize = font_size;
+}
+
 void TextComponent::setText(const QString text) {
         mText = text;
         if(mLabel != nullptr) {
@@ -32,13 +32,22 @@ public:
     /**
       * Advanced constructor.
       */
-    TextComponent(const QString text, const QString name = "");
+    TextComponent(const QString text = "", const QString name = "");
 
     void onInitialize();
     void onDeinitialize();
     void onEnable();
     void onDisable();
     void onUpdate(double time_diff);
+    void onSerialize(IOPacket &packet);
+
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
 
     /**
       * Gets the text displayed.
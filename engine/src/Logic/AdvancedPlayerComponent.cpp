@@ -18,8 +18,7 @@ namespace dt {
 
 AdvancedPlayerComponent::AdvancedPlayerComponent(const QString name)
     : Component(name),
-      mBtController(nullptr),
-      mBtGhostObject(nullptr),
+      mController(nullptr),
       mMouseEnabled(true),
       mMouseSensitivity(1.0),
       mMouseYInversed(false),
@@ -39,23 +38,7 @@ void AdvancedPlayerComponent::onInitialize() {
     start_trans.setOrigin(BtOgre::Convert::toBullet(getNode()->getPosition(Node::SCENE)));
     start_trans.setRotation(BtOgre::Convert::toBullet(getNode()->getRotation(Node::SCENE)));
 
-    btScalar character_height = 1.75;
-    btScalar character_width = 0.44;
-    btConvexShape* capsule = new btCapsuleShape(character_width, character_height);
-
-    mBtGhostObject = std::shared_ptr<btPairCachingGhostObject>(new btPairCachingGhostObject());
-    mBtGhostObject->setWorldTransform(start_trans);
-    mBtGhostObject->setCollisionShape(capsule);
-    mBtGhostObject->setCollisionFlags(btCollisionObject::CF_CHARACTER_OBJECT);
-    /////////////////////////////////////////////////////////////////////////////////////////////////
-    //TODO: Make a better way to distinguish between AdvancedPlayerComponent and PhysicsBodyComponent.
-    //For now, it's just a null pointer check to do this.
-    mBtGhostObject->setUserPointer(nullptr);
-    /////////////////////////////////////////////////////////////////////////////////////////////////
-    mBtController = std::shared_ptr<btKinematicCharacterController>
-        (new btKinematicCharacterController(mBtGhostObject.get(), capsule, 1));
-    getNode()->getScene()->getPhysicsWorld()->getBulletWorld()->addCollisionObject(mBtGhostObject.get());
-    getNode()->getScene()->getPhysicsWorld()->getBulletWorld()->addAction(mBtController.get());
+    mController = getNode()->getScene()->getPhysicsWorld()->getCharacterControllerPool()->create(start_trans);
 
     if(!QObject::connect(InputManager::get(), SIGNAL(sPressed(dt::InputManager::InputCode, const OIS::EventArg&)),
                          this,                SLOT(_handleButtonDown(dt::InputManager::InputCode, const OIS::EventArg&)))) {
@@ -77,6 +60,12 @@ void AdvancedPlayerComponent::onInitialize() {
 }
 
 void AdvancedPlayerComponent::onDeinitialize() {
+    // the character is already gone if the world was deinitialized first
+    auto world = getNode()->getScene()->getPhysicsWorld();
+    if(world != nullptr && world->getCharacterControllerPool() != nullptr)
+        world->getCharacterControllerPool()->destroy(mController);
+    mController = nullptr;
+
     if(!QObject::disconnect(this, SLOT(_handleButtonDown(dt::InputManager::InputCode, const OIS::EventArg&)))) {
             Logger::get().error("Cannot disconnect signal sPressed with " + getName()
                 + "'s input handling slot.");
@@ -103,39 +92,36 @@ void AdvancedPlayerComponent::onEnable() {
     transform.setOrigin(BtOgre::Convert::toBullet(getNode()->getPosition(Node::SCENE)));
     transform.setRotation(BtOgre::Convert::toBullet(getNode()->getRotation(Node::SCENE)));
 
-    mBtGhostObject->setWorldTransform(transform);
-    getNode()->getScene()->getPhysicsWorld()->getBulletWorld()->addCollisionObject(mBtGhostObject.get());
+    mController->setWorldTransform(transform);
+    mController->setEnabled(true);
 }
 
 void AdvancedPlayerComponent::onDisable() {
     setKeyboardEnabled(false);
     setMouseEnabled(false);
 
-    getNode()->getScene()->getPhysicsWorld()->getBulletWorld()->removeCollisionObject(mBtGhostObject.get());
+    mController->setEnabled(false);
 }
 
 void AdvancedPlayerComponent::onUpdate(double time_diff) {
-    static Ogre::Vector3 move;
-    static Ogre::Quaternion quaternion;
-    static btTransform trans;
-
-    quaternion = Ogre::Quaternion(Ogre::Radian(getNode()->getRotation().getYaw()), Ogre::Vector3(0.0, 1.0, 0.0));
-    move = quaternion * BtOgre::Convert::toOgre(mMove);
+    Ogre::Quaternion quaternion(Ogre::Radian(getNode()->getRotation().getYaw()), Ogre::Vector3(0.0, 1.0, 0.0));
+    Ogre::Vector3 move = quaternion * BtOgre::Convert::toOgre(mMove);
     move.normalise();
     move *= mMoveSpeed;
-    
-    mBtController->setVelocityForTimeInterval(BtOgre::Convert::toBullet(move), 0.5);
 
-    trans = mBtGhostObject->getWorldTransform();
+    // handed to Bullet by the pool together with all other characters
+    mController->setWalkVelocity(BtOgre::Convert::toBullet(move));
+
+    const btTransform& trans = mController->getWorldTransform();
 
     getNode()->setPosition(BtOgre::Convert::toOgre(trans.getOrigin()), Node::SCENE);
 
-    if(!move.isZeroLength() && mBtController->onGround() && !mIsMoving) {
+    if(!move.isZeroLength() && mController->onGround() && !mIsMoving) {
         //Emit sMove when the player starts to move when he's stopping or has done jumpping.
         emit sMove();
         mIsMoving = true;
     }
-    else if((move.isZeroLength() || !mBtController->onGround()) && mIsMoving) {
+    else if((move.isZeroLength() || !mController->onGround()) && mIsMoving) {
         //Emit sStop when the player starts to stop or jump while he's moving.
         emit sStop();
         mIsMoving = false;
@@ -225,8 +211,8 @@ void AdvancedPlayerComponent::_handleButtonDown(dt::InputManager::InputCode inpu
             mMove.setX(mMove.getX() + 1.0f);
         }
 
-        if(mJumpEnabled && input_code == InputManager::KC_SPACE && mBtController->onGround()) {
-            mBtController->jump();
+        if(mJumpEnabled && input_code == InputManager::KC_SPACE && mController->onGround()) {
+            mController->jump();
 
             emit sStop();
             emit sJump();
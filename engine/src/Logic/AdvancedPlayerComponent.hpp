@@ -13,13 +13,10 @@
 
 #include <Scene/Component.hpp>
 #include <Input/InputManager.hpp>
+#include <Physics/CharacterController.hpp>
 
-#include <BulletCollision/CollisionShapes/btConvexHullShape.h>
 #include <btBulletDynamicsCommon.h>
 #include <btBulletCollisionCommon.h>
-#include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
-#include <BulletCollision/CollisionDispatch/btGhostObject.h>
-#include <BulletDynamics/Character/btKinematicCharacterController.h>
 
 #define OIS_DYNAMIC_LIB
 #include <OIS.h>
@@ -182,8 +179,7 @@ signals:
     void sJump();
 
 private:
-    std::shared_ptr<btKinematicCharacterController> mBtController;       //!< The bullet's built-in character controller.
-    std::shared_ptr<btPairCachingGhostObject> mBtGhostObject;            //!< The bullet's ghost object.;
+    CharacterController* mController;   //!< The character controller, owned by the physics world's pool.
     bool mMouseEnabled;         //!< Whether the Mouse is enabled for looking around or not.
     float mMouseSensitivity;    //!< The sensitivity of the mouse. Default: 1.0.
     bool mMouseYInversed;       //!< True if the mouse's y-axis should be inversed.
@@ -8,6 +8,7 @@
 
 #include <Logic/CollisionComponent.hpp>
 #include <Graphics/MeshComponent.hpp>
+#include <Network/Archive.hpp>
 #include <Scene/Node.hpp>
 #include <Scene/Scene.hpp>
 #include <Utils/Utils.hpp>
@@ -41,6 +42,16 @@ void CollisionComponent::onCheck(const Ogre::Vector3& start, const Ogre::Vector3
     bullet_body->applyCentralImpulse(BtOgre::Convert::toBullet(impulse) * mRange);
 }
 
+void CollisionComponent::onSerialize(IOPacket& packet) {
+    InteractionComponent::onSerialize(packet);
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void CollisionComponent::streamFields(Archive& archive) {
+    archive.stream(mBulletMeshHandle, "bullet_mesh");
+}
+
 void CollisionComponent::onHit(PhysicsBodyComponent* hit, PhysicsBodyComponent* bullet) {
     Node* node = bullet->getNode();
     node->kill();
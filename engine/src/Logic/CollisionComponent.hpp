@@ -34,7 +34,7 @@ public:
       * @param name The name of the Component.
       * @see Component
       */
-    CollisionComponent(const QString bullet_handle, const QString name = "");
+    CollisionComponent(const QString bullet_handle = "", const QString name = "");
 
     /**
       * Sets the handle of the bullet's mesh.
@@ -49,6 +49,15 @@ public:
     const QString getBulletMeshHandle();
 
     void onInitialize();
+    void onSerialize(IOPacket &packet);
+
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
 
 protected:
     /*
@@ -8,6 +8,7 @@
 
 #include <Logic/FollowPathComponent.hpp>
 
+#include <Network/Archive.hpp>
 #include <Scene/Node.hpp>
 #include <Utils/Math.hpp>
 
@@ -61,6 +62,28 @@ void FollowPathComponent::onUpdate(double time_diff) {
     }
 }
 
+void FollowPathComponent::onSerialize(IOPacket& packet) {
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void FollowPathComponent::streamFields(Archive& archive) {
+    archive.stream(EnumHelper(&mMode), "mode", SINGLE);
+    archive.stream(mTotalDuration, "duration", 0.0f);
+    archive.stream(mSmoothCorners, "smooth_corners", false);
+    archive.stream(mSmoothAcceleration, "smooth_acceleration", false);
+    archive.stream(mFollowRotation, "follow_rotation", false);
+
+    uint32_t count = archive.beginList(mPoints.size(), "points");
+    mPoints.resize(count);
+    for(uint32_t i = 0; i < count; ++i) {
+        archive.beginObject();
+        archive.stream(mPoints[i], "point");
+        archive.endObject();
+    }
+    archive.endList();
+}
+
 void FollowPathComponent::addPoint(Ogre::Vector3 point) {
     mPoints.push_back(point);
     if(mPoints.size() == 1) {
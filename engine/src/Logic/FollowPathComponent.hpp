@@ -51,6 +51,15 @@ public:
     void onInitialize();
     void onDeinitialize();
     void onUpdate(double time_diff);
+    void onSerialize(IOPacket &packet);
+
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
 
     /**
       * Adds a point to the end of the path.
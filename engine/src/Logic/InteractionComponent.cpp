@@ -8,6 +8,8 @@
 
 #include <Logic/InteractionComponent.hpp>
 
+#include <Network/Archive.hpp>
+
 #include <BtOgreGP.h>
 
 namespace dt {
@@ -74,4 +76,15 @@ namespace dt {
     bool InteractionComponent::isReady() const {
         return mRemainTime <= 0.0f;
     }
+
+    void InteractionComponent::onSerialize(IOPacket& packet) {
+        packet.dispatch(*this);
+    }
+
+    template <typename Archive>
+    void InteractionComponent::streamFields(Archive& archive) {
+        archive.stream(mRange, "range", 0.0f);
+        archive.stream(mOffset, "offset", 0.0f);
+        archive.stream(mInterval, "interval", 1.0f);
+    }
 }
@@ -88,6 +88,15 @@ public:
     void setRemainTime(float remain_time);
 
     void onUpdate(double time_diff);
+    void onSerialize(IOPacket &packet);
+
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
 
     /**
       * Gets whether it's ready to perform the next interaction.
@@ -8,6 +8,7 @@
 
 #include <Logic/ScriptComponent.hpp>
 #include <Logic/ScriptManager.hpp>
+#include <Network/Archive.hpp>
 #include <Utils/Logger.hpp>
 #include <Utils/Utils.hpp>
 
@@ -17,15 +18,14 @@ ScriptComponent::ScriptComponent(const QString script_name, const QString name,
     : Component(name),
       mScriptName(script_name),
       mValid(true),
-      mIsUpdateEnabled(is_update_enabled) {
-    if(!ScriptManager::get()->hasScript(mScriptName)) {
-        Logger::get().error("Cannot create ScriptComponent for script \"" + mScriptName + "\": script not loaded.");
-        mValid = false;
-    }
-}
+      mIsUpdateEnabled(is_update_enabled) {}
 
 void ScriptComponent::onInitialize() {
-    if(mValid) {
+    // checked here, the script name is only known after deserialization
+    mValid = ScriptManager::get()->hasScript(mScriptName);
+    if(!mValid) {
+        Logger::get().error("Cannot create ScriptComponent for script \"" + mScriptName + "\": script not loaded.");
+    } else {
         // create our QScriptValue, that represents the script object
         mScriptObject = ScriptManager::get()->getScriptObject(mScriptName, this);
 
@@ -49,6 +49,16 @@ void ScriptComponent::onUpdate(double time_diff) {
     }
 }
 
+void ScriptComponent::onSerialize(IOPacket& packet) {
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void ScriptComponent::streamFields(Archive& archive) {
+    archive.stream(mScriptName, "script");
+    archive.stream(mIsUpdateEnabled, "update_enabled", false);
+}
+
 QScriptValue ScriptComponent::_callScriptFunction(QString name, QScriptValueList params) {
     if(!mValid) {
         return QScriptValue::UndefinedValue;
@@ -33,13 +33,22 @@ public:
       * @param is_update_enabled Whether update call of the script is enabled or not.
       * @see Component
       */
-    ScriptComponent(const QString script_name, const QString name = "", bool is_update_enabled = false);
+    ScriptComponent(const QString script_name = "", const QString name = "", bool is_update_enabled = false);
 
     void onInitialize();
     void onDeinitialize();
     void onEnable();
     void onDisable();
     void onUpdate(double time_diff);
+    void onSerialize(IOPacket &packet);
+
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
 
     /**
       * Gets if update call of the script is enabled or not.
@@ -0,0 +1,529 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_ARCHIVE
+#define DUCTTAPE_ENGINE_NETWORK_ARCHIVE
+
+#include <Config.hpp>
+
+#include <Network/BitStream.hpp>
+#include <Network/IOPacket.hpp>
+#include <Utils/EnumHelper.hpp>
+#include <Utils/Utils.hpp>
+
+#include <QByteArray>
+
+#include <string>
+#include <vector>
+
+namespace dt {
+
+/**
+  * An IOPacket with its mode and direction fixed at compile time. Archives have the same streaming methods
+  * as the IOPacket, without virtual calls or checks of the mode, so a method templated on the archive is
+  * compiled into straight-line code for each of them. They work on the state of the IOPacket they are
+  * created from, so they can be mixed with calls to the IOPacket itself, e.g. for nested objects.
+  * The output is the same as that of the IOPacket.
+  * @code
+  * void MyComponent::onSerialize(IOPacket& packet) {
+  *     packet.dispatch(*this);
+  * }
+  *
+  * template <typename Archive>
+  * void MyComponent::streamFields(Archive& archive) {
+  *     archive.stream(mSpeed, "speed", 1.f);
+  *     archive.stream(mTarget, "target");
+  * }
+  * @endcode
+  * @see IOPacket::dispatch
+  */
+template <IOPacket::Mode M, IOPacket::Direction D>
+class Archive;
+
+typedef Archive<IOPacket::BINARY, IOPacket::SERIALIZE> BinaryWriter;
+typedef Archive<IOPacket::BINARY, IOPacket::DESERIALIZE> BinaryReader;
+typedef Archive<IOPacket::TEXT, IOPacket::SERIALIZE> YamlWriter;
+typedef Archive<IOPacket::TEXT, IOPacket::DESERIALIZE> YamlReader;
+typedef Archive<IOPacket::BITS, IOPacket::SERIALIZE> BitWriter;
+typedef Archive<IOPacket::BITS, IOPacket::DESERIALIZE> BitReader;
+
+/**
+  * Writes into an sf::Packet.
+  */
+template <>
+class Archive<IOPacket::BINARY, IOPacket::SERIALIZE> {
+public:
+    Archive(IOPacket& packet)
+        : mIOPacket(packet),
+          mPacket(*packet.mPacket) {}
+
+    IOPacket& getIOPacket() {
+        return mIOPacket;
+    }
+
+    IOPacket::Direction getDirection() const {
+        return IOPacket::SERIALIZE;
+    }
+
+    template <typename T>
+    Archive& stream(T& t, const char* key, T def = T()) {
+        mPacket << t;
+        return *this;
+    }
+
+    Archive& stream(EnumHelper h, const char* key, uint32_t def = 0) {
+        mPacket << h.get();
+        return *this;
+    }
+
+    Archive& stream(QString& s, const char* key, QString def = "") {
+        mPacket << Utils::toStdString(s);
+        return *this;
+    }
+
+    Archive& stream(QUuid& id, const char* key, QUuid def = QUuid()) {
+        mPacket << Utils::toStdString(id.toString());
+        return *this;
+    }
+
+    Archive& stream(std::vector<char>& data, const char* key) {
+        mPacket << static_cast<uint32_t>(data.size());
+        if(data.size() > 0)
+            mPacket.append(&data[0], data.size());
+        return *this;
+    }
+
+    Archive& streamRanged(int32_t& value, int32_t min, int32_t max, const char* key, int32_t def = 0) {
+        return stream(value, key, def);
+    }
+
+    Archive& streamQuantized(float& value, float min, float max, uint32_t bits, const char* key, float def = 0.f) {
+        return stream(value, key, def);
+    }
+
+    uint32_t beginList(uint32_t count, const char* key) {
+        mPacket << count;
+        return count;
+    }
+
+    void endList() {}
+
+    void beginObject() {}
+
+    void endObject() {}
+
+private:
+    IOPacket& mIOPacket;    //!< The IOPacket the archive was created from.
+    sf::Packet& mPacket;    //!< The packet to write into.
+};
+
+/**
+  * Reads from an sf::Packet.
+  */
+template <>
+class Archive<IOPacket::BINARY, IOPacket::DESERIALIZE> {
+public:
+    Archive(IOPacket& packet)
+        : mIOPacket(packet),
+          mPacket(*packet.mPacket) {}
+
+    IOPacket& getIOPacket() {
+        return mIOPacket;
+    }
+
+    IOPacket::Direction getDirection() const {
+        return IOPacket::DESERIALIZE;
+    }
+
+    template <typename T>
+    Archive& stream(T& t, const char* key, T def = T()) {
+        mPacket >> t;
+        return *this;
+    }
+
+    Archive& stream(EnumHelper h, const char* key, uint32_t def = 0) {
+        uint32_t x = 0;
+        mPacket >> x;
+        h.set(x);
+        return *this;
+    }
+
+    Archive& stream(QString& s, const char* key, QString def = "") {
+        std::string stdstr;
+        mPacket >> stdstr;
+        s = QString(stdstr.c_str());
+        return *this;
+    }
+
+    Archive& stream(QUuid& id, const char* key, QUuid def = QUuid()) {
+        std::string stdstr;
+        mPacket >> stdstr;
+        if(stdstr == "") id = def;
+        else id = QUuid(QString::fromStdString(stdstr));
+        return *this;
+    }
+
+    Archive& stream(std::vector<char>& data, const char* key) {
+        uint32_t size = 0;
+        mPacket >> size;
+        data.resize(size);
+        for(uint32_t i = 0; i < size; ++i) {
+            int8_t byte = 0;
+            mPacket >> byte;
+            data[i] = static_cast<char>(byte);
+        }
+        return *this;
+    }
+
+    Archive& streamRanged(int32_t& value, int32_t min, int32_t max, const char* key, int32_t def = 0) {
+        return stream(value, key, def);
+    }
+
+    Archive& streamQuantized(float& value, float min, float max, uint32_t bits, const char* key, float def = 0.f) {
+        return stream(value, key, def);
+    }
+
+    uint32_t beginList(uint32_t count, const char* key) {
+        mPacket >> count;
+        return count;
+    }
+
+    void endList() {}
+
+    void beginObject() {}
+
+    void endObject() {}
+
+private:
+    IOPacket& mIOPacket;    //!< The IOPacket the archive was created from.
+    sf::Packet& mPacket;    //!< The packet to read from.
+};
+
+/**
+  * Writes into a YAML::Emitter.
+  */
+template <>
+class Archive<IOPacket::TEXT, IOPacket::SERIALIZE> {
+public:
+    Archive(IOPacket& packet)
+        : mIOPacket(packet),
+          mEmitter(*packet.mEmitter) {}
+
+    IOPacket& getIOPacket() {
+        return mIOPacket;
+    }
+
+    IOPacket::Direction getDirection() const {
+        return IOPacket::SERIALIZE;
+    }
+
+    template <typename T>
+    Archive& stream(T& t, const char* key, T def = T()) {
+        mEmitter << YAML::Key << key << YAML::Value << YAML::DoubleQuoted << t << YAML::Auto;
+        return *this;
+    }
+
+    Archive& stream(EnumHelper h, const char* key, uint32_t def = 0) {
+        uint32_t x = h.get();
+        return stream(x, key);
+    }
+
+    Archive& stream(QString& s, const char* key, QString def = "") {
+        std::string stdstr = Utils::toStdString(s);
+        return stream(stdstr, key);
+    }
+
+    Archive& stream(QUuid& id, const char* key, QUuid def = QUuid()) {
+        std::string stdstr = Utils::toStdString(id.toString());
+        return stream(stdstr, key);
+    }
+
+    Archive& stream(std::vector<char>& data, const char* key) {
+        std::string hex;
+        if(data.size() > 0)
+            hex = QByteArray(&data[0], data.size()).toHex().constData();
+        return stream(hex, key);
+    }
+
+    Archive& streamRanged(int32_t& value, int32_t min, int32_t max, const char* key, int32_t def = 0) {
+        return stream(value, key, def);
+    }
+
+    Archive& streamQuantized(float& value, float min, float max, uint32_t bits, const char* key, float def = 0.f) {
+        return stream(value, key, def);
+    }
+
+    uint32_t beginList(uint32_t count, const char* key) {
+        return mIOPacket.beginList(count, key);
+    }
+
+    void endList() {
+        mIOPacket.endList();
+    }
+
+    void beginObject() {
+        mEmitter << YAML::BeginMap;
+    }
+
+    void endObject() {
+        mEmitter << YAML::EndMap;
+    }
+
+private:
+    IOPacket& mIOPacket;        //!< The IOPacket the archive was created from.
+    YAML::Emitter& mEmitter;    //!< The emitter to write into.
+};
+
+/**
+  * Reads from a YAML::Node or a YamlDocument.
+  */
+template <>
+class Archive<IOPacket::TEXT, IOPacket::DESERIALIZE> {
+public:
+    Archive(IOPacket& packet)
+        : mIOPacket(packet) {}
+
+    IOPacket& getIOPacket() {
+        return mIOPacket;
+    }
+
+    IOPacket::Direction getDirection() const {
+        return IOPacket::DESERIALIZE;
+    }
+
+    template <typename T>
+    Archive& stream(T& t, const char* key, T def = T()) {
+        if(mIOPacket.mDocument != nullptr) {
+            if(!mIOPacket.mDocument->read(mIOPacket._findEntry(key), t))
+                t = def;
+        } else {
+            const YAML::Node* node = mIOPacket.mNode->FindValue(key);
+            if(node == nullptr)
+                t = def;
+            else
+                *node >> t;
+        }
+        return *this;
+    }
+
+    Archive& stream(EnumHelper h, const char* key, uint32_t def = 0) {
+        uint32_t x = 0;
+        stream(x, key, def);
+        h.set(x);
+        return *this;
+    }
+
+    Archive& stream(QString& s, const char* key, QString def = "") {
+        std::string stdstr;
+        stream(stdstr, key, def.toStdString());
+        s = QString(stdstr.c_str());
+        return *this;
+    }
+
+    Archive& stream(QUuid& id, const char* key, QUuid def = QUuid()) {
+        std::string stdstr;
+        stream(stdstr, key);
+        if(stdstr == "") id = def;
+        else id = QUuid(QString::fromStdString(stdstr));
+        return *this;
+    }
+
+    Archive& stream(std::vector<char>& data, const char* key) {
+        std::string hex;
+        stream(hex, key);
+        QByteArray bytes = QByteArray::fromHex(QByteArray(hex.c_str()));
+        data.assign(bytes.constData(), bytes.constData() + bytes.size());
+        return *this;
+    }
+
+    Archive& streamRanged(int32_t& value, int32_t min, int32_t max, const char* key, int32_t def = 0) {
+        return stream(value, key, def);
+    }
+
+    Archive& streamQuantized(float& value, float min, float max, uint32_t bits, const char* key, float def = 0.f) {
+        return stream(value, key, def);
+    }
+
+    uint32_t beginList(uint32_t count, const char* key) {
+        return mIOPacket.beginList(count, key);
+    }
+
+    void endList() {
+        mIOPacket.endList();
+    }
+
+    void beginObject() {
+        mIOPacket.beginObject();
+    }
+
+    void endObject() {
+        mIOPacket.endObject();
+    }
+
+private:
+    IOPacket& mIOPacket;    //!< The IOPacket the archive was created from.
+};
+
+/**
+  * Writes into a BitStream.
+  */
+template <>
+class Archive<IOPacket::BITS, IOPacket::SERIALIZE> {
+public:
+    Archive(IOPacket& packet)
+        : mIOPacket(packet),
+          mStream(*packet.mBitStream) {}
+
+    IOPacket& getIOPacket() {
+        return mIOPacket;
+    }
+
+    IOPacket::Direction getDirection() const {
+        return IOPacket::SERIALIZE;
+    }
+
+    template <typename T>
+    Archive& stream(T& t, const char* key, T def = T()) {
+        mStream.stream(t);
+        return *this;
+    }
+
+    Archive& stream(EnumHelper h, const char* key, uint32_t def = 0) {
+        mStream.writeVarint(h.get());
+        return *this;
+    }
+
+    Archive& stream(std::vector<char>& data, const char* key) {
+        mStream.writeVarint(data.size());
+        if(data.size() > 0)
+            mStream.writeBytes(&data[0], data.size());
+        return *this;
+    }
+
+    Archive& streamRanged(int32_t& value, int32_t min, int32_t max, const char* key, int32_t def = 0) {
+        mStream.writeRanged(value, min, max);
+        return *this;
+    }
+
+    Archive& streamQuantized(float& value, float min, float max, uint32_t bits, const char* key, float def = 0.f) {
+        mStream.writeQuantized(value, min, max, bits);
+        return *this;
+    }
+
+    uint32_t beginList(uint32_t count, const char* key) {
+        mStream.writeVarint(count);
+        return count;
+    }
+
+    void endList() {}
+
+    void beginObject() {}
+
+    void endObject() {}
+
+private:
+    IOPacket& mIOPacket;    //!< The IOPacket the archive was created from.
+    BitStream& mStream;     //!< The stream to write into.
+};
+
+/**
+  * Reads from a BitStream.
+  */
+template <>
+class Archive<IOPacket::BITS, IOPacket::DESERIALIZE> {
+public:
+    Archive(IOPacket& packet)
+        : mIOPacket(packet),
+          mStream(*packet.mBitStream) {}
+
+    IOPacket& getIOPacket() {
+        return mIOPacket;
+    }
+
+    IOPacket::Direction getDirection() const {
+        return IOPacket::DESERIALIZE;
+    }
+
+    template <typename T>
+    Archive& stream(T& t, const char* key, T def = T()) {
+        mStream.stream(t);
+        return *this;
+    }
+
+    Archive& stream(EnumHelper h, const char* key, uint32_t def = 0) {
+        h.set(static_cast<uint32_t>(mStream.readVarint()));
+        return *this;
+    }
+
+    Archive& stream(std::vector<char>& data, const char* key) {
+        uint32_t size = static_cast<uint32_t>(mStream.readVarint());
+        const char* bytes = mStream.skipBytes(size);
+        if(bytes == nullptr)
+            data.clear();
+        else
+            data.assign(bytes, bytes + size);
+        return *this;
+    }
+
+    Archive& streamRanged(int32_t& value, int32_t min, int32_t max, const char* key, int32_t def = 0) {
+        value = mStream.readRanged(min, max);
+        return *this;
+    }
+
+    Archive& streamQuantized(float& value, float min, float max, uint32_t bits, const char* key, float def = 0.f) {
+        value = mStream.readQuantized(min, max, bits);
+        return *this;
+    }
+
+    uint32_t beginList(uint32_t count, const char* key) {
+        return static_cast<uint32_t>(mStream.readVarint());
+    }
+
+    void endList() {}
+
+    void beginObject() {}
+
+    void endObject() {}
+
+private:
+    IOPacket& mIOPacket;    //!< The IOPacket the archive was created from.
+    BitStream& mStream;     //!< The stream to read from.
+};
+
+template <typename T>
+void IOPacket::dispatch(T& object) {
+    if(mMode == BINARY) {
+        if(mDirection == SERIALIZE) {
+            BinaryWriter archive(*this);
+            object.streamFields(archive);
+        } else {
+            BinaryReader archive(*this);
+            object.streamFields(archive);
+        }
+    } else if(mMode == TEXT) {
+        if(mDirection == SERIALIZE) {
+            YamlWriter archive(*this);
+            object.streamFields(archive);
+        } else {
+            YamlReader archive(*this);
+            object.streamFields(archive);
+        }
+    } else {
+        if(mDirection == SERIALIZE) {
+            BitWriter archive(*this);
+            object.streamFields(archive);
+        } else {
+            BitReader archive(*this);
+            object.streamFields(archive);
+        }
+    }
+}
+
+}
+
+#endif
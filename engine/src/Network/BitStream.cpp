@@ -0,0 +1,411 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/BitStream.hpp>
+
+#include <Network/Quantization.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace dt {
+
+/**
+  * The maximum number of bytes of a varint holding 64 bits.
+  */
+static const uint32_t MAX_VARINT_BYTES = 10;
+
+/**
+  * Returns the number of bits needed to store all values up to a maximum.
+  * @param max The maximum.
+  * @returns The number of bits.
+  */
+static uint32_t bitsForRange(uint32_t max) {
+    uint32_t bits = 0;
+    while(bits < 32 && (max >> bits) != 0)
+        ++bits;
+    return bits;
+}
+
+/**
+  * Returns the code point of the character at a position of a string, combining surrogate pairs.
+  * @param s The string.
+  * @param i The position. It is moved to the last QChar of the character.
+  * @returns The code point.
+  */
+static uint32_t codePointAt(const QString& s, int& i) {
+    uint32_t c = s.at(i).unicode();
+    if(c >= 0xd800 && c < 0xdc00 && i + 1 < s.size()) {
+        uint32_t low = s.at(i + 1).unicode();
+        if(low >= 0xdc00 && low < 0xe000) {
+            ++i;
+            return 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+        }
+    }
+    return c;
+}
+
+/**
+  * Returns the number of bytes of a code point in UTF-8.
+  * @param c The code point.
+  * @returns The number of bytes.
+  */
+static uint32_t utf8Length(uint32_t c) {
+    return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
+
+BitStream::BitStream(char* buffer, uint32_t size, Access access)
+    : mBuffer(access == WRITE ? buffer : nullptr),
+      mData(buffer),
+      mCapacity(size * 8),
+      mPosition(0),
+      mIsOverflowed(false) {}
+
+BitStream::BitStream(const char* data, uint32_t size)
+    : mBuffer(nullptr),
+      mData(data),
+      mCapacity(size * 8),
+      mPosition(0),
+      mIsOverflowed(false) {}
+
+bool BitStream::isWriting() const {
+    return mBuffer != nullptr;
+}
+
+bool BitStream::isOverflowed() const {
+    return mIsOverflowed;
+}
+
+uint32_t BitStream::getSize() const {
+    return (mPosition + 7) / 8;
+}
+
+uint32_t BitStream::getBitPosition() const {
+    return mPosition;
+}
+
+bool BitStream::isAtEnd() const {
+    return mPosition + 8 > mCapacity;
+}
+
+void BitStream::align() {
+    // the rest of a byte is zero already, as bytes are cleared when they are first written to
+    mPosition = std::min((mPosition + 7) & ~7u, mCapacity);
+}
+
+void BitStream::writeBits(uint32_t value, uint32_t bits) {
+    if(!_reserve(bits))
+        return;
+
+    while(bits > 0) {
+        uint32_t offset = mPosition & 7;
+        uint32_t count = std::min(8 - offset, bits);
+        unsigned char& byte = reinterpret_cast<unsigned char&>(mBuffer[mPosition >> 3]);
+        if(offset == 0)
+            byte = 0;
+        byte |= static_cast<unsigned char>((value & ((1u << count) - 1)) << offset);
+
+        value >>= count;
+        bits -= count;
+        mPosition += count;
+    }
+}
+
+uint32_t BitStream::readBits(uint32_t bits) {
+    if(!_reserve(bits))
+        return 0;
+
+    uint32_t value = 0;
+    uint32_t shift = 0;
+    while(bits > 0) {
+        uint32_t offset = mPosition & 7;
+        uint32_t count = std::min(8 - offset, bits);
+        uint32_t byte = static_cast<unsigned char>(mData[mPosition >> 3]);
+        value |= ((byte >> offset) & ((1u << count) - 1)) << shift;
+
+        shift += count;
+        bits -= count;
+        mPosition += count;
+    }
+    return value;
+}
+
+void BitStream::writeVarint(uint64_t value) {
+    while(value >= 0x80) {
+        writeBits(static_cast<uint32_t>(value & 0x7f) | 0x80, 8);
+        value >>= 7;
+    }
+    writeBits(static_cast<uint32_t>(value), 8);
+}
+
+uint64_t BitStream::readVarint() {
+    uint64_t value = 0;
+    for(uint32_t i = 0; i < MAX_VARINT_BYTES; ++i) {
+        uint32_t byte = readBits(8);
+        value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+        if((byte & 0x80) == 0)
+            break;
+    }
+    return value;
+}
+
+void BitStream::writeSignedVarint(int64_t value) {
+    writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+int64_t BitStream::readSignedVarint() {
+    uint64_t value = readVarint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void BitStream::writeRanged(int32_t value, int32_t min, int32_t max) {
+    value = std::max(min, std::min(max, value));
+    uint32_t range = static_cast<uint32_t>(static_cast<int64_t>(max) - min);
+    writeBits(static_cast<uint32_t>(static_cast<int64_t>(value) - min), bitsForRange(range));
+}
+
+int32_t BitStream::readRanged(int32_t min, int32_t max) {
+    uint32_t range = static_cast<uint32_t>(static_cast<int64_t>(max) - min);
+    uint32_t value = std::min(readBits(bitsForRange(range)), range);
+    return static_cast<int32_t>(min + static_cast<int64_t>(value));
+}
+
+void BitStream::writeQuantized(float value, float min, float max, uint32_t bits) {
+    writeBits(Quantization::quantizeFloat(value, min, max, bits), bits);
+}
+
+float BitStream::readQuantized(float min, float max, uint32_t bits) {
+    return Quantization::dequantizeFloat(readBits(bits), min, max, bits);
+}
+
+void BitStream::writeBytes(const char* data, uint32_t size) {
+    align();
+    if(!_reserve(static_cast<uint64_t>(size) * 8))
+        return;
+
+    if(size > 0)
+        std::memcpy(mBuffer + (mPosition >> 3), data, size);
+    mPosition += size * 8;
+}
+
+void BitStream::readBytes(char* data, uint32_t size) {
+    const char* bytes = skipBytes(size);
+    if(bytes == nullptr)
+        std::memset(data, 0, size);
+    else if(size > 0)
+        std::memcpy(data, bytes, size);
+}
+
+const char* BitStream::skipBytes(uint32_t size) {
+    align();
+    if(!_reserve(static_cast<uint64_t>(size) * 8))
+        return nullptr;
+
+    const char* bytes = mData + (mPosition >> 3);
+    mPosition += size * 8;
+    return bytes;
+}
+
+void BitStream::writeUuid(const QUuid& id) {
+    writeBits(id.data1, 32);
+    writeBits(id.data2, 16);
+    writeBits(id.data3, 16);
+    for(uint32_t i = 0; i < 8; ++i)
+        writeBits(id.data4[i], 8);
+}
+
+QUuid BitStream::readUuid() {
+    QUuid id;
+    id.data1 = readBits(32);
+    id.data2 = static_cast<ushort>(readBits(16));
+    id.data3 = static_cast<ushort>(readBits(16));
+    for(uint32_t i = 0; i < 8; ++i)
+        id.data4[i] = static_cast<uchar>(readBits(8));
+    return id;
+}
+
+void BitStream::writeString(const QString& s) {
+    uint32_t size = 0;
+    for(int i = 0; i < s.size(); ++i)
+        size += utf8Length(codePointAt(s, i));
+
+    writeVarint(size);
+    align();
+    if(!_reserve(static_cast<uint64_t>(size) * 8))
+        return;
+
+    unsigned char* out = reinterpret_cast<unsigned char*>(mBuffer + (mPosition >> 3));
+    for(int i = 0; i < s.size(); ++i) {
+        uint32_t c = codePointAt(s, i);
+        if(c < 0x80) {
+            *out++ = static_cast<unsigned char>(c);
+        } else if(c < 0x800) {
+            *out++ = static_cast<unsigned char>(0xc0 | (c >> 6));
+            *out++ = static_cast<unsigned char>(0x80 | (c & 0x3f));
+        } else if(c < 0x10000) {
+            *out++ = static_cast<unsigned char>(0xe0 | (c >> 12));
+            *out++ = static_cast<unsigned char>(0x80 | ((c >> 6) & 0x3f));
+            *out++ = static_cast<unsigned char>(0x80 | (c & 0x3f));
+        } else {
+            *out++ = static_cast<unsigned char>(0xf0 | (c >> 18));
+            *out++ = static_cast<unsigned char>(0x80 | ((c >> 12) & 0x3f));
+            *out++ = static_cast<unsigned char>(0x80 | ((c >> 6) & 0x3f));
+            *out++ = static_cast<unsigned char>(0x80 | (c & 0x3f));
+        }
+    }
+    mPosition += size * 8;
+}
+
+QString BitStream::readString() {
+    uint32_t size = static_cast<uint32_t>(std::min<uint64_t>(readVarint(), mCapacity / 8));
+    const char* bytes = skipBytes(size);
+    if(bytes == nullptr || size == 0)
+        return QString();
+    return QString::fromUtf8(bytes, size);
+}
+
+void BitStream::stream(bool& value) {
+    if(isWriting())
+        writeBits(value ? 1 : 0, 1);
+    else
+        value = (readBits(1) != 0);
+}
+
+void BitStream::stream(int8_t& value) {
+    if(isWriting())
+        writeBits(static_cast<uint8_t>(value), 8);
+    else
+        value = static_cast<int8_t>(readBits(8));
+}
+
+void BitStream::stream(uint8_t& value) {
+    if(isWriting())
+        writeBits(value, 8);
+    else
+        value = static_cast<uint8_t>(readBits(8));
+}
+
+void BitStream::stream(int16_t& value) {
+    if(isWriting())
+        writeSignedVarint(value);
+    else
+        value = static_cast<int16_t>(readSignedVarint());
+}
+
+void BitStream::stream(uint16_t& value) {
+    if(isWriting())
+        writeVarint(value);
+    else
+        value = static_cast<uint16_t>(readVarint());
+}
+
+void BitStream::stream(int32_t& value) {
+    if(isWriting())
+        writeSignedVarint(value);
+    else
+        value = static_cast<int32_t>(readSignedVarint());
+}
+
+void BitStream::stream(uint32_t& value) {
+    if(isWriting())
+        writeVarint(value);
+    else
+        value = static_cast<uint32_t>(readVarint());
+}
+
+void BitStream::stream(int64_t& value) {
+    if(isWriting())
+        writeSignedVarint(value);
+    else
+        value = readSignedVarint();
+}
+
+void BitStream::stream(uint64_t& value) {
+    if(isWriting())
+        writeVarint(value);
+    else
+        value = readVarint();
+}
+
+void BitStream::stream(float& value) {
+    uint32_t bits = 0;
+    if(isWriting()) {
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeBits(bits, 32);
+    } else {
+        bits = readBits(32);
+        std::memcpy(&value, &bits, sizeof(bits));
+    }
+}
+
+void BitStream::stream(double& value) {
+    uint64_t bits = 0;
+    if(isWriting()) {
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeBits(static_cast<uint32_t>(bits), 32);
+        writeBits(static_cast<uint32_t>(bits >> 32), 32);
+    } else {
+        bits = readBits(32);
+        bits |= static_cast<uint64_t>(readBits(32)) << 32;
+        std::memcpy(&value, &bits, sizeof(bits));
+    }
+}
+
+void BitStream::stream(std::string& value) {
+    if(isWriting()) {
+        writeVarint(value.size());
+        writeBytes(value.data(), value.size());
+    } else {
+        uint32_t size = static_cast<uint32_t>(std::min<uint64_t>(readVarint(), mCapacity / 8));
+        const char* bytes = skipBytes(size);
+        if(bytes == nullptr)
+            value.clear();
+        else
+            value.assign(bytes, size);
+    }
+}
+
+void BitStream::stream(QString& value) {
+    if(isWriting())
+        writeString(value);
+    else
+        value = readString();
+}
+
+void BitStream::stream(QUuid& value) {
+    if(isWriting())
+        writeUuid(value);
+    else
+        value = readUuid();
+}
+
+void BitStream::stream(Ogre::Vector3& value) {
+    stream(value.x);
+    stream(value.y);
+    stream(value.z);
+}
+
+void BitStream::stream(Ogre::Quaternion& value) {
+    stream(value.w);
+    stream(value.x);
+    stream(value.y);
+    stream(value.z);
+}
+
+bool BitStream::_reserve(uint64_t bits) {
+    if(mIsOverflowed)
+        return false;
+
+    if(mPosition + bits > mCapacity) {
+        mIsOverflowed = true;
+        return false;
+    }
+    return true;
+}
+
+}
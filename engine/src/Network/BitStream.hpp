@@ -0,0 +1,261 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_BITSTREAM
+#define DUCTTAPE_ENGINE_NETWORK_BITSTREAM
+
+#include <Config.hpp>
+
+#include <OgreQuaternion.h>
+#include <OgreVector3.h>
+
+#include <QString>
+#include <QUuid>
+
+#include <cstdint>
+#include <string>
+
+namespace dt {
+
+/**
+  * Reads or writes values packed bit by bit in a buffer owned by the caller. Nothing is allocated while
+  * writing, and reading only allocates the strings it returns. Unsigned integers wider than 8 bits are
+  * written as varints (7 bits per byte plus a continuation bit), signed ones zigzag-encoded first, so small
+  * values take few bits. Ranged integers and quantized floats take exactly as many bits as asked for,
+  * UUIDs 128 bits. Strings and byte blocks start at a byte boundary, so they are copied in one go.
+  * Writing past the end of the buffer or reading past the end of the data does not throw, but marks the
+  * stream as overflowed; read values are zero from then on.
+  * @code
+  * char buffer[1200];
+  * BitStream writer(buffer, sizeof(buffer), BitStream::WRITE);
+  * writer.writeRanged(health, 0, 100);     // 7 bits
+  * writer.writeVarint(score);
+  * if(!writer.isOverflowed())
+  *     send(buffer, writer.getSize());
+  * @endcode
+  * @see IOPacket
+  */
+class DUCTTAPE_API BitStream {
+public:
+    /**
+      * Whether the stream reads or writes.
+      */
+    enum Access {
+        READ,
+        WRITE
+    };
+
+    /**
+      * Advanced constructor.
+      * @param buffer The buffer to read from or write to.
+      * @param size The size of the data or the buffer, in bytes.
+      * @param access Whether the stream reads or writes.
+      */
+    BitStream(char* buffer, uint32_t size, Access access);
+
+    /**
+      * Reading constructor.
+      * @param data The data to read.
+      * @param size The size of the data, in bytes.
+      */
+    BitStream(const char* data, uint32_t size);
+
+    /**
+      * Returns whether the stream writes or reads.
+      * @returns True if the stream writes.
+      */
+    bool isWriting() const;
+
+    /**
+      * Returns whether a value did not fit into the buffer or was read past the end of the data.
+      * @returns True if the stream overflowed.
+      */
+    bool isOverflowed() const;
+
+    /**
+      * Returns the number of bytes written or read, including a partly used last byte.
+      * @returns The size, in bytes.
+      */
+    uint32_t getSize() const;
+
+    /**
+      * Returns the number of bits written or read.
+      * @returns The position, in bits.
+      */
+    uint32_t getBitPosition() const;
+
+    /**
+      * Returns whether all data has been read.
+      * @returns True if less than a byte is left.
+      */
+    bool isAtEnd() const;
+
+    /**
+      * Moves on to the next byte boundary. The skipped bits are zero.
+      */
+    void align();
+
+    /**
+      * Writes the lowest bits of a value.
+      * @param value The value.
+      * @param bits The number of bits, from 0 to 32.
+      */
+    void writeBits(uint32_t value, uint32_t bits);
+
+    /**
+      * Reads a value.
+      * @param bits The number of bits, from 0 to 32.
+      * @returns The value.
+      */
+    uint32_t readBits(uint32_t bits);
+
+    /**
+      * Writes an unsigned integer as varint.
+      * @param value The value.
+      */
+    void writeVarint(uint64_t value);
+
+    /**
+      * Reads a varint.
+      * @returns The value.
+      */
+    uint64_t readVarint();
+
+    /**
+      * Writes a signed integer as zigzag-encoded varint.
+      * @param value The value.
+      */
+    void writeSignedVarint(int64_t value);
+
+    /**
+      * Reads a zigzag-encoded varint.
+      * @returns The value.
+      */
+    int64_t readSignedVarint();
+
+    /**
+      * Writes an integer in a range, using as few bits as the range needs. Values outside are clamped.
+      * @param value The value.
+      * @param min The smallest possible value.
+      * @param max The largest possible value.
+      */
+    void writeRanged(int32_t value, int32_t min, int32_t max);
+
+    /**
+      * Reads an integer in a range.
+      * @param min The smallest possible value.
+      * @param max The largest possible value.
+      * @returns The value.
+      */
+    int32_t readRanged(int32_t min, int32_t max);
+
+    /**
+      * Writes a float quantized in a range.
+      * @param value The value.
+      * @param min The lower end of the range.
+      * @param max The upper end of the range.
+      * @param bits The number of bits, from 1 to 32.
+      * @see Quantization::quantizeFloat
+      */
+    void writeQuantized(float value, float min, float max, uint32_t bits);
+
+    /**
+      * Reads a float quantized in a range.
+      * @param min The lower end of the range.
+      * @param max The upper end of the range.
+      * @param bits The number of bits, from 1 to 32.
+      * @returns The value.
+      */
+    float readQuantized(float min, float max, uint32_t bits);
+
+    /**
+      * Writes a block of bytes, starting at the next byte boundary.
+      * @param data The bytes.
+      * @param size The number of bytes.
+      */
+    void writeBytes(const char* data, uint32_t size);
+
+    /**
+      * Reads a block of bytes, starting at the next byte boundary.
+      * @param data The buffer to read into.
+      * @param size The number of bytes.
+      */
+    void readBytes(char* data, uint32_t size);
+
+    /**
+      * Returns a block of bytes in the data, starting at the next byte boundary, without copying it.
+      * @param size The number of bytes.
+      * @returns The bytes, or nullptr if the data is too short.
+      */
+    const char* skipBytes(uint32_t size);
+
+    /**
+      * Writes a QUuid as 128 bits.
+      * @param id The QUuid.
+      */
+    void writeUuid(const QUuid& id);
+
+    /**
+      * Reads a QUuid.
+      * @returns The QUuid.
+      */
+    QUuid readUuid();
+
+    /**
+      * Writes a QString as UTF-8, prefixed with its size in bytes. The string is encoded straight into the buffer.
+      * @param s The QString.
+      */
+    void writeString(const QString& s);
+
+    /**
+      * Reads a QString.
+      * @returns The QString.
+      */
+    QString readString();
+
+    /**
+      * Writes or reads a value, depending on the direction of the stream. The types without a bit count of
+      * their own are written as follows: bool as 1 bit, 8 bit integers as 8 bits, wider integers as varints,
+      * floats and doubles as 32 and 64 bits, std::strings like QStrings and Ogre vectors and quaternions as floats.
+      * @param value The value.
+      */
+    void stream(bool& value);
+    void stream(int8_t& value);
+    void stream(uint8_t& value);
+    void stream(int16_t& value);
+    void stream(uint16_t& value);
+    void stream(int32_t& value);
+    void stream(uint32_t& value);
+    void stream(int64_t& value);
+    void stream(uint64_t& value);
+    void stream(float& value);
+    void stream(double& value);
+    void stream(std::string& value);
+    void stream(QString& value);
+    void stream(QUuid& value);
+    void stream(Ogre::Vector3& value);
+    void stream(Ogre::Quaternion& value);
+
+private:
+    /**
+      * Private method. Checks whether a number of bits fits into the buffer, and marks the stream as overflowed if not.
+      * @param bits The number of bits.
+      * @returns True if the bits fit.
+      */
+    bool _reserve(uint64_t bits);
+
+    char* mBuffer;              //!< The buffer written to, or nullptr when reading.
+    const char* mData;          //!< The data read or written.
+    uint32_t mCapacity;         //!< The size of the buffer or data, in bits.
+    uint32_t mPosition;         //!< The current position, in bits.
+    bool mIsOverflowed;         //!< Whether the stream overflowed.
+};
+
+}
+
+#endif
@@ -0,0 +1,210 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_CLIENTPREDICTION
+#define DUCTTAPE_ENGINE_NETWORK_CLIENTPREDICTION
+
+#include <Config.hpp>
+
+#include <Scene/Node.hpp>
+
+#include <OgreMath.h>
+#include <OgreQuaternion.h>
+#include <OgreVector3.h>
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace dt {
+
+/**
+  * Client-side prediction for the node the local player controls. Every input is applied to the node
+  * at once, numbered and kept until the server has processed it, together with the transform it led to.
+  * When a snapshot tells which input the server processed last, the transform predicted for that input is
+  * compared with the authoritative one. Only if they differ by more than the quantization of the snapshots,
+  * the node is reset to the authoritative transform and the inputs the server has not processed yet are
+  * applied again. As long as client and server step the same way, the player sees no correction at all.
+  * The input is any copyable type. It has to be sent to the server together with its sequence number,
+  * which passes the number of the latest input it applied to NodeReplicator::setProcessedInput.
+  * @code
+  * prediction.setTolerance(replicator.getPositionPrecision());
+  * // client, every fixed step
+  * uint32_t sequence = prediction.applyInput(player, input, time_diff);
+  * sendInput(sequence, input);
+  * prediction.reconcile(player, replicator.getProcessedInput(), position, rotation);
+  * @endcode
+  * @see NodeReplicator::setPredicted
+  */
+template <typename Input>
+class ClientPrediction {
+public:
+    /**
+      * The function that moves a node by one input. It has to do the same on the client and the server.
+      */
+    typedef std::function<void(Node* node, const Input& input, double time_diff)> StepFunction;
+
+    /**
+      * Advanced constructor.
+      * @param step The function that moves a node by one input.
+      * @param capacity The maximum number of inputs waiting for the server. The oldest ones are dropped.
+      */
+    ClientPrediction(StepFunction step, uint32_t capacity = 128)
+        : mStep(step),
+          mCapacity(capacity),
+          mSequence(0),
+          mLastProcessed(0),
+          mLastCorrection(0.f),
+          mCorrectionCount(0),
+          // a quantization step with the default position bounds of the NodeReplicator
+          mPositionTolerance(2048.f / 65535.f),
+          mRotationTolerance(Ogre::Degree(0.5f)) {}
+
+    /**
+      * Sets how far the authoritative transform may be from the predicted one before the node is corrected.
+      * It should cover the quantization of the snapshots. Default: one step with the default position bounds,
+      * and half a degree.
+      * @param position The largest difference per axis.
+      * @param rotation The largest difference in rotation.
+      * @see NodeReplicator::getPositionPrecision
+      */
+    void setTolerance(const Ogre::Vector3& position, const Ogre::Radian& rotation = Ogre::Degree(0.5f)) {
+        mPositionTolerance = position;
+        mRotationTolerance = rotation;
+    }
+
+    /**
+      * Applies an input to the node and keeps it until the server has processed it.
+      * @param node The node the local player controls.
+      * @param input The input.
+      * @param time_diff The length of the step, in seconds.
+      * @returns The sequence number of the input, to be sent along with it. The first one is 1.
+      */
+    uint32_t applyInput(Node* node, const Input& input, double time_diff) {
+        if(mPending.size() >= mCapacity)
+            mPending.pop_front();
+
+        PendingInput pending;
+        pending.mSequence = ++mSequence;
+        pending.mInput = input;
+        pending.mTimeDiff = time_diff;
+        mPending.push_back(pending);
+
+        mStep(node, input, time_diff);
+        mPending.back().mPosition = node->getPosition(Node::SCENE);
+        mPending.back().mRotation = node->getRotation(Node::SCENE);
+        return mSequence;
+    }
+
+    /**
+      * Corrects the node with the authoritative transform, if the server has processed a newer input
+      * since the last call and the transform predicted for it is off by more than the tolerance. The inputs
+      * up to the processed one are dropped, the others are applied again.
+      * @param node The node the local player controls.
+      * @param processed The sequence number of the latest input the server processed.
+      * @param position The authoritative position of the node, after that input.
+      * @param rotation The authoritative rotation of the node, after that input.
+      * @returns True if the node has been reconciled, whether it had to be corrected or not.
+      */
+    bool reconcile(Node* node, uint32_t processed, const Ogre::Vector3& position, const Ogre::Quaternion& rotation) {
+        if(processed <= mLastProcessed || processed > mSequence)
+            return false;
+
+        mLastProcessed = processed;
+        bool is_predicted = false;
+        Ogre::Vector3 predicted_position = Ogre::Vector3::ZERO;
+        Ogre::Quaternion predicted_rotation = Ogre::Quaternion::IDENTITY;
+        while(!mPending.empty() && mPending.front().mSequence <= processed) {
+            if(mPending.front().mSequence == processed) {
+                is_predicted = true;
+                predicted_position = mPending.front().mPosition;
+                predicted_rotation = mPending.front().mRotation;
+            }
+            mPending.pop_front();
+        }
+
+        // the authoritative transform is quantized, so it is never exactly the predicted one
+        Ogre::Vector3 difference = position - predicted_position;
+        if(is_predicted && std::abs(difference.x) <= mPositionTolerance.x && std::abs(difference.y) <= mPositionTolerance.y
+           && std::abs(difference.z) <= mPositionTolerance.z && predicted_rotation.equals(rotation, mRotationTolerance)) {
+            mLastCorrection = 0.f;
+            return true;
+        }
+
+        Ogre::Vector3 predicted = node->getPosition(Node::SCENE);
+        node->setPosition(position, Node::SCENE);
+        node->setRotation(rotation, Node::SCENE);
+        for(auto iter = mPending.begin(); iter != mPending.end(); ++iter) {
+            mStep(node, iter->mInput, iter->mTimeDiff);
+        }
+
+        mLastCorrection = predicted.distance(node->getPosition(Node::SCENE));
+        if(mLastCorrection > 0.f)
+            ++mCorrectionCount;
+        return true;
+    }
+
+    /**
+      * Returns the number of inputs the server has not processed yet.
+      * @returns The number of inputs.
+      */
+    uint32_t getPendingCount() const {
+        return mPending.size();
+    }
+
+    /**
+      * Returns the sequence number of the latest input applied.
+      * @returns The sequence number, or 0 if there was no input yet.
+      */
+    uint32_t getSequence() const {
+        return mSequence;
+    }
+
+    /**
+      * Returns how far the last reconciliation moved the node from where it was predicted.
+      * @returns The distance.
+      */
+    float getLastCorrection() const {
+        return mLastCorrection;
+    }
+
+    /**
+      * Returns the number of reconciliations that moved the node.
+      * @returns The number of corrections.
+      */
+    uint32_t getCorrectionCount() const {
+        return mCorrectionCount;
+    }
+
+private:
+    /**
+      * An input the server has not processed yet.
+      */
+    struct PendingInput {
+        uint32_t mSequence;             //!< The sequence number.
+        Input mInput;                   //!< The input.
+        double mTimeDiff;               //!< The length of the step, in seconds.
+        Ogre::Vector3 mPosition;        //!< The position of the node after the input.
+        Ogre::Quaternion mRotation;     //!< The rotation of the node after the input.
+    };
+
+    StepFunction mStep;                 //!< The function that moves a node by one input.
+    uint32_t mCapacity;                 //!< The maximum number of pending inputs.
+    std::deque<PendingInput> mPending;  //!< The inputs the server has not processed yet, oldest first.
+    uint32_t mSequence;                 //!< The sequence number of the latest input.
+    uint32_t mLastProcessed;            //!< The latest input the server processed.
+    float mLastCorrection;              //!< The distance the node moved in the last reconciliation.
+    uint32_t mCorrectionCount;          //!< The number of reconciliations that moved the node.
+    Ogre::Vector3 mPositionTolerance;   //!< The largest difference per axis that is not corrected.
+    Ogre::Radian mRotationTolerance;    //!< The largest difference in rotation that is not corrected.
+};
+
+}
+
+#endif
@@ -0,0 +1,117 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/CongestionControl.hpp>
+
+#include <algorithm>
+
+namespace dt {
+
+/**
+  * The send rate of a new connection, in bytes per second.
+  */
+static const double INITIAL_SEND_RATE = 64000.0;
+
+/**
+  * The amount the send rate is raised by per round trip without loss, in bytes per second.
+  */
+static const double ADDITIVE_INCREASE = 1200.0;
+
+/**
+  * The shortest round trip the rate is adapted per, in seconds. Keeps loopback connections from growing too fast.
+  */
+static const double MIN_EPOCH = 0.05;
+
+/**
+  * The time the bucket holds tokens for, in seconds. Together with MIN_BUCKET_SIZE, this is the largest burst.
+  */
+static const double BUCKET_TIME = 0.1;
+
+/**
+  * The smallest bucket size, in bytes. Two full datagrams.
+  */
+static const double MIN_BUCKET_SIZE = 2400.0;
+
+CongestionControl::CongestionControl()
+    : mMinRate(8000),
+      mMaxRate(1000000),
+      mRate(INITIAL_SEND_RATE),
+      mTokens(MIN_BUCKET_SIZE),
+      mLastUpdate(-1.0),
+      mRoundTripTime(MIN_EPOCH),
+      mEpochStart(0.0),
+      mLastDecrease(-1.0),
+      mIsLimited(false),
+      mHasLoss(false) {}
+
+void CongestionControl::setLimits(uint32_t min_rate, uint32_t max_rate) {
+    mMinRate = min_rate;
+    mMaxRate = max_rate;
+    if(mMaxRate != 0)
+        mRate = std::min(mRate, static_cast<double>(mMaxRate));
+    mRate = std::max(mRate, static_cast<double>(mMinRate));
+}
+
+uint32_t CongestionControl::getMinRate() const {
+    return mMinRate;
+}
+
+uint32_t CongestionControl::getMaxRate() const {
+    return mMaxRate;
+}
+
+uint32_t CongestionControl::getRate() const {
+    return static_cast<uint32_t>(mRate);
+}
+
+void CongestionControl::update(double time, double round_trip_time) {
+    mRoundTripTime = std::max(round_trip_time, MIN_EPOCH);
+    if(mLastUpdate < 0.0) {
+        mLastUpdate = time;
+        mEpochStart = time;
+        return;
+    }
+
+    double bucket_size = std::max(mRate * BUCKET_TIME, MIN_BUCKET_SIZE);
+    mTokens = std::min(mTokens + mRate * (time - mLastUpdate), bucket_size);
+    mLastUpdate = time;
+
+    if(time - mEpochStart >= mRoundTripTime) {
+        // only grow if the rate was actually needed, or an idle connection would grow without limit
+        if(!mHasLoss && mIsLimited) {
+            mRate += ADDITIVE_INCREASE;
+            if(mMaxRate != 0)
+                mRate = std::min(mRate, static_cast<double>(mMaxRate));
+        }
+        mEpochStart = time;
+        mIsLimited = false;
+        mHasLoss = false;
+    }
+}
+
+bool CongestionControl::canSend() {
+    if(mMaxRate == 0 || mTokens > 0.0)
+        return true;
+    mIsLimited = true;
+    return false;
+}
+
+void CongestionControl::consume(uint32_t bytes) {
+    mTokens -= bytes;
+}
+
+void CongestionControl::onLoss(double time) {
+    mHasLoss = true;
+    if(mLastDecrease >= 0.0 && time - mLastDecrease < mRoundTripTime)
+        return;
+
+    mRate = std::max(mRate * 0.5, static_cast<double>(mMinRate));
+    mLastDecrease = time;
+}
+
+}
@@ -0,0 +1,98 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_CONGESTIONCONTROL
+#define DUCTTAPE_ENGINE_NETWORK_CONGESTIONCONTROL
+
+#include <Config.hpp>
+
+#include <cstdint>
+
+namespace dt {
+
+/**
+  * Limits the rate data is sent to one remote device. A token bucket filled at the send rate decides whether
+  * a message may be sent now, and the send rate itself is adapted like TCP does (AIMD): it is halved when
+  * datagrams are lost, at most once per round trip, and raised by a fixed amount every round trip without loss
+  * in which the rate was used up.
+  * @see NetworkChannels
+  */
+class DUCTTAPE_API CongestionControl {
+public:
+    /**
+      * Default constructor.
+      */
+    CongestionControl();
+
+    /**
+      * Sets the range the send rate is adapted in. The current rate is clamped to it.
+      * @param min_rate The lowest send rate, in bytes per second.
+      * @param max_rate The highest send rate, in bytes per second. 0 disables the limit.
+      */
+    void setLimits(uint32_t min_rate, uint32_t max_rate);
+
+    /**
+      * Returns the lowest send rate.
+      * @returns The lowest send rate, in bytes per second.
+      */
+    uint32_t getMinRate() const;
+
+    /**
+      * Returns the highest send rate.
+      * @returns The highest send rate, in bytes per second, or 0 if the rate is not limited.
+      */
+    uint32_t getMaxRate() const;
+
+    /**
+      * Returns the current send rate.
+      * @returns The send rate, in bytes per second.
+      */
+    uint32_t getRate() const;
+
+    /**
+      * Fills the bucket for the time passed and raises the rate if a round trip passed without loss.
+      * @param time The current time, in seconds.
+      * @param round_trip_time The round-trip time, in seconds.
+      */
+    void update(double time, double round_trip_time);
+
+    /**
+      * Returns whether a message may be sent now. The last message sent may overdraw the bucket, so messages
+      * larger than the bucket are sent too.
+      * @returns Whether the bucket is not empty.
+      */
+    bool canSend();
+
+    /**
+      * Takes the size of a message sent from the bucket.
+      * @param bytes The size, in bytes.
+      */
+    void consume(uint32_t bytes);
+
+    /**
+      * Reacts to a lost datagram by halving the rate, unless it has been halved within the last round trip.
+      * @param time The current time, in seconds.
+      */
+    void onLoss(double time);
+
+private:
+    uint32_t mMinRate;          //!< The lowest send rate, in bytes per second.
+    uint32_t mMaxRate;          //!< The highest send rate, in bytes per second, or 0.
+    double mRate;               //!< The current send rate, in bytes per second.
+    double mTokens;             //!< The bytes that may be sent now. Negative if the bucket was overdrawn.
+    double mLastUpdate;         //!< The time of the last update(), or -1 before the first one.
+    double mRoundTripTime;      //!< The round-trip time given to the last update(), in seconds.
+    double mEpochStart;         //!< The time the current round trip started.
+    double mLastDecrease;       //!< The time the rate was halved last, or -1.
+    bool mIsLimited;            //!< Whether the bucket ran empty in the current round trip.
+    bool mHasLoss;              //!< Whether datagrams were lost in the current round trip.
+};
+
+}
+
+#endif
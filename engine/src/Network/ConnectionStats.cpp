@@ -0,0 +1,180 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/ConnectionStats.hpp>
+
+#include <cstdlib>
+
+namespace dt {
+
+/**
+  * The length of a measuring window, in seconds.
+  */
+static const double STATS_WINDOW = 1.0;
+
+ConnectionStats::ConnectionStats()
+    : mHasRoundTripTime(false),
+      mRoundTripTime(0),
+      mRoundTripVariance(0),
+      mJitter(0),
+      mLastSample(0),
+      mWindowStart(-1.0),
+      mWindowReceivedBytes(0),
+      mWindowReceived(0),
+      mWindowExpected(0),
+      mWindowSentBytes(0),
+      mWindowSent(0),
+      mWindowDelivered(0),
+      mWindowLost(0),
+      mLoss(0.f),
+      mOutgoingLoss(0.f),
+      mIncomingBytesPerSecond(0.0),
+      mOutgoingBytesPerSecond(0.0),
+      mIncomingPacketsPerSecond(0.0),
+      mOutgoingPacketsPerSecond(0.0),
+      mReceivedBytes(0),
+      mSentBytes(0) {}
+
+void ConnectionStats::addRoundTripSample(int64_t round_trip_time) {
+    if(round_trip_time < 0)
+        round_trip_time = 0;
+
+    if(!mHasRoundTripTime) {
+        mRoundTripTime = round_trip_time;
+        mRoundTripVariance = round_trip_time / 2;
+        mJitter = 0;
+        mHasRoundTripTime = true;
+    } else {
+        // the variance is updated with the old mean, as in RFC 6298
+        mRoundTripVariance += (std::llabs(mRoundTripTime - round_trip_time) - mRoundTripVariance) / 4;
+        mRoundTripTime += (round_trip_time - mRoundTripTime) / 8;
+        mJitter += (std::llabs(round_trip_time - mLastSample) - mJitter) / 16;
+    }
+    mLastSample = round_trip_time;
+}
+
+void ConnectionStats::addReceived(uint32_t bytes) {
+    mWindowReceivedBytes += bytes;
+    ++mWindowReceived;
+    mReceivedBytes += bytes;
+}
+
+void ConnectionStats::addExpected(uint32_t count) {
+    mWindowExpected += count;
+}
+
+void ConnectionStats::addDelivered() {
+    ++mWindowDelivered;
+}
+
+void ConnectionStats::addLost() {
+    ++mWindowLost;
+}
+
+void ConnectionStats::addSent(uint32_t bytes) {
+    mWindowSentBytes += bytes;
+    ++mWindowSent;
+    mSentBytes += bytes;
+}
+
+void ConnectionStats::update(double time) {
+    if(mWindowStart < 0.0) {
+        mWindowStart = time;
+        return;
+    }
+
+    double elapsed = time - mWindowStart;
+    if(elapsed < STATS_WINDOW)
+        return;
+
+    mIncomingBytesPerSecond = mWindowReceivedBytes / elapsed;
+    mOutgoingBytesPerSecond = mWindowSentBytes / elapsed;
+    mIncomingPacketsPerSecond = mWindowReceived / elapsed;
+    mOutgoingPacketsPerSecond = mWindowSent / elapsed;
+
+    // late datagrams filling a gap of an earlier window count as received, but not as expected
+    if(mWindowExpected > mWindowReceived)
+        mLoss = static_cast<float>(mWindowExpected - mWindowReceived) / mWindowExpected;
+    else
+        mLoss = 0.f;
+
+    uint32_t resolved = mWindowDelivered + mWindowLost;
+    mOutgoingLoss = (resolved > 0) ? static_cast<float>(mWindowLost) / resolved : 0.f;
+
+    mWindowStart = time;
+    mWindowReceivedBytes = 0;
+    mWindowReceived = 0;
+    mWindowExpected = 0;
+    mWindowSentBytes = 0;
+    mWindowSent = 0;
+    mWindowDelivered = 0;
+    mWindowLost = 0;
+}
+
+bool ConnectionStats::hasRoundTripTime() const {
+    return mHasRoundTripTime;
+}
+
+int64_t ConnectionStats::getRoundTripTime() const {
+    return mRoundTripTime;
+}
+
+int64_t ConnectionStats::getRoundTripVariance() const {
+    return mRoundTripVariance;
+}
+
+int64_t ConnectionStats::getJitter() const {
+    return mJitter;
+}
+
+float ConnectionStats::getLoss() const {
+    return mLoss;
+}
+
+float ConnectionStats::getOutgoingLoss() const {
+    return mOutgoingLoss;
+}
+
+double ConnectionStats::getIncomingBytesPerSecond() const {
+    return mIncomingBytesPerSecond;
+}
+
+double ConnectionStats::getOutgoingBytesPerSecond() const {
+    return mOutgoingBytesPerSecond;
+}
+
+double ConnectionStats::getIncomingPacketsPerSecond() const {
+    return mIncomingPacketsPerSecond;
+}
+
+double ConnectionStats::getOutgoingPacketsPerSecond() const {
+    return mOutgoingPacketsPerSecond;
+}
+
+uint64_t ConnectionStats::getReceivedBytes() const {
+    return mReceivedBytes;
+}
+
+uint64_t ConnectionStats::getSentBytes() const {
+    return mSentBytes;
+}
+
+QString ConnectionStats::toString() const {
+    return QString("rtt %1 ms (+-%2), jitter %3 ms, loss %4% in %5% out, in %6 kB/s (%7 pkt/s), out %8 kB/s (%9 pkt/s)")
+        .arg(mRoundTripTime / 1000.0, 0, 'f', 3)
+        .arg(mRoundTripVariance / 1000.0, 0, 'f', 3)
+        .arg(mJitter / 1000.0, 0, 'f', 3)
+        .arg(mLoss * 100.0, 0, 'f', 1)
+        .arg(mOutgoingLoss * 100.0, 0, 'f', 1)
+        .arg(mIncomingBytesPerSecond / 1000.0, 0, 'f', 1)
+        .arg(mIncomingPacketsPerSecond, 0, 'f', 0)
+        .arg(mOutgoingBytesPerSecond / 1000.0, 0, 'f', 1)
+        .arg(mOutgoingPacketsPerSecond, 0, 'f', 0);
+}
+
+}
@@ -0,0 +1,180 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_CONNECTIONSTATS
+#define DUCTTAPE_ENGINE_NETWORK_CONNECTIONSTATS
+
+#include <Config.hpp>
+
+#include <QString>
+
+#include <cstdint>
+
+namespace dt {
+
+/**
+  * Measurements of the traffic with one remote device. The round-trip time is smoothed like TCP does
+  * (RFC 6298) and kept in microseconds, the jitter is the smoothed difference between consecutive
+  * round-trip times (RFC 3550). The rates and the loss are measured over windows of one second.
+  * @see ConnectionsManager::getStats
+  */
+class DUCTTAPE_API ConnectionStats {
+public:
+    /**
+      * Default constructor.
+      */
+    ConnectionStats();
+
+    /**
+      * Adds a measured round-trip time.
+      * @param round_trip_time The round-trip time, in microseconds.
+      */
+    void addRoundTripSample(int64_t round_trip_time);
+
+    /**
+      * Counts a datagram received.
+      * @param bytes The size of the datagram, in bytes.
+      */
+    void addReceived(uint32_t bytes);
+
+    /**
+      * Counts datagrams the remote device has sent, going by their sequence numbers. The difference to the
+      * datagrams received is the loss.
+      * @param count The number of datagrams.
+      */
+    void addExpected(uint32_t count);
+
+    /**
+      * Counts a sent datagram with messages that has been acknowledged.
+      */
+    void addDelivered();
+
+    /**
+      * Counts a sent datagram with messages that has been lost.
+      */
+    void addLost();
+
+    /**
+      * Counts a datagram sent.
+      * @param bytes The size of the datagram, in bytes.
+      */
+    void addSent(uint32_t bytes);
+
+    /**
+      * Ends the current measuring window if it is one second old, and updates the rates and the loss.
+      * @param time The current time, in seconds.
+      */
+    void update(double time);
+
+    /**
+      * Returns whether a round-trip time has been measured yet.
+      * @returns Whether a round-trip time has been measured.
+      */
+    bool hasRoundTripTime() const;
+
+    /**
+      * Returns the smoothed round-trip time.
+      * @returns The round-trip time, in microseconds.
+      */
+    int64_t getRoundTripTime() const;
+
+    /**
+      * Returns the smoothed mean deviation of the round-trip time.
+      * @returns The round-trip time variation, in microseconds.
+      */
+    int64_t getRoundTripVariance() const;
+
+    /**
+      * Returns the smoothed difference between consecutive round-trip times.
+      * @returns The jitter, in microseconds.
+      */
+    int64_t getJitter() const;
+
+    /**
+      * Returns the fraction of the datagrams sent by the remote device that did not arrive in the last window.
+      * @returns The loss, between 0 and 1.
+      */
+    float getLoss() const;
+
+    /**
+      * Returns the fraction of the datagrams with messages sent to the remote device that were lost in the last window.
+      * @returns The loss, between 0 and 1.
+      */
+    float getOutgoingLoss() const;
+
+    /**
+      * Returns the bytes received per second in the last window.
+      * @returns The incoming bandwidth, in bytes per second.
+      */
+    double getIncomingBytesPerSecond() const;
+
+    /**
+      * Returns the bytes sent per second in the last window.
+      * @returns The outgoing bandwidth, in bytes per second.
+      */
+    double getOutgoingBytesPerSecond() const;
+
+    /**
+      * Returns the datagrams received per second in the last window.
+      * @returns The incoming datagram rate.
+      */
+    double getIncomingPacketsPerSecond() const;
+
+    /**
+      * Returns the datagrams sent per second in the last window.
+      * @returns The outgoing datagram rate.
+      */
+    double getOutgoingPacketsPerSecond() const;
+
+    /**
+      * Returns the total number of bytes received.
+      * @returns The number of bytes.
+      */
+    uint64_t getReceivedBytes() const;
+
+    /**
+      * Returns the total number of bytes sent.
+      * @returns The number of bytes.
+      */
+    uint64_t getSentBytes() const;
+
+    /**
+      * Formats the measurements for a log line.
+      * @returns The measurements, e.g. "rtt 12.345 ms (+-0.210), jitter 0.100 ms, loss 0.0% in 0.0% out, in 1.2 kB/s (20 pkt/s), out 0.8 kB/s (20 pkt/s)".
+      */
+    QString toString() const;
+
+private:
+    bool mHasRoundTripTime;           //!< Whether a round-trip time has been measured.
+    int64_t mRoundTripTime;           //!< The smoothed round-trip time, in microseconds.
+    int64_t mRoundTripVariance;       //!< The smoothed mean deviation of the round-trip time, in microseconds.
+    int64_t mJitter;                  //!< The smoothed difference between consecutive round-trip times, in microseconds.
+    int64_t mLastSample;              //!< The last round-trip time measured, in microseconds.
+
+    double mWindowStart;              //!< The time the current window started, or -1 before the first update().
+    uint32_t mWindowReceivedBytes;    //!< The bytes received in the current window.
+    uint32_t mWindowReceived;         //!< The datagrams received in the current window.
+    uint32_t mWindowExpected;         //!< The datagrams sent by the remote device in the current window.
+    uint32_t mWindowSentBytes;        //!< The bytes sent in the current window.
+    uint32_t mWindowSent;             //!< The datagrams sent in the current window.
+    uint32_t mWindowDelivered;        //!< The datagrams with messages acknowledged in the current window.
+    uint32_t mWindowLost;             //!< The datagrams with messages lost in the current window.
+
+    float mLoss;                      //!< The loss in the last window.
+    float mOutgoingLoss;              //!< The loss of sent datagrams in the last window.
+    double mIncomingBytesPerSecond;   //!< The incoming bandwidth in the last window.
+    double mOutgoingBytesPerSecond;   //!< The outgoing bandwidth in the last window.
+    double mIncomingPacketsPerSecond; //!< The incoming datagram rate in the last window.
+    double mOutgoingPacketsPerSecond; //!< The outgoing datagram rate in the last window.
+    uint64_t mReceivedBytes;          //!< The total number of bytes received.
+    uint64_t mSentBytes;              //!< The total number of bytes sent.
+};
+
+}
+
+#endif
@@ -18,8 +18,14 @@ namespace dt {
 
 ConnectionsManager::ConnectionsManager(ConnectionsManager::ID_t max_connections)
     : mMaxConnections(max_connections),
+      mNextID(1),
+      mMinSendRate(8000),
+      mMaxSendRate(1000000),
+      mMaxReassemblyBytes(16 * 1024 * 1024),
+      mReassemblyTimeout(10.0),
       mTimeout(10.0),
-      mPingInterval(1.0) {}
+      mPingInterval(1.0),
+      mLingerTime(1.0) {}
 
 ConnectionsManager::~ConnectionsManager() {}
 
@@ -45,19 +51,35 @@ ConnectionsManager::ID_t ConnectionsManager::getMaxConnections() const {
 }
 
 bool ConnectionsManager::isKnownConnection(Connection c) {
-    return getConnectionID(c) != 0;
+    return findConnectionID(c.getIPAddress(), c.getPort()) != 0;
 }
 
 ConnectionsManager::ID_t ConnectionsManager::addConnection(Connection::ConnectionSP c) {
     ConnectionsManager::ID_t id = _getNewID();
-    if(id != 0)
+    if(id != 0) {
         mConnections[id] = c;
+        mEndpointIDs[_endpointKey(c->getIPAddress(), c->getPort())] = id;
+
+        if(id >= mChannels.size())
+            mChannels.resize(id + 1);
+        mChannels[id].reset(new NetworkChannels());
+        mChannels[id]->getCongestionControl().setLimits(mMinSendRate, mMaxSendRate);
+        mChannels[id]->setReassemblyLimits(mMaxReassemblyBytes, mReassemblyTimeout);
+        // a new connection has the full timeout to send its first packet
+        mLastActivity[id] = Root::getInstance().getTimeSinceInitialize();
+    }
     return id;
 }
 
 void ConnectionsManager::removeConnection(ConnectionsManager::ID_t id) {
-    if(getConnection(id) != nullptr) {
-        mConnections.erase(id);
+    auto iter = mConnections.find(id);
+    if(iter != mConnections.end()) {
+        mEndpointIDs.erase(_endpointKey(iter->second->getIPAddress(), iter->second->getPort()));
+        mConnections.erase(iter);
+        mChannels[id].reset();
+        mLastActivity.erase(id);
+        mClosing.erase(id);
+        mFreeIDs.push_back(id);
     }
 }
 
@@ -65,39 +87,98 @@ void ConnectionsManager::removeConnection(Connection c) {
     removeConnection(getConnectionID(c));
 }
 
-ConnectionsManager::ID_t ConnectionsManager::getConnectionID(Connection c) {
-    // run through connections in a loop
-    for(std::map<ConnectionsManager::ID_t, Connection::ConnectionSP>::iterator i = 
-                                        mConnections.begin(); i != mConnections.end(); ++i) {
-        if(i->second->getPort() == c.getPort() && i->second->getIPAddress() == c.getIPAddress()) {
-            return i->first;
-        }
+void ConnectionsManager::closeConnection(ConnectionsManager::ID_t id) {
+    if(mConnections.count(id) == 0 || isClosing(id))
+        return;
+
+    mClosing[id] = Root::getInstance().getTimeSinceInitialize() + mLingerTime;
+    // the linger time limits how long it is kept instead
+    mLastActivity.erase(id);
+}
+
+bool ConnectionsManager::isClosing(ConnectionsManager::ID_t id) const {
+    return mClosing.count(id) > 0;
+}
+
+void ConnectionsManager::removeClosedConnections() {
+    if(mClosing.empty())
+        return;
+
+    double time = Root::getInstance().getTimeSinceInitialize();
+    mClosed.clear();
+    for(auto iter = mClosing.begin(); iter != mClosing.end(); ++iter) {
+        if(time >= iter->second || mChannels[iter->first]->getUnackedCount() == 0)
+            mClosed.push_back(iter->first);
     }
 
+    for(auto iter = mClosed.begin(); iter != mClosed.end(); ++iter) {
+        removeConnection(*iter);
+    }
+}
+
+ConnectionsManager::ID_t ConnectionsManager::getConnectionID(Connection c) {
+    return findConnectionID(c.getIPAddress(), c.getPort());
+}
+
+ConnectionsManager::ID_t ConnectionsManager::findConnectionID(const sf::IpAddress& address, uint16_t port) const {
+    auto iter = mEndpointIDs.find(_endpointKey(address, port));
+    if(iter != mEndpointIDs.end())
+        return iter->second;
+
     // nothing found, return 0
     return 0;
 }
 
 Connection::ConnectionSP ConnectionsManager::getConnection(ConnectionsManager::ID_t id) {
-    if(mConnections.count(id) > 0)
-        return mConnections.find(id)->second;
+    auto iter = mConnections.find(id);
+    if(iter != mConnections.end())
+        return iter->second;
     else
         return Connection::ConnectionSP();
 }
 
+NetworkChannels* ConnectionsManager::getChannels(ConnectionsManager::ID_t id) {
+    if(id < mChannels.size())
+        return mChannels[id].get();
+    return nullptr;
+}
+
+ConnectionsManager::ID_t ConnectionsManager::getHighestID() const {
+    return mNextID - 1;
+}
+
 std::vector<Connection::ConnectionSP> ConnectionsManager::getAllConnections() {
     std::vector<Connection::ConnectionSP> result;
 
     for(std::map<ConnectionsManager::ID_t, Connection::ConnectionSP>::iterator i = 
                                 mConnections.begin(); i != mConnections.end(); ++i) {
-        result.push_back(i->second);
+        if(!isClosing(i->first))
+            result.push_back(i->second);
     }
 
     return result;
 }
 
+void ConnectionsManager::getConnectionIDs(std::vector<ConnectionsManager::ID_t>& ids) const {
+    ids.clear();
+    for(auto iter = mConnections.begin(); iter != mConnections.end(); ++iter) {
+        if(!isClosing(iter->first))
+            ids.push_back(iter->first);
+    }
+}
+
 double ConnectionsManager::getPing(ConnectionsManager::ID_t connection) {
-    return mPings[connection];
+    ConnectionStats* stats = getStats(connection);
+    if(stats == nullptr || !stats->hasRoundTripTime())
+        return 0.0;
+    return stats->getRoundTripTime() / 1000000.0;
+}
+
+ConnectionStats* ConnectionsManager::getStats(ConnectionsManager::ID_t connection) {
+    NetworkChannels* channels = getChannels(connection);
+    if(channels == nullptr)
+        return nullptr;
+    return &channels->getStats();
 }
 
 ConnectionsManager::ID_t ConnectionsManager::_getNewID() {
@@ -107,18 +188,57 @@ ConnectionsManager::ID_t ConnectionsManager::_getNewID() {
         mMaxConnections = 65535;
     }
 
-    // run until we find an empty one
-    for(ConnectionsManager::ID_t i = 1; i <= mMaxConnections; ++i) {
-        if(getConnection(i) == nullptr)
-            return i;
+    if(mConnections.size() >= mMaxConnections) {
+        // all slots used
+        return 0;
     }
 
-    // no ID left -> all slots used
-    return 0;
+    // reuse the ID of a removed connection first
+    if(!mFreeIDs.empty()) {
+        ConnectionsManager::ID_t id = mFreeIDs.back();
+        mFreeIDs.pop_back();
+        return id;
+    }
+
+    // fewer than 65535 connections are in use, so there is always an unused ID left
+    return mNextID++;
+}
+
+uint64_t ConnectionsManager::_endpointKey(const sf::IpAddress& address, uint16_t port) {
+    return (static_cast<uint64_t>(address.toInteger()) << 16) | port;
 }
 
 uint16_t ConnectionsManager::getConnectionCount() {
-    return mConnections.size();
+    return mConnections.size() - mClosing.size();
+}
+
+void ConnectionsManager::setSendRateLimits(uint32_t min_rate, uint32_t max_rate) {
+    mMinSendRate = min_rate;
+    mMaxSendRate = max_rate;
+    for(auto iter = mChannels.begin(); iter != mChannels.end(); ++iter) {
+        if(*iter != nullptr)
+            (*iter)->getCongestionControl().setLimits(mMinSendRate, mMaxSendRate);
+    }
+}
+
+uint32_t ConnectionsManager::getSendRate(ConnectionsManager::ID_t connection) {
+    NetworkChannels* channels = getChannels(connection);
+    if(channels == nullptr)
+        return 0;
+    return channels->getCongestionControl().getRate();
+}
+
+void ConnectionsManager::setReassemblyLimits(uint32_t max_bytes, double timeout) {
+    mMaxReassemblyBytes = max_bytes;
+    mReassemblyTimeout = timeout;
+    for(auto iter = mChannels.begin(); iter != mChannels.end(); ++iter) {
+        if(*iter != nullptr)
+            (*iter)->setReassemblyLimits(mMaxReassemblyBytes, mReassemblyTimeout);
+    }
+}
+
+uint32_t ConnectionsManager::getMaxReassemblyBytes() const {
+    return mMaxReassemblyBytes;
 }
 
 void ConnectionsManager::setPingInterval(double ping_interval) {
@@ -146,6 +266,14 @@ double ConnectionsManager::getTimeout() {
     return mTimeout;
 }
 
+void ConnectionsManager::setLingerTime(double linger_time) {
+    mLingerTime = linger_time;
+}
+
+double ConnectionsManager::getLingerTime() const {
+    return mLingerTime;
+}
+
 
 void ConnectionsManager::handleEvent(std::shared_ptr<NetworkEvent> e) {
 /*    if(e->GetType() == "DT_TIMERTICKEVENT") {
@@ -155,8 +283,9 @@ void ConnectionsManager::handleEvent(std::shared_ptr<NetworkEvent> e) {
             _Ping();
             _CheckTimeouts();
         }
-    } else */ if(e->getType() == "DT_PINGEVENT") {
-        std::shared_ptr<PingEvent> p = std::dynamic_pointer_cast<PingEvent>(e);
+    } else */
+    std::shared_ptr<PingEvent> p = std::dynamic_pointer_cast<PingEvent>(e);
+    if(p != nullptr) {
         if(p->isLocalEvent()) {
             // yes, we received this from the network
             if(p->isReply()) {
@@ -164,7 +293,12 @@ void ConnectionsManager::handleEvent(std::shared_ptr<NetworkEvent> e) {
             } else {
                 // just reply!
                 // time's crucial, send directly
-                std::shared_ptr<PingEvent> ping(new PingEvent(p->getTimestamp(), true));
+                std::shared_ptr<PingEvent> ping = NetworkManager::get()->createEvent<PingEvent>();
+                ping->setTimestamp(p->getTimestamp());
+                ping->isReply(true);
+                // the timestamp is only meaningful to the sender of the ping
+                ping->clearRecipients();
+                ping->addRecipient(p->getSenderID());
                 NetworkManager::get()->queueEvent(ping);
                 NetworkManager::get()->sendQueuedEvents();
             }
@@ -175,7 +309,10 @@ void ConnectionsManager::handleEvent(std::shared_ptr<NetworkEvent> e) {
     //    std::shared_ptr<NetworkEvent> n = std::dynamic_pointer_cast<NetworkEvent>(e);
         if(e->isLocalEvent()) {
             // we received a network event
-            mLastActivity[e->getSenderID()] = Root::getInstance().getTimeSinceInitialize();
+            // the connection may have been removed while handling the event
+            auto activity = mLastActivity.find(e->getSenderID());
+            if(activity != mLastActivity.end())
+                activity->second = Root::getInstance().getTimeSinceInitialize();
         }
     //}
 }
@@ -185,45 +322,70 @@ void ConnectionsManager::timerTick(QString message, double interval) {
         // this is our timer
         _ping();
         _checkTimeouts();
+        _logStats();
     }
 }
 
 
 void ConnectionsManager::_ping() {
-    NetworkManager::get()->queueEvent(std::make_shared<PingEvent>(Root::getInstance().getTimeSinceInitialize()));
+    std::shared_ptr<PingEvent> ping = NetworkManager::get()->createEvent<PingEvent>();
+    ping->setTimestamp(Root::getInstance().getTimeSinceInitialize());
+    ping->isReply(false);
+    NetworkManager::get()->queueEvent(ping);
 }
 
 void ConnectionsManager::_handlePing(std::shared_ptr<PingEvent> ping_event) {
-    uint32_t ping = Root::getInstance().getTimeSinceInitialize() - ping_event->getTimestamp();
-    mPings[ping_event->getSenderID()] = ping;
+    ConnectionStats* stats = getStats(ping_event->getSenderID());
+    if(stats == nullptr)
+        return;
 
-    Logger::get().debug("Ping for connection #" + Utils::toString(ping_event->getSenderID()) + ": " + Utils::toString(ping));
+    // measured from the arrival of the reply, so the frame time does not count if the network thread runs
+    double round_trip_time = ping_event->getReceiveTime() - ping_event->getTimestamp();
+    stats->addRoundTripSample(static_cast<int64_t>(round_trip_time * 1000000.0 + 0.5));
 }
 
 void ConnectionsManager::_checkTimeouts() {
-    uint32_t time = Root::getInstance().getTimeSinceInitialize();
-    for(auto i = mConnections.begin(); i != mConnections.end(); ++i) {
-        uint32_t diff = time - mLastActivity[i->first];
-        if(diff > mTimeout) {
-            _timeoutConnection(i->first);
-        }
+    if(mTimeout <= 0)
+        return;
+
+    double time = Root::getInstance().getTimeSinceInitialize();
+    mTimedOut.clear();
+    for(auto iter = mLastActivity.begin(); iter != mLastActivity.end(); ++iter) {
+        if(time - iter->second > mTimeout)
+            mTimedOut.push_back(iter->first);
+    }
+
+    // timing out removes the connection, so not while iterating
+    for(auto iter = mTimedOut.begin(); iter != mTimedOut.end(); ++iter) {
+        _timeoutConnection(*iter);
     }
 }
 
 void ConnectionsManager::_timeoutConnection(ConnectionsManager::ID_t connection) {
     Logger::get().warning("Connection timed out: " + Utils::toString(connection));
 
-    uint32_t diff = Root::getInstance().getTimeSinceInitialize() - mLastActivity[connection];
+    auto activity = mLastActivity.find(connection);
+    double diff = (activity != mLastActivity.end()) ? Root::getInstance().getTimeSinceInitialize() - activity->second : mTimeout;
 
     // Send the event, hoping it will arrive at the destination
-    std::shared_ptr<GoodbyeEvent> e(new GoodbyeEvent("Timeout after " + Utils::toString(diff) + " seconds."));
+    std::shared_ptr<GoodbyeEvent> e = NetworkManager::get()->createEvent<GoodbyeEvent>();
+    e->setReason("Timeout after " + Utils::toString(diff) + " seconds.");
     e->clearRecipients();
     e->addRecipient(connection);
-    // send it directly
+    // send it directly, and keep the connection until it is acknowledged
     NetworkManager::get()->queueEvent(e);
     NetworkManager::get()->sendQueuedEvents();
 
-    removeConnection(connection);
+    closeConnection(connection);
+}
+
+void ConnectionsManager::_logStats() {
+    for(auto iter = mConnections.begin(); iter != mConnections.end(); ++iter) {
+        ConnectionStats* stats = getStats(iter->first);
+        if(stats != nullptr)
+            Logger::get().debug("Connection #" + Utils::toString(iter->first) + ": " + stats->toString()
+                                + ", send rate " + Utils::toString(getSendRate(iter->first) / 1000) + " kB/s");
+    }
 }
 
 }
@@ -13,11 +13,14 @@
 
 #include <Core/Manager.hpp>
 #include <Network/Connection.hpp>
+#include <Network/NetworkChannels.hpp>
 #include <Network/PingEvent.hpp>
 #include <Utils/Timer.hpp>
 
 #include <map>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 namespace dt {
 
@@ -93,6 +96,28 @@ public:
       */
     void removeConnection(Connection c);
 
+    /**
+      * Closes a Connection. It is kept until all reliable events sent to it, such as a GoodbyeEvent, have been
+      * acknowledged, or until the linger time has passed, so they are resent if lost. It is left out of
+      * broadcasts and timeouts meanwhile.
+      * @param id The ID of the Connection to close.
+      * @see ConnectionsManager::setLingerTime
+      */
+    void closeConnection(ID_t id);
+
+    /**
+      * Returns whether a Connection is being closed.
+      * @param id The ID of the Connection.
+      * @returns True if the Connection is waiting for its last events to be acknowledged.
+      */
+    bool isClosing(ID_t id) const;
+
+    /**
+      * Removes the closing Connections whose events have all been acknowledged or whose linger time has passed.
+      * Called by NetworkManager::sendQueuedEvents.
+      */
+    void removeClosedConnections();
+
     /**
       * Returns the ID of a Connection.
       * @param c The Connection to search for.
@@ -100,6 +125,15 @@ public:
       */
     ID_t getConnectionID(Connection c);
 
+    /**
+      * Returns the ID of the Connection with the address and port given. This is a hash lookup
+      * and does not allocate.
+      * @param address The IP address of the remote device.
+      * @param port The port of the remote device.
+      * @returns The ID of the Connection or 0 if it is not known.
+      */
+    ID_t findConnectionID(const sf::IpAddress& address, uint16_t port) const;
+
     /**
       * Returns a pointer to the Connection with the ID.
       * @param id The ID to search for.
@@ -108,13 +142,33 @@ public:
     Connection::ConnectionSP getConnection(ID_t id);
 
     /**
-      * Returns a list of all Connections.
+      * Returns the channels to the Connection with the ID. They are created when the Connection
+      * is added and destroyed when it is removed.
+      * @param id The ID of the Connection.
+      * @returns The channels or nullptr if the Connection is not known.
+      */
+    NetworkChannels* getChannels(ID_t id);
+
+    /**
+      * Returns the highest ID assigned so far. All Connections have an ID between 1 and this.
+      * @returns The highest ID assigned so far.
+      */
+    ID_t getHighestID() const;
+
+    /**
+      * Returns a list of all Connections that are not being closed.
       * @returns A list of all Connections.
       */
     std::vector<Connection::ConnectionSP> getAllConnections();
 
     /**
-     * Returns the number of active connections.
+      * Fills a list with the IDs of all Connections that are not being closed. The memory of the list is reused.
+      * @param ids The list to replace the contents of.
+      */
+    void getConnectionIDs(std::vector<ID_t>& ids) const;
+
+    /**
+     * Returns the number of active connections, not counting the ones being closed.
      * @returns An int of the number of active connections.
      */
     uint16_t getConnectionCount();
@@ -143,13 +197,64 @@ public:
       */
     double getTimeout();
 
+    /**
+      * Sets the longest time a closed connection is kept for its last events to be acknowledged. Default: 1.0.
+      * @param linger_time The linger time, in seconds.
+      */
+    void setLingerTime(double linger_time);
+
+    /**
+      * Returns the longest time a closed connection is kept for its last events to be acknowledged.
+      * @returns The linger time, in seconds.
+      */
+    double getLingerTime() const;
+
     /**
       * Returns the ping of a connection.
       * @param connection The ID of the connection.
-      * @returns The ping of the connection.
+      * @returns The smoothed round-trip time of the connection, in seconds, or 0 if it has not been measured.
+      * @see ConnectionsManager::getStats
       */
     double getPing(ID_t connection);
 
+    /**
+      * Returns the measurements of the traffic with a connection: round-trip time, jitter, loss and bandwidth.
+      * They are written to the debug log with every ping.
+      * @param connection The ID of the connection.
+      * @returns The measurements, or nullptr if the connection is not known.
+      */
+    ConnectionStats* getStats(ID_t connection);
+
+    /**
+      * Sets the range the send rate to each connection is adapted in, for the existing and all new connections.
+      * Default: 8000 to 1000000.
+      * @param min_rate The lowest send rate, in bytes per second.
+      * @param max_rate The highest send rate, in bytes per second. 0 disables rate limiting.
+      * @see CongestionControl
+      */
+    void setSendRateLimits(uint32_t min_rate, uint32_t max_rate);
+
+    /**
+      * Returns the current send rate to a connection.
+      * @param connection The ID of the connection.
+      * @returns The send rate, in bytes per second, or 0 if the connection is not known.
+      */
+    uint32_t getSendRate(ID_t connection);
+
+    /**
+      * Sets the limits of the reassembly of large messages, for the existing and all new connections.
+      * @param max_bytes The most bytes of incomplete messages kept per connection. Default: 16 MB.
+      * @param timeout The time after which an incomplete message that got no new fragment is discarded, in seconds. Default: 10.
+      * @see NetworkChannels::setReassemblyLimits
+      */
+    void setReassemblyLimits(uint32_t max_bytes, double timeout);
+
+    /**
+      * Returns the most bytes of incomplete messages kept per connection.
+      * @returns The number of bytes.
+      */
+    uint32_t getMaxReassemblyBytes() const;
+
 public slots:
     void handleEvent(std::shared_ptr<dt::NetworkEvent> e);
     void timerTick(QString message, double interval);
@@ -161,6 +266,14 @@ private:
       */
     ID_t _getNewID();
 
+    /**
+      * Private method. Returns the key of an endpoint in mEndpointIDs.
+      * @param address The IP address.
+      * @param port The port.
+      * @returns The key.
+      */
+    static uint64_t _endpointKey(const sf::IpAddress& address, uint16_t port);
+
     /**
       * Private method. Sends out a PingEvent.
       */
@@ -183,10 +296,26 @@ private:
       */
     void _timeoutConnection(ID_t connection);
 
+    /**
+      * Private method. Writes the measurements of all connections to the debug log.
+      */
+    void _logStats();
+
     ID_t mMaxConnections;                                  //!< The maximum number of Connections allowed.
     std::map<ID_t, Connection::ConnectionSP> mConnections; //!< The Connections known to this manager.
-    std::map<ID_t, double> mPings;                         //!< The pings for the different Connections.
+    std::unordered_map<uint64_t, ID_t> mEndpointIDs;       //!< The IDs of the Connections by IP address and port.
+    std::vector<ID_t> mFreeIDs;                            //!< IDs of removed Connections, ready to be reused.
+    ID_t mNextID;                                          //!< The lowest ID that has never been assigned.
+    std::vector<std::unique_ptr<NetworkChannels>> mChannels; //!< The channels to the Connections, indexed by ID.
     std::map<ID_t, double> mLastActivity;                  //!< The time the connection sent the last packet.
+    std::vector<ID_t> mTimedOut;                           //!< The connections found timed out by _checkTimeouts(). Reused.
+    std::map<ID_t, double> mClosing;                       //!< The time until which the closing connections are kept.
+    std::vector<ID_t> mClosed;                             //!< The connections found done by removeClosedConnections(). Reused.
+    double mLingerTime;                                    //!< The longest time a closed connection is kept, in seconds.
+    uint32_t mMinSendRate;                                 //!< The lowest send rate to a connection, in bytes per second.
+    uint32_t mMaxSendRate;                                 //!< The highest send rate to a connection, in bytes per second, or 0.
+    uint32_t mMaxReassemblyBytes;                          //!< The most bytes of incomplete large messages kept per connection.
+    double mReassemblyTimeout;                             //!< The time after which an incomplete large message is discarded.
 
     double mTimeout;        //!< The time to wait before a connection times out. In milliseconds.
     double mPingInterval;   //!< The interval in milliseconds between two pings.
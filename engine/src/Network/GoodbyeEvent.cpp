@@ -17,6 +17,14 @@ const QString GoodbyeEvent::getType() const {
     return "DT_GOODBYEEVENT";
 }
 
+NetworkEvent::Channel GoodbyeEvent::getChannel() const {
+    return RELIABLE_ORDERED;
+}
+
+NetworkEvent::Priority GoodbyeEvent::getPriority() const {
+    return HIGH;
+}
+
 std::shared_ptr<NetworkEvent> GoodbyeEvent::clone() const {
     std::shared_ptr<NetworkEvent> ptr(new GoodbyeEvent(mReason));
     return ptr;
@@ -32,6 +32,8 @@ public:
     GoodbyeEvent(const QString reason = "");
 
     const QString getType() const;
+    Channel getChannel() const;
+    Priority getPriority() const;
     std::shared_ptr<NetworkEvent> clone() const;
     void serialize(IOPacket& p);
 
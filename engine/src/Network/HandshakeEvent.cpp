@@ -16,6 +16,14 @@ const QString HandshakeEvent::getType() const {
     return "DT_HANDSHAKEEVENT";
 }
 
+NetworkEvent::Channel HandshakeEvent::getChannel() const {
+    return RELIABLE_ORDERED;
+}
+
+NetworkEvent::Priority HandshakeEvent::getPriority() const {
+    return HIGH;
+}
+
 std::shared_ptr<NetworkEvent> HandshakeEvent::clone() const {
     std::shared_ptr<NetworkEvent> ptr(new HandshakeEvent());
     return ptr;
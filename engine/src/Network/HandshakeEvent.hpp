@@ -28,6 +28,8 @@ public:
       */
     HandshakeEvent();
     const QString getType() const;
+    Channel getChannel() const;
+    Priority getPriority() const;
     std::shared_ptr<NetworkEvent> clone() const;
     void serialize(IOPacket& p);
 };
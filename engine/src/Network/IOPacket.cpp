@@ -10,6 +10,7 @@
 
 #include <Utils/Utils.hpp>
 
+#include <QByteArray>
 #include <QUuid>
 
 namespace dt {
@@ -17,17 +18,38 @@ namespace dt {
 IOPacket::IOPacket(sf::Packet* packet, Direction direction)
     : mDirection(direction),
       mMode(BINARY),
-      mPacket(packet) {}
+      mPacket(packet),
+      mHasFailed(false) {}
+
+IOPacket::IOPacket(BitStream* stream)
+    : mDirection(stream->isWriting() ? SERIALIZE : DESERIALIZE),
+      mMode(BITS),
+      mBitStream(stream),
+      mHasFailed(false) {}
 
 IOPacket::IOPacket(YAML::Node* node)
     : mDirection(DESERIALIZE),
       mMode(TEXT),
-      mNode(node) {}
+      mNode(node),
+      mDocument(nullptr),
+      mHasFailed(false) {}
 
 IOPacket::IOPacket(YAML::Emitter* emitter)
     : mDirection(SERIALIZE),
       mMode(TEXT),
-      mEmitter(emitter) {}
+      mEmitter(emitter),
+      mDocument(nullptr),
+      mHasFailed(false) {}
+
+IOPacket::IOPacket(YamlDocument* document)
+    : mDirection(DESERIALIZE),
+      mMode(TEXT),
+      mNode(nullptr),
+      mDocument(document),
+      mEntry(document->getRoot()),
+      mCursor(YamlDocument::NO_ENTRY),
+      mHint(YamlDocument::NO_ENTRY),
+      mHasFailed(false) {}
 
 IOPacket::Mode IOPacket::getMode() const {
     return mMode;
@@ -37,6 +59,14 @@ IOPacket::Direction IOPacket::getDirection() const {
     return mDirection;
 }
 
+void IOPacket::setFailed() {
+    mHasFailed = true;
+}
+
+bool IOPacket::hasFailed() const {
+    return mHasFailed;
+}
+
 IOPacket& IOPacket::stream(EnumHelper h, QString key, uint32_t def) {
     if(mDirection == DESERIALIZE) {
         uint32_t x = 0;
@@ -51,7 +81,9 @@ IOPacket& IOPacket::stream(EnumHelper h, QString key, uint32_t def) {
 }
 
 IOPacket& IOPacket::stream(QString& s, QString key, QString def) {
-    if(mDirection == DESERIALIZE) {
+    if(mMode == BITS) {
+        mBitStream->stream(s);
+    } else if(mDirection == DESERIALIZE) {
         std::string stdstr;
         stream(stdstr, key, def.toStdString());
         s = QString(stdstr.c_str());
@@ -63,7 +95,9 @@ IOPacket& IOPacket::stream(QString& s, QString key, QString def) {
 }
 
 IOPacket& IOPacket::stream(QUuid& id, QString key, QUuid def) {
-    if(mDirection == DESERIALIZE) {
+    if(mMode == BITS) {
+        mBitStream->stream(id);
+    } else if(mDirection == DESERIALIZE) {
         std::string stdstr;
         stream(stdstr, key);
         if(stdstr == "") id = def;
@@ -75,8 +109,71 @@ IOPacket& IOPacket::stream(QUuid& id, QString key, QUuid def) {
     return *this;
 }
 
-uint32_t IOPacket::beginList(uint32_t count, QString key) {
+IOPacket& IOPacket::stream(std::vector<char>& data, QString key) {
     if(mMode == BINARY) {
+        uint32_t size = data.size();
+        stream(size, key);
+        if(mDirection == DESERIALIZE) {
+            data.resize(size);
+            for(uint32_t i = 0; i < size; ++i) {
+                int8_t byte = 0;
+                *mPacket >> byte;
+                data[i] = static_cast<char>(byte);
+            }
+        } else if(size > 0) {
+            mPacket->append(&data[0], size);
+        }
+    } else if(mMode == BITS) {
+        uint32_t size = data.size();
+        stream(size, key);
+        if(mDirection == DESERIALIZE) {
+            const char* bytes = mBitStream->skipBytes(size);
+            if(bytes == nullptr)
+                data.clear();
+            else
+                data.assign(bytes, bytes + size);
+        } else if(size > 0) {
+            mBitStream->writeBytes(&data[0], size);
+        }
+    } else {
+        QString hex;
+        if(mDirection == DESERIALIZE) {
+            stream(hex, key);
+            QByteArray bytes = QByteArray::fromHex(hex.toAscii());
+            data.assign(bytes.constData(), bytes.constData() + bytes.size());
+        } else {
+            if(data.size() > 0)
+                hex = QString(QByteArray(&data[0], data.size()).toHex());
+            stream(hex, key);
+        }
+    }
+    return *this;
+}
+
+IOPacket& IOPacket::streamRanged(int32_t& value, int32_t min, int32_t max, QString key, int32_t def) {
+    if(mMode != BITS)
+        return stream(value, key, def);
+
+    if(mDirection == DESERIALIZE)
+        value = mBitStream->readRanged(min, max);
+    else
+        mBitStream->writeRanged(value, min, max);
+    return *this;
+}
+
+IOPacket& IOPacket::streamQuantized(float& value, float min, float max, uint32_t bits, QString key, float def) {
+    if(mMode != BITS)
+        return stream(value, key, def);
+
+    if(mDirection == DESERIALIZE)
+        value = mBitStream->readQuantized(min, max, bits);
+    else
+        mBitStream->writeQuantized(value, min, max, bits);
+    return *this;
+}
+
+uint32_t IOPacket::beginList(uint32_t count, QString key) {
+    if(mMode != TEXT) {
         stream(count, "count"); // Notice: key does not matter in binary mode
     } else {
         mIndexInSequenceStack.push_back(mIndexInSequence);
@@ -84,10 +181,21 @@ uint32_t IOPacket::beginList(uint32_t count, QString key) {
         if(mDirection == SERIALIZE) {
             *mEmitter << YAML::Key << key.toStdString();
             *mEmitter << YAML::Value << YAML::BeginSeq;
+        } else if(mDocument != nullptr) {
+            mEntryStack.push_back(mEntry);
+            mCursorStack.push_back(mCursor);
+            std::string stdkey = key.toStdString();
+            mEntry = _findEntry(stdkey.c_str());
+            mHint = YamlDocument::NO_ENTRY;
+            if(mDocument->getType(mEntry) != YamlDocument::SEQUENCE)
+                mEntry = YamlDocument::NO_ENTRY;
+            mCursor = mDocument->getFirstChild(mEntry);
+            return mDocument->getSize(mEntry);
         } else {
+            // a missing list is empty
             mNodeStack.push_back(mNode);
-            mNode = &((*mNode)[key.toStdString()]);
-            return mNode->size();
+            mNode = mNode->FindValue(key.toStdString());
+            return mNode == nullptr ? 0 : mNode->size();
         }
     }
     return count;
@@ -104,6 +212,12 @@ void IOPacket::endList() {
 
         if(mDirection == SERIALIZE) {
             *mEmitter << YAML::EndSeq;
+        } else if(mDocument != nullptr) {
+            mEntry = mEntryStack.back();
+            mEntryStack.pop_back();
+            mCursor = mCursorStack.back();
+            mCursorStack.pop_back();
+            mHint = YamlDocument::NO_ENTRY;
         } else {
             mNode = mNodeStack.back();
             mNodeStack.pop_back();
@@ -115,6 +229,10 @@ void IOPacket::beginObject() {
     if(mMode == TEXT) {
         if(mDirection == SERIALIZE) {
             *mEmitter << YAML::BeginMap;
+        } else if(mDocument != nullptr) {
+            mEntryStack.push_back(mEntry);
+            mEntry = mCursor;
+            mHint = YamlDocument::NO_ENTRY;
         } else {
             mNodeStack.push_back(mNode);
             mNode = &((*mNode)[mIndexInSequence]);
@@ -126,6 +244,11 @@ void IOPacket::endObject() {
     if(mMode == TEXT) {
         if(mDirection == SERIALIZE) {
             *mEmitter << YAML::EndMap;
+        } else if(mDocument != nullptr) {
+            mEntry = mEntryStack.back();
+            mEntryStack.pop_back();
+            mCursor = mDocument->getNextSibling(mCursor);
+            mHint = YamlDocument::NO_ENTRY;
         } else {
             mNode = mNodeStack.back();
             mNodeStack.pop_back();
@@ -134,6 +257,14 @@ void IOPacket::endObject() {
     }
 }
 
+uint32_t IOPacket::_findEntry(const char* key) {
+    uint32_t entry = mDocument->find(mEntry, mDocument->getKeyId(key), mHint);
+    // the fields are usually read in the order they were written
+    if(entry != YamlDocument::NO_ENTRY)
+        mHint = mDocument->getNextSibling(entry);
+    return entry;
+}
+
 sf::Packet& operator >> (sf::Packet& packet, Ogre::Vector3& v) {
     packet >> v.x >> v.y >> v.z;
     return packet;
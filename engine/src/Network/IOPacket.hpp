@@ -11,6 +11,8 @@
 
 #include <Config.hpp>
 
+#include <Network/BitStream.hpp>
+#include <Network/YamlDocument.hpp>
 #include <Utils/EnumHelper.hpp>
 
 #include <QString>
@@ -23,6 +25,8 @@
 #include <OgreVector3.h>
 #include <OgreQuaternion.h>
 
+#include <vector>
+
 // first, declare some streaming operators
 
 namespace YAML {
@@ -48,6 +52,7 @@ sf::Packet& operator << (sf::Packet& packet, Ogre::Quaternion& q);
   * the method \b Stream to combine both serialization and deserialization in the same method. The data will
   * be read or written based on the context the IOPacket was created in.
   * @see EnumHelper
+  * @see Archive
   * @code
   * iopacket.Stream(some_variable, "key", default_value);
   * iopacket.Stream(EnumHelper(my_enum), "key", (uint32_t)MyEnum::DEFAULT_VALUE); // see EnumHelper
@@ -67,13 +72,27 @@ public:
 
     enum Mode {
         BINARY, //!< sf::Packet
-        TEXT    //!< Yaml
+        TEXT,   //!< Yaml
+        BITS    //!< BitStream
     };
 
     IOPacket(sf::Packet* packet, Direction direction = DESERIALIZE);
     IOPacket(YAML::Node* node);
     IOPacket(YAML::Emitter* emitter);
 
+    /**
+      * Text constructor for reading large documents, such as scenes, without building a tree of YAML::Nodes.
+      * The output is the same as with the YAML::Node.
+      * @param document The document to read from. Its root has to be a map.
+      */
+    IOPacket(YamlDocument* document);
+
+    /**
+      * Bit-packed constructor. The direction is that of the stream.
+      * @param stream The BitStream to read from or write to.
+      */
+    IOPacket(BitStream* stream);
+
     /**
       * Returns the mode set for this IOPacket.
       * @returns The mode set for this IOPacket.
@@ -86,6 +105,18 @@ public:
       */
     Direction getDirection() const;
 
+    /**
+      * Marks the data as unreadable from the current position on, e.g. after an object whose fields cannot
+      * be skipped. Readers have to stop when they see this.
+      */
+    void setFailed();
+
+    /**
+      * Returns whether the data has been marked as unreadable.
+      * @returns True if reading has to stop.
+      */
+    bool hasFailed() const;
+
     template <typename T>
     IOPacket& stream(T& t, QString key, T def = T()) {
         if(mMode == BINARY) {
@@ -93,12 +124,20 @@ public:
                 *mPacket >> t;
             else
                 *mPacket << t;
+        } else if(mMode == BITS) {
+            mBitStream->stream(t);
         } else {
             if(mDirection == DESERIALIZE) {
-                try {
-                    (*mNode)[key.toStdString()] >> t;
-                } catch(YAML::TypedKeyNotFound<std::string>& e) {
-                    t = def;
+                std::string stdkey = key.toStdString();
+                if(mDocument != nullptr) {
+                    if(!mDocument->read(_findEntry(stdkey.c_str()), t))
+                        t = def;
+                } else {
+                    const YAML::Node* node = mNode->FindValue(stdkey);
+                    if(node == nullptr)
+                        t = def;
+                    else
+                        *node >> t;
                 }
             } else {
                 *mEmitter << YAML::Key << key.toStdString() << YAML::Value << YAML::DoubleQuoted << t << YAML::Auto;
@@ -107,13 +146,55 @@ public:
         return *this;
     }
 
-    // TODO: try template specialization
+    IOPacket& stream(EnumHelper h, QString key = "", uint32_t def = 0);
 
-    virtual IOPacket& stream(EnumHelper h, QString key = "", uint32_t def = 0);
+    IOPacket& stream(QString& s, QString key = "", QString def = "");
 
-    virtual IOPacket& stream(QString& s, QString key = "", QString def = "");
+    IOPacket& stream(QUuid& id, QString key = "", QUuid def = QUuid());
 
-    virtual IOPacket& stream(QUuid& id, QString key = "", QUuid def = QUuid());
+    /**
+      * Streams a block of raw bytes. In text mode, the bytes are written as a hex string.
+      * @param data The bytes.
+      * @param key The key in text mode.
+      * @returns This IOPacket.
+      */
+    IOPacket& stream(std::vector<char>& data, QString key = "");
+
+    /**
+      * Streams an integer in a range. In bit-packed mode, it takes only as many bits as the range needs,
+      * in the other modes it is streamed like any integer.
+      * @param value The value. It is clamped to the range when written bit-packed.
+      * @param min The smallest possible value.
+      * @param max The largest possible value.
+      * @param key The key in text mode.
+      * @param def The default value in text mode.
+      * @returns This IOPacket.
+      */
+    IOPacket& streamRanged(int32_t& value, int32_t min, int32_t max, QString key, int32_t def = 0);
+
+    /**
+      * Streams a float quantized in a range. In bit-packed mode, it takes the given number of bits,
+      * in the other modes it is streamed like any float, without loss.
+      * @param value The value.
+      * @param min The lower end of the range.
+      * @param max The upper end of the range.
+      * @param bits The number of bits in bit-packed mode.
+      * @param key The key in text mode.
+      * @param def The default value in text mode.
+      * @returns This IOPacket.
+      * @see Quantization::quantizeFloat
+      */
+    IOPacket& streamQuantized(float& value, float min, float max, uint32_t bits, QString key, float def = 0.f);
+
+    /**
+      * Streams an object with the Archive matching the mode and direction of this IOPacket, by calling
+      * object.streamFields(archive). The mode is checked once for the object instead of once per field.
+      * Defined in Network/Archive.hpp, which has to be included to use it.
+      * @param object The object.
+      * @see Archive
+      */
+    template <typename T>
+    void dispatch(T& object);
 
     uint32_t beginList(uint32_t count, QString key);
 
@@ -124,15 +205,32 @@ public:
     void endObject();
 
 protected:
+    template <Mode M, Direction D> friend class Archive;
+
+    /**
+      * Finds the value of a key in the current map of the YamlDocument.
+      * @param key The key.
+      * @returns The entry of the value, or YamlDocument::NO_ENTRY.
+      */
+    uint32_t _findEntry(const char* key);
+
     Direction mDirection;   //!< The streaming direction.
     Mode mMode;             //!< The data mode.
 
     sf::Packet* mPacket;
+    BitStream* mBitStream;
     const YAML::Node* mNode;
     std::vector<const YAML::Node*> mNodeStack;
     int mIndexInSequence;
     std::vector<int> mIndexInSequenceStack;
     YAML::Emitter* mEmitter;
+    YamlDocument* mDocument;                //!< The document to read from, instead of mNode.
+    uint32_t mEntry;                        //!< The map or sequence of the document being read.
+    uint32_t mCursor;                       //!< The item of the sequence being read.
+    uint32_t mHint;                         //!< The value after the last one found in mEntry.
+    std::vector<uint32_t> mEntryStack;      //!< The enclosing maps and sequences.
+    std::vector<uint32_t> mCursorStack;     //!< The items being read in the enclosing sequences.
+    bool mHasFailed;                        //!< Whether the data has been marked as unreadable.
 
 };
 
@@ -0,0 +1,627 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/NetworkChannels.hpp>
+
+#include <Utils/Logger.hpp>
+#include <Utils/Utils.hpp>
+
+#include <algorithm>
+
+namespace dt {
+
+/**
+  * The number of sent datagrams remembered for acknowledgements.
+  */
+static const uint32_t SENT_DATAGRAM_BUFFER_SIZE = 256;
+
+/**
+  * How far ahead of the next expected message a reliable message may be. Messages further ahead
+  * are dropped and arrive again with a resend.
+  */
+static const uint16_t RECEIVE_WINDOW_SIZE = 1024;
+
+/**
+  * The round-trip time assumed until the first acknowledgement arrives, in seconds.
+  */
+static const double INITIAL_ROUND_TRIP_TIME = 0.1;
+
+/**
+  * The size of the datagram header, in bytes.
+  */
+static const uint32_t DATAGRAM_HEADER_SIZE = 8;
+
+/**
+  * How many datagrams sent later have to be acknowledged before an unacknowledged datagram counts as
+  * lost. Allows for some reordering, like the duplicate acknowledgement threshold in TCP.
+  */
+static const uint16_t LOSS_DISTANCE = 3;
+
+/**
+  * The default size of the fragments of large messages, in bytes. With the datagram and fragment headers,
+  * a fragment fits into a datagram of the default maximum size.
+  */
+static const uint32_t DEFAULT_FRAGMENT_SIZE = 1024;
+
+/**
+  * The most large messages being reassembled at once per connection.
+  */
+static const uint32_t MAX_REASSEMBLIES = 64;
+
+/**
+  * Appends a 16 bit integer in network byte order, as sf::Packet does.
+  */
+static void appendUint16(std::vector<char>& data, uint16_t value) {
+    data.push_back(static_cast<char>(value >> 8));
+    data.push_back(static_cast<char>(value & 0xff));
+}
+
+/**
+  * Appends a 32 bit integer in network byte order, as sf::Packet does.
+  */
+static void appendUint32(std::vector<char>& data, uint32_t value) {
+    appendUint16(data, static_cast<uint16_t>(value >> 16));
+    appendUint16(data, static_cast<uint16_t>(value & 0xffff));
+}
+
+/**
+  * Appends the channel and message ID every message starts with.
+  */
+static void appendMessagePrefix(std::vector<char>& data, NetworkEvent::Channel channel, uint16_t id, uint8_t flags = 0) {
+    data.push_back(static_cast<char>(channel | flags));
+    if(channel != NetworkEvent::UNRELIABLE)
+        appendUint16(data, id);
+}
+
+static bool isReliable(NetworkEvent::Channel channel) {
+    return channel == NetworkEvent::RELIABLE_UNORDERED || channel == NetworkEvent::RELIABLE_ORDERED;
+}
+
+NetworkChannels::NetworkChannels()
+    : mLocalSequence(0),
+      mRemoteSequence(0),
+      mReceivedBits(0),
+      mAckPending(false),
+      mSentDatagrams(SENT_DATAGRAM_BUFFER_SIZE),
+      mLastSequencedId(0),
+      mHasSequenced(false),
+      mIsWriting(false),
+      mWriteStart(0),
+      mWriteDatagram(nullptr),
+      mRoundTripTime(INITIAL_ROUND_TRIP_TIME),
+      mHasRoundTripTime(false),
+      mResentCount(0),
+      mDroppedCount(0),
+      mNewestAcked(0),
+      mHasAcked(false),
+      mLossCheckSequence(0),
+      mNextReliableKey(0),
+      mFragmentSize(DEFAULT_FRAGMENT_SIZE),
+      mNextFragmentGroup(0),
+      mReassemblyBytes(0),
+      mMaxReassemblyBytes(16 * 1024 * 1024),
+      mReassemblyTimeout(10.0),
+      mDiscardedCount(0) {
+    std::fill(mNextMessageId, mNextMessageId + 4, 0);
+    for(uint32_t i = 0; i < SENT_DATAGRAM_BUFFER_SIZE; ++i) {
+        mSentDatagrams[i].mIsValid = false;
+    }
+    for(uint32_t i = 0; i < 2; ++i) {
+        mReceiveWindows[i].mNext = 0;
+    }
+}
+
+void NetworkChannels::setFragmentSize(uint32_t size) {
+    mFragmentSize = std::max(size, 1u);
+}
+
+void NetworkChannels::setReassemblyLimits(uint32_t max_bytes, double timeout) {
+    mMaxReassemblyBytes = max_bytes;
+    mReassemblyTimeout = timeout;
+}
+
+void NetworkChannels::queueMessage(NetworkEvent::Channel channel, const char* data, uint32_t size,
+                                   NetworkEvent::Priority priority, bool is_compressed) {
+    uint32_t count = (size + mFragmentSize - 1) / mFragmentSize;
+    if(count > 0xffff) {
+        Logger::get().error("NetworkChannels: A message of " + Utils::toString(size) + " bytes is too large to be sent.");
+        return;
+    }
+
+    uint16_t id = (channel != NetworkEvent::UNRELIABLE) ? mNextMessageId[channel]++ : 0;
+    uint8_t flags = is_compressed ? COMPRESSED_FLAG : 0;
+    if(size <= mFragmentSize) {
+        mHeader.clear();
+        appendMessagePrefix(mHeader, channel, id, flags);
+        // read back like a string from an sf::Packet
+        appendUint32(mHeader, size);
+        _queue(channel, id, priority, mHeader, data, size);
+        return;
+    }
+
+    // too large for a datagram: every fragment is sent as a message of its own, with the ID of the whole message
+    uint16_t group = mNextFragmentGroup++;
+    for(uint32_t index = 0; index < count; ++index) {
+        uint32_t offset = index * mFragmentSize;
+        uint32_t fragment_size = std::min(mFragmentSize, size - offset);
+
+        mHeader.clear();
+        appendMessagePrefix(mHeader, channel, id, flags | FRAGMENT_FLAG);
+        appendUint16(mHeader, group);
+        appendUint16(mHeader, static_cast<uint16_t>(index));
+        appendUint16(mHeader, static_cast<uint16_t>(count));
+        // the data is read back like a string from an sf::Packet
+        appendUint32(mHeader, fragment_size);
+        _queue(channel, id, priority, mHeader, data + offset, fragment_size);
+    }
+}
+
+void NetworkChannels::writeDatagrams(double time, uint32_t max_size, std::vector<char>& data, std::vector<uint32_t>& ends) {
+    mStats.update(time);
+    mCongestionControl.update(time, mRoundTripTime);
+    _expireReassemblies(time);
+
+    // by priority, and within one the reliable messages first, new ones and those not acknowledged in time
+    double timeout = _getResendTimeout();
+    for(int32_t priority = NetworkEvent::HIGH; priority >= NetworkEvent::LOW; --priority) {
+        for(auto iter = mReliableMessages.begin(); iter != mReliableMessages.end(); ++iter) {
+            if(iter->mIsAcked || iter->mPriority != priority)
+                continue;
+
+            if(iter->mLastSent >= 0 && time - iter->mLastSent < timeout)
+                continue;
+
+            if(!mCongestionControl.canSend())
+                break;
+
+            if(iter->mLastSent >= 0)
+                ++mResentCount;
+
+            _appendMessage(&iter->mData[0], iter->mData.size(), time, max_size, data, ends);
+            mWriteDatagram->mMessages.push_back(iter->mKey);
+            iter->mLastSent = time;
+        }
+
+        uint32_t start = 0;
+        for(auto iter = mUnreliableMessages.begin(); iter != mUnreliableMessages.end(); ++iter) {
+            if(iter->mPriority == priority && mCongestionControl.canSend()) {
+                _appendMessage(&mUnreliableData[start], iter->mEnd - start, time, max_size, data, ends);
+                iter->mIsSent = true;
+            }
+            start = iter->mEnd;
+        }
+    }
+    _deferUnreliable();
+
+    // acknowledge received datagrams even if there is nothing to send
+    if(!mIsWriting && mAckPending)
+        _beginDatagram(time, data);
+
+    if(mIsWriting)
+        _endDatagram(data, ends);
+}
+
+bool NetworkChannels::readHeader(sf::Packet& packet, double time) {
+    uint16_t sequence = 0;
+    uint16_t ack = 0;
+    uint32_t ack_bits = 0;
+    if(!(packet >> sequence >> ack >> ack_bits))
+        return false;
+
+    // bit i acknowledges the datagram ack - i
+    for(uint16_t i = 0; i < 32; ++i) {
+        if(ack_bits & (1u << i))
+            _ack(ack - i, time);
+    }
+    _detectLosses(time);
+
+    // drop the acknowledged messages at the front
+    while(!mReliableMessages.empty() && mReliableMessages.front().mIsAcked) {
+        mReliableMessages.pop_front();
+    }
+
+    if(mReceivedBits == 0) {
+        // first datagram
+        mRemoteSequence = sequence;
+        mReceivedBits = 1;
+        mStats.addExpected(1);
+    } else if(isNewer(sequence, mRemoteSequence)) {
+        uint16_t shift = sequence - mRemoteSequence;
+        mReceivedBits = (shift < 32) ? (mReceivedBits << shift) | 1 : 1;
+        mRemoteSequence = sequence;
+        // the datagrams skipped are lost, unless they arrive late
+        mStats.addExpected(shift);
+    } else {
+        uint16_t distance = mRemoteSequence - sequence;
+        if(distance >= 32) {
+            // too old to be acknowledged, reliable messages in it will be resent anyway
+            return false;
+        }
+
+        uint32_t bit = 1u << distance;
+        if(mReceivedBits & bit) {
+            // duplicate
+            return false;
+        }
+        mReceivedBits |= bit;
+    }
+    mStats.addReceived(packet.getDataSize());
+
+    // datagrams without messages are not acknowledged, or the acknowledgements would never stop
+    if(!packet.endOfPacket())
+        mAckPending = true;
+
+    return true;
+}
+
+bool NetworkChannels::receiveMessage(NetworkEvent::Channel channel, uint16_t id, std::shared_ptr<NetworkEvent> event) {
+    switch(channel) {
+    case NetworkEvent::UNRELIABLE:
+        return true;
+
+    case NetworkEvent::UNRELIABLE_SEQUENCED:
+        if(mHasSequenced && !isNewer(id, mLastSequencedId))
+            return false;
+        mHasSequenced = true;
+        mLastSequencedId = id;
+        return true;
+
+    case NetworkEvent::RELIABLE_UNORDERED:
+    case NetworkEvent::RELIABLE_ORDERED: {
+        ReceiveWindow& window = mReceiveWindows[channel - NetworkEvent::RELIABLE_UNORDERED];
+
+        // already handled or too far ahead
+        uint16_t distance = id - window.mNext;
+        if(distance >= RECEIVE_WINDOW_SIZE)
+            return false;
+
+        if(window.mPending.count(id) > 0)
+            return false;
+
+        if(channel == NetworkEvent::RELIABLE_ORDERED) {
+            if(distance != 0) {
+                // wait for the messages before
+                window.mPending[id] = event;
+                return false;
+            }
+            ++window.mNext;
+            return true;
+        }
+
+        // unordered: handle right away, just remember the ID
+        if(distance != 0) {
+            window.mPending[id] = nullptr;
+        } else {
+            ++window.mNext;
+            auto iter = window.mPending.find(window.mNext);
+            while(iter != window.mPending.end()) {
+                window.mPending.erase(iter);
+                iter = window.mPending.find(++window.mNext);
+            }
+        }
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+const std::vector<char>* NetworkChannels::receiveFragment(NetworkEvent::Channel channel, uint16_t id, uint16_t group,
+                                                          uint16_t index, uint16_t count, std::string& data, double time) {
+    if(index >= count || data.empty() || _isHandled(channel, id))
+        return nullptr;
+
+    auto iter = mReassemblies.find(group);
+    if(iter != mReassemblies.end() && (iter->second.mChannel != channel || iter->second.mId != id
+                                       || iter->second.mFragments.size() != count)) {
+        // a leftover of an earlier message with the same number
+        mReassemblyBytes -= iter->second.mCost;
+        mReassemblies.erase(iter);
+        ++mDiscardedCount;
+        iter = mReassemblies.end();
+    }
+
+    if(iter == mReassemblies.end()) {
+        // the count comes from the remote device, so check it before allocating the fragments
+        uint32_t cost = sizeof(Reassembly) + count * sizeof(std::string);
+        if(count > mMaxReassemblyBytes / mFragmentSize + 1 || mReassemblyBytes + cost > mMaxReassemblyBytes
+           || mReassemblies.size() >= MAX_REASSEMBLIES) {
+            // not an error, as forged headers would flood the log
+            Logger::get().debug("NetworkChannels: Discarding a large message of " + Utils::toString(count)
+                                + " fragments, it does not fit into the reassembly buffers.");
+            ++mDiscardedCount;
+            return nullptr;
+        }
+
+        iter = mReassemblies.insert(std::make_pair(group, Reassembly())).first;
+        Reassembly& reassembly = iter->second;
+        reassembly.mChannel = channel;
+        reassembly.mId = id;
+        reassembly.mFragments.resize(count);
+        reassembly.mReceivedCount = 0;
+        reassembly.mSize = 0;
+        reassembly.mCost = cost;
+        mReassemblyBytes += cost;
+    }
+
+    Reassembly& reassembly = iter->second;
+    if(!reassembly.mFragments[index].empty())
+        return nullptr;
+
+    if(mReassemblyBytes + data.size() > mMaxReassemblyBytes) {
+        Logger::get().error("NetworkChannels: Discarding a large message, the reassembly buffers are full.");
+        mReassemblyBytes -= reassembly.mCost;
+        mReassemblies.erase(iter);
+        ++mDiscardedCount;
+        return nullptr;
+    }
+
+    reassembly.mSize += data.size();
+    reassembly.mCost += data.size();
+    reassembly.mLastReceived = time;
+    mReassemblyBytes += data.size();
+    reassembly.mFragments[index].swap(data);
+    if(++reassembly.mReceivedCount < count)
+        return nullptr;
+
+    mAssembled.clear();
+    mAssembled.reserve(reassembly.mSize);
+    for(auto fragment = reassembly.mFragments.begin(); fragment != reassembly.mFragments.end(); ++fragment) {
+        mAssembled.insert(mAssembled.end(), fragment->begin(), fragment->end());
+    }
+    mReassemblyBytes -= reassembly.mCost;
+    mReassemblies.erase(iter);
+    return &mAssembled;
+}
+
+std::shared_ptr<NetworkEvent> NetworkChannels::popOrderedEvent() {
+    ReceiveWindow& window = mReceiveWindows[NetworkEvent::RELIABLE_ORDERED - NetworkEvent::RELIABLE_UNORDERED];
+    std::shared_ptr<NetworkEvent> event;
+    while(event == nullptr) {
+        auto iter = window.mPending.find(window.mNext);
+        if(iter == window.mPending.end())
+            return nullptr;
+
+        // messages that could not be decoded are skipped
+        event = iter->second;
+        window.mPending.erase(iter);
+        ++window.mNext;
+    }
+    return event;
+}
+
+double NetworkChannels::getRoundTripTime() const {
+    return mRoundTripTime;
+}
+
+uint32_t NetworkChannels::getUnackedCount() const {
+    uint32_t count = 0;
+    for(auto iter = mReliableMessages.begin(); iter != mReliableMessages.end(); ++iter) {
+        if(!iter->mIsAcked)
+            ++count;
+    }
+    return count;
+}
+
+uint64_t NetworkChannels::getResentCount() const {
+    return mResentCount;
+}
+
+ConnectionStats& NetworkChannels::getStats() {
+    return mStats;
+}
+
+CongestionControl& NetworkChannels::getCongestionControl() {
+    return mCongestionControl;
+}
+
+uint64_t NetworkChannels::getDroppedCount() const {
+    return mDroppedCount;
+}
+
+uint32_t NetworkChannels::getReassemblyBytes() const {
+    return mReassemblyBytes;
+}
+
+uint32_t NetworkChannels::getReassemblyCount() const {
+    return mReassemblies.size();
+}
+
+uint64_t NetworkChannels::getDiscardedCount() const {
+    return mDiscardedCount;
+}
+
+bool NetworkChannels::isNewer(uint16_t a, uint16_t b) {
+    return ((a > b) && (a - b <= 32768)) || ((a < b) && (b - a > 32768));
+}
+
+void NetworkChannels::_queue(NetworkEvent::Channel channel, uint16_t id, NetworkEvent::Priority priority,
+                             const std::vector<char>& header, const char* data, uint32_t size) {
+    if(isReliable(channel)) {
+        mReliableMessages.push_back(ReliableMessage());
+        ReliableMessage& message = mReliableMessages.back();
+        message.mChannel = channel;
+        message.mPriority = priority;
+        message.mId = id;
+        message.mKey = mNextReliableKey++;
+        message.mLastSent = -1.0;
+        message.mIsAcked = false;
+        message.mData.reserve(header.size() + size);
+        message.mData.assign(header.begin(), header.end());
+        message.mData.insert(message.mData.end(), data, data + size);
+    } else {
+        mUnreliableData.insert(mUnreliableData.end(), header.begin(), header.end());
+        mUnreliableData.insert(mUnreliableData.end(), data, data + size);
+
+        UnreliableMessage message;
+        message.mEnd = mUnreliableData.size();
+        message.mPriority = priority;
+        message.mIsSent = false;
+        message.mIsDeferred = false;
+        mUnreliableMessages.push_back(message);
+    }
+}
+
+bool NetworkChannels::_isHandled(NetworkEvent::Channel channel, uint16_t id) const {
+    switch(channel) {
+    case NetworkEvent::UNRELIABLE_SEQUENCED:
+        return mHasSequenced && !isNewer(id, mLastSequencedId);
+
+    case NetworkEvent::RELIABLE_UNORDERED:
+    case NetworkEvent::RELIABLE_ORDERED: {
+        const ReceiveWindow& window = mReceiveWindows[channel - NetworkEvent::RELIABLE_UNORDERED];
+        uint16_t distance = id - window.mNext;
+        return distance >= RECEIVE_WINDOW_SIZE || window.mPending.count(id) > 0;
+    }
+
+    default:
+        return false;
+    }
+}
+
+void NetworkChannels::_expireReassemblies(double time) {
+    for(auto iter = mReassemblies.begin(); iter != mReassemblies.end();) {
+        if(time - iter->second.mLastReceived > mReassemblyTimeout) {
+            mReassemblyBytes -= iter->second.mCost;
+            mReassemblies.erase(iter++);
+            ++mDiscardedCount;
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void NetworkChannels::_appendMessage(const char* message, uint32_t size, double time, uint32_t max_size,
+                                     std::vector<char>& data, std::vector<uint32_t>& ends) {
+    if(mIsWriting && data.size() - mWriteStart + size > max_size)
+        _endDatagram(data, ends);
+
+    if(!mIsWriting)
+        _beginDatagram(time, data);
+
+    data.insert(data.end(), message, message + size);
+    mWriteDatagram->mHasMessages = true;
+    mCongestionControl.consume(size);
+}
+
+void NetworkChannels::_beginDatagram(double time, std::vector<char>& data) {
+    uint16_t sequence = mLocalSequence++;
+
+    SentDatagram& datagram = mSentDatagrams[sequence % SENT_DATAGRAM_BUFFER_SIZE];
+    datagram.mSequence = sequence;
+    datagram.mIsValid = true;
+    datagram.mIsAcked = false;
+    datagram.mHasMessages = false;
+    datagram.mTime = time;
+    datagram.mMessages.clear();
+
+    mIsWriting = true;
+    mWriteStart = data.size();
+    mWriteDatagram = &datagram;
+
+    appendUint16(data, sequence);
+    appendUint16(data, mRemoteSequence);
+    appendUint32(data, mReceivedBits);
+    mAckPending = false;
+    mCongestionControl.consume(DATAGRAM_HEADER_SIZE);
+}
+
+void NetworkChannels::_endDatagram(std::vector<char>& data, std::vector<uint32_t>& ends) {
+    mStats.addSent(data.size() - mWriteStart);
+    ends.push_back(data.size());
+    mIsWriting = false;
+    mWriteDatagram = nullptr;
+}
+
+void NetworkChannels::_ack(uint16_t sequence, double time) {
+    SentDatagram& datagram = mSentDatagrams[sequence % SENT_DATAGRAM_BUFFER_SIZE];
+    if(!datagram.mIsValid || datagram.mSequence != sequence || datagram.mIsAcked)
+        return;
+
+    datagram.mIsAcked = true;
+    if(datagram.mHasMessages)
+        mStats.addDelivered();
+    if(!mHasAcked || isNewer(sequence, mNewestAcked)) {
+        mNewestAcked = sequence;
+        mHasAcked = true;
+    }
+
+    // datagrams without messages are only acknowledged when the remote device sends something anyway
+    if(datagram.mHasMessages) {
+        double sample = time - datagram.mTime;
+        if(mHasRoundTripTime) {
+            mRoundTripTime += (sample - mRoundTripTime) * 0.1;
+        } else {
+            mRoundTripTime = sample;
+            mHasRoundTripTime = true;
+        }
+    }
+
+    // the messages are ordered by key, which matters with the many fragments of a large message
+    for(auto key = datagram.mMessages.begin(); key != datagram.mMessages.end(); ++key) {
+        auto iter = std::lower_bound(mReliableMessages.begin(), mReliableMessages.end(), *key,
+                                     [] (const ReliableMessage& message, uint32_t k) { return message.mKey < k; });
+        if(iter != mReliableMessages.end() && iter->mKey == *key)
+            iter->mIsAcked = true;
+    }
+}
+
+void NetworkChannels::_detectLosses(double time) {
+    if(!mHasAcked)
+        return;
+
+    while(true) {
+        uint16_t distance = mNewestAcked - mLossCheckSequence;
+        if(distance < LOSS_DISTANCE || distance >= 32768)
+            break;
+
+        if(distance >= SENT_DATAGRAM_BUFFER_SIZE) {
+            // the records are gone, skip to the oldest one left
+            mLossCheckSequence = static_cast<uint16_t>(mNewestAcked - SENT_DATAGRAM_BUFFER_SIZE + 1);
+            continue;
+        }
+
+        const SentDatagram& datagram = mSentDatagrams[mLossCheckSequence % SENT_DATAGRAM_BUFFER_SIZE];
+        if(datagram.mIsValid && datagram.mSequence == mLossCheckSequence && datagram.mHasMessages && !datagram.mIsAcked) {
+            mStats.addLost();
+            mCongestionControl.onLoss(time);
+        }
+        ++mLossCheckSequence;
+    }
+}
+
+void NetworkChannels::_deferUnreliable() {
+    mDeferredData.clear();
+    uint32_t start = 0;
+    uint32_t kept = 0;
+    for(auto iter = mUnreliableMessages.begin(); iter != mUnreliableMessages.end(); ++iter) {
+        uint32_t end = iter->mEnd;
+        if(!iter->mIsSent) {
+            if(iter->mIsDeferred || iter->mPriority == NetworkEvent::LOW) {
+                ++mDroppedCount;
+            } else {
+                mDeferredData.insert(mDeferredData.end(), mUnreliableData.begin() + start, mUnreliableData.begin() + end);
+                UnreliableMessage& message = mUnreliableMessages[kept++];
+                message.mEnd = mDeferredData.size();
+                message.mPriority = iter->mPriority;
+                message.mIsSent = false;
+                message.mIsDeferred = true;
+            }
+        }
+        start = end;
+    }
+    mUnreliableMessages.resize(kept);
+    mUnreliableData.swap(mDeferredData);
+}
+
+double NetworkChannels::_getResendTimeout() const {
+    return std::min(std::max(2.0 * mRoundTripTime, 0.05), 1.0);
+}
+
+}
@@ -0,0 +1,381 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_NETWORKCHANNELS
+#define DUCTTAPE_ENGINE_NETWORK_NETWORKCHANNELS
+
+#include <Config.hpp>
+
+#include <Network/CongestionControl.hpp>
+#include <Network/ConnectionStats.hpp>
+#include <Network/NetworkEvent.hpp>
+
+#include <SFML/Network/Packet.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dt {
+
+/**
+  * The channels to one remote device. Every datagram starts with a header holding its sequence number,
+  * the sequence number of the latest datagram received from the remote device and a bitfield of the
+  * 32 datagrams received before, so every datagram acknowledges the ones received recently. Each event
+  * in a datagram is prefixed with its channel, a message ID except on the unreliable channel, and its size,
+  * so an event the receiver cannot decode does not take the events after it down with it.
+  * Reliable messages are kept and resent until a datagram containing them has been acknowledged.
+  * Messages larger than the fragment size are split into fragments that are sent like messages of their own,
+  * so a large message is spread over as many writeDatagrams() as the send rate needs. The receiver puts
+  * the fragments back together in a reassembly buffer. Buffers that get no fragment for a while are
+  * discarded, and so are messages that would take the buffered data of a connection beyond a memory cap.
+  * The bookkeeping of a buffer counts towards the cap as well, and the number of buffers is limited, so
+  * forged fragment headers cannot make the receiver allocate more than the cap.
+  * @see NetworkEvent::Channel
+  */
+class DUCTTAPE_API NetworkChannels {
+public:
+    /**
+      * Set in the channel byte of a fragment of a large message.
+      */
+    static const uint8_t FRAGMENT_FLAG = 0x80;
+
+    /**
+      * Set in the channel byte of a compressed message, or of all fragments of one.
+      */
+    static const uint8_t COMPRESSED_FLAG = 0x40;
+
+    /**
+      * Default constructor.
+      */
+    NetworkChannels();
+
+    /**
+      * Sets the size of the fragments large messages are split into. Should leave room for the datagram
+      * header and the fragment header within the maximum datagram size. Both ends should use the same size,
+      * as messages of more fragments than the memory cap holds at this size are rejected.
+      * @param size The size of a fragment, in bytes. Default: 1024.
+      */
+    void setFragmentSize(uint32_t size);
+
+    /**
+      * Sets the limits of the reassembly of large messages.
+      * @param max_bytes The most bytes of incomplete messages kept. Default: 16 MB.
+      * @param timeout The time after which an incomplete message that got no new fragment is discarded, in seconds. Default: 10.
+      */
+    void setReassemblyLimits(uint32_t max_bytes, double timeout);
+
+    /**
+      * Queues a message to be sent with the next call of writeDatagrams().
+      * @param channel The channel to send the message on.
+      * @param data The serialized event.
+      * @param size The size of the serialized event, in bytes.
+      * @param priority The priority of the event under congestion.
+      * @param is_compressed Whether the data is a frame written by a Compressor.
+      */
+    void queueMessage(NetworkEvent::Channel channel, const char* data, uint32_t size,
+                      NetworkEvent::Priority priority = NetworkEvent::NORMAL, bool is_compressed = false);
+
+    /**
+      * Packs the queued messages and the reliable messages due for a resend into datagrams. If there is
+      * nothing to send, but received datagrams have to be acknowledged, a datagram without messages is written.
+      * Messages are written by priority as long as the send rate allows. Reliable messages that do not fit wait
+      * for the next call, unreliable ones get one more chance, unreliable low-priority messages are dropped.
+      * @param time The current time, in seconds.
+      * @param max_size The maximum size of a datagram, in bytes. Larger messages get a datagram of their own.
+      * @param data The buffer to append the datagrams to.
+      * @param ends The offsets in data at which the written datagrams end are appended to this list.
+      */
+    void writeDatagrams(double time, uint32_t max_size, std::vector<char>& data, std::vector<uint32_t>& ends);
+
+    /**
+      * Reads the header of a received datagram and processes the acknowledgements in it.
+      * @param packet The packet holding the datagram. The header is read from it.
+      * @param time The current time, in seconds.
+      * @returns False if the datagram is a duplicate, too old or malformed and should be dropped.
+      */
+    bool readHeader(sf::Packet& packet, double time);
+
+    /**
+      * Decides what to do with a received message.
+      * @param channel The channel the message was sent on.
+      * @param id The message ID read from the datagram.
+      * @param event The deserialized event, or nullptr if the message could not be decoded. Its ID is used up
+      * anyway, so the reliable channels do not wait for it forever.
+      * @returns True if the event should be handled now. Reliable-ordered events that arrive early are
+      * kept and returned by popOrderedEvent() once the events before them arrived.
+      */
+    bool receiveMessage(NetworkEvent::Channel channel, uint16_t id, std::shared_ptr<NetworkEvent> event);
+
+    /**
+      * Adds a received fragment of a large message to its reassembly buffer.
+      * @param channel The channel the message was sent on.
+      * @param id The message ID read from the datagram.
+      * @param group The number of the fragmented message.
+      * @param index The index of the fragment.
+      * @param count The number of fragments of the message.
+      * @param data The data of the fragment. It is swapped into the buffer, so it may be left empty.
+      * @param time The current time, in seconds.
+      * @returns The message, once all its fragments arrived, or nullptr. It stays valid until the next call.
+      */
+    const std::vector<char>* receiveFragment(NetworkEvent::Channel channel, uint16_t id, uint16_t group, uint16_t index,
+                                             uint16_t count, std::string& data, double time);
+
+    /**
+      * Returns the next reliable-ordered event that can be handled now.
+      * @returns The event, or nullptr if the next one has not arrived yet.
+      */
+    std::shared_ptr<NetworkEvent> popOrderedEvent();
+
+    /**
+      * Returns the smoothed round-trip time measured from the acknowledgements.
+      * @returns The round-trip time, in seconds.
+      */
+    double getRoundTripTime() const;
+
+    /**
+      * Returns the number of reliable messages waiting to be acknowledged.
+      * @returns The number of unacknowledged reliable messages.
+      */
+    uint32_t getUnackedCount() const;
+
+    /**
+      * Returns the number of times a reliable message has been resent.
+      * @returns The number of resends.
+      */
+    uint64_t getResentCount() const;
+
+    /**
+      * Returns the measurements of the traffic through these channels. The bytes and datagrams are counted
+      * here, the round-trip times are added by the ConnectionsManager from the pings.
+      * @returns The measurements.
+      */
+    ConnectionStats& getStats();
+
+    /**
+      * Returns the send rate control of these channels, e.g. to change its limits.
+      * @returns The congestion control.
+      */
+    CongestionControl& getCongestionControl();
+
+    /**
+      * Returns the number of unreliable messages dropped because the send rate was used up.
+      * @returns The number of dropped messages.
+      */
+    uint64_t getDroppedCount() const;
+
+    /**
+      * Returns the number of bytes of incomplete large messages in the reassembly buffers.
+      * @returns The number of bytes.
+      */
+    uint32_t getReassemblyBytes() const;
+
+    /**
+      * Returns the number of incomplete large messages in the reassembly buffers.
+      * @returns The number of messages.
+      */
+    uint32_t getReassemblyCount() const;
+
+    /**
+      * Returns the number of incomplete large messages discarded, because they timed out, exceeded the memory cap
+      * or had invalid fragment headers.
+      * @returns The number of discarded messages.
+      */
+    uint64_t getDiscardedCount() const;
+
+    /**
+      * Returns whether a sequence number is newer than another one, taking the wrap-around into account.
+      * @param a The sequence number to check.
+      * @param b The sequence number to compare with.
+      * @returns True if a is newer than b.
+      */
+    static bool isNewer(uint16_t a, uint16_t b);
+
+private:
+    /**
+      * A reliable message waiting to be acknowledged.
+      */
+    struct ReliableMessage {
+        std::vector<char> mData;    //!< The message or fragment, including the channel and ID.
+        uint8_t mChannel;           //!< The channel.
+        uint8_t mPriority;          //!< The priority, see NetworkEvent::Priority.
+        uint16_t mId;               //!< The message ID. The fragments of a message share it.
+        uint32_t mKey;              //!< Identifies the message in the records of sent datagrams. Increases with every message.
+        double mLastSent;           //!< The time the message was last sent, or -1 if it has not been sent yet.
+        bool mIsAcked;              //!< Whether a datagram containing the message has been acknowledged.
+    };
+
+    /**
+      * The record of a sent datagram.
+      */
+    struct SentDatagram {
+        uint16_t mSequence;                 //!< The sequence number of the datagram.
+        bool mIsValid;                      //!< Whether the record is in use.
+        bool mIsAcked;                      //!< Whether the datagram has been acknowledged.
+        bool mHasMessages;                  //!< Whether the datagram holds messages. Only those are acknowledged for sure.
+        double mTime;                       //!< The time the datagram was sent.
+        std::vector<uint32_t> mMessages;    //!< The keys of the reliable messages in the datagram.
+    };
+
+    /**
+      * A queued unreliable message. The message itself is in mUnreliableData.
+      */
+    struct UnreliableMessage {
+        uint32_t mEnd;              //!< The offset in mUnreliableData at which the message ends.
+        uint8_t mPriority;          //!< The priority, see NetworkEvent::Priority.
+        bool mIsSent;               //!< Whether the message has been written by the current writeDatagrams().
+        bool mIsDeferred;           //!< Whether the message already waited for one writeDatagrams().
+    };
+
+    /**
+      * The receiving state of a reliable channel.
+      */
+    struct ReceiveWindow {
+        uint16_t mNext;                                                 //!< The ID of the next message expected.
+        std::map<uint16_t, std::shared_ptr<NetworkEvent>> mPending;     //!< The messages received ahead of mNext.
+    };
+
+    /**
+      * A large message being put back together.
+      */
+    struct Reassembly {
+        uint8_t mChannel;                           //!< The channel.
+        uint16_t mId;                               //!< The message ID.
+        std::vector<std::string> mFragments;        //!< The fragments, empty if missing.
+        uint16_t mReceivedCount;                    //!< The number of fragments received.
+        uint32_t mSize;                             //!< The number of bytes received.
+        uint32_t mCost;                             //!< The bytes counted towards the memory cap, including the bookkeeping.
+        double mLastReceived;                       //!< The time the last fragment arrived.
+    };
+
+    /**
+      * Private method. Queues a message or a fragment.
+      * @param channel The channel.
+      * @param id The message ID.
+      * @param priority The priority.
+      * @param header The channel byte and the headers.
+      * @param data The data.
+      * @param size The size of the data, in bytes.
+      */
+    void _queue(NetworkEvent::Channel channel, uint16_t id, NetworkEvent::Priority priority,
+                const std::vector<char>& header, const char* data, uint32_t size);
+
+    /**
+      * Private method. Returns whether a message has been handled already, so its fragments can be dropped.
+      * @param channel The channel.
+      * @param id The message ID.
+      * @returns True if the message has been handled or would be dropped.
+      */
+    bool _isHandled(NetworkEvent::Channel channel, uint16_t id) const;
+
+    /**
+      * Private method. Discards the incomplete messages that got no fragment within the timeout.
+      * @param time The current time, in seconds.
+      */
+    void _expireReassemblies(double time);
+
+    /**
+      * Private method. Appends a message to the datagram being written, starting a new one if needed.
+      * @param message The message.
+      * @param size The size of the message, in bytes.
+      * @param time The current time, in seconds.
+      * @param max_size The maximum size of a datagram, in bytes.
+      * @param data The buffer the datagrams are written to.
+      * @param ends The list of datagram ends.
+      */
+    void _appendMessage(const char* message, uint32_t size, double time, uint32_t max_size,
+                        std::vector<char>& data, std::vector<uint32_t>& ends);
+
+    /**
+      * Private method. Starts a new datagram and writes its header.
+      * @param time The current time, in seconds.
+      * @param data The buffer the datagrams are written to.
+      */
+    void _beginDatagram(double time, std::vector<char>& data);
+
+    /**
+      * Private method. Ends the datagram being written.
+      * @param data The buffer the datagrams are written to.
+      * @param ends The list of datagram ends.
+      */
+    void _endDatagram(std::vector<char>& data, std::vector<uint32_t>& ends);
+
+    /**
+      * Private method. Marks a sent datagram and the reliable messages in it as acknowledged.
+      * @param sequence The sequence number of the datagram.
+      * @param time The current time, in seconds.
+      */
+    void _ack(uint16_t sequence, double time);
+
+    /**
+      * Private method. Counts the datagrams with messages that were not acknowledged, although datagrams sent
+      * after them were, as lost, and tells the congestion control.
+      * @param time The current time, in seconds.
+      */
+    void _detectLosses(double time);
+
+    /**
+      * Private method. Removes the unreliable messages written, and keeps the others for one more
+      * writeDatagrams(), except for those of low priority.
+      */
+    void _deferUnreliable();
+
+    /**
+      * Private method. Returns the time to wait for an acknowledgement before resending a reliable message.
+      * @returns The resend timeout, in seconds.
+      */
+    double _getResendTimeout() const;
+
+    uint16_t mLocalSequence;                        //!< The sequence number of the next datagram sent.
+    uint16_t mRemoteSequence;                       //!< The sequence number of the latest datagram received.
+    uint32_t mReceivedBits;                         //!< Bit i is set if datagram mRemoteSequence - i has been received.
+    bool mAckPending;                               //!< Whether received datagrams have to be acknowledged.
+
+    uint16_t mNextMessageId[4];                     //!< The ID of the next message sent, per channel.
+    std::deque<ReliableMessage> mReliableMessages;  //!< The reliable messages waiting to be acknowledged, oldest first.
+    std::vector<char> mUnreliableData;              //!< The queued unreliable messages, back to back.
+    std::vector<UnreliableMessage> mUnreliableMessages; //!< The queued unreliable messages.
+    std::vector<char> mDeferredData;                //!< The unreliable messages kept by _deferUnreliable(). Reused.
+    std::vector<SentDatagram> mSentDatagrams;       //!< The records of the datagrams sent recently, indexed by sequence.
+
+    ReceiveWindow mReceiveWindows[2];               //!< The receiving state of the two reliable channels.
+    uint16_t mLastSequencedId;                      //!< The ID of the latest unreliable-sequenced message handled.
+    bool mHasSequenced;                             //!< Whether an unreliable-sequenced message has been handled.
+
+    bool mIsWriting;                                //!< Whether a datagram is being written.
+    uint32_t mWriteStart;                           //!< The offset of the datagram being written.
+    SentDatagram* mWriteDatagram;                   //!< The record of the datagram being written.
+
+    double mRoundTripTime;                          //!< The smoothed round-trip time, in seconds.
+    bool mHasRoundTripTime;                         //!< Whether the round-trip time has been measured.
+    uint64_t mResentCount;                          //!< The number of resent reliable messages.
+    ConnectionStats mStats;                         //!< The measurements of the traffic.
+    CongestionControl mCongestionControl;           //!< The send rate control.
+    uint64_t mDroppedCount;                         //!< The number of unreliable messages dropped under congestion.
+    uint16_t mNewestAcked;                          //!< The sequence number of the newest datagram acknowledged.
+    bool mHasAcked;                                 //!< Whether a datagram has been acknowledged.
+    uint16_t mLossCheckSequence;                    //!< The sequence number of the next datagram to check for loss.
+
+    uint32_t mNextReliableKey;                      //!< The key of the next reliable message queued.
+    uint32_t mFragmentSize;                         //!< The size of the fragments large messages are split into.
+    uint16_t mNextFragmentGroup;                    //!< The number of the next fragmented message sent.
+    std::vector<char> mHeader;                      //!< The headers of the message being queued. Reused.
+    std::map<uint16_t, Reassembly> mReassemblies;   //!< The large messages being put back together, by number.
+    uint32_t mReassemblyBytes;                      //!< The number of bytes in the reassembly buffers.
+    uint32_t mMaxReassemblyBytes;                   //!< The most bytes kept in the reassembly buffers.
+    double mReassemblyTimeout;                      //!< The time after which an incomplete message is discarded.
+    std::vector<char> mAssembled;                   //!< The message reassembled last. Reused.
+    uint64_t mDiscardedCount;                       //!< The number of incomplete messages discarded.
+};
+
+}
+
+#endif
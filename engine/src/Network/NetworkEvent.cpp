@@ -15,24 +15,33 @@
 namespace dt {
 
 NetworkEvent::NetworkEvent()
-    : mSenderID(false),
-     mIsLocalEvent(false) {
+    : mSenderID(0),
+      mIsLocalEvent(false),
+      mTypeId(0),
+      mReceiveTime(0.0) {
 
     // add default recipients
-    const std::vector<Connection::ConnectionSP>&& connections = ConnectionsManager::get()->getAllConnections();
-    for(auto iter = connections.begin(); iter != connections.end(); ++iter) {
-        addRecipient(ConnectionsManager::get()->getConnectionID(**iter));
-    }
+    ConnectionsManager::get()->getConnectionIDs(mRecipients);
 }
 
-uint16_t NetworkEvent::getTypeId() const{
-    return NetworkManager::get()->getEventId(getType());
+uint16_t NetworkEvent::getTypeId() const {
+    if(mTypeId == 0)
+        mTypeId = NetworkManager::get()->getEventId(*this);
+    return mTypeId;
 }
 
 bool NetworkEvent::isNetworkEvent() const {
     return true;
 }
 
+NetworkEvent::Channel NetworkEvent::getChannel() const {
+    return UNRELIABLE;
+}
+
+NetworkEvent::Priority NetworkEvent::getPriority() const {
+    return NORMAL;
+}
+
 void NetworkEvent::addRecipient(uint16_t id) {
     mRecipients.push_back(id);
 }
@@ -77,4 +86,15 @@ void NetworkEvent::setSenderID(uint16_t id) {
     mSenderID = id;
 }
 
+double NetworkEvent::getReceiveTime() const {
+    return mReceiveTime;
+}
+
+void NetworkEvent::_recycle() {
+    mSenderID = 0;
+    mIsLocalEvent = false;
+    mReceiveTime = 0.0;
+    ConnectionsManager::get()->getConnectionIDs(mRecipients);
+}
+
 }
@@ -26,12 +26,53 @@ namespace dt {
   */
 class DUCTTAPE_API NetworkEvent {
 public:
+    /**
+      * The channels a NetworkEvent can be sent on.
+      */
+    enum Channel {
+        UNRELIABLE,             //!< Not acknowledged. The event may be lost or arrive out of order.
+        UNRELIABLE_SEQUENCED,   //!< Not acknowledged. Events older than the last one received are dropped.
+        RELIABLE_UNORDERED,     //!< Resent until acknowledged. Handled in the order of arrival.
+        RELIABLE_ORDERED        //!< Resent until acknowledged. Handled in the order of sending.
+    };
+
+    /**
+      * How important an event is when the send rate to a connection is used up. More important events are
+      * sent first, unreliable low-priority events are dropped.
+      * @see CongestionControl
+      */
+    enum Priority {
+        LOW,        //!< Dropped under congestion, if unreliable.
+        NORMAL,     //!< Delayed under congestion.
+        HIGH        //!< Sent before all other events.
+    };
+
     /**
       * Default constructor.
       */
     NetworkEvent();
     virtual const QString getType() const = 0;
     bool isNetworkEvent() const;
+
+    /**
+      * Returns the channel events of this type are sent on. Override this for events that have to
+      * arrive or must not be handled out of order.
+      * @returns The channel. Default: UNRELIABLE.
+      */
+    virtual Channel getChannel() const;
+
+    /**
+      * Returns the priority of events of this type under congestion. Override this for events that are
+      * small and urgent, like pings, or that are sent often and may be skipped.
+      * @returns The priority. Default: NORMAL.
+      */
+    virtual Priority getPriority() const;
+
+    /**
+      * Returns the network type ID of this event. The ID is looked up once per event class and
+      * cached in the instance afterwards, events created by the NetworkManager have it set already.
+      * @returns The network type ID, or 0 if the event type is not registered.
+      */
     uint16_t getTypeId() const;
 
     /**
@@ -106,10 +147,31 @@ public:
       */
     void setSenderID(uint16_t id);
 
+    /**
+      * Returns the time the datagram holding this event arrived. With the network thread running, this is
+      * the time it arrived at the socket, otherwise the time it was read from the socket.
+      * @see NetworkManager::setThreaded(bool threaded);
+      * @returns The time since the Root was initialized, in seconds, or 0 if the event was not received.
+      */
+    double getReceiveTime() const;
+
 protected:
+    friend class NetworkManager;
+    friend class NetworkEventPool;
+
     std::vector<uint16_t> mRecipients;  //!< The list of recipients for this NetworkEvent.
     uint16_t mSenderID;                 //!< The Connection ID of the sender. This is being set when the Event is received in the NetworkManager.
     bool mIsLocalEvent;                 //!< Whether this event should only be handled locally.
+    mutable uint16_t mTypeId;           //!< The cached network type ID, or 0 if it has not been looked up yet.
+    double mReceiveTime;                //!< The time the event arrived. This is being set when the Event is received in the NetworkManager.
+
+private:
+    /**
+      * Private method. Resets the recipients, the sender and the receive time to those of a new event, so a
+      * pooled instance can be used again.
+      * @see NetworkEventPool
+      */
+    void _recycle();
 };
 
 }
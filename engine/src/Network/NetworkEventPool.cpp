@@ -0,0 +1,81 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/NetworkEventPool.hpp>
+
+#include <algorithm>
+
+namespace dt {
+
+/**
+  * The number of instances acquire() checks before it clones a new one. Events are mostly released in the
+  * order they were created, so the instance handed out longest ago is usually free.
+  */
+static const uint32_t POOL_SCAN_LENGTH = 4;
+
+NetworkEventPool::NetworkEventPool(std::shared_ptr<NetworkEvent> prototype, uint32_t max_size)
+    : mPrototype(prototype),
+      mNext(0),
+      mMaxSize(max_size),
+      mAllocationCount(0) {}
+
+void NetworkEventPool::setPrototype(std::shared_ptr<NetworkEvent> prototype) {
+    mPrototype = prototype;
+    clear();
+}
+
+std::shared_ptr<NetworkEvent> NetworkEventPool::acquire() {
+    if(mPrototype == nullptr)
+        return std::shared_ptr<NetworkEvent>();
+
+    uint32_t size = mInstances.size();
+    uint32_t scan = std::min(size, POOL_SCAN_LENGTH);
+    for(uint32_t i = 0; i < scan; ++i) {
+        uint32_t index = (mNext + i) % size;
+        std::shared_ptr<NetworkEvent>& event = mInstances[index];
+        if(event.use_count() == 1) {
+            mNext = (index + 1) % size;
+            event->_recycle();
+            return event;
+        }
+    }
+
+    ++mAllocationCount;
+    std::shared_ptr<NetworkEvent> event = mPrototype->clone();
+    event->mTypeId = mPrototype->mTypeId;
+    if(size < mMaxSize)
+        mInstances.push_back(event);
+    return event;
+}
+
+void NetworkEventPool::setMaxSize(uint32_t max_size) {
+    mMaxSize = max_size;
+    if(mInstances.size() > mMaxSize) {
+        mInstances.resize(mMaxSize);
+        mNext = 0;
+    }
+}
+
+uint32_t NetworkEventPool::getMaxSize() const {
+    return mMaxSize;
+}
+
+uint32_t NetworkEventPool::getSize() const {
+    return mInstances.size();
+}
+
+uint64_t NetworkEventPool::getAllocationCount() const {
+    return mAllocationCount;
+}
+
+void NetworkEventPool::clear() {
+    mInstances.clear();
+    mNext = 0;
+}
+
+}
@@ -0,0 +1,99 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_NETWORKEVENTPOOL
+#define DUCTTAPE_ENGINE_NETWORK_NETWORKEVENTPOOL
+
+#include <Config.hpp>
+
+#include <Network/NetworkEvent.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace dt {
+
+/**
+  * A pool of instances of one NetworkEvent class. The pool keeps a reference to every instance it
+  * hands out, and hands an instance out again once nobody else holds it, so neither the event nor the
+  * shared_ptr control block has to be allocated again. Instances are only cloned from the prototype
+  * while the pool is growing, or when it is full.
+  * @note The pool is not thread-safe, the events have to be created and released on one thread.
+  * @see NetworkManager::createEvent
+  */
+class DUCTTAPE_API NetworkEventPool {
+public:
+    /**
+      * Advanced constructor.
+      * @param prototype The event to clone new instances from.
+      * @param max_size The maximum number of instances to keep.
+      */
+    NetworkEventPool(std::shared_ptr<NetworkEvent> prototype = std::shared_ptr<NetworkEvent>(),
+                     uint32_t max_size = 64);
+
+    /**
+      * Sets the event to clone new instances from. This releases the instances kept.
+      * @param prototype The prototype.
+      */
+    void setPrototype(std::shared_ptr<NetworkEvent> prototype);
+
+    /**
+      * Returns the event new instances are cloned from.
+      * @returns The prototype, or nullptr if there is none.
+      */
+    std::shared_ptr<NetworkEvent> getPrototype() const;
+
+    /**
+      * Returns an instance nobody else holds, or a new clone of the prototype. The recipients, the sender
+      * and the receive time of a reused instance are reset as if it had just been constructed, the fields of
+      * the subclass keep their last values.
+      * @returns The instance, or nullptr if there is no prototype.
+      */
+    std::shared_ptr<NetworkEvent> acquire();
+
+    /**
+      * Sets the maximum number of instances to keep. Instances cloned while the pool is full are not kept.
+      * @param max_size The maximum number of instances.
+      */
+    void setMaxSize(uint32_t max_size);
+
+    /**
+      * Returns the maximum number of instances to keep.
+      * @returns The maximum number of instances.
+      */
+    uint32_t getMaxSize() const;
+
+    /**
+      * Returns the number of instances kept.
+      * @returns The number of instances.
+      */
+    uint32_t getSize() const;
+
+    /**
+      * Returns the number of instances cloned from the prototype so far.
+      * @returns The number of clones.
+      */
+    uint64_t getAllocationCount() const;
+
+    /**
+      * Releases the instances kept. Instances still held elsewhere stay valid.
+      */
+    void clear();
+
+private:
+    std::shared_ptr<NetworkEvent> mPrototype;               //!< The event to clone new instances from.
+    std::vector<std::shared_ptr<NetworkEvent>> mInstances;  //!< The instances kept.
+    uint32_t mNext;                                         //!< The index of the instance handed out longest ago.
+    uint32_t mMaxSize;                                      //!< The maximum number of instances to keep.
+    uint64_t mAllocationCount;                              //!< The number of clones made.
+};
+
+}
+
+#endif
@@ -14,11 +14,64 @@
 #include <Utils/Utils.hpp>
 #include <Utils/LogManager.hpp>
 
-namespace dt {
+#include <SFML/Network/SocketSelector.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
 
-NetworkManager::NetworkManager() {}
+namespace dt {
 
-NetworkManager::~NetworkManager() {}
+/**
+  * The number of datagrams received per recvmmsg call.
+  */
+static const uint32_t RECEIVE_BATCH_SIZE = 16;
+
+/**
+  * The number of datagrams sent per sendmmsg call.
+  */
+static const uint32_t SEND_BATCH_SIZE = 16;
+
+/**
+  * The number of datagrams the queues between the network thread and the main thread hold.
+  */
+static const uint32_t THREAD_QUEUE_SIZE = 1024;
+
+/**
+  * The longest time the network thread waits for a datagram before it checks for datagrams to send, in milliseconds.
+  */
+static const int32_t THREAD_WAIT_TIME = 1;
+
+NetworkManager::NetworkManager()
+    : mReceiveBudget(256),
+      mBatchedReceive(false),
+      mReceivedCount(0),
+      mDroppedCount(0),
+      mBudgetExhaustedCount(0),
+      mMaxDatagramSize(1200),
+      mBatchedSend(false),
+      mSentBytes(0),
+      mSentDatagrams(0),
+      mLastTickSentBytes(0),
+      mLastTickSentDatagrams(0),
+      mCompressor(Compressor::NONE),
+      mLastEventId(0),
+      mHandshakeEventId(0),
+      mGoodbyeEventId(0),
+      mIsThreadRunning(false),
+      mIncoming(THREAD_QUEUE_SIZE),
+      mOutgoing(THREAD_QUEUE_SIZE),
+      mThreadDroppedCount(0) {}
+
+NetworkManager::~NetworkManager() {
+    _stopThread();
+    _dropIncoming();
+}
 
 void NetworkManager::initialize() {
     // initialize the connections mananger
@@ -31,15 +84,19 @@ void NetworkManager::initialize() {
 
     ptr = std::shared_ptr<NetworkEvent>(new HandshakeEvent());
     registerNetworkEventPrototype(ptr);
+    mHandshakeEventId = ptr->getTypeId();
 
     ptr = std::shared_ptr<NetworkEvent>(new GoodbyeEvent());
     registerNetworkEventPrototype(ptr);
+    mGoodbyeEventId = ptr->getTypeId();
 
     ptr = std::shared_ptr<NetworkEvent>(new PingEvent(0));
     registerNetworkEventPrototype(ptr);
 }
 
 void NetworkManager::deinitialize() {
+    _stopThread();
+    _dropIncoming();
     mConnectionsManager.deinitialize();
 }
 
@@ -48,12 +105,18 @@ NetworkManager* NetworkManager::get() {
 }
 
 bool NetworkManager::bindSocket(uint16_t port) {
+    bool threaded = isThreaded();
+    _stopThread();
+
     if(mSocket.bind(port) != sf::Socket::Done) {
         Logger::get().error("Binding socket to port " + Utils::toString(port) + " failed.");
         return false;
     }
     mSocket.setBlocking(false);
     Logger::get().info("Binding socket to port " + Utils::toString(port) + " successful.");
+
+    if(threaded)
+        _startThread();
     return true;
 }
 
@@ -72,13 +135,14 @@ void NetworkManager::connect(Connection::ConnectionSP target) {
 
 void NetworkManager::disconnect(Connection target) {
     // send goodbye
-    std::shared_ptr<GoodbyeEvent> goodbye(new GoodbyeEvent("Disconnected"));
+    std::shared_ptr<GoodbyeEvent> goodbye = createEvent<GoodbyeEvent>();
+    goodbye->setReason("Disconnected");
     goodbye->clearRecipients();
     goodbye->addRecipient(mConnectionsManager.getConnectionID(target));
-    // do not queue the event but send it directly, as we will remove the connection now
+    // do not queue the event but send it directly, the connection is kept until it is acknowledged
     _sendEvent(goodbye);
 
-    mConnectionsManager.removeConnection(target);
+    mConnectionsManager.closeConnection(mConnectionsManager.getConnectionID(target));
 }
 
 void NetworkManager::disconnectAll() {
@@ -89,10 +153,18 @@ void NetworkManager::disconnectAll() {
 }
 
 void NetworkManager::sendQueuedEvents() {
+    uint64_t sent_bytes = mSentBytes;
+    uint64_t sent_datagrams = mSentDatagrams;
+
     while(mQueue.size() > 0) {
-        _sendEvent(mQueue.front());
+        _writeEvent(mQueue.front());
         mQueue.pop_front();
     }
+    _flushDatagrams();
+    mConnectionsManager.removeClosedConnections();
+
+    mLastTickSentBytes = mSentBytes - sent_bytes;
+    mLastTickSentDatagrams = mSentDatagrams - sent_datagrams;
 }
 
 void NetworkManager::queueEvent(std::shared_ptr<NetworkEvent> event) {
@@ -101,39 +173,160 @@ void NetworkManager::queueEvent(std::shared_ptr<NetworkEvent> event) {
 }
 
 void NetworkManager::handleIncomingEvents() {
-    sf::Packet packet;
-    sf::IpAddress remote;
-    uint16_t port;
-    if(mSocket.receive(packet, remote, port) == sf::Socket::Done) {
-        // check if sender is known, otherwise add it
-        Connection::ConnectionSP sender(new Connection(remote, port));
-        uint16_t sender_id = 0;
-        if(mConnectionsManager.isKnownConnection(*sender.get())) {
-            sender_id = mConnectionsManager.getConnectionID(*sender.get());
-        } else {
-            sender_id = mConnectionsManager.addConnection(sender);
-        }
-
-        while(!packet.endOfPacket()) {
-            uint16_t type;
-            packet >> type;
-            std::shared_ptr<NetworkEvent> event = createPrototypeInstance(type);
-            if(event != nullptr) {
-                // Logger::Get().Debug("NetworkManager: Received event [" + Utils::ToString(event->GetTypeId()) + ": " +
-                                   // event->GetType() + "] from <" + Utils::ToString(sender_id) + ">. Handling.");
-                IOPacket iop(&packet, IOPacket::DESERIALIZE);
-                event->serialize(iop);
-                event->isLocalEvent(true);
-                event->setSenderID(sender_id);
-                handleEvent(event);
-            } else {
-                Logger::get().error("NetworkManager: Cannot create instance of packet type [" + Utils::toString(type) + "]. Skipping packet.");
+    if(mReceiveBuffer.empty()) {
+        mReceiveBuffer.resize(mBatchedReceive ? RECEIVE_BATCH_SIZE * sf::UdpSocket::MaxDatagramSize
+                                              : sf::UdpSocket::MaxDatagramSize);
+    }
+
+    // datagrams the network thread could not queue
+    mDroppedCount += mThreadDroppedCount.exchange(0);
+
+    // the datagrams received by the network thread, also the ones left when it was stopped
+    uint32_t handled = 0;
+    while(handled < mReceiveBudget) {
+        QueuedDatagram* datagram = mIncoming.front();
+        if(datagram == nullptr)
+            break;
+
+        ++handled;
+        _receiveDatagram(datagram->mData.empty() ? nullptr : &datagram->mData[0], datagram->mData.size(),
+                         datagram->mAddress, datagram->mPort, datagram->mTime);
+        mIncoming.pop();
+    }
+
+    // an event handler may have started the thread, which owns the socket then
+    while(handled < mReceiveBudget && !isThreaded()) {
+#ifdef __linux__
+        if(mBatchedReceive) {
+            uint32_t received = _receiveBatch(std::min(mReceiveBudget - handled, RECEIVE_BATCH_SIZE));
+            if(received == 0)
                 break;
-            }
+            handled += received;
+            continue;
+        }
+#endif
+        std::size_t size = 0;
+        sf::IpAddress remote;
+        uint16_t port;
+        if(mSocket.receive(&mReceiveBuffer[0], sf::UdpSocket::MaxDatagramSize, size, remote, port) != sf::Socket::Done)
+            break;
+
+        ++handled;
+        _receiveDatagram(&mReceiveBuffer[0], size, remote, port, Root::getInstance().getTimeSinceInitialize());
+    }
+
+    if(handled >= mReceiveBudget) {
+        // budget used up, leave the rest for the next frame
+        ++mBudgetExhaustedCount;
+    }
+
+    if(mSimulator.isEnabled() && mSimulator.getSimulateIncoming()) {
+        // hand out the simulated datagrams whose delay has passed
+        double time = Root::getInstance().getTimeSinceInitialize();
+        sf::IpAddress remote;
+        uint16_t port;
+        while(mSimulator.popIncoming(time, mSimulatedDatagram, remote, port)) {
+            _handleDatagram(mSimulatedDatagram.empty() ? nullptr : &mSimulatedDatagram[0], mSimulatedDatagram.size(), remote, port, time);
         }
     }
 }
 
+void NetworkManager::setThreaded(bool threaded) {
+    if(threaded && !isThreaded()) {
+        _startThread();
+    } else if(!threaded) {
+        _stopThread();
+    }
+}
+
+bool NetworkManager::isThreaded() const {
+    return mThread != nullptr;
+}
+
+void NetworkManager::setReceiveBudget(uint32_t budget) {
+    mReceiveBudget = budget;
+}
+
+uint32_t NetworkManager::getReceiveBudget() const {
+    return mReceiveBudget;
+}
+
+void NetworkManager::setBatchedReceive(bool batched_receive) {
+    if(batched_receive != mBatchedReceive) {
+        mBatchedReceive = batched_receive;
+        // reallocated with the right size on the next receive
+        mReceiveBuffer.clear();
+    }
+}
+
+bool NetworkManager::getBatchedReceive() const {
+    return mBatchedReceive;
+}
+
+uint64_t NetworkManager::getReceivedCount() const {
+    return mReceivedCount;
+}
+
+uint64_t NetworkManager::getDroppedCount() const {
+    return mDroppedCount;
+}
+
+uint64_t NetworkManager::getBudgetExhaustedCount() const {
+    return mBudgetExhaustedCount;
+}
+
+void NetworkManager::resetReceiveCounters() {
+    mReceivedCount = 0;
+    mDroppedCount = 0;
+    mBudgetExhaustedCount = 0;
+}
+
+void NetworkManager::setMaxDatagramSize(uint32_t size) {
+    mMaxDatagramSize = size;
+}
+
+uint32_t NetworkManager::getMaxDatagramSize() const {
+    return mMaxDatagramSize;
+}
+
+void NetworkManager::setBatchedSend(bool batched_send) {
+    mBatchedSend = batched_send;
+}
+
+bool NetworkManager::getBatchedSend() const {
+    return mBatchedSend;
+}
+
+uint64_t NetworkManager::getSentBytes() const {
+    return mSentBytes;
+}
+
+uint64_t NetworkManager::getSentDatagrams() const {
+    return mSentDatagrams;
+}
+
+uint32_t NetworkManager::getLastTickSentBytes() const {
+    return mLastTickSentBytes;
+}
+
+uint32_t NetworkManager::getLastTickSentDatagrams() const {
+    return mLastTickSentDatagrams;
+}
+
+void NetworkManager::resetSendCounters() {
+    mSentBytes = 0;
+    mSentDatagrams = 0;
+    mLastTickSentBytes = 0;
+    mLastTickSentDatagrams = 0;
+}
+
+NetworkSimulator* NetworkManager::getSimulator() {
+    return &mSimulator;
+}
+
+Compressor* NetworkManager::getCompressor() {
+    return &mCompressor;
+}
 
 void NetworkManager::handleEvent(std::shared_ptr<NetworkEvent> e) {
     if(!e->isLocalEvent()) {
@@ -142,13 +335,14 @@ void NetworkManager::handleEvent(std::shared_ptr<NetworkEvent> e) {
         return;
     }
 
-    if(e->getType() == "DT_HANDSHAKEEVENT") {
+    uint16_t type_id = e->getTypeId();
+    if(type_id == mHandshakeEventId) {
         // new client connected / server replied
         std::shared_ptr<HandshakeEvent> h = std::dynamic_pointer_cast<HandshakeEvent>(e);
         if(h->getSenderID() != 0) {
 
         }
-    } else if(e->getType() == "DT_GOODBYEEVENT") {
+    } else if(type_id == mGoodbyeEventId) {
         // client sent a goodbye event / server will disconnect the client
         std::shared_ptr<GoodbyeEvent> g = std::dynamic_pointer_cast<GoodbyeEvent>(e);
         if(g->getSenderID() != 0) {
@@ -159,18 +353,27 @@ void NetworkManager::handleEvent(std::shared_ptr<NetworkEvent> e) {
 }
 
 void NetworkManager::registerNetworkEventPrototype(std::shared_ptr<NetworkEvent> event) {
-    mNetworkEventPrototypes.push_back(event);
     // register the ID (if not already happened)
-    registerEvent(event->getType());
+    uint16_t id = registerEvent(event->getType());
+    if(id == 0)
+        return;
+
+    mEventTypes[id].mPool.setPrototype(event);
+    mEventClassIds[std::type_index(typeid(*event))] = id;
+    event->mTypeId = id;
 }
 
 std::shared_ptr<NetworkEvent> NetworkManager::createPrototypeInstance(uint16_t type_id) {
-    for(auto iter = mNetworkEventPrototypes.begin(); iter != mNetworkEventPrototypes.end(); ++iter) {
-        if(getEventId((*iter)->getType()) == type_id) {
-            return std::dynamic_pointer_cast<NetworkEvent>((*iter)->clone());
-        }
-    }
-    return nullptr;
+    if(type_id >= mEventTypes.size())
+        return nullptr;
+
+    return mEventTypes[type_id].mPool.acquire();
+}
+
+NetworkEventPool* NetworkManager::getEventPool(uint16_t type_id) {
+    if(!eventRegistered(type_id))
+        return nullptr;
+    return &mEventTypes[type_id].mPool;
 }
 
 ConnectionsManager* NetworkManager::getConnectionsManager() {
@@ -179,8 +382,17 @@ ConnectionsManager* NetworkManager::getConnectionsManager() {
 
 uint16_t NetworkManager::registerEvent(const QString name) {
     if(!eventRegistered(name)) {
-        mLastEventId++;
-        mEventIds[mLastEventId] = name;
+        // skip Ids that have been registered explicitly
+        do {
+            mLastEventId++;
+        } while(eventRegistered(mLastEventId) && mLastEventId != 0);
+
+        if(mLastEventId == 0) {
+            Logger::get().error("Cannot register event " + name + ": no Id left.");
+            return 0;
+        }
+
+        _setEventName(mLastEventId, name);
         return mLastEventId;
     } else {
         Logger::get().debug("Event " + name + " already registered with id " + Utils::toString(getEventId(name)) + ".");
@@ -189,8 +401,8 @@ uint16_t NetworkManager::registerEvent(const QString name) {
 }
 
 bool NetworkManager::registerEvent(const QString name, uint16_t id) {
-    if (!(eventRegistered(name) || eventRegistered(id))) {
-        mEventIds[id] = name;
+    if (!(id == 0 || eventRegistered(name) || eventRegistered(id))) {
+        _setEventName(id, name);
         return true;
     } else {
         Logger::get().debug("That Event has already been registered or that id has already been taken.");
@@ -200,7 +412,16 @@ bool NetworkManager::registerEvent(const QString name, uint16_t id) {
 
 bool NetworkManager::unregisterEvent(const QString name) {
     if(eventRegistered(name)) {
-        mEventIds[getEventId(name)] = "";
+        uint16_t id = getEventId(name);
+        mEventIds.remove(name);
+        mEventTypes[id] = EventType();
+
+        for(auto iter = mEventClassIds.begin(); iter != mEventClassIds.end();) {
+            if(iter->second == id)
+                iter = mEventClassIds.erase(iter);
+            else
+                ++iter;
+        }
         return true;
     } else {
         Logger::get().debug("Event " + name + " was never registered.");
@@ -209,46 +430,446 @@ bool NetworkManager::unregisterEvent(const QString name) {
 }
 
 bool NetworkManager::eventRegistered(const QString name) {
-    for(auto iter = mEventIds.begin(); iter != mEventIds.end(); ++iter) {
-        if(iter->second == name)
-            return true;
-    }
-    return false;
+    return mEventIds.contains(name);
 }
 
 bool NetworkManager::eventRegistered(uint16_t id) {
-    return mEventIds.count(id) > 0 && mEventIds[id] != "";
+    return id < mEventTypes.size() && !mEventTypes[id].mName.isEmpty();
 }
 
 uint16_t NetworkManager::getEventId(const QString name) {
-    for(auto iter = mEventIds.begin(); iter != mEventIds.end(); ++iter) {
-        if(iter->second == name)
-            return iter->first;
-    }
-    return 0;
+    return mEventIds.value(name, 0);
+}
+
+uint16_t NetworkManager::getEventId(const NetworkEvent& event) {
+    std::type_index type(typeid(event));
+    auto iter = mEventClassIds.find(type);
+    if(iter != mEventClassIds.end())
+        return iter->second;
+
+    // first event of a class without prototype, look it up by name once
+    uint16_t id = getEventId(event.getType());
+    if(id != 0)
+        mEventClassIds[type] = id;
+    return id;
 }
 
 const QString NetworkManager::getEventString(uint16_t id) {
-    return mEventIds[id];
+    if(id < mEventTypes.size())
+        return mEventTypes[id].mName;
+    return "";
 }
 
 void NetworkManager::_sendEvent(std::shared_ptr<NetworkEvent> event) {
-    // create packet
-    sf::Packet p;
-    p << getEventId(event->getType());
-    IOPacket packet(&p, IOPacket::SERIALIZE);
+    _writeEvent(event);
+    _flushDatagrams();
+}
+
+void NetworkManager::_writeEvent(std::shared_ptr<NetworkEvent> event) {
+    // serialize the event once for all recipients
+    mSendPacket.clear();
+    mSendPacket << event->getTypeId();
+    IOPacket packet(&mSendPacket, IOPacket::SERIALIZE);
     event->serialize(packet);
 
-    // send packet to all recipients
+    const char* data = static_cast<const char*>(mSendPacket.getData());
+    uint32_t size = mSendPacket.getDataSize();
+
+    // small events are not worth compressing, and are sent as they are
+    bool is_compressed = mCompressor.getMethod() != Compressor::NONE && size >= mCompressor.getThreshold()
+                         && mCompressor.compress(data, size, mCompressed);
+    if(is_compressed) {
+        data = &mCompressed[0];
+        size = mCompressed.size();
+    }
+
+    NetworkEvent::Channel channel = event->getChannel();
+    NetworkEvent::Priority priority = event->getPriority();
+
+    // queue it on the channels of all recipients
     const std::vector<uint16_t>& recipients = event->getRecipients();
     for(auto iter = recipients.begin(); iter != recipients.end(); ++iter) {
-        Connection::ConnectionSP r = mConnectionsManager.getConnection(*iter);
-        if(!r) {
+        NetworkChannels* channels = mConnectionsManager.getChannels(*iter);
+        if(channels == nullptr) {
             Logger::get().error("Cannot send event to " + Utils::toString(*iter) + ": No connection with this ID");
         } else {
-            mSocket.send(p, r->getIPAddress(), r->getPort());
+            channels->queueMessage(channel, data, size, priority, is_compressed);
+        }
+    }
+}
+
+void NetworkManager::_flushDatagrams() {
+    double time = Root::getInstance().getTimeSinceInitialize();
+
+    mSendBuffer.clear();
+    mSendList.clear();
+
+    // every connection may have resends or acknowledgements due, not only the recipients of new events
+    uint32_t highest_id = mConnectionsManager.getHighestID();
+    for(uint32_t id = 1; id <= highest_id; ++id) {
+        NetworkChannels* channels = mConnectionsManager.getChannels(id);
+        if(channels == nullptr)
+            continue;
+
+        uint32_t start = mSendBuffer.size();
+        mSendEnds.clear();
+        channels->writeDatagrams(time, mMaxDatagramSize, mSendBuffer, mSendEnds);
+        if(mSendEnds.empty())
+            continue;
+
+        Connection::ConnectionSP r = mConnectionsManager.getConnection(id);
+        PendingDatagram datagram;
+        datagram.mAddress = r->getIPAddress();
+        datagram.mPort = r->getPort();
+
+        for(auto end = mSendEnds.begin(); end != mSendEnds.end(); ++end) {
+            datagram.mOffset = start;
+            datagram.mSize = *end - start;
+            mSendList.push_back(datagram);
+            start = *end;
+        }
+    }
+
+    if(mSimulator.isEnabled() && mSimulator.getSimulateOutgoing()) {
+        for(auto iter = mSendList.begin(); iter != mSendList.end(); ++iter) {
+            mSimulator.queueOutgoing(&mSendBuffer[iter->mOffset], iter->mSize, iter->mAddress, iter->mPort, time);
+            mSentBytes += iter->mSize;
+            ++mSentDatagrams;
+        }
+        mSimulator.sendOutgoing(mSocket, time);
+        return;
+    }
+
+    if(isThreaded()) {
+        // hand the datagrams to the network thread
+        uint32_t queued = 0;
+        for(; queued < mSendList.size(); ++queued) {
+            QueuedDatagram* datagram = mOutgoing.beginPush();
+            if(datagram == nullptr)
+                break;
+
+            const PendingDatagram& pending = mSendList[queued];
+            datagram->mData.assign(mSendBuffer.begin() + pending.mOffset, mSendBuffer.begin() + pending.mOffset + pending.mSize);
+            datagram->mAddress = pending.mAddress;
+            datagram->mPort = pending.mPort;
+            mOutgoing.endPush();
+            mSentBytes += pending.mSize;
+            ++mSentDatagrams;
+        }
+        // the thread is behind, send the rest right away
+        mSendList.erase(mSendList.begin(), mSendList.begin() + queued);
+    }
+
+#ifdef __linux__
+    if(mBatchedSend && !isThreaded()) {
+        _sendBatch(mSendList.size());
+        return;
+    }
+#endif
+
+    for(auto iter = mSendList.begin(); iter != mSendList.end(); ++iter) {
+        if(mSocket.send(&mSendBuffer[iter->mOffset], iter->mSize, iter->mAddress, iter->mPort) == sf::Socket::Done) {
+            mSentBytes += iter->mSize;
+            ++mSentDatagrams;
+        }
+    }
+}
+
+void NetworkManager::_sendBatch(uint32_t count) {
+#ifdef __linux__
+    mmsghdr messages[SEND_BATCH_SIZE];
+    iovec buffers[SEND_BATCH_SIZE];
+    sockaddr_in addresses[SEND_BATCH_SIZE];
+
+    for(uint32_t first = 0; first < count; first += SEND_BATCH_SIZE) {
+        uint32_t batch = std::min(count - first, SEND_BATCH_SIZE);
+
+        for(uint32_t i = 0; i < batch; ++i) {
+            const PendingDatagram& datagram = mSendList[first + i];
+            buffers[i].iov_base = &mSendBuffer[datagram.mOffset];
+            buffers[i].iov_len = datagram.mSize;
+
+            memset(&addresses[i], 0, sizeof(sockaddr_in));
+            addresses[i].sin_family = AF_INET;
+            addresses[i].sin_addr.s_addr = htonl(datagram.mAddress.toInteger());
+            addresses[i].sin_port = htons(datagram.mPort);
+
+            memset(&messages[i], 0, sizeof(mmsghdr));
+            messages[i].msg_hdr.msg_iov = &buffers[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_name = &addresses[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+
+        // sendmmsg may send only part of the batch, continue with the rest
+        uint32_t sent = 0;
+        while(sent < batch) {
+            int result = sendmmsg(mSocket.getNativeHandle(), &messages[sent], batch - sent, 0);
+            if(result <= 0)
+                break;
+
+            uint32_t end = sent + static_cast<uint32_t>(result);
+            for(uint32_t i = sent; i < end; ++i) {
+                mSentBytes += messages[i].msg_len;
+                ++mSentDatagrams;
+            }
+            sent = end;
+        }
+    }
+#endif
+}
+
+void NetworkManager::_receiveDatagram(const char* data, std::size_t size, const sf::IpAddress& remote, uint16_t port, double time) {
+    ++mReceivedCount;
+
+    if(mSimulator.isEnabled() && mSimulator.getSimulateIncoming()) {
+        mSimulator.queueIncoming(data, size, remote, port, time);
+    } else {
+        _handleDatagram(data, size, remote, port, time);
+    }
+}
+
+void NetworkManager::_handleDatagram(const char* data, std::size_t size, const sf::IpAddress& remote, uint16_t port, double time) {
+
+    // check if sender is known, otherwise add it
+    uint16_t sender_id = mConnectionsManager.findConnectionID(remote, port);
+    if(sender_id == 0) {
+        sender_id = mConnectionsManager.addConnection(Connection::ConnectionSP(new Connection(remote, port)));
+    }
+
+    if(sender_id == 0) {
+        // no connection slot left
+        ++mDroppedCount;
+        return;
+    }
+
+    // clear() keeps the packet's memory
+    mReceivePacket.clear();
+    mReceivePacket.append(data, size);
+
+    NetworkChannels* channels = mConnectionsManager.getChannels(sender_id);
+    if(!channels->readHeader(mReceivePacket, time)) {
+        // duplicate, too old or malformed
+        ++mDroppedCount;
+        return;
+    }
+
+    while(!mReceivePacket.endOfPacket()) {
+        uint8_t channel_id = 0;
+        mReceivePacket >> channel_id;
+        bool is_fragment = (channel_id & NetworkChannels::FRAGMENT_FLAG) != 0;
+        bool is_compressed = (channel_id & NetworkChannels::COMPRESSED_FLAG) != 0;
+        channel_id &= ~(NetworkChannels::FRAGMENT_FLAG | NetworkChannels::COMPRESSED_FLAG);
+        if(channel_id > static_cast<uint8_t>(NetworkEvent::RELIABLE_ORDERED)) {
+            Logger::get().error("NetworkManager: Received event on unknown channel [" + Utils::toString(static_cast<uint32_t>(channel_id)) + "]. Skipping packet.");
+            ++mDroppedCount;
+            break;
+        }
+
+        NetworkEvent::Channel channel = static_cast<NetworkEvent::Channel>(channel_id);
+        uint16_t id = 0;
+        if(channel != NetworkEvent::UNRELIABLE)
+            mReceivePacket >> id;
+
+        const char* message = nullptr;
+        std::size_t message_size = 0;
+        if(is_fragment) {
+            // a fragment of a large message, which is handled once all fragments arrived
+            uint16_t group = 0;
+            uint16_t index = 0;
+            uint16_t count = 0;
+            if(!(mReceivePacket >> group >> index >> count >> mFragment)) {
+                ++mDroppedCount;
+                return;
+            }
+
+            const std::vector<char>* assembled = channels->receiveFragment(channel, id, group, index, count, mFragment, time);
+            if(assembled == nullptr)
+                continue;
+
+            message = &(*assembled)[0];
+            message_size = assembled->size();
+        } else {
+            // prefixed with its size, so the events after it can be read even if this one cannot be decoded
+            if(!(mReceivePacket >> mFragment)) {
+                ++mDroppedCount;
+                return;
+            }
+
+            message = mFragment.data();
+            message_size = mFragment.size();
+        }
+
+        mMessagePacket.clear();
+        if(is_compressed) {
+            // a few bytes on the wire must not make us allocate the 64 MB allowed for files
+            mCompressor.setMaxSize(mConnectionsManager.getMaxReassemblyBytes());
+            if(!mCompressor.decompress(message, message_size, mDecompressed))
+                ++mDroppedCount;
+            else if(!mDecompressed.empty())
+                mMessagePacket.append(&mDecompressed[0], mDecompressed.size());
+        } else {
+            mMessagePacket.append(message, message_size);
+        }
+
+        // handling an event may remove the connection
+        if(!_handleMessage(mMessagePacket, channel, id, sender_id, time))
+            return;
+        channels = mConnectionsManager.getChannels(sender_id);
+    }
+}
+
+bool NetworkManager::_handleMessage(sf::Packet& packet, NetworkEvent::Channel channel, uint16_t id, uint16_t sender_id, double time) {
+    // an empty packet is a message that could not be decompressed, and has been counted already
+    uint16_t type = 0;
+    std::shared_ptr<NetworkEvent> event;
+    if(packet >> type) {
+        event = createPrototypeInstance(type);
+        if(event == nullptr) {
+            Logger::get().error("NetworkManager: Cannot create instance of packet type [" + Utils::toString(type) + "]. Skipping packet.");
+            ++mDroppedCount;
+        }
+    }
+
+    if(event != nullptr) {
+        IOPacket iop(&packet, IOPacket::DESERIALIZE);
+        event->serialize(iop);
+        event->isLocalEvent(true);
+        event->setSenderID(sender_id);
+        event->mReceiveTime = time;
+    }
+
+    NetworkChannels* channels = mConnectionsManager.getChannels(sender_id);
+    if(channels == nullptr)
+        return false;
+
+    // a message that cannot be decoded still uses up its ID, or the reliable channels would wait for it forever
+    if(channels->receiveMessage(channel, id, event) && event != nullptr)
+        handleEvent(event);
+
+    // hand out the reliable-ordered events that waited for this one
+    if(channel == NetworkEvent::RELIABLE_ORDERED) {
+        while((channels = mConnectionsManager.getChannels(sender_id)) != nullptr
+              && (event = channels->popOrderedEvent()) != nullptr) {
+            handleEvent(event);
+        }
+    }
+    return mConnectionsManager.getChannels(sender_id) != nullptr;
+}
+
+uint32_t NetworkManager::_receiveBatch(uint32_t count) {
+#ifdef __linux__
+    mmsghdr messages[RECEIVE_BATCH_SIZE];
+    iovec buffers[RECEIVE_BATCH_SIZE];
+    sockaddr_in addresses[RECEIVE_BATCH_SIZE];
+
+    for(uint32_t i = 0; i < count; ++i) {
+        buffers[i].iov_base = &mReceiveBuffer[i * sf::UdpSocket::MaxDatagramSize];
+        buffers[i].iov_len = sf::UdpSocket::MaxDatagramSize;
+
+        memset(&messages[i], 0, sizeof(mmsghdr));
+        messages[i].msg_hdr.msg_iov = &buffers[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &addresses[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+
+    int received = recvmmsg(mSocket.getNativeHandle(), messages, count, MSG_DONTWAIT, nullptr);
+    if(received <= 0)
+        return 0;
+
+    double time = Root::getInstance().getTimeSinceInitialize();
+
+    for(int i = 0; i < received; ++i) {
+        if(messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            ++mReceivedCount;
+            ++mDroppedCount;
+            continue;
+        }
+
+        sf::IpAddress remote(ntohl(addresses[i].sin_addr.s_addr));
+        _receiveDatagram(static_cast<const char*>(buffers[i].iov_base), messages[i].msg_len, remote,
+                        ntohs(addresses[i].sin_port), time);
+    }
+    return received;
+#else
+    return 0;
+#endif
+}
+
+void NetworkManager::_startThread() {
+    mIsThreadRunning = true;
+    mThread = std::shared_ptr<sf::Thread>(new sf::Thread(&NetworkManager::_threadFunction, this));
+    mThread->launch();
+}
+
+void NetworkManager::_stopThread() {
+    if(mThread == nullptr)
+        return;
+
+    mIsThreadRunning = false;
+    mThread->wait();
+    mThread.reset();
+
+    // hand the datagrams still queued to the socket
+    while(QueuedDatagram* datagram = mOutgoing.front()) {
+        mSocket.send(&datagram->mData[0], datagram->mData.size(), datagram->mAddress, datagram->mPort);
+        mOutgoing.pop();
+    }
+
+    // the datagrams received but not handled yet stay in mIncoming for handleIncomingEvents()
+}
+
+void NetworkManager::_dropIncoming() {
+    mDroppedCount += mThreadDroppedCount.exchange(0);
+    while(mIncoming.front() != nullptr) {
+        ++mDroppedCount;
+        mIncoming.pop();
+    }
+}
+
+void NetworkManager::_threadFunction(void* user_data) {
+    NetworkManager* manager = static_cast<NetworkManager*>(user_data);
+    Root& root = Root::getInstance();
+
+    sf::SocketSelector selector;
+    selector.add(manager->mSocket);
+    std::vector<char> buffer(sf::UdpSocket::MaxDatagramSize);
+
+    while(manager->mIsThreadRunning) {
+        while(QueuedDatagram* datagram = manager->mOutgoing.front()) {
+            manager->mSocket.send(&datagram->mData[0], datagram->mData.size(), datagram->mAddress, datagram->mPort);
+            manager->mOutgoing.pop();
+        }
+
+        if(!selector.wait(sf::milliseconds(THREAD_WAIT_TIME)))
+            continue;
+
+        std::size_t size = 0;
+        sf::IpAddress remote;
+        uint16_t port;
+        while(manager->mSocket.receive(&buffer[0], buffer.size(), size, remote, port) == sf::Socket::Done) {
+            QueuedDatagram* datagram = manager->mIncoming.beginPush();
+            if(datagram == nullptr) {
+                ++manager->mThreadDroppedCount;
+                continue;
+            }
+
+            datagram->mData.assign(buffer.begin(), buffer.begin() + size);
+            datagram->mAddress = remote;
+            datagram->mPort = port;
+            datagram->mTime = root.getTimeSinceInitialize();
+            manager->mIncoming.endPush();
         }
     }
 }
 
+void NetworkManager::_setEventName(uint16_t id, const QString name) {
+    if(id >= mEventTypes.size())
+        mEventTypes.resize(id + 1);
+
+    mEventTypes[id].mName = name;
+    mEventIds.insert(name, id);
+}
+
 }
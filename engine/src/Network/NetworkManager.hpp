@@ -14,12 +14,24 @@
 #include <Core/Manager.hpp>
 #include <Network/ConnectionsManager.hpp>
 #include <Network/NetworkEvent.hpp>
+#include <Network/NetworkEventPool.hpp>
+#include <Network/NetworkSimulator.hpp>
+#include <Utils/Compressor.hpp>
+#include <Utils/SpscQueue.hpp>
 
+#include <SFML/Network/Packet.hpp>
 #include <SFML/Network/UdpSocket.hpp>
+#include <SFML/System/Thread.hpp>
 
+#include <QHash>
+
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
 #include <vector>
 
 namespace dt {
@@ -51,7 +63,8 @@ public:
     static NetworkManager* get();
 
     /**
-      * Binds the Socket used for the complete networking to the port given.
+      * Binds the Socket used for the complete networking to the port given. The network thread, if running,
+      * is restarted with the new socket.
       * @param port The port to bind the socket to, or 0 to automatically select a free port.
       * @returns True if the binding was successful. Otherwise false.
       */
@@ -64,7 +77,8 @@ public:
     void connect(Connection::ConnectionSP target);
 
     /**
-      * Disconnects from a remote device. This method sends a GoodbyeEvent to that target.
+      * Disconnects from a remote device. This method sends a GoodbyeEvent to that target, which is resent
+      * until it is acknowledged or the linger time of the ConnectionsManager has passed.
       * @param target The remote device to disconnect from.
       */
     void disconnect(Connection target);
@@ -76,8 +90,12 @@ public:
     void disconnectAll();
 
     /**
-      * Sends all pending Events from the queue.
+      * Sends all pending Events from the queue, on the channel of their type. The events for each recipient
+      * are packed into as few datagrams as possible, each at most the maximum datagram size, together with
+      * the reliable events due for a resend and the acknowledgements of received datagrams.
       * @see NetworkManager::QueueEvent(NetworkEvent* event);
+      * @see NetworkManager::setMaxDatagramSize(uint32_t size);
+      * @see NetworkChannels
       */
     void sendQueuedEvents();
 
@@ -89,14 +107,160 @@ public:
     void queueEvent(std::shared_ptr<NetworkEvent> event);
 
     /**
-      * Receives and handles all events pending at the socket.
+      * Receives and handles the events pending at the socket, up to the receive budget.
+      * Datagrams beyond the budget stay in the socket until the next call. The datagrams received by
+      * the network thread are handled first, also the ones it left behind when it was stopped.
+      * @see NetworkManager::setReceiveBudget(uint32_t budget);
       */
     void handleIncomingEvents();
 
+    /**
+      * Starts or stops the network thread. While it runs, it receives datagrams as soon
+      * as they arrive, timestamps them and hands them to handleIncomingEvents() through a lock-free queue,
+      * and sends the datagrams written by sendQueuedEvents(). So a slow frame does not delay the socket, and
+      * NetworkEvent::getReceiveTime() and the round-trip times do not include the frame time. The events are
+      * still decoded and handled on the thread calling handleIncomingEvents(), as handling them needs the
+      * connections and channels. Batched receiving and sending are not used while the thread runs. Default: false.
+      * @param threaded Whether to run the network thread.
+      */
+    void setThreaded(bool threaded);
+
+    /**
+      * Returns whether the network thread runs.
+      * @returns Whether the network thread runs.
+      */
+    bool isThreaded() const;
+
+    /**
+      * Sets the maximum number of datagrams handled per call of handleIncomingEvents(). Default: 256.
+      * @param budget The maximum number of datagrams per call.
+      */
+    void setReceiveBudget(uint32_t budget);
+
+    /**
+      * Returns the maximum number of datagrams handled per call of handleIncomingEvents().
+      * @returns The maximum number of datagrams per call.
+      */
+    uint32_t getReceiveBudget() const;
+
+    /**
+      * Sets whether to receive several datagrams per system call using recvmmsg. Only has an effect
+      * on Linux. Default: false.
+      * @param batched_receive Whether to use recvmmsg.
+      */
+    void setBatchedReceive(bool batched_receive);
+
+    /**
+      * Returns whether several datagrams are received per system call.
+      * @returns Whether several datagrams are received per system call.
+      */
+    bool getBatchedReceive() const;
+
+    /**
+      * Returns the number of datagrams received since the last reset.
+      * @returns The number of datagrams received.
+      */
+    uint64_t getReceivedCount() const;
+
+    /**
+      * Returns the number of received datagrams that were dropped because they were truncated,
+      * came from an unknown sender while no connection slot was left, or contained unknown events.
+      * @returns The number of datagrams dropped.
+      */
+    uint64_t getDroppedCount() const;
+
+    /**
+      * Returns the number of calls of handleIncomingEvents() that used up their budget. The remaining
+      * datagrams, if any, are left in the socket for the next call. This counts calls, not datagrams: a
+      * call receiving exactly as many datagrams as the budget allows counts even if none were left.
+      * @returns The number of calls that used up the budget.
+      */
+    uint64_t getBudgetExhaustedCount() const;
+
+    /**
+      * Resets the received, dropped and budget exhausted counters.
+      */
+    void resetReceiveCounters();
+
+    /**
+      * Sets the maximum size of the datagrams events are packed into. Events larger than this are
+      * sent in a datagram of their own. Default: 1200, which fits into the MTU of most networks.
+      * @param size The maximum datagram size, in bytes.
+      */
+    void setMaxDatagramSize(uint32_t size);
+
+    /**
+      * Returns the maximum size of the datagrams events are packed into.
+      * @returns The maximum datagram size, in bytes.
+      */
+    uint32_t getMaxDatagramSize() const;
+
+    /**
+      * Sets whether to send several datagrams per system call using sendmmsg. Only has an effect
+      * on Linux. Default: false.
+      * @param batched_send Whether to use sendmmsg.
+      */
+    void setBatchedSend(bool batched_send);
+
+    /**
+      * Returns whether several datagrams are sent per system call.
+      * @returns Whether several datagrams are sent per system call.
+      */
+    bool getBatchedSend() const;
+
+    /**
+      * Returns the number of bytes sent since the last reset.
+      * @returns The number of bytes sent.
+      */
+    uint64_t getSentBytes() const;
+
+    /**
+      * Returns the number of datagrams sent since the last reset.
+      * @returns The number of datagrams sent.
+      */
+    uint64_t getSentDatagrams() const;
+
+    /**
+      * Returns the number of bytes sent by the last call of sendQueuedEvents().
+      * @returns The number of bytes sent in the last tick.
+      */
+    uint32_t getLastTickSentBytes() const;
+
+    /**
+      * Returns the number of datagrams sent by the last call of sendQueuedEvents().
+      * @returns The number of datagrams sent in the last tick.
+      */
+    uint32_t getLastTickSentDatagrams() const;
+
+    /**
+      * Resets the sent bytes and datagrams counters.
+      */
+    void resetSendCounters();
+
+    /**
+      * Returns the network simulator. Enable it to test over loopback with latency, jitter, loss,
+      * duplication, reordering and limited bandwidth.
+      * @returns The network simulator.
+      */
+    NetworkSimulator* getSimulator();
+
+    /**
+      * Returns the compressor events are compressed with before they are sent. It compresses nothing until
+      * a method is set. Compressed events are decompressed regardless, but a dictionary has to be set on
+      * both sides. Events are not decompressed beyond the reassembly limit of the connections, a larger
+      * event could not be received uncompressed either.
+      * @code
+      * nm->getCompressor()->setMethod(Compressor::getDefaultMethod());
+      * @endcode
+      * @returns The compressor.
+      */
+    Compressor* getCompressor();
+
     void handleEvent(std::shared_ptr<NetworkEvent> e);
 
     /**
-      * Registers a NetworkEvent as prototype for incoming packets.
+      * Registers a NetworkEvent as prototype for incoming packets. This assigns the network type ID
+      * of the event class, if it has not been registered before.
       * @see Factory Pattern
       * @see NetworkEvent::Clone();
       * @param event A new instance of a NetworkEvent to be used for factory.
@@ -104,14 +268,41 @@ public:
     void registerNetworkEventPrototype(std::shared_ptr<NetworkEvent> event);
 
     /**
-      * Creates a new instance of the prototype with the type ID given.
+      * Creates an instance of the prototype with the type ID given. The instance comes from the pool of the
+      * event type, so it is only cloned if all pooled instances are still in use.
       * @see Factory Pattern
       * @see NetworkEvent::Clone();
       * @see Event::GetTypeID();
+      * @see NetworkEventPool
       * @param type_id The ID of the type of NetworkEvent to create an instance of.
-      * @returns A new instance of the prototype with the type ID given.
+      * @returns An instance of the prototype with the type ID given, or nullptr if there is none.
+      */
+    std::shared_ptr<NetworkEvent> createPrototypeInstance(uint16_t type_id);
+
+    /**
+      * Creates a pooled instance of a registered event class. The fields of the class keep the values of the
+      * last use of the instance, so set all of them before queueing it.
+      * @code
+      * std::shared_ptr<PingEvent> ping = NetworkManager::get()->createEvent<PingEvent>();
+      * ping->setTimestamp(time);
+      * NetworkManager::get()->queueEvent(ping);
+      * @endcode
+      * @returns The instance, or nullptr if no prototype of the class has been registered.
       */
-    std::shared_ptr<NetworkEvent> createPrototypeInstance(uint16_t type);
+    template <typename T>
+    std::shared_ptr<T> createEvent() {
+        auto iter = mEventClassIds.find(std::type_index(typeid(T)));
+        if(iter == mEventClassIds.end())
+            return std::shared_ptr<T>();
+        return std::static_pointer_cast<T>(createPrototypeInstance(iter->second));
+    }
+
+    /**
+      * Returns the pool of instances of an event type, e.g. to change its size.
+      * @param type_id The ID of the event type.
+      * @returns The pool, or nullptr if the event type is not registered.
+      */
+    NetworkEventPool* getEventPool(uint16_t type_id);
 
     /**
       * Returns a pointer to the ConnectionsManager.
@@ -162,6 +353,14 @@ public:
       */
     uint16_t getEventId(const QString string);
 
+    /**
+      * Returns the Id for the class of an event. The result is cached per event class, so this
+      * does not compare any strings once the class is known.
+      * @param event The event.
+      * @returns The Id for the class of the event, or 0 if it is not registered.
+      */
+    uint16_t getEventId(const NetworkEvent& event);
+
     /**
       * Returns the string for an Id.
       * @param id The Id to find.
@@ -174,18 +373,173 @@ signals:
 
 private:
     /**
-      * Sends an Event to its recipients.
+      * Sends an Event to its recipients right away.
       * @param event The event to send.
       */
     void _sendEvent(std::shared_ptr<NetworkEvent> event);
 
+    /**
+      * Serializes an Event and queues it on the channels of its recipients.
+      * @param event The event to write.
+      */
+    void _writeEvent(std::shared_ptr<NetworkEvent> event);
+
+    /**
+      * Sends the outgoing datagrams of all connections.
+      */
+    void _flushDatagrams();
+
+    /**
+      * Sends count datagrams with a single sendmmsg call per batch.
+      * @param count The number of datagrams in mSendList.
+      */
+    void _sendBatch(uint32_t count);
+
+    /**
+      * Stores the name of an event type in the table of event types.
+      * @param id The Id of the event type.
+      * @param name The name of the event type.
+      */
+    void _setEventName(uint16_t id, const QString name);
+
+    /**
+      * Passes a received datagram to the network simulator, if it simulates received datagrams, or handles it.
+      * @param data The datagram.
+      * @param size The size of the datagram, in bytes.
+      * @param remote The address of the sender.
+      * @param port The port of the sender.
+      * @param time The time the datagram arrived, in seconds.
+      */
+    void _receiveDatagram(const char* data, std::size_t size, const sf::IpAddress& remote, uint16_t port, double time);
+
+    /**
+      * Decodes and handles the events of one datagram.
+      * @param data The datagram.
+      * @param size The size of the datagram, in bytes.
+      * @param remote The address of the sender.
+      * @param port The port of the sender.
+      * @param time The time the datagram arrived, in seconds.
+      */
+    void _handleDatagram(const char* data, std::size_t size, const sf::IpAddress& remote, uint16_t port, double time);
+
+    /**
+      * Decodes and handles one event of a datagram or of a reassembled large message.
+      * @param packet The packet to read the event from. Empty if the message could not be decompressed.
+      * @param channel The channel the event was sent on.
+      * @param id The message ID. It is used up even if the event cannot be decoded.
+      * @param sender_id The ID of the connection the event came from.
+      * @param time The time the event arrived, in seconds.
+      * @returns False if the connection has been removed meanwhile.
+      */
+    bool _handleMessage(sf::Packet& packet, NetworkEvent::Channel channel, uint16_t id, uint16_t sender_id, double time);
+
+    /**
+      * Receives up to count datagrams with a single recvmmsg call and handles them.
+      * @param count The maximum number of datagrams to receive.
+      * @returns The number of datagrams received, 0 if none were pending.
+      */
+    uint32_t _receiveBatch(uint32_t count);
+
+    /**
+      * Private method. Starts the network thread.
+      */
+    void _startThread();
+
+    /**
+      * Private method. Stops the network thread and waits for it to finish. The datagrams it received are
+      * left for handleIncomingEvents().
+      */
+    void _stopThread();
+
+    /**
+      * Private method. Drops the datagrams the network thread received that were not handled, counting them.
+      */
+    void _dropIncoming();
+
+    /**
+      * Private method. The loop of the network thread.
+      * @param user_data Data that is being passed in by the sf::Thread (void* to NetworkManager instance).
+      */
+    static void _threadFunction(void* user_data);
+
+    /**
+      * The UDP socket, exposing the native handle for recvmmsg.
+      */
+    class Socket : public sf::UdpSocket {
+    public:
+        sf::SocketHandle getNativeHandle() const {
+            return getHandle();
+        }
+    };
+
+    /**
+      * A datagram ready to be sent.
+      */
+    struct PendingDatagram {
+        uint32_t mOffset;                   //!< The offset of the payload in mSendBuffer.
+        uint32_t mSize;                     //!< The size of the payload, in bytes.
+        sf::IpAddress mAddress;             //!< The address of the recipient.
+        uint16_t mPort;                     //!< The port of the recipient.
+    };
+
+    /**
+      * A datagram passed between the network thread and the main thread.
+      */
+    struct QueuedDatagram {
+        std::vector<char> mData;            //!< The datagram. Its memory is kept when the slot is reused.
+        sf::IpAddress mAddress;             //!< The address of the remote device.
+        uint16_t mPort;                     //!< The port of the remote device.
+        double mTime;                       //!< The time the datagram arrived, in seconds.
+    };
+
+    /**
+      * An entry of the table of event types.
+      */
+    struct EventType {
+        QString mName;                              //!< The name of the event type, or empty if the Id is unused.
+        NetworkEventPool mPool;                     //!< The instances of the event type, cloned from the registered prototype.
+    };
+
     ConnectionsManager mConnectionsManager;                     //!< The ConnectionsManager that manages all remote devices.
     std::deque<std::shared_ptr<NetworkEvent>> mQueue;           //!< The queue of Events to be send. @see NetworkManager::QueueEvent(NetworkEvent* event);
-    std::vector<std::shared_ptr<NetworkEvent>> mNetworkEventPrototypes;    //!< The list of prototypes known to mankind :P
-    sf::UdpSocket mSocket;                                      //!< The socket used for data transmissions over network.
+    Socket mSocket;                                             //!< The socket used for data transmissions over network.
+    std::vector<char> mReceiveBuffer;                           //!< The buffer datagrams are received into. Allocated once.
+    sf::Packet mReceivePacket;                                  //!< The packet incoming datagrams are decoded from. Reused.
+    sf::Packet mMessagePacket;                                  //!< The packet reassembled large messages are decoded from. Reused.
+    std::string mFragment;                                      //!< The data of the fragment or message being received. Reused.
+    std::vector<char> mDecompressed;                            //!< The compressed message being received, decompressed. Reused.
+    uint32_t mReceiveBudget;                                    //!< The maximum number of datagrams per handleIncomingEvents().
+    bool mBatchedReceive;                                       //!< Whether to use recvmmsg.
+    uint64_t mReceivedCount;                                    //!< The number of datagrams received.
+    uint64_t mDroppedCount;                                     //!< The number of datagrams dropped.
+    uint64_t mBudgetExhaustedCount;                             //!< The number of calls of handleIncomingEvents() that used up the receive budget.
+    sf::Packet mSendPacket;                                     //!< The packet outgoing events are serialized into. Reused.
+    std::vector<char> mSendBuffer;                              //!< The datagrams being flushed, back to back. Reused.
+    std::vector<uint32_t> mSendEnds;                            //!< The offsets in mSendBuffer at which the datagrams end.
+    std::vector<PendingDatagram> mSendList;                     //!< The datagrams being flushed. Reused.
+    uint32_t mMaxDatagramSize;                                  //!< The maximum size of coalesced datagrams.
+    bool mBatchedSend;                                          //!< Whether to use sendmmsg.
+    uint64_t mSentBytes;                                        //!< The number of bytes sent.
+    uint64_t mSentDatagrams;                                    //!< The number of datagrams sent.
+    uint32_t mLastTickSentBytes;                                //!< The number of bytes sent by the last sendQueuedEvents().
+    uint32_t mLastTickSentDatagrams;                            //!< The number of datagrams sent by the last sendQueuedEvents().
+    NetworkSimulator mSimulator;                                //!< The network simulator.
+    std::vector<char> mSimulatedDatagram;                       //!< The buffer simulated received datagrams are handed out in.
+    Compressor mCompressor;                                     //!< The compressor for outgoing and incoming events.
+    std::vector<char> mCompressed;                              //!< The event being sent, compressed. Reused.
 
     uint16_t mLastEventId;                                      //!< The Id used to register the last string with.
-    std::map<uint16_t, QString> mEventIds;                      //!< The relation map between Ids/strings.
+    std::vector<EventType> mEventTypes;                         //!< The event types, indexed by their Id.
+    QHash<QString, uint16_t> mEventIds;                         //!< The Ids of the event types by name.
+    std::unordered_map<std::type_index, uint16_t> mEventClassIds; //!< The Ids of the event types by event class.
+    uint16_t mHandshakeEventId;                                 //!< The Id of the HandshakeEvent.
+    uint16_t mGoodbyeEventId;                                   //!< The Id of the GoodbyeEvent.
+
+    std::shared_ptr<sf::Thread> mThread;                        //!< The network thread, or nullptr if it does not run.
+    std::atomic<bool> mIsThreadRunning;                         //!< Whether the network thread should keep running.
+    SpscQueue<QueuedDatagram> mIncoming;                        //!< The datagrams received by the network thread.
+    SpscQueue<QueuedDatagram> mOutgoing;                        //!< The datagrams to be sent by the network thread.
+    std::atomic<uint32_t> mThreadDroppedCount;                  //!< The datagrams the network thread dropped because mIncoming was full.
 };
 
 }
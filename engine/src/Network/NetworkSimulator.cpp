@@ -0,0 +1,226 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/NetworkSimulator.hpp>
+
+#include <Utils/Logger.hpp>
+
+#include <QStringList>
+
+#include <algorithm>
+
+namespace dt {
+
+/**
+  * The range of the extra delay of reordered datagrams, in seconds.
+  */
+static const double REORDER_DELAY_MIN = 0.02;
+static const double REORDER_DELAY_MAX = 0.06;
+
+/**
+  * The longest time a datagram waits for a link at its bandwidth limit before it is dropped, in seconds.
+  */
+static const double MAX_QUEUE_DELAY = 1.0;
+
+NetworkSimulator::Conditions::Conditions()
+    : mLatency(0.0),
+      mJitter(0.0),
+      mPacketLoss(0.f),
+      mDuplication(0.f),
+      mReordering(0.f),
+      mBandwidth(0) {}
+
+NetworkSimulator::NetworkSimulator()
+    : mIsEnabled(false),
+      mSimulateOutgoing(true),
+      mSimulateIncoming(false),
+      mLostCount(0),
+      mDuplicatedCount(0),
+      mReorderedCount(0) {}
+
+void NetworkSimulator::setEnabled(bool enabled) {
+    mIsEnabled = enabled;
+    if(!mIsEnabled) {
+        mOutgoing.clear();
+        mIncoming.clear();
+        mBusyUntil.clear();
+    }
+}
+
+bool NetworkSimulator::isEnabled() const {
+    return mIsEnabled;
+}
+
+void NetworkSimulator::setSimulateOutgoing(bool simulate_outgoing) {
+    mSimulateOutgoing = simulate_outgoing;
+}
+
+bool NetworkSimulator::getSimulateOutgoing() const {
+    return mSimulateOutgoing;
+}
+
+void NetworkSimulator::setSimulateIncoming(bool simulate_incoming) {
+    mSimulateIncoming = simulate_incoming;
+}
+
+bool NetworkSimulator::getSimulateIncoming() const {
+    return mSimulateIncoming;
+}
+
+void NetworkSimulator::setConditions(const Conditions& conditions) {
+    mConditions = conditions;
+}
+
+const NetworkSimulator::Conditions& NetworkSimulator::getConditions() const {
+    return mConditions;
+}
+
+void NetworkSimulator::setConditions(const sf::IpAddress& address, uint16_t port, const Conditions& conditions) {
+    mEndpointConditions[_endpointKey(address, port)] = conditions;
+}
+
+void NetworkSimulator::clearConditions(const sf::IpAddress& address, uint16_t port) {
+    mEndpointConditions.erase(_endpointKey(address, port));
+}
+
+void NetworkSimulator::setSeed(uint32_t seed) {
+    mGenerator.seed(seed);
+}
+
+bool NetworkSimulator::configure(const QString& options) {
+    bool success = true;
+
+    QStringList list = options.split(",", QString::SkipEmptyParts);
+    for(auto iter = list.begin(); iter != list.end(); ++iter) {
+        QString key = iter->section("=", 0, 0).trimmed().toLower();
+        bool ok = false;
+        double value = iter->section("=", 1).trimmed().toDouble(&ok);
+        if(!ok) {
+            Logger::get().error("NetworkSimulator: Invalid option \"" + *iter + "\".");
+            success = false;
+            continue;
+        }
+
+        if(key == "latency") {
+            mConditions.mLatency = value / 1000.0;
+        } else if(key == "jitter") {
+            mConditions.mJitter = value / 1000.0;
+        } else if(key == "loss") {
+            mConditions.mPacketLoss = value / 100.0;
+        } else if(key == "duplicate") {
+            mConditions.mDuplication = value / 100.0;
+        } else if(key == "reorder") {
+            mConditions.mReordering = value / 100.0;
+        } else if(key == "bandwidth") {
+            mConditions.mBandwidth = static_cast<uint32_t>(value);
+        } else if(key == "seed") {
+            setSeed(static_cast<uint32_t>(value));
+        } else if(key == "incoming") {
+            mSimulateIncoming = (value != 0);
+        } else {
+            Logger::get().error("NetworkSimulator: Unknown option \"" + key + "\".");
+            success = false;
+        }
+    }
+
+    setEnabled(true);
+    return success;
+}
+
+void NetworkSimulator::queueOutgoing(const char* data, uint32_t size, const sf::IpAddress& address, uint16_t port, double time) {
+    _queue(mOutgoing, 0, data, size, address, port, time);
+}
+
+void NetworkSimulator::sendOutgoing(sf::UdpSocket& socket, double time) {
+    while(!mOutgoing.empty() && mOutgoing.begin()->first <= time) {
+        Datagram& datagram = mOutgoing.begin()->second;
+        socket.send(&datagram.mData[0], datagram.mData.size(), datagram.mAddress, datagram.mPort);
+        mOutgoing.erase(mOutgoing.begin());
+    }
+}
+
+void NetworkSimulator::queueIncoming(const char* data, uint32_t size, const sf::IpAddress& address, uint16_t port, double time) {
+    _queue(mIncoming, 1, data, size, address, port, time);
+}
+
+bool NetworkSimulator::popIncoming(double time, std::vector<char>& data, sf::IpAddress& address, uint16_t& port) {
+    if(mIncoming.empty() || mIncoming.begin()->first > time)
+        return false;
+
+    Datagram& datagram = mIncoming.begin()->second;
+    data.swap(datagram.mData);
+    address = datagram.mAddress;
+    port = datagram.mPort;
+    mIncoming.erase(mIncoming.begin());
+    return true;
+}
+
+uint64_t NetworkSimulator::getLostCount() const {
+    return mLostCount;
+}
+
+uint64_t NetworkSimulator::getDuplicatedCount() const {
+    return mDuplicatedCount;
+}
+
+uint64_t NetworkSimulator::getReorderedCount() const {
+    return mReorderedCount;
+}
+
+void NetworkSimulator::_queue(DatagramQueue& queue, uint32_t direction, const char* data, uint32_t size,
+                              const sf::IpAddress& address, uint16_t port, double time) {
+    uint64_t key = _endpointKey(address, port);
+    auto iter = mEndpointConditions.find(key);
+    const Conditions& conditions = (iter != mEndpointConditions.end()) ? iter->second : mConditions;
+
+    if(_random() < conditions.mPacketLoss) {
+        ++mLostCount;
+        return;
+    }
+
+    // the datagram leaves once the link has sent the ones before it
+    double departure = time;
+    if(conditions.mBandwidth > 0) {
+        double& busy_until = mBusyUntil[(key << 1) | direction];
+        departure = std::max(time, busy_until);
+        if(departure - time > MAX_QUEUE_DELAY) {
+            ++mLostCount;
+            return;
+        }
+        departure += static_cast<double>(size) / conditions.mBandwidth;
+        busy_until = departure;
+    }
+
+    Datagram datagram;
+    datagram.mData.assign(data, data + size);
+    datagram.mAddress = address;
+    datagram.mPort = port;
+
+    double delay = conditions.mLatency + conditions.mJitter * _random();
+    if(_random() < conditions.mReordering) {
+        delay += REORDER_DELAY_MIN + (REORDER_DELAY_MAX - REORDER_DELAY_MIN) * _random();
+        ++mReorderedCount;
+    }
+
+    if(_random() < conditions.mDuplication) {
+        queue.insert(std::make_pair(departure + conditions.mLatency + conditions.mJitter * _random(), datagram));
+        ++mDuplicatedCount;
+    }
+
+    queue.insert(std::make_pair(departure + delay, datagram));
+}
+
+float NetworkSimulator::_random() {
+    return std::uniform_real_distribution<float>(0.f, 1.f)(mGenerator);
+}
+
+uint64_t NetworkSimulator::_endpointKey(const sf::IpAddress& address, uint16_t port) {
+    return (static_cast<uint64_t>(address.toInteger()) << 16) | port;
+}
+
+}
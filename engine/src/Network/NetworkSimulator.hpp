@@ -0,0 +1,251 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_NETWORKSIMULATOR
+#define DUCTTAPE_ENGINE_NETWORK_NETWORKSIMULATOR
+
+#include <Config.hpp>
+
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/UdpSocket.hpp>
+
+#include <QString>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace dt {
+
+/**
+  * Simulates a bad network, to test the netcode over loopback. While enabled, the NetworkManager hands its
+  * outgoing datagrams (and, if requested, the received ones) to the simulator, which loses, delays, duplicates
+  * and reorders them and limits the bandwidth, according to the conditions set for the remote device. All
+  * random decisions come from a seeded generator, so a run can be reproduced.
+  * @code
+  * // from the command line of the TestFramework or the chat sample
+  * --netsim=latency=100,jitter=20,loss=5,duplicate=1,reorder=2,bandwidth=16000,seed=42
+  * @endcode
+  * @see NetworkManager::getSimulator();
+  */
+class DUCTTAPE_API NetworkSimulator {
+public:
+    /**
+      * The conditions of the network between this and a remote device, in one direction.
+      */
+    struct Conditions {
+        /**
+          * Default constructor. A perfect network.
+          */
+        Conditions();
+
+        double mLatency;        //!< The delay of every datagram, in seconds.
+        double mJitter;         //!< The maximum random delay added to the latency, in seconds.
+        float mPacketLoss;      //!< The probability of a datagram being lost, from 0 to 1.
+        float mDuplication;     //!< The probability of a datagram arriving twice, from 0 to 1.
+        float mReordering;      //!< The probability of a datagram being held back behind the following ones, from 0 to 1.
+        uint32_t mBandwidth;    //!< The bandwidth, in bytes per second, or 0 for no limit.
+    };
+
+    /**
+      * Default constructor. The simulator is disabled and simulates outgoing datagrams only.
+      */
+    NetworkSimulator();
+
+    /**
+      * Enables or disables the simulator. Disabling it drops the datagrams it holds back.
+      * @param enabled Whether the simulator is enabled.
+      */
+    void setEnabled(bool enabled);
+
+    /**
+      * Returns whether the simulator is enabled.
+      * @returns Whether the simulator is enabled.
+      */
+    bool isEnabled() const;
+
+    /**
+      * Sets whether outgoing datagrams are passed through the simulator. Default: true.
+      * @param simulate_outgoing Whether outgoing datagrams are simulated.
+      */
+    void setSimulateOutgoing(bool simulate_outgoing);
+
+    /**
+      * Returns whether outgoing datagrams are passed through the simulator.
+      * @returns Whether outgoing datagrams are simulated.
+      */
+    bool getSimulateOutgoing() const;
+
+    /**
+      * Sets whether received datagrams are passed through the simulator. Default: false.
+      * @param simulate_incoming Whether received datagrams are simulated.
+      */
+    void setSimulateIncoming(bool simulate_incoming);
+
+    /**
+      * Returns whether received datagrams are passed through the simulator.
+      * @returns Whether received datagrams are simulated.
+      */
+    bool getSimulateIncoming() const;
+
+    /**
+      * Sets the conditions for all remote devices without conditions of their own.
+      * @param conditions The conditions.
+      */
+    void setConditions(const Conditions& conditions);
+
+    /**
+      * Returns the conditions for all remote devices without conditions of their own.
+      * @returns The conditions.
+      */
+    const Conditions& getConditions() const;
+
+    /**
+      * Sets the conditions for one remote device.
+      * @param address The address of the remote device.
+      * @param port The port of the remote device.
+      * @param conditions The conditions.
+      */
+    void setConditions(const sf::IpAddress& address, uint16_t port, const Conditions& conditions);
+
+    /**
+      * Removes the conditions of one remote device, so the default conditions apply again.
+      * @param address The address of the remote device.
+      * @param port The port of the remote device.
+      */
+    void clearConditions(const sf::IpAddress& address, uint16_t port);
+
+    /**
+      * Seeds the random number generator, so runs can be reproduced.
+      * @param seed The seed.
+      */
+    void setSeed(uint32_t seed);
+
+    /**
+      * Sets up the simulator from a list of options and enables it. The options are separated by commas:
+      * latency=<ms>, jitter=<ms>, loss=<percent>, duplicate=<percent>, reorder=<percent>,
+      * bandwidth=<bytes per second>, seed=<number> and incoming=<0|1>.
+      * @param options The options, for example "latency=100,jitter=20,loss=5".
+      * @returns False if an option could not be parsed. The valid options are applied anyway.
+      */
+    bool configure(const QString& options);
+
+    /**
+      * Takes a datagram to be sent. It is lost or sent by sendOutgoing() once its delay has passed.
+      * @param data The datagram.
+      * @param size The size of the datagram, in bytes.
+      * @param address The address of the recipient.
+      * @param port The port of the recipient.
+      * @param time The current time, in seconds.
+      */
+    void queueOutgoing(const char* data, uint32_t size, const sf::IpAddress& address, uint16_t port, double time);
+
+    /**
+      * Sends the outgoing datagrams whose delay has passed.
+      * @param socket The socket to send the datagrams with.
+      * @param time The current time, in seconds.
+      */
+    void sendOutgoing(sf::UdpSocket& socket, double time);
+
+    /**
+      * Takes a received datagram. It is lost or returned by popIncoming() once its delay has passed.
+      * @param data The datagram.
+      * @param size The size of the datagram, in bytes.
+      * @param address The address of the sender.
+      * @param port The port of the sender.
+      * @param time The current time, in seconds.
+      */
+    void queueIncoming(const char* data, uint32_t size, const sf::IpAddress& address, uint16_t port, double time);
+
+    /**
+      * Returns the next received datagram whose delay has passed.
+      * @param time The current time, in seconds.
+      * @param data The datagram is swapped into this vector.
+      * @param address The address of the sender.
+      * @param port The port of the sender.
+      * @returns False if no datagram is due.
+      */
+    bool popIncoming(double time, std::vector<char>& data, sf::IpAddress& address, uint16_t& port);
+
+    /**
+      * Returns the number of datagrams lost by the simulator, including those dropped because the
+      * bandwidth limit was exceeded for too long.
+      * @returns The number of datagrams lost.
+      */
+    uint64_t getLostCount() const;
+
+    /**
+      * Returns the number of datagrams duplicated by the simulator.
+      * @returns The number of datagrams duplicated.
+      */
+    uint64_t getDuplicatedCount() const;
+
+    /**
+      * Returns the number of datagrams held back by the simulator to reorder them.
+      * @returns The number of datagrams reordered.
+      */
+    uint64_t getReorderedCount() const;
+
+private:
+    /**
+      * A datagram waiting for its delay to pass.
+      */
+    struct Datagram {
+        std::vector<char> mData;    //!< The datagram.
+        sf::IpAddress mAddress;     //!< The address of the remote device.
+        uint16_t mPort;             //!< The port of the remote device.
+    };
+
+    typedef std::multimap<double, Datagram> DatagramQueue;
+
+    /**
+      * Private method. Decides the fate of a datagram and queues it.
+      * @param queue The queue to add the datagram to.
+      * @param direction 0 for outgoing, 1 for incoming datagrams.
+      * @param data The datagram.
+      * @param size The size of the datagram, in bytes.
+      * @param address The address of the remote device.
+      * @param port The port of the remote device.
+      * @param time The current time, in seconds.
+      */
+    void _queue(DatagramQueue& queue, uint32_t direction, const char* data, uint32_t size,
+                const sf::IpAddress& address, uint16_t port, double time);
+
+    /**
+      * Private method. Returns a random number from 0 to 1.
+      * @returns A random number from 0 to 1.
+      */
+    float _random();
+
+    /**
+      * Private method. Returns the key of an endpoint in the maps of the simulator.
+      * @param address The IP address.
+      * @param port The port.
+      * @returns The key.
+      */
+    static uint64_t _endpointKey(const sf::IpAddress& address, uint16_t port);
+
+    bool mIsEnabled;                                            //!< Whether the simulator is enabled.
+    bool mSimulateOutgoing;                                     //!< Whether outgoing datagrams are simulated.
+    bool mSimulateIncoming;                                     //!< Whether received datagrams are simulated.
+    Conditions mConditions;                                     //!< The default conditions.
+    std::unordered_map<uint64_t, Conditions> mEndpointConditions; //!< The conditions of single remote devices.
+    std::unordered_map<uint64_t, double> mBusyUntil;            //!< The time each link is busy until, by endpoint and direction.
+    std::mt19937 mGenerator;                                    //!< The random number generator.
+    DatagramQueue mOutgoing;                                    //!< The outgoing datagrams, by the time they are sent.
+    DatagramQueue mIncoming;                                    //!< The received datagrams, by the time they are handled.
+    uint64_t mLostCount;                                        //!< The number of datagrams lost.
+    uint64_t mDuplicatedCount;                                  //!< The number of datagrams duplicated.
+    uint64_t mReorderedCount;                                   //!< The number of datagrams reordered.
+};
+
+}
+
+#endif
@@ -0,0 +1,951 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/NodeReplicator.hpp>
+
+#include <Network/NetworkChannels.hpp>
+#include <Network/NetworkManager.hpp>
+#include <Network/Quantization.hpp>
+#include <Network/ReplicationAckEvent.hpp>
+#include <Utils/Logger.hpp>
+#include <Utils/Utils.hpp>
+
+#include <SFML/Network/Packet.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace dt {
+
+/**
+  * The number of snapshots remembered per client and on the receiving side. A snapshot has to be
+  * acknowledged within this many updates to become a baseline.
+  */
+static const uint32_t SNAPSHOT_HISTORY_SIZE = 32;
+
+/**
+  * The number of bits per axis of a quantized position.
+  */
+static const uint32_t POSITION_BITS = 16;
+
+/**
+  * The estimated size of a snapshot without entities: the event type, the sequence numbers, the timestamp,
+  * the processed input and the entity count.
+  */
+static const uint32_t SNAPSHOT_HEADER_SIZE = 24;
+
+/**
+  * The space in a datagram kept free of snapshot data for the datagram header and other events.
+  */
+static const uint32_t DATAGRAM_RESERVE = 64;
+
+/**
+  * The difference between the time of a snapshot and the estimated time of the sender, in seconds, beyond
+  * which the estimate is reset instead of corrected, e.g. after a pause.
+  */
+static const double CLOCK_RESET_ERROR = 0.5;
+
+/**
+  * The share of the difference between the time of a snapshot and the estimated time of the sender that is
+  * corrected per snapshot. Small, so the jitter of the snapshots does not make the interpolated nodes shake.
+  */
+static const double CLOCK_CORRECTION = 0.1;
+
+/**
+  * Returns the FNV-1a hash of a block of bytes.
+  */
+static uint32_t hashBytes(const std::vector<char>& data) {
+    uint32_t hash = 2166136261u;
+    for(auto iter = data.begin(); iter != data.end(); ++iter) {
+        hash ^= static_cast<uint8_t>(*iter);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+  * Copies the data of a packet into a vector.
+  */
+static std::vector<char> packetData(const sf::Packet& packet) {
+    const char* data = static_cast<const char*>(packet.getData());
+    return std::vector<char>(data, data + packet.getDataSize());
+}
+
+NodeReplicator::NodeReplicator()
+    : mNextEntityId(1),
+      mSequence(0),
+      mBandwidth(16000),
+      mPositionMin(-1024.f, -1024.f, -1024.f),
+      mPositionMax(1024.f, 1024.f, 1024.f),
+      mUpdateCount(0),
+      mTime(0.0),
+      mSpatialIndex(nullptr),
+      mEnterRadius(50.f),
+      mLeaveRadius(60.f),
+      mReceiveRoot(nullptr),
+      mMatchNodesByName(false),
+      mReceived(SNAPSHOT_HISTORY_SIZE),
+      mLastApplied(0),
+      mHasApplied(false),
+      mInterpolationDelay(0.0),
+      mClock(0.0),
+      mHasClock(false) {
+    for(uint32_t i = 0; i < SNAPSHOT_HISTORY_SIZE; ++i) {
+        mReceived[i].mIsValid = false;
+    }
+
+    NetworkManager* network_manager = NetworkManager::get();
+    network_manager->registerNetworkEventPrototype(std::shared_ptr<NetworkEvent>(new ReplicationEvent()));
+    network_manager->registerNetworkEventPrototype(std::shared_ptr<NetworkEvent>(new ReplicationAckEvent()));
+    QObject::connect(network_manager, SIGNAL(newEvent(std::shared_ptr<dt::NetworkEvent>)),
+                     this,            SLOT(handleEvent(std::shared_ptr<dt::NetworkEvent>)));
+}
+
+uint16_t NodeReplicator::addNode(Node* node, float relevance) {
+    auto existing = mEntityIds.find(node);
+    if(existing != mEntityIds.end()) {
+        mEntities[existing->second].mRelevance = relevance;
+        return existing->second;
+    }
+
+    if(mEntities.size() >= 0xffff) {
+        Logger::get().error("NodeReplicator: No entity ID left for node " + node->getName() + ".");
+        return 0;
+    }
+
+    // hand out the IDs in turn, so the clients have forgotten a removed entity before its ID is used again
+    while(mNextEntityId == 0 || mEntities.count(mNextEntityId) > 0) {
+        ++mNextEntityId;
+    }
+    uint16_t id = mNextEntityId++;
+
+    Entity& entity = mEntities[id];
+    entity.mNode = node;
+    entity.mRelevance = relevance;
+    entity.mIsAlwaysRelevant = false;
+    entity.mCaptured = 0;
+    mEntityIds[node] = id;
+
+    QObject::connect(node, SIGNAL(destroyed(QObject*)), this, SLOT(_onNodeDestroyed(QObject*)));
+    return id;
+}
+
+void NodeReplicator::removeNode(Node* node) {
+    auto iter = mEntityIds.find(node);
+    if(iter == mEntityIds.end())
+        return;
+
+    QObject::disconnect(node, SIGNAL(destroyed(QObject*)), this, SLOT(_onNodeDestroyed(QObject*)));
+    setAlwaysRelevant(node, false);
+    mEntities.erase(iter->second);
+    mEntityIds.erase(iter);
+}
+
+void NodeReplicator::setRelevance(Node* node, float relevance) {
+    auto iter = mEntityIds.find(node);
+    if(iter != mEntityIds.end())
+        mEntities[iter->second].mRelevance = relevance;
+}
+
+void NodeReplicator::setAlwaysRelevant(Node* node, bool always_relevant) {
+    auto iter = mEntityIds.find(node);
+    if(iter == mEntityIds.end())
+        return;
+
+    Entity& entity = mEntities[iter->second];
+    if(entity.mIsAlwaysRelevant == always_relevant)
+        return;
+
+    entity.mIsAlwaysRelevant = always_relevant;
+    if(always_relevant) {
+        mAlwaysRelevant.insert(std::lower_bound(mAlwaysRelevant.begin(), mAlwaysRelevant.end(), iter->second), iter->second);
+    } else {
+        mAlwaysRelevant.erase(std::lower_bound(mAlwaysRelevant.begin(), mAlwaysRelevant.end(), iter->second));
+    }
+}
+
+uint16_t NodeReplicator::getEntityId(Node* node) const {
+    auto iter = mEntityIds.find(node);
+    return (iter != mEntityIds.end()) ? iter->second : 0;
+}
+
+Node* NodeReplicator::getNode(uint16_t entity_id) const {
+    auto entity = mEntities.find(entity_id);
+    if(entity != mEntities.end())
+        return entity->second.mNode;
+
+    auto received = mReceivedNodes.find(entity_id);
+    return (received != mReceivedNodes.end()) ? received->second : nullptr;
+}
+
+void NodeReplicator::addClient(ConnectionsManager::ID_t connection, Node* focus) {
+    Client& client = mClients[connection];
+    client.mFocus = focus;
+    client.mBandwidth = 0;
+    client.mSnapshots.assign(SNAPSHOT_HISTORY_SIZE, Snapshot());
+    for(uint32_t i = 0; i < SNAPSHOT_HISTORY_SIZE; ++i) {
+        client.mSnapshots[i].mIsValid = false;
+    }
+    client.mAcked = 0;
+    client.mHasAck = false;
+    client.mPriorities.clear();
+    client.mLastSize = 0;
+    client.mLastEntityCount = 0;
+    client.mDeferredEntityCount = 0;
+    client.mProcessedInput = 0;
+}
+
+void NodeReplicator::removeClient(ConnectionsManager::ID_t connection) {
+    mClients.erase(connection);
+}
+
+void NodeReplicator::setFocus(ConnectionsManager::ID_t connection, Node* focus) {
+    auto iter = mClients.find(connection);
+    if(iter != mClients.end())
+        iter->second.mFocus = focus;
+}
+
+void NodeReplicator::setBandwidth(uint32_t bytes_per_second) {
+    mBandwidth = bytes_per_second;
+}
+
+void NodeReplicator::setBandwidth(ConnectionsManager::ID_t connection, uint32_t bytes_per_second) {
+    auto iter = mClients.find(connection);
+    if(iter != mClients.end())
+        iter->second.mBandwidth = bytes_per_second;
+}
+
+void NodeReplicator::setSpatialIndex(SpatialIndex* index) {
+    mSpatialIndex = index;
+}
+
+void NodeReplicator::setInterestRadius(float enter_radius, float leave_radius) {
+    mEnterRadius = enter_radius;
+    mLeaveRadius = std::max(enter_radius, leave_radius);
+}
+
+bool NodeReplicator::isRelevant(ConnectionsManager::ID_t connection, Node* node) const {
+    auto client = mClients.find(connection);
+    uint16_t id = getEntityId(node);
+    if(client == mClients.end() || id == 0)
+        return false;
+
+    const std::vector<uint16_t>& interest = client->second.mInterest;
+    return std::binary_search(interest.begin(), interest.end(), id);
+}
+
+void NodeReplicator::addInterestedRecipients(NetworkEvent& event, Node* node) const {
+    uint16_t id = getEntityId(node);
+    if(id == 0)
+        return;
+
+    for(auto iter = mClients.begin(); iter != mClients.end(); ++iter) {
+        const std::vector<uint16_t>& interest = iter->second.mInterest;
+        if(std::binary_search(interest.begin(), interest.end(), id))
+            event.addRecipient(iter->first);
+    }
+}
+
+uint32_t NodeReplicator::getInterestSize(ConnectionsManager::ID_t connection) const {
+    auto iter = mClients.find(connection);
+    return (iter != mClients.end()) ? iter->second.mInterest.size() : 0;
+}
+
+void NodeReplicator::setPositionBounds(const Ogre::Vector3& min, const Ogre::Vector3& max) {
+    mPositionMin = min;
+    mPositionMax = max;
+}
+
+Ogre::Vector3 NodeReplicator::getPositionPrecision() const {
+    return (mPositionMax - mPositionMin) / static_cast<float>((1u << POSITION_BITS) - 1);
+}
+
+void NodeReplicator::setProcessedInput(ConnectionsManager::ID_t connection, uint32_t sequence) {
+    auto iter = mClients.find(connection);
+    if(iter != mClients.end())
+        iter->second.mProcessedInput = sequence;
+}
+
+void NodeReplicator::update(double time_diff) {
+    mTime += time_diff;
+    if(mClients.empty())
+        return;
+
+    ++mUpdateCount;
+    ++mSequence;
+
+    for(auto iter = mClients.begin(); iter != mClients.end(); ++iter) {
+        _updateInterest(iter->second);
+        _writeSnapshot(iter->first, iter->second, time_diff);
+    }
+}
+
+uint32_t NodeReplicator::getLastSnapshotSize(ConnectionsManager::ID_t connection) const {
+    auto iter = mClients.find(connection);
+    return (iter != mClients.end()) ? iter->second.mLastSize : 0;
+}
+
+uint32_t NodeReplicator::getLastSnapshotEntityCount(ConnectionsManager::ID_t connection) const {
+    auto iter = mClients.find(connection);
+    return (iter != mClients.end()) ? iter->second.mLastEntityCount : 0;
+}
+
+uint32_t NodeReplicator::getDeferredEntityCount(ConnectionsManager::ID_t connection) const {
+    auto iter = mClients.find(connection);
+    return (iter != mClients.end()) ? iter->second.mDeferredEntityCount : 0;
+}
+
+void NodeReplicator::setReceiveRoot(Node* root) {
+    mReceiveRoot = root;
+}
+
+void NodeReplicator::setMatchNodesByName(bool match) {
+    mMatchNodesByName = match;
+}
+
+void NodeReplicator::setInterpolationDelay(double delay) {
+    mInterpolationDelay = std::max(delay, 0.0);
+    if(mInterpolationDelay == 0.0)
+        mBuffers.clear();
+}
+
+double NodeReplicator::getInterpolationDelay() const {
+    return mInterpolationDelay;
+}
+
+void NodeReplicator::interpolate(double time_diff) {
+    if(mInterpolationDelay == 0.0 || !mHasClock)
+        return;
+
+    mClock += time_diff;
+    double time = mClock - mInterpolationDelay;
+
+    Ogre::Vector3 position;
+    Ogre::Quaternion rotation;
+    for(auto iter = mBuffers.begin(); iter != mBuffers.end(); ++iter) {
+        auto node = mReceivedNodes.find(iter->first);
+        if(node == mReceivedNodes.end() || _isPredicted(node->second) || !iter->second.sample(time, position, rotation))
+            continue;
+
+        node->second->setPosition(position, Node::SCENE);
+        node->second->setRotation(rotation, Node::SCENE);
+    }
+}
+
+void NodeReplicator::setPredicted(Node* node, bool predicted) {
+    auto iter = std::find(mPredicted.begin(), mPredicted.end(), node);
+    if(predicted && iter == mPredicted.end())
+        mPredicted.push_back(node);
+    else if(!predicted && iter != mPredicted.end())
+        mPredicted.erase(iter);
+}
+
+bool NodeReplicator::getReceivedTransform(Node* node, Ogre::Vector3& position, Ogre::Quaternion& rotation) const {
+    if(!mHasApplied)
+        return false;
+
+    const Snapshot& snapshot = mReceived[mLastApplied % SNAPSHOT_HISTORY_SIZE];
+    if(!snapshot.mIsValid || snapshot.mSequence != mLastApplied)
+        return false;
+
+    for(auto iter = mReceivedNodes.begin(); iter != mReceivedNodes.end(); ++iter) {
+        if(iter->second != node)
+            continue;
+
+        uint16_t id = iter->first;
+        auto state = std::lower_bound(snapshot.mEntities.begin(), snapshot.mEntities.end(), id,
+                                      [] (const EntityState& entity, uint16_t entity_id) { return entity.mId < entity_id; });
+        if(state == snapshot.mEntities.end() || state->mId != id)
+            return false;
+
+        position = _getPosition(*state);
+        rotation = Quantization::dequantizeQuaternion(state->mRotation);
+        return true;
+    }
+    return false;
+}
+
+uint32_t NodeReplicator::getProcessedInput() const {
+    if(!mHasApplied)
+        return 0;
+
+    const Snapshot& snapshot = mReceived[mLastApplied % SNAPSHOT_HISTORY_SIZE];
+    return (snapshot.mIsValid && snapshot.mSequence == mLastApplied) ? snapshot.mProcessedInput : 0;
+}
+
+void NodeReplicator::handleEvent(std::shared_ptr<NetworkEvent> e) {
+    // only handle received events
+    if(!e->isLocalEvent())
+        return;
+
+    std::shared_ptr<ReplicationAckEvent> ack = std::dynamic_pointer_cast<ReplicationAckEvent>(e);
+    if(ack != nullptr) {
+        auto iter = mClients.find(ack->getSenderID());
+        if(iter == mClients.end())
+            return;
+
+        Client& client = iter->second;
+        uint16_t sequence = ack->getSequence();
+        if(client.mHasAck && !NetworkChannels::isNewer(sequence, client.mAcked))
+            return;
+
+        const Snapshot& snapshot = client.mSnapshots[sequence % SNAPSHOT_HISTORY_SIZE];
+        if(snapshot.mIsValid && snapshot.mSequence == sequence) {
+            client.mAcked = sequence;
+            client.mHasAck = true;
+        }
+        return;
+    }
+
+    std::shared_ptr<ReplicationEvent> snapshot = std::dynamic_pointer_cast<ReplicationEvent>(e);
+    if(snapshot != nullptr && mReceiveRoot != nullptr)
+        _applySnapshot(snapshot);
+}
+
+void NodeReplicator::_onNodeDestroyed(QObject* object) {
+    Node* node = static_cast<Node*>(object);
+
+    auto iter = mEntityIds.find(node);
+    if(iter != mEntityIds.end()) {
+        if(mEntities[iter->second].mIsAlwaysRelevant)
+            mAlwaysRelevant.erase(std::lower_bound(mAlwaysRelevant.begin(), mAlwaysRelevant.end(), iter->second));
+        mEntities.erase(iter->second);
+        mEntityIds.erase(iter);
+    }
+
+    for(auto received = mReceivedNodes.begin(); received != mReceivedNodes.end(); ++received) {
+        if(received->second == node) {
+            mBuffers.erase(received->first);
+            mReceivedNodes.erase(received);
+            break;
+        }
+    }
+    setPredicted(node, false);
+
+    for(auto client = mClients.begin(); client != mClients.end(); ++client) {
+        if(client->second.mFocus == node)
+            client->second.mFocus = nullptr;
+    }
+
+    if(mReceiveRoot == node)
+        mReceiveRoot = nullptr;
+}
+
+const NodeReplicator::EntityState& NodeReplicator::_captureEntity(uint16_t id, Entity& entity) {
+    EntityState& state = entity.mState;
+    if(entity.mCaptured == mUpdateCount)
+        return state;
+
+    entity.mCaptured = mUpdateCount;
+    Node* node = entity.mNode;
+    state.mId = id;
+
+    Ogre::Vector3 position = node->getPosition(Node::SCENE);
+    for(uint32_t axis = 0; axis < 3; ++axis) {
+        state.mPosition[axis] = static_cast<uint16_t>(Quantization::quantizeFloat(position[axis],
+            mPositionMin[axis], mPositionMax[axis], POSITION_BITS));
+    }
+    state.mRotation = Quantization::quantizeQuaternion(node->getRotation(Node::SCENE));
+    state.mScale = node->getScale(Node::SCENE);
+    state.mIsEnabled = node->isEnabled();
+
+    if(node->mComponents.empty()) {
+        state.mComponentsHash = 0;
+        state.mComponents.reset();
+        return state;
+    }
+
+    // every component is serialized into a block of its own, so the receiver can skip unknown ones
+    sf::Packet packet;
+    IOPacket io(&packet, IOPacket::SERIALIZE);
+    io.beginList(node->mComponents.size(), "components");
+    for(auto component = node->mComponents.begin(); component != node->mComponents.end(); ++component) {
+        sf::Packet component_packet;
+        IOPacket component_io(&component_packet, IOPacket::SERIALIZE);
+        component->second->onSerialize(component_io);
+
+        QString name = component->second->getName();
+        bool enabled = component->second->isEnabled();
+        std::vector<char> data = packetData(component_packet);
+        io.stream(name, "name");
+        io.stream(enabled, "enabled");
+        io.stream(data, "data");
+    }
+    io.endList();
+
+    std::vector<char> components = packetData(packet);
+    uint32_t hash = hashBytes(components);
+    if(state.mComponents == nullptr || state.mComponentsHash != hash || *state.mComponents != components) {
+        state.mComponentsHash = hash;
+        state.mComponents = std::make_shared<const std::vector<char>>(std::move(components));
+    }
+    return state;
+}
+
+void NodeReplicator::_updateInterest(Client& client) {
+    std::vector<uint16_t>& interest = client.mInterest;
+    interest.clear();
+
+    if(mSpatialIndex == nullptr || client.mFocus == nullptr) {
+        interest.reserve(mEntities.size());
+        for(auto iter = mEntities.begin(); iter != mEntities.end(); ++iter) {
+            interest.push_back(iter->first);
+        }
+        return;
+    }
+
+    // entities enter within the enter radius, but only leave beyond the leave radius
+    mPreviousInterest.swap(interest);
+    Ogre::Vector3 center = client.mFocus->getPosition(Node::SCENE);
+    mQueryResult.clear();
+    mSpatialIndex->queryRadius(center, mLeaveRadius, mQueryResult);
+    for(auto iter = mQueryResult.begin(); iter != mQueryResult.end(); ++iter) {
+        auto entity = mEntityIds.find(*iter);
+        if(entity == mEntityIds.end())
+            continue;
+
+        if((*iter)->getPosition(Node::SCENE).distance(center) <= mEnterRadius
+           || std::binary_search(mPreviousInterest.begin(), mPreviousInterest.end(), entity->second))
+            interest.push_back(entity->second);
+    }
+    mPreviousInterest.clear();
+
+    interest.insert(interest.end(), mAlwaysRelevant.begin(), mAlwaysRelevant.end());
+    std::sort(interest.begin(), interest.end());
+    interest.erase(std::unique(interest.begin(), interest.end()), interest.end());
+}
+
+void NodeReplicator::_writeSnapshot(ConnectionsManager::ID_t id, Client& client, double time_diff) {
+    const State empty;
+    const State* baseline = &empty;
+    bool has_baseline = false;
+    uint32_t acked_input = 0;
+    if(client.mHasAck) {
+        const Snapshot& acked = client.mSnapshots[client.mAcked % SNAPSHOT_HISTORY_SIZE];
+        if(acked.mIsValid && acked.mSequence == client.mAcked) {
+            baseline = &acked.mEntities;
+            has_baseline = true;
+            acked_input = acked.mProcessedInput;
+        }
+    }
+
+    Ogre::Vector3 focus = Ogre::Vector3::ZERO;
+    if(client.mFocus != nullptr)
+        focus = client.mFocus->getPosition(Node::SCENE);
+
+    // compare the interest set with the baseline, both are ordered by ID
+    std::vector<Candidate> candidates;
+    auto current = client.mInterest.begin();
+    auto base = baseline->begin();
+    while(current != client.mInterest.end() || base != baseline->end()) {
+        Candidate candidate;
+        candidate.mEntity = nullptr;
+        candidate.mCurrent = nullptr;
+        candidate.mBaseline = nullptr;
+        candidate.mIsWritten = false;
+
+        // entities outside the interest set are not read at all
+        if(current != client.mInterest.end() && (base == baseline->end() || *current <= base->mId)) {
+            Entity& entity = mEntities.find(*current)->second;
+            candidate.mEntity = &entity;
+            candidate.mCurrent = &_captureEntity(*current, entity);
+            ++current;
+        }
+
+        if(candidate.mCurrent != nullptr && (base == baseline->end() || candidate.mCurrent->mId < base->mId)) {
+            candidate.mFields = ReplicationEvent::CREATED | ReplicationEvent::POSITION | ReplicationEvent::ROTATION
+                | ReplicationEvent::SCALE;
+            if(candidate.mCurrent->mComponents != nullptr)
+                candidate.mFields |= ReplicationEvent::COMPONENTS;
+        } else if(candidate.mCurrent == nullptr) {
+            // removed, or left the interest set
+            candidate.mBaseline = &*base++;
+            candidate.mFields = ReplicationEvent::REMOVED;
+        } else {
+            candidate.mBaseline = &*base++;
+            uint8_t changed = _diff(*candidate.mCurrent, *candidate.mBaseline);
+            if(changed == 0) {
+                client.mPriorities.erase(candidate.mCurrent->mId);
+                continue;
+            }
+            candidate.mFields = changed & ~ReplicationEvent::ENABLED;
+        }
+
+        float weight = 1.f;
+        QString name;
+        if(candidate.mCurrent != nullptr) {
+            if(candidate.mCurrent->mIsEnabled)
+                candidate.mFields |= ReplicationEvent::ENABLED;
+
+            weight = candidate.mEntity->mRelevance;
+            if(client.mFocus != nullptr)
+                weight /= 1.f + candidate.mEntity->mNode->getPosition(Node::SCENE).distance(focus);
+            if(candidate.mFields & ReplicationEvent::CREATED)
+                name = candidate.mEntity->mNode->getName();
+        }
+
+        // the priority grows every update the entity is left out
+        const EntityState& state = (candidate.mCurrent != nullptr) ? *candidate.mCurrent : *candidate.mBaseline;
+        float& priority = client.mPriorities[state.mId];
+        priority += weight;
+        candidate.mPriority = priority;
+        candidate.mSize = _getSize(state, name, candidate.mFields);
+        candidates.push_back(candidate);
+    }
+
+    client.mLastSize = 0;
+    client.mLastEntityCount = 0;
+    client.mDeferredEntityCount = 0;
+    if(candidates.empty() && client.mProcessedInput == acked_input)
+        return;
+
+    // pick the entities with the highest priority that fit into the budget, but at least one
+    std::vector<uint32_t> order(candidates.size());
+    for(uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&candidates] (uint32_t a, uint32_t b) {
+        return candidates[a].mPriority > candidates[b].mPriority || (candidates[a].mPriority == candidates[b].mPriority && a < b);
+    });
+
+    uint32_t bandwidth = (client.mBandwidth > 0) ? client.mBandwidth : mBandwidth;
+    uint32_t max_size = NetworkManager::get()->getMaxDatagramSize();
+    uint32_t budget = std::min(static_cast<uint32_t>(bandwidth * time_diff),
+                               (max_size > DATAGRAM_RESERVE) ? max_size - DATAGRAM_RESERVE : max_size);
+
+    uint32_t size = SNAPSHOT_HEADER_SIZE;
+    uint32_t count = 0;
+    for(auto iter = order.begin(); iter != order.end(); ++iter) {
+        Candidate& candidate = candidates[*iter];
+        if(count > 0 && size + candidate.mSize > budget)
+            continue;
+
+        candidate.mIsWritten = true;
+        size += candidate.mSize;
+        ++count;
+    }
+
+    // the client's state once it has this snapshot: the baseline with the written entities replaced
+    std::shared_ptr<ReplicationEvent> event = NetworkManager::get()->createEvent<ReplicationEvent>();
+    event->reset(mSequence, client.mAcked, has_baseline);
+    event->setTimestamp(static_cast<uint32_t>(mTime * 1000.0));
+    event->setProcessedInput(client.mProcessedInput);
+    std::vector<ReplicationEvent::Entity>& entities = event->getEntities();
+    entities.reserve(count);
+
+    State state;
+    state.reserve(baseline->size() + count);
+    base = baseline->begin();
+    for(auto iter = candidates.begin(); iter != candidates.end(); ++iter) {
+        uint16_t entity_id = (iter->mCurrent != nullptr) ? iter->mCurrent->mId : iter->mBaseline->mId;
+        while(base != baseline->end() && base->mId < entity_id) {
+            state.push_back(*base++);
+        }
+        if(base != baseline->end() && base->mId == entity_id) {
+            if(!iter->mIsWritten)
+                state.push_back(*base);
+            ++base;
+        }
+
+        if(!iter->mIsWritten)
+            continue;
+
+        client.mPriorities.erase(entity_id);
+
+        entities.push_back(ReplicationEvent::Entity());
+        ReplicationEvent::Entity& entity = entities.back();
+        entity.mId = entity_id;
+        entity.mFields = iter->mFields;
+        if(iter->mCurrent == nullptr)
+            continue;
+
+        const EntityState& current_state = *iter->mCurrent;
+        state.push_back(current_state);
+
+        if(entity.mFields & ReplicationEvent::CREATED)
+            entity.mName = iter->mEntity->mNode->getName();
+        std::copy(current_state.mPosition, current_state.mPosition + 3, entity.mPosition);
+        entity.mRotation = current_state.mRotation;
+        entity.mScale = current_state.mScale;
+        if((entity.mFields & ReplicationEvent::COMPONENTS) && current_state.mComponents != nullptr)
+            entity.mComponents = *current_state.mComponents;
+    }
+    while(base != baseline->end()) {
+        state.push_back(*base++);
+    }
+
+    // the slot may hold the baseline, so it is replaced only now
+    Snapshot& snapshot = client.mSnapshots[mSequence % SNAPSHOT_HISTORY_SIZE];
+    snapshot.mSequence = mSequence;
+    snapshot.mIsValid = true;
+    snapshot.mEntities.swap(state);
+    snapshot.mProcessedInput = client.mProcessedInput;
+
+    event->clearRecipients();
+    event->addRecipient(id);
+    NetworkManager::get()->queueEvent(event);
+
+    client.mLastSize = size;
+    client.mLastEntityCount = count;
+    client.mDeferredEntityCount = candidates.size() - count;
+}
+
+void NodeReplicator::_applySnapshot(std::shared_ptr<ReplicationEvent> event) {
+    uint16_t sequence = event->getSequence();
+    if(mHasApplied && !NetworkChannels::isNewer(sequence, mLastApplied))
+        return;
+
+    const State empty;
+    const State* baseline = &empty;
+    if(event->hasBaseline()) {
+        const Snapshot& snapshot = mReceived[event->getBaseline() % SNAPSHOT_HISTORY_SIZE];
+        if(!snapshot.mIsValid || snapshot.mSequence != event->getBaseline()) {
+            // the baseline is gone, wait for a snapshot relative to a newer one
+            return;
+        }
+        baseline = &snapshot.mEntities;
+    }
+
+    // rebuild the full state from the baseline and the changes, both are ordered by ID
+    State state;
+    std::vector<ReplicationEvent::Entity>& entities = event->getEntities();
+    state.reserve(baseline->size() + entities.size());
+    auto base = baseline->begin();
+    for(auto iter = entities.begin(); iter != entities.end(); ++iter) {
+        while(base != baseline->end() && base->mId < iter->mId) {
+            state.push_back(*base++);
+        }
+
+        const EntityState* previous = nullptr;
+        if(base != baseline->end() && base->mId == iter->mId)
+            previous = &*base++;
+
+        if(iter->mFields & ReplicationEvent::REMOVED)
+            continue;
+
+        EntityState entity;
+        if(previous != nullptr && !(iter->mFields & ReplicationEvent::CREATED)) {
+            entity = *previous;
+        } else {
+            std::fill(entity.mPosition, entity.mPosition + 3, 0);
+            entity.mRotation = Quantization::quantizeQuaternion(Ogre::Quaternion::IDENTITY);
+            entity.mScale = Ogre::Vector3::UNIT_SCALE;
+            entity.mComponentsHash = 0;
+        }
+
+        entity.mId = iter->mId;
+        if(iter->mFields & ReplicationEvent::CREATED)
+            entity.mName = iter->mName;
+        if(iter->mFields & ReplicationEvent::POSITION)
+            std::copy(iter->mPosition, iter->mPosition + 3, entity.mPosition);
+        if(iter->mFields & ReplicationEvent::ROTATION)
+            entity.mRotation = iter->mRotation;
+        if(iter->mFields & ReplicationEvent::SCALE)
+            entity.mScale = iter->mScale;
+        entity.mIsEnabled = (iter->mFields & ReplicationEvent::ENABLED) != 0;
+        if(iter->mFields & ReplicationEvent::COMPONENTS) {
+            entity.mComponentsHash = hashBytes(iter->mComponents);
+            entity.mComponents.reset();
+            if(!iter->mComponents.empty())
+                entity.mComponents = std::make_shared<const std::vector<char>>(std::move(iter->mComponents));
+        }
+        state.push_back(entity);
+    }
+    while(base != baseline->end()) {
+        state.push_back(*base++);
+    }
+
+    // keep the estimated time of the sender close to the time of the newest snapshot
+    double time = event->getTimestamp() / 1000.0;
+    if(!mHasClock || std::abs(time - mClock) > CLOCK_RESET_ERROR)
+        mClock = time;
+    else
+        mClock += (time - mClock) * CLOCK_CORRECTION;
+    mHasClock = true;
+
+    // move the nodes from the state applied last to the new one
+    const State* applied = &empty;
+    if(mHasApplied) {
+        const Snapshot& snapshot = mReceived[mLastApplied % SNAPSHOT_HISTORY_SIZE];
+        if(snapshot.mIsValid && snapshot.mSequence == mLastApplied)
+            applied = &snapshot.mEntities;
+    }
+
+    auto next = state.begin();
+    auto last = applied->begin();
+    while(next != state.end() || last != applied->end()) {
+        if(last == applied->end() || (next != state.end() && next->mId < last->mId)) {
+            _applyEntity(*next++, nullptr, time);
+        } else if(next == state.end() || last->mId < next->mId) {
+            _forgetReceived(last->mId);
+            ++last;
+        } else {
+            _applyEntity(*next++, &*last++, time);
+        }
+    }
+
+    Snapshot& snapshot = mReceived[sequence % SNAPSHOT_HISTORY_SIZE];
+    snapshot.mSequence = sequence;
+    snapshot.mIsValid = true;
+    snapshot.mEntities.swap(state);
+    snapshot.mProcessedInput = event->getProcessedInput();
+    mLastApplied = sequence;
+    mHasApplied = true;
+
+    std::shared_ptr<ReplicationAckEvent> ack = NetworkManager::get()->createEvent<ReplicationAckEvent>();
+    ack->setSequence(sequence);
+    ack->clearRecipients();
+    ack->addRecipient(event->getSenderID());
+    NetworkManager::get()->queueEvent(ack);
+}
+
+void NodeReplicator::_applyEntity(const EntityState& state, const EntityState* previous, double time) {
+    Node* node = nullptr;
+    auto iter = mReceivedNodes.find(state.mId);
+    if(iter != mReceivedNodes.end()) {
+        node = iter->second;
+    } else {
+        Node::NodeSP existing = mReceiveRoot->findChildNode(state.mName, false);
+        bool matched = existing != nullptr && mMatchNodesByName;
+        for(auto received = mReceivedNodes.begin(); matched && received != mReceivedNodes.end(); ++received) {
+            if(received->second == existing.get())
+                matched = false;
+        }
+
+        if(matched) {
+            node = existing.get();
+        } else if(existing != nullptr) {
+            // the name is taken, child names have to be unique
+            node = mReceiveRoot->addChildNode(new Node(state.mName + "-" + Utils::toString(state.mId))).get();
+        } else {
+            node = mReceiveRoot->addChildNode(new Node(state.mName)).get();
+        }
+
+        mReceivedNodes[state.mId] = node;
+        QObject::connect(node, SIGNAL(destroyed(QObject*)), this, SLOT(_onNodeDestroyed(QObject*)));
+        previous = nullptr;
+    }
+
+    uint8_t fields = (previous != nullptr) ? _diff(state, *previous) : 0xff;
+
+    if(_isPredicted(node)) {
+        fields &= ~(ReplicationEvent::POSITION | ReplicationEvent::ROTATION);
+    } else if(mInterpolationDelay > 0.0) {
+        // every snapshot adds a transform, also when the node stands still; only new nodes are placed at once
+        SnapshotBuffer& buffer = mBuffers[state.mId];
+        if(buffer.getSize() > 0)
+            fields &= ~(ReplicationEvent::POSITION | ReplicationEvent::ROTATION);
+        buffer.add(time, _getPosition(state), Quantization::dequantizeQuaternion(state.mRotation));
+    }
+
+    if(fields & ReplicationEvent::POSITION)
+        node->setPosition(_getPosition(state), Node::SCENE);
+    if(fields & ReplicationEvent::ROTATION)
+        node->setRotation(Quantization::dequantizeQuaternion(state.mRotation), Node::SCENE);
+    if(fields & ReplicationEvent::SCALE)
+        node->setScale(state.mScale, Node::SCENE);
+    if((fields & ReplicationEvent::ENABLED) && state.mIsEnabled != node->isEnabled()) {
+        if(state.mIsEnabled)
+            node->enable();
+        else
+            node->disable();
+    }
+
+    if(!(fields & ReplicationEvent::COMPONENTS) || state.mComponents == nullptr)
+        return;
+
+    sf::Packet packet;
+    packet.append(&(*state.mComponents)[0], state.mComponents->size());
+    IOPacket io(&packet, IOPacket::DESERIALIZE);
+    uint32_t count = io.beginList(0, "components");
+    for(uint32_t i = 0; i < count; ++i) {
+        QString name;
+        bool enabled = true;
+        std::vector<char> data;
+        io.stream(name, "name");
+        io.stream(enabled, "enabled");
+        io.stream(data, "data");
+
+        // components that only exist on the sending side are skipped
+        std::shared_ptr<Component> component = node->findComponent<Component>(name);
+        if(component == nullptr)
+            continue;
+
+        sf::Packet component_packet;
+        if(!data.empty())
+            component_packet.append(&data[0], data.size());
+        IOPacket component_io(&component_packet, IOPacket::DESERIALIZE);
+        component->onSerialize(component_io);
+
+        if(enabled != component->isEnabled()) {
+            if(enabled)
+                component->enable();
+            else
+                component->disable();
+        }
+    }
+    io.endList();
+}
+
+void NodeReplicator::_forgetReceived(uint16_t id) {
+    mBuffers.erase(id);
+
+    auto iter = mReceivedNodes.find(id);
+    if(iter == mReceivedNodes.end())
+        return;
+
+    QObject::disconnect(iter->second, SIGNAL(destroyed(QObject*)), this, SLOT(_onNodeDestroyed(QObject*)));
+    setPredicted(iter->second, false);
+    iter->second->kill();
+    mReceivedNodes.erase(iter);
+}
+
+bool NodeReplicator::_isPredicted(Node* node) const {
+    return std::find(mPredicted.begin(), mPredicted.end(), node) != mPredicted.end();
+}
+
+Ogre::Vector3 NodeReplicator::_getPosition(const EntityState& state) const {
+    Ogre::Vector3 position;
+    for(uint32_t axis = 0; axis < 3; ++axis) {
+        position[axis] = Quantization::dequantizeFloat(state.mPosition[axis], mPositionMin[axis],
+                                                       mPositionMax[axis], POSITION_BITS);
+    }
+    return position;
+}
+
+uint8_t NodeReplicator::_diff(const EntityState& a, const EntityState& b) {
+    uint8_t fields = 0;
+    if(!std::equal(a.mPosition, a.mPosition + 3, b.mPosition))
+        fields |= ReplicationEvent::POSITION;
+    if(a.mRotation != b.mRotation)
+        fields |= ReplicationEvent::ROTATION;
+    if(a.mScale != b.mScale)
+        fields |= ReplicationEvent::SCALE;
+    if(a.mIsEnabled != b.mIsEnabled)
+        fields |= ReplicationEvent::ENABLED;
+    if(a.mComponentsHash != b.mComponentsHash || (a.mComponents == nullptr) != (b.mComponents == nullptr))
+        fields |= ReplicationEvent::COMPONENTS;
+    return fields;
+}
+
+uint32_t NodeReplicator::_getSize(const EntityState& state, const QString& name, uint8_t fields) {
+    uint32_t size = 3;
+    if(fields & ReplicationEvent::CREATED)
+        size += 4 + name.toUtf8().size();
+    if(fields & ReplicationEvent::POSITION)
+        size += 6;
+    if(fields & ReplicationEvent::ROTATION)
+        size += 4;
+    if(fields & ReplicationEvent::SCALE)
+        size += 12;
+    if(fields & ReplicationEvent::COMPONENTS)
+        size += 4 + ((state.mComponents != nullptr) ? state.mComponents->size() : 0);
+    return size;
+}
+
+}
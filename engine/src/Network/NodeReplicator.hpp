@@ -0,0 +1,483 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_NODEREPLICATOR
+#define DUCTTAPE_ENGINE_NETWORK_NODEREPLICATOR
+
+#include <Config.hpp>
+
+#include <Network/ConnectionsManager.hpp>
+#include <Network/NetworkEvent.hpp>
+#include <Network/ReplicationEvent.hpp>
+#include <Network/SnapshotBuffer.hpp>
+#include <Scene/Node.hpp>
+#include <Scene/SpatialIndex.hpp>
+
+#include <OgreQuaternion.h>
+#include <OgreVector3.h>
+
+#include <QObject>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace dt {
+
+/**
+  * Replicates the transform, the enabled state and the components of nodes to remote devices. Each call of
+  * update() sends every client a snapshot holding only the fields that changed since the latest snapshot the
+  * client acknowledged. Positions are quantized to 16 bits per axis within the position bounds and rotations
+  * to 32 bits. When the changed entities do not fit into the bandwidth budget of a client, those with the
+  * highest priority are sent first: the priority of a changed entity grows with its relevance and its
+  * closeness to the focus node of the client every update it is left out, so no entity starves.
+  * With a SpatialIndex set, each client only gets the entities around its focus node: entities enter its
+  * interest set within the enter radius and leave it beyond the larger leave radius, so entities at the
+  * border do not flap in and out. The interest sets are computed with spatial queries, so their cost
+  * depends on the number of entities close to the clients, not on the number of all entities.
+  * The receiving side applies the snapshots to the nodes below its receive root, creating a node for each new entity.
+  * Both sides have to use the same position bounds. With an interpolation delay set, the received transforms
+  * are buffered with the time of the sender instead, and interpolate() moves the nodes to where they were that
+  * long ago, so they move smoothly between snapshots. The node of the local player can be left to a
+  * ClientPrediction, which reconciles it with the transform in the snapshots.
+  * @code
+  * // server
+  * replicator.addNode(player);
+  * replicator.addClient(connection_id, player);
+  * replicator.setSpatialIndex(scene->getSpatialIndex());
+  * replicator.update(time_diff);
+  * NetworkManager::get()->sendQueuedEvents();
+  * // client
+  * replicator.setReceiveRoot(scene);
+  * replicator.setInterpolationDelay(0.1);
+  * replicator.interpolate(time_diff);
+  * @endcode
+  * @see ReplicationEvent
+  * @see ClientPrediction
+  */
+class DUCTTAPE_API NodeReplicator : public QObject {
+    Q_OBJECT
+public:
+    /**
+      * Default constructor. Registers the replication events with the NetworkManager.
+      */
+    NodeReplicator();
+
+    /**
+      * Adds a node to be replicated to all clients.
+      * @param node The node.
+      * @param relevance The weight of the node when prioritizing entities. Default: 1.
+      * @returns The entity ID of the node, or 0 if no ID is left.
+      */
+    uint16_t addNode(Node* node, float relevance = 1.f);
+
+    /**
+      * Stops replicating a node. The clients remove their copy of it.
+      * @param node The node.
+      */
+    void removeNode(Node* node);
+
+    /**
+      * Sets the weight of a node when prioritizing entities.
+      * @param node The node.
+      * @param relevance The weight.
+      */
+    void setRelevance(Node* node, float relevance);
+
+    /**
+      * Sets whether a node is in the interest set of every client, wherever it is.
+      * @param node The node.
+      * @param always_relevant Whether the node is always relevant.
+      */
+    void setAlwaysRelevant(Node* node, bool always_relevant);
+
+    /**
+      * Returns the entity ID of a replicated node.
+      * @param node The node.
+      * @returns The entity ID, or 0 if the node is not replicated.
+      */
+    uint16_t getEntityId(Node* node) const;
+
+    /**
+      * Returns the node of an entity, on the sending or the receiving side.
+      * @param entity_id The entity ID.
+      * @returns The node, or nullptr if there is none.
+      */
+    Node* getNode(uint16_t entity_id) const;
+
+    /**
+      * Adds a remote device to replicate the nodes to.
+      * @param connection The ID of the connection to the client.
+      * @param focus The node the client looks from, usually its avatar. Entities close to it are sent first.
+      */
+    void addClient(ConnectionsManager::ID_t connection, Node* focus = nullptr);
+
+    /**
+      * Removes a client.
+      * @param connection The ID of the connection to the client.
+      */
+    void removeClient(ConnectionsManager::ID_t connection);
+
+    /**
+      * Sets the node a client looks from.
+      * @param connection The ID of the connection to the client.
+      * @param focus The node, or nullptr to prioritize by relevance only.
+      */
+    void setFocus(ConnectionsManager::ID_t connection, Node* focus);
+
+    /**
+      * Sets the bandwidth budget of the clients without a budget of their own. Default: 16000.
+      * @param bytes_per_second The budget, in bytes per second.
+      */
+    void setBandwidth(uint32_t bytes_per_second);
+
+    /**
+      * Sets the bandwidth budget of one client.
+      * @param connection The ID of the connection to the client.
+      * @param bytes_per_second The budget, in bytes per second, or 0 to use the default budget.
+      */
+    void setBandwidth(ConnectionsManager::ID_t connection, uint32_t bytes_per_second);
+
+    /**
+      * Sets the index the interest sets are computed from. The replicated nodes have to be added to it.
+      * @param index The index, or nullptr to send all entities to all clients. Default: nullptr.
+      */
+    void setSpatialIndex(SpatialIndex* index);
+
+    /**
+      * Sets the distances from the focus node at which entities enter and leave the interest set of a client.
+      * Default: 50 and 60.
+      * @param enter_radius Entities closer than this enter the interest set.
+      * @param leave_radius Entities farther away than this leave the interest set. Should be larger than enter_radius.
+      */
+    void setInterestRadius(float enter_radius, float leave_radius);
+
+    /**
+      * Returns whether a node is in the interest set of a client. Clients without a focus node, or all clients if
+      * there is no SpatialIndex, are interested in all nodes. The interest sets are updated by update().
+      * @param connection The ID of the connection to the client.
+      * @param node The node.
+      * @returns True if the client is interested in the node.
+      */
+    bool isRelevant(ConnectionsManager::ID_t connection, Node* node) const;
+
+    /**
+      * Adds the clients interested in a node to the recipients of an event, so events about the node
+      * only go where the node is replicated to.
+      * @param event The event.
+      * @param node The node the event is about.
+      */
+    void addInterestedRecipients(NetworkEvent& event, Node* node) const;
+
+    /**
+      * Returns the number of entities in the interest set of a client.
+      * @param connection The ID of the connection to the client.
+      * @returns The number of entities.
+      */
+    uint32_t getInterestSize(ConnectionsManager::ID_t connection) const;
+
+    /**
+      * Sets the range positions are quantized in. Positions outside are clamped. Default: -1024 to 1024 on all axes.
+      * @param min The lower corner of the range.
+      * @param max The upper corner of the range.
+      */
+    void setPositionBounds(const Ogre::Vector3& min, const Ogre::Vector3& max);
+
+    /**
+      * Returns the size of a quantization step of the positions, per axis. A received position is off by up
+      * to half of that.
+      * @returns The size of a quantization step.
+      * @see ClientPrediction::setTolerance
+      */
+    Ogre::Vector3 getPositionPrecision() const;
+
+    /**
+      * Sets the latest input of a client that has been applied, to be sent with the next snapshots. Snapshots
+      * are sent until the client acknowledges one with it, even if no entity changed.
+      * @param connection The ID of the connection to the client.
+      * @param sequence The sequence number of the input.
+      * @see ClientPrediction
+      */
+    void setProcessedInput(ConnectionsManager::ID_t connection, uint32_t sequence);
+
+    /**
+      * Sends every client a snapshot of the entities that changed since the latest snapshot it acknowledged.
+      * The snapshots are queued at the NetworkManager.
+      * @param time_diff The time since the last update, in seconds. The bandwidth budget of this update depends on it.
+      */
+    void update(double time_diff);
+
+    /**
+      * Returns the estimated size of the last snapshot sent to a client.
+      * @param connection The ID of the connection to the client.
+      * @returns The size, in bytes.
+      */
+    uint32_t getLastSnapshotSize(ConnectionsManager::ID_t connection) const;
+
+    /**
+      * Returns the number of entities in the last snapshot sent to a client.
+      * @param connection The ID of the connection to the client.
+      * @returns The number of entities.
+      */
+    uint32_t getLastSnapshotEntityCount(ConnectionsManager::ID_t connection) const;
+
+    /**
+      * Returns the number of changed entities left out of the last snapshot sent to a client, because of its bandwidth budget.
+      * @param connection The ID of the connection to the client.
+      * @returns The number of entities deferred.
+      */
+    uint32_t getDeferredEntityCount(ConnectionsManager::ID_t connection) const;
+
+    /**
+      * Sets the node received snapshots are applied below. A child node is created for each new entity.
+      * @param root The node, or nullptr to ignore received snapshots.
+      */
+    void setReceiveRoot(Node* root);
+
+    /**
+      * Sets whether new entities are applied to existing children of the receive root with the same name,
+      * instead of new child nodes. Only direct children not used by another entity are matched. Matched
+      * nodes are treated like created ones, so they are killed when their entity is removed.
+      * @param match Whether to match existing nodes by name. Default: false.
+      */
+    void setMatchNodesByName(bool match);
+
+    /**
+      * Sets how far behind the sender the received nodes are shown. The delay should be longer than the time
+      * between two snapshots plus the jitter, so there is usually a newer transform to interpolate towards.
+      * @param delay The delay, in seconds, or 0 to apply received transforms at once. Default: 0.
+      */
+    void setInterpolationDelay(double delay);
+
+    /**
+      * Returns how far behind the sender the received nodes are shown.
+      * @returns The delay, in seconds.
+      */
+    double getInterpolationDelay() const;
+
+    /**
+      * Moves the received nodes to their interpolated transforms. Only needed with an interpolation delay set,
+      * every frame or every fixed step.
+      * @param time_diff The time since the last call, in seconds.
+      */
+    void interpolate(double time_diff);
+
+    /**
+      * Sets whether a received node is moved by a ClientPrediction. Received transforms are not applied to
+      * it, but can be looked up with getReceivedTransform() to reconcile the node.
+      * @param node The node.
+      * @param predicted Whether the node is predicted.
+      */
+    void setPredicted(Node* node, bool predicted);
+
+    /**
+      * Returns the transform of a received node in the latest snapshot applied.
+      * @param node The node.
+      * @param position The position is written here.
+      * @param rotation The rotation is written here.
+      * @returns False if the node is not in the latest snapshot.
+      */
+    bool getReceivedTransform(Node* node, Ogre::Vector3& position, Ogre::Quaternion& rotation) const;
+
+    /**
+      * Returns the latest input of this device the sender processed, as of the latest snapshot applied.
+      * @returns The sequence number of the input, or 0 if none has been processed.
+      */
+    uint32_t getProcessedInput() const;
+
+public slots:
+    /**
+      * Handles the received snapshots and acknowledgements.
+      * @param e The event.
+      */
+    void handleEvent(std::shared_ptr<dt::NetworkEvent> e);
+
+private slots:
+    /**
+      * Forgets a node that has been destroyed.
+      * @param object The node.
+      */
+    void _onNodeDestroyed(QObject* object);
+
+private:
+    /**
+      * The replicated state of one entity.
+      */
+    struct EntityState {
+        uint16_t mId;                                           //!< The entity ID.
+        QString mName;                                          //!< The name of the node. Only kept on the receiving side.
+        uint16_t mPosition[3];                                  //!< The quantized position.
+        uint32_t mRotation;                                     //!< The packed rotation.
+        Ogre::Vector3 mScale;                                   //!< The scale.
+        bool mIsEnabled;                                        //!< Whether the node is enabled.
+        uint32_t mComponentsHash;                               //!< The hash of the serialized components.
+        std::shared_ptr<const std::vector<char>> mComponents;   //!< The serialized components, or nullptr if there are none.
+    };
+
+    typedef std::vector<EntityState> State;     //!< The state of all entities, ordered by ID.
+
+    /**
+      * A snapshot sent or received.
+      */
+    struct Snapshot {
+        uint16_t mSequence;         //!< The sequence number.
+        bool mIsValid;              //!< Whether the record is in use.
+        State mEntities;            //!< The entities.
+        uint32_t mProcessedInput;   //!< The latest input of the client processed, sent with the snapshot.
+    };
+
+    /**
+      * A replicated node.
+      */
+    struct Entity {
+        Node* mNode;            //!< The node.
+        float mRelevance;       //!< The weight of the node when prioritizing entities.
+        bool mIsAlwaysRelevant; //!< Whether the node is in every interest set.
+        EntityState mState;     //!< The state of the node, read once per update when a client is interested in it.
+        uint32_t mCaptured;     //!< The update the state was read in.
+    };
+
+    /**
+      * A remote device the nodes are replicated to.
+      */
+    struct Client {
+        Node* mFocus;                                   //!< The node the client looks from.
+        uint32_t mBandwidth;                            //!< The bandwidth budget, in bytes per second, or 0 for the default.
+        std::vector<Snapshot> mSnapshots;               //!< The snapshots sent recently, indexed by sequence.
+        uint16_t mAcked;                                //!< The latest snapshot acknowledged.
+        bool mHasAck;                                   //!< Whether a snapshot has been acknowledged.
+        std::unordered_map<uint16_t, float> mPriorities; //!< The accumulated priority of the changed entities.
+        std::vector<uint16_t> mInterest;                //!< The IDs of the entities the client is interested in, ordered.
+        uint32_t mLastSize;                             //!< The estimated size of the last snapshot.
+        uint32_t mLastEntityCount;                      //!< The number of entities in the last snapshot.
+        uint32_t mDeferredEntityCount;                  //!< The number of changed entities left out of the last snapshot.
+        uint32_t mProcessedInput;                       //!< The latest input of the client applied.
+    };
+
+    /**
+      * A changed entity to be sent to a client.
+      */
+    struct Candidate {
+        const Entity* mEntity;          //!< The entity, or nullptr if it has been removed or left the interest set.
+        const EntityState* mCurrent;    //!< The current state, or nullptr if the entity is gone for the client.
+        const EntityState* mBaseline;   //!< The state in the baseline, or nullptr if it is not in the baseline.
+        uint8_t mFields;                //!< The fields to send.
+        uint32_t mSize;                 //!< The estimated size of the entity in the snapshot, in bytes.
+        float mPriority;                //!< The accumulated priority.
+        bool mIsWritten;                //!< Whether the entity is in the snapshot.
+    };
+
+    /**
+      * Private method. Reads the current state of a node, once per update.
+      * @param id The entity ID.
+      * @param entity The entity.
+      * @returns The state.
+      */
+    const EntityState& _captureEntity(uint16_t id, Entity& entity);
+
+    /**
+      * Private method. Recomputes the interest set of a client.
+      * @param client The client.
+      */
+    void _updateInterest(Client& client);
+
+    /**
+      * Private method. Sends a client the entities that changed since its baseline, within its budget.
+      * @param id The ID of the connection to the client.
+      * @param client The client.
+      * @param time_diff The time since the last update, in seconds.
+      */
+    void _writeSnapshot(ConnectionsManager::ID_t id, Client& client, double time_diff);
+
+    /**
+      * Private method. Applies a received snapshot.
+      * @param event The snapshot.
+      */
+    void _applySnapshot(std::shared_ptr<ReplicationEvent> event);
+
+    /**
+      * Private method. Moves a received node to a new state.
+      * @param state The new state.
+      * @param previous The state applied before, or nullptr if the entity is new.
+      * @param time The time of the sender the state was captured at, in seconds.
+      */
+    void _applyEntity(const EntityState& state, const EntityState* previous, double time);
+
+    /**
+      * Private method. Forgets a received entity.
+      * @param id The entity ID.
+      */
+    void _forgetReceived(uint16_t id);
+
+    /**
+      * Private method. Returns whether a received node is moved by a ClientPrediction.
+      * @param node The node.
+      * @returns True if the node is predicted.
+      */
+    bool _isPredicted(Node* node) const;
+
+    /**
+      * Private method. Returns the position of an entity state.
+      * @param state The state.
+      * @returns The dequantized position.
+      */
+    Ogre::Vector3 _getPosition(const EntityState& state) const;
+
+    /**
+      * Private method. Returns the fields that differ between two states of an entity.
+      * @param a The first state.
+      * @param b The second state.
+      * @returns The fields that differ.
+      */
+    static uint8_t _diff(const EntityState& a, const EntityState& b);
+
+    /**
+      * Private method. Returns the number of bytes the fields of an entity take in a snapshot.
+      * @param state The state of the entity.
+      * @param name The name of the node, sent with created entities.
+      * @param fields The fields sent.
+      * @returns The estimated size, in bytes.
+      */
+    static uint32_t _getSize(const EntityState& state, const QString& name, uint8_t fields);
+
+    std::map<uint16_t, Entity> mEntities;               //!< The replicated nodes, by entity ID.
+    std::unordered_map<Node*, uint16_t> mEntityIds;     //!< The entity IDs, by node.
+    uint16_t mNextEntityId;                             //!< The entity ID tried first for the next node.
+    std::map<ConnectionsManager::ID_t, Client> mClients; //!< The clients, by connection ID.
+    uint16_t mSequence;                                 //!< The sequence number of the latest snapshot.
+    uint32_t mBandwidth;                                //!< The default bandwidth budget, in bytes per second.
+    Ogre::Vector3 mPositionMin;                         //!< The lower corner of the position range.
+    Ogre::Vector3 mPositionMax;                         //!< The upper corner of the position range.
+    std::vector<uint16_t> mAlwaysRelevant;              //!< The IDs of the entities in every interest set, ordered.
+    uint32_t mUpdateCount;                              //!< The number of calls of update().
+    double mTime;                                       //!< The time since the first update, in seconds. Sent with the snapshots.
+
+    SpatialIndex* mSpatialIndex;                        //!< The index the interest sets are computed from.
+    float mEnterRadius;                                 //!< The distance within which entities enter an interest set.
+    float mLeaveRadius;                                 //!< The distance beyond which entities leave an interest set.
+    std::vector<Node*> mQueryResult;                    //!< The result of the last spatial query. Reused.
+    std::vector<uint16_t> mPreviousInterest;            //!< The previous interest set of the client being updated. Reused.
+
+    Node* mReceiveRoot;                                 //!< The node received snapshots are applied below.
+    bool mMatchNodesByName;                             //!< Whether new entities are applied to existing children of the receive root by name.
+    std::unordered_map<uint16_t, Node*> mReceivedNodes; //!< The nodes of the received entities, by entity ID.
+    std::vector<Snapshot> mReceived;                    //!< The snapshots received recently, indexed by sequence.
+    uint16_t mLastApplied;                              //!< The sequence number of the latest snapshot applied.
+    bool mHasApplied;                                   //!< Whether a snapshot has been applied.
+    double mInterpolationDelay;                         //!< How far behind the sender the received nodes are shown, in seconds.
+    double mClock;                                      //!< The estimated time of the sender, in seconds.
+    bool mHasClock;                                     //!< Whether a snapshot has set mClock.
+    std::unordered_map<uint16_t, SnapshotBuffer> mBuffers; //!< The buffered transforms of the received entities, by entity ID.
+    std::vector<Node*> mPredicted;                      //!< The received nodes moved by a ClientPrediction.
+};
+
+}
+
+#endif
@@ -18,6 +18,11 @@ const QString PingEvent::getType() const {
     return "DT_PINGEVENT";
 }
 
+NetworkEvent::Priority PingEvent::getPriority() const {
+    // a delayed ping measures the queue, not the connection
+    return HIGH;
+}
+
 std::shared_ptr<NetworkEvent> PingEvent::clone() const {
     std::shared_ptr<NetworkEvent> ptr(new PingEvent(mTimestamp, mIsReply));
     return ptr;
@@ -32,8 +37,16 @@ bool PingEvent::isReply() const {
     return mIsReply;
 }
 
+void PingEvent::isReply(bool is_reply) {
+    mIsReply = is_reply;
+}
+
 double PingEvent::getTimestamp() const {
     return mTimestamp;
 }
 
+void PingEvent::setTimestamp(double timestamp) {
+    mTimestamp = timestamp;
+}
+
 }
@@ -31,6 +31,7 @@ public:
       */
     PingEvent(double timestamp, bool is_reply = false);
     const QString getType() const;
+    Priority getPriority() const;
 
     std::shared_ptr<NetworkEvent> clone() const;
     void serialize(IOPacket& p);
@@ -41,12 +42,24 @@ public:
       */
     bool isReply() const;
 
+    /**
+      * Sets whether this ping is a reply.
+      * @param is_reply Whether this ping is a reply.
+      */
+    void isReply(bool is_reply);
+
     /**
       * Returns the time the ping was sent.
       * @returns The time the ping was sent.
       */
     double getTimestamp() const;
 
+    /**
+      * Sets the time the ping was sent.
+      * @param timestamp The time the ping was sent.
+      */
+    void setTimestamp(double timestamp);
+
 protected:
     bool mIsReply;          //!< Whether this ping is a reply.
     double mTimestamp;    //!< The time the ping was sent.
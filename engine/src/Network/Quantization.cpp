@@ -0,0 +1,87 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/Quantization.hpp>
+
+#include <Utils/Math.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace dt {
+
+/**
+  * The number of bits of each of the three smallest quaternion components.
+  */
+static const uint32_t QUATERNION_COMPONENT_BITS = 10;
+
+/**
+  * The range of the three smallest components of a unit quaternion: none of them can exceed 1 / sqrt(2).
+  */
+static const float QUATERNION_COMPONENT_RANGE = 0.70710678f;
+
+namespace Quantization {
+    static uint32_t maxValue(uint32_t bits) {
+        return (bits >= 32) ? 0xffffffffu : (1u << bits) - 1;
+    }
+
+    uint32_t quantizeFloat(float value, float min, float max, uint32_t bits) {
+        float normalized = (Math::clamp(value, min, max) - min) / (max - min);
+        return static_cast<uint32_t>(std::floor(normalized * maxValue(bits) + 0.5));
+    }
+
+    float dequantizeFloat(uint32_t value, float min, float max, uint32_t bits) {
+        return min + (max - min) * static_cast<float>(static_cast<double>(value) / maxValue(bits));
+    }
+
+    uint32_t quantizeQuaternion(const Ogre::Quaternion& q) {
+        Ogre::Quaternion n = q;
+        n.normalise();
+        float components[4] = {n.w, n.x, n.y, n.z};
+
+        uint32_t largest = 0;
+        for(uint32_t i = 1; i < 4; ++i) {
+            if(std::fabs(components[i]) > std::fabs(components[largest]))
+                largest = i;
+        }
+
+        // make the largest component positive, so its sign does not have to be sent
+        float sign = (components[largest] < 0) ? -1.f : 1.f;
+
+        uint32_t result = largest;
+        for(uint32_t i = 0; i < 4; ++i) {
+            if(i == largest)
+                continue;
+            result = (result << QUATERNION_COMPONENT_BITS) | quantizeFloat(components[i] * sign,
+                -QUATERNION_COMPONENT_RANGE, QUATERNION_COMPONENT_RANGE, QUATERNION_COMPONENT_BITS);
+        }
+        return result;
+    }
+
+    Ogre::Quaternion dequantizeQuaternion(uint32_t value) {
+        uint32_t largest = value >> (3 * QUATERNION_COMPONENT_BITS);
+        float components[4];
+        float sum = 0.f;
+
+        for(int32_t i = 3; i >= 0; --i) {
+            if(static_cast<uint32_t>(i) == largest)
+                continue;
+            components[i] = dequantizeFloat(value & maxValue(QUATERNION_COMPONENT_BITS),
+                -QUATERNION_COMPONENT_RANGE, QUATERNION_COMPONENT_RANGE, QUATERNION_COMPONENT_BITS);
+            sum += components[i] * components[i];
+            value >>= QUATERNION_COMPONENT_BITS;
+        }
+        components[largest] = std::sqrt(std::max(0.f, 1.f - sum));
+
+        Ogre::Quaternion q(components[0], components[1], components[2], components[3]);
+        q.normalise();
+        return q;
+    }
+} // namespace Quantization
+
+} // namespace dt
@@ -0,0 +1,63 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_QUANTIZATION
+#define DUCTTAPE_ENGINE_NETWORK_QUANTIZATION
+
+#include <Config.hpp>
+
+#include <OgreQuaternion.h>
+
+#include <cstdint>
+
+namespace dt {
+
+/**
+  * Functions for packing values into fewer bits before sending them over network.
+  */
+namespace Quantization {
+    /**
+      * Maps a float in a range to an integer of the given number of bits. Values outside the range are clamped.
+      * @param value The value.
+      * @param min The lower end of the range.
+      * @param max The upper end of the range.
+      * @param bits The number of bits, up to 32.
+      * @returns The quantized value.
+      */
+    uint32_t DUCTTAPE_API quantizeFloat(float value, float min, float max, uint32_t bits);
+
+    /**
+      * Maps an integer created by quantizeFloat() back to the range.
+      * @param value The quantized value.
+      * @param min The lower end of the range.
+      * @param max The upper end of the range.
+      * @param bits The number of bits, up to 32.
+      * @returns The value, with an error of at most half a step of (max - min) / (2^bits - 1).
+      */
+    float DUCTTAPE_API dequantizeFloat(uint32_t value, float min, float max, uint32_t bits);
+
+    /**
+      * Packs a unit quaternion into 32 bits using the smallest-three encoding: the index of the largest
+      * component takes 2 bits and the other three components 10 bits each. The largest component is
+      * restored from the others, its sign does not matter as q and -q are the same rotation.
+      * @param q The quaternion. It is normalized first.
+      * @returns The packed quaternion.
+      */
+    uint32_t DUCTTAPE_API quantizeQuaternion(const Ogre::Quaternion& q);
+
+    /**
+      * Unpacks a quaternion packed by quantizeQuaternion().
+      * @param value The packed quaternion.
+      * @returns The unit quaternion.
+      */
+    Ogre::Quaternion DUCTTAPE_API dequantizeQuaternion(uint32_t value);
+} // namespace Quantization
+
+} // namespace dt
+
+#endif
@@ -0,0 +1,41 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/ReplicationAckEvent.hpp>
+
+namespace dt {
+
+ReplicationAckEvent::ReplicationAckEvent(uint16_t sequence)
+    : mSequence(sequence) {}
+
+const QString ReplicationAckEvent::getType() const {
+    return "DT_REPLICATIONACKEVENT";
+}
+
+NetworkEvent::Priority ReplicationAckEvent::getPriority() const {
+    return HIGH;
+}
+
+std::shared_ptr<NetworkEvent> ReplicationAckEvent::clone() const {
+    std::shared_ptr<NetworkEvent> ptr(new ReplicationAckEvent(mSequence));
+    return ptr;
+}
+
+void ReplicationAckEvent::serialize(IOPacket& p) {
+    p.stream(mSequence, "sequence");
+}
+
+uint16_t ReplicationAckEvent::getSequence() const {
+    return mSequence;
+}
+
+void ReplicationAckEvent::setSequence(uint16_t sequence) {
+    mSequence = sequence;
+}
+
+}
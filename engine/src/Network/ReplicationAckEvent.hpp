@@ -0,0 +1,56 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_REPLICATIONACKEVENT
+#define DUCTTAPE_ENGINE_NETWORK_REPLICATIONACKEVENT
+
+#include <Config.hpp>
+
+#include <Network/NetworkEvent.hpp>
+
+#include <cstdint>
+#include <memory>
+
+namespace dt {
+
+/**
+  * Acknowledges a ReplicationEvent, so the sender can use the snapshot as baseline for the next ones.
+  * @see NodeReplicator
+  */
+class DUCTTAPE_API ReplicationAckEvent : public NetworkEvent {
+public:
+    /**
+      * Advanced constructor.
+      * @param sequence The sequence number of the latest snapshot applied.
+      */
+    ReplicationAckEvent(uint16_t sequence = 0);
+
+    const QString getType() const;
+    Priority getPriority() const;
+    std::shared_ptr<NetworkEvent> clone() const;
+    void serialize(IOPacket& p);
+
+    /**
+      * Returns the sequence number of the latest snapshot applied.
+      * @returns The sequence number of the snapshot.
+      */
+    uint16_t getSequence() const;
+
+    /**
+      * Sets the sequence number of the latest snapshot applied.
+      * @param sequence The sequence number of the snapshot.
+      */
+    void setSequence(uint16_t sequence);
+
+private:
+    uint16_t mSequence;     //!< The sequence number of the snapshot.
+};
+
+}
+
+#endif
@@ -0,0 +1,117 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/ReplicationEvent.hpp>
+
+#include <Network/Archive.hpp>
+
+namespace dt {
+
+ReplicationEvent::ReplicationEvent(uint16_t sequence, uint16_t baseline, bool has_baseline)
+    : mSequence(sequence),
+      mBaseline(baseline),
+      mHasBaseline(has_baseline),
+      mTimestamp(0),
+      mProcessedInput(0) {}
+
+void ReplicationEvent::reset(uint16_t sequence, uint16_t baseline, bool has_baseline) {
+    mSequence = sequence;
+    mBaseline = baseline;
+    mHasBaseline = has_baseline;
+    mTimestamp = 0;
+    mProcessedInput = 0;
+    mEntities.clear();
+}
+
+const QString ReplicationEvent::getType() const {
+    return "DT_REPLICATIONEVENT";
+}
+
+NetworkEvent::Channel ReplicationEvent::getChannel() const {
+    // a newer snapshot always replaces an older one
+    return UNRELIABLE_SEQUENCED;
+}
+
+std::shared_ptr<NetworkEvent> ReplicationEvent::clone() const {
+    std::shared_ptr<NetworkEvent> ptr(new ReplicationEvent(mSequence, mBaseline, mHasBaseline));
+    return ptr;
+}
+
+void ReplicationEvent::serialize(IOPacket& p) {
+    p.dispatch(*this);
+}
+
+template <typename Archive>
+void ReplicationEvent::streamFields(Archive& archive) {
+    archive.stream(mSequence, "sequence");
+    archive.stream(mBaseline, "baseline");
+    archive.stream(mHasBaseline, "has_baseline", false);
+    archive.stream(mTimestamp, "timestamp");
+    archive.stream(mProcessedInput, "processed_input");
+
+    uint32_t count = archive.beginList(mEntities.size(), "entities");
+    if(archive.getDirection() == IOPacket::DESERIALIZE)
+        mEntities.resize(count);
+
+    for(uint32_t i = 0; i < count; ++i) {
+        Entity& entity = mEntities[i];
+        archive.beginObject();
+        archive.stream(entity.mId, "id");
+        archive.stream(entity.mFields, "fields");
+
+        if(entity.mFields & CREATED)
+            archive.stream(entity.mName, "name");
+        if(entity.mFields & POSITION) {
+            archive.stream(entity.mPosition[0], "x");
+            archive.stream(entity.mPosition[1], "y");
+            archive.stream(entity.mPosition[2], "z");
+        }
+        if(entity.mFields & ROTATION)
+            archive.stream(entity.mRotation, "rotation");
+        if(entity.mFields & SCALE)
+            archive.stream(entity.mScale, "scale", Ogre::Vector3::UNIT_SCALE);
+        if(entity.mFields & COMPONENTS)
+            archive.stream(entity.mComponents, "components");
+        archive.endObject();
+    }
+    archive.endList();
+}
+
+uint16_t ReplicationEvent::getSequence() const {
+    return mSequence;
+}
+
+uint16_t ReplicationEvent::getBaseline() const {
+    return mBaseline;
+}
+
+bool ReplicationEvent::hasBaseline() const {
+    return mHasBaseline;
+}
+
+void ReplicationEvent::setTimestamp(uint32_t timestamp) {
+    mTimestamp = timestamp;
+}
+
+uint32_t ReplicationEvent::getTimestamp() const {
+    return mTimestamp;
+}
+
+void ReplicationEvent::setProcessedInput(uint32_t sequence) {
+    mProcessedInput = sequence;
+}
+
+uint32_t ReplicationEvent::getProcessedInput() const {
+    return mProcessedInput;
+}
+
+std::vector<ReplicationEvent::Entity>& ReplicationEvent::getEntities() {
+    return mEntities;
+}
+
+}
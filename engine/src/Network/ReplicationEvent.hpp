@@ -0,0 +1,150 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_REPLICATIONEVENT
+#define DUCTTAPE_ENGINE_NETWORK_REPLICATIONEVENT
+
+#include <Config.hpp>
+
+#include <Network/NetworkEvent.hpp>
+
+#include <OgreVector3.h>
+
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace dt {
+
+/**
+  * A snapshot of replicated nodes, sent by the NodeReplicator. It only holds the fields that changed since
+  * the baseline, the latest snapshot the recipient acknowledged, so the recipient rebuilds the full state
+  * from its copy of the baseline.
+  * @see NodeReplicator
+  */
+class DUCTTAPE_API ReplicationEvent : public NetworkEvent {
+public:
+    /**
+      * The fields of an entity contained in a snapshot.
+      */
+    enum Field {
+        CREATED = 0x01,     //!< The entity is not in the baseline. Its name is sent.
+        REMOVED = 0x02,     //!< The entity has been removed. No other field is sent.
+        POSITION = 0x04,    //!< The position, quantized to 16 bits per axis.
+        ROTATION = 0x08,    //!< The rotation, packed with the smallest-three encoding.
+        SCALE = 0x10,       //!< The scale.
+        ENABLED = 0x20,     //!< Not a field, but the value: whether the node is enabled. Set with every entity.
+        COMPONENTS = 0x40   //!< The serialized components.
+    };
+
+    /**
+      * The changed fields of one entity.
+      */
+    struct Entity {
+        uint16_t mId;                       //!< The entity ID.
+        uint8_t mFields;                    //!< The fields sent, see Field.
+        QString mName;                      //!< The name of the node, if CREATED is set.
+        uint16_t mPosition[3];              //!< The quantized position, if POSITION is set.
+        uint32_t mRotation;                 //!< The packed rotation, if ROTATION is set.
+        Ogre::Vector3 mScale;               //!< The scale, if SCALE is set.
+        std::vector<char> mComponents;      //!< The serialized components, if COMPONENTS is set.
+    };
+
+    /**
+      * Advanced constructor.
+      * @param sequence The sequence number of the snapshot.
+      * @param baseline The sequence number of the snapshot the changes are relative to.
+      * @param has_baseline False if the snapshot is relative to the empty state.
+      */
+    ReplicationEvent(uint16_t sequence = 0, uint16_t baseline = 0, bool has_baseline = false);
+
+    /**
+      * Starts a new snapshot in this event, e.g. in a pooled instance. The entities are removed, but
+      * the memory of the list is kept.
+      * @param sequence The sequence number of the snapshot.
+      * @param baseline The sequence number of the snapshot the changes are relative to.
+      * @param has_baseline False if the snapshot is relative to the empty state.
+      */
+    void reset(uint16_t sequence, uint16_t baseline, bool has_baseline);
+
+    const QString getType() const;
+    Channel getChannel() const;
+    std::shared_ptr<NetworkEvent> clone() const;
+    void serialize(IOPacket& p);
+
+    /**
+      * Streams the snapshot with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
+
+    /**
+      * Returns the sequence number of the snapshot.
+      * @returns The sequence number of the snapshot.
+      */
+    uint16_t getSequence() const;
+
+    /**
+      * Returns the sequence number of the snapshot the changes are relative to.
+      * @returns The sequence number of the baseline.
+      */
+    uint16_t getBaseline() const;
+
+    /**
+      * Returns whether the changes are relative to a previous snapshot or to the empty state.
+      * @returns False if the snapshot is relative to the empty state.
+      */
+    bool hasBaseline() const;
+
+    /**
+      * Sets the time of the sender the snapshot was captured at.
+      * @param timestamp The time, in milliseconds.
+      */
+    void setTimestamp(uint32_t timestamp);
+
+    /**
+      * Returns the time of the sender the snapshot was captured at.
+      * @returns The time, in milliseconds.
+      */
+    uint32_t getTimestamp() const;
+
+    /**
+      * Sets the sequence number of the latest input of the recipient the sender processed.
+      * @param sequence The sequence number, or 0 if no input has been processed.
+      * @see ClientPrediction
+      */
+    void setProcessedInput(uint32_t sequence);
+
+    /**
+      * Returns the sequence number of the latest input of the recipient the sender processed.
+      * @returns The sequence number, or 0 if no input has been processed.
+      */
+    uint32_t getProcessedInput() const;
+
+    /**
+      * Returns the changed entities.
+      * @returns The changed entities, ordered by ID.
+      */
+    std::vector<Entity>& getEntities();
+
+private:
+    uint16_t mSequence;             //!< The sequence number of the snapshot.
+    uint16_t mBaseline;             //!< The sequence number of the baseline.
+    bool mHasBaseline;              //!< Whether the snapshot has a baseline.
+    uint32_t mTimestamp;            //!< The time of the sender, in milliseconds.
+    uint32_t mProcessedInput;       //!< The latest input of the recipient processed.
+    std::vector<Entity> mEntities;  //!< The changed entities.
+};
+
+}
+
+#endif
@@ -0,0 +1,71 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/SnapshotBuffer.hpp>
+
+namespace dt {
+
+SnapshotBuffer::SnapshotBuffer(uint32_t capacity)
+    : mCapacity(capacity > 2 ? capacity : 2) {}
+
+void SnapshotBuffer::add(double time, const Ogre::Vector3& position, const Ogre::Quaternion& rotation) {
+    if(!mTransforms.empty() && time <= mTransforms.back().mTime)
+        return;
+
+    if(mTransforms.size() >= mCapacity)
+        mTransforms.pop_front();
+
+    Transform transform;
+    transform.mTime = time;
+    transform.mPosition = position;
+    transform.mRotation = rotation;
+    mTransforms.push_back(transform);
+}
+
+bool SnapshotBuffer::sample(double time, Ogre::Vector3& position, Ogre::Quaternion& rotation) const {
+    if(mTransforms.empty())
+        return false;
+
+    if(time <= mTransforms.front().mTime) {
+        position = mTransforms.front().mPosition;
+        rotation = mTransforms.front().mRotation;
+        return true;
+    }
+    if(time >= mTransforms.back().mTime) {
+        position = mTransforms.back().mPosition;
+        rotation = mTransforms.back().mRotation;
+        return true;
+    }
+
+    // the sample time moves forward, so the pair is usually among the newest ones
+    uint32_t next = mTransforms.size() - 1;
+    while(mTransforms[next - 1].mTime > time) {
+        --next;
+    }
+
+    const Transform& from = mTransforms[next - 1];
+    const Transform& to = mTransforms[next];
+    float t = static_cast<float>((time - from.mTime) / (to.mTime - from.mTime));
+    position = from.mPosition + (to.mPosition - from.mPosition) * t;
+    rotation = Ogre::Quaternion::Slerp(t, from.mRotation, to.mRotation, true);
+    return true;
+}
+
+void SnapshotBuffer::clear() {
+    mTransforms.clear();
+}
+
+uint32_t SnapshotBuffer::getSize() const {
+    return mTransforms.size();
+}
+
+double SnapshotBuffer::getNewestTime() const {
+    return mTransforms.empty() ? 0.0 : mTransforms.back().mTime;
+}
+
+}
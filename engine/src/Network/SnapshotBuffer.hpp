@@ -0,0 +1,90 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_SNAPSHOTBUFFER
+#define DUCTTAPE_ENGINE_NETWORK_SNAPSHOTBUFFER
+
+#include <Config.hpp>
+
+#include <OgreQuaternion.h>
+#include <OgreVector3.h>
+
+#include <cstdint>
+#include <deque>
+
+namespace dt {
+
+/**
+  * The received transforms of one replicated node, stamped with the time of the sender. Sampling the buffer
+  * some time behind the newest transform interpolates between the two transforms around that time, so the
+  * node moves smoothly although the transforms arrive at a lower rate than frames are drawn, and late or
+  * lost snapshots are bridged.
+  * @see NodeReplicator::setInterpolationDelay
+  */
+class DUCTTAPE_API SnapshotBuffer {
+public:
+    /**
+      * Advanced constructor.
+      * @param capacity The maximum number of transforms kept. The oldest ones are dropped.
+      */
+    SnapshotBuffer(uint32_t capacity = 32);
+
+    /**
+      * Adds a transform. Transforms that are not newer than the newest one are ignored, so they have to
+      * be added in the order they were sent.
+      * @param time The time of the sender the transform was captured at, in seconds.
+      * @param position The position.
+      * @param rotation The rotation.
+      */
+    void add(double time, const Ogre::Vector3& position, const Ogre::Quaternion& rotation);
+
+    /**
+      * Returns the transform at a point in time. Between two transforms, the position is interpolated
+      * linearly and the rotation spherically. Before the oldest or after the newest transform, that
+      * transform is returned: the buffer does not extrapolate.
+      * @param time The time of the sender, in seconds.
+      * @param position The position is written here.
+      * @param rotation The rotation is written here.
+      * @returns False if the buffer is empty.
+      */
+    bool sample(double time, Ogre::Vector3& position, Ogre::Quaternion& rotation) const;
+
+    /**
+      * Removes all transforms.
+      */
+    void clear();
+
+    /**
+      * Returns the number of transforms in the buffer.
+      * @returns The number of transforms.
+      */
+    uint32_t getSize() const;
+
+    /**
+      * Returns the time of the newest transform.
+      * @returns The time, in seconds, or 0 if the buffer is empty.
+      */
+    double getNewestTime() const;
+
+private:
+    /**
+      * A received transform.
+      */
+    struct Transform {
+        double mTime;                   //!< The time of the sender, in seconds.
+        Ogre::Vector3 mPosition;        //!< The position.
+        Ogre::Quaternion mRotation;     //!< The rotation.
+    };
+
+    std::deque<Transform> mTransforms;  //!< The transforms, oldest first.
+    uint32_t mCapacity;                 //!< The maximum number of transforms.
+};
+
+}
+
+#endif
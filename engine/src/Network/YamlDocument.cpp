@@ -0,0 +1,282 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Network/YamlDocument.hpp>
+
+#include <Utils/Logger.hpp>
+#include <Utils/Utils.hpp>
+
+#include <cstring>
+
+namespace dt {
+
+/**
+  * Reads a number of floating point values from the items of a sequence.
+  */
+static bool readFloats(const YamlDocument& document, uint32_t entry, float* values, uint32_t count) {
+    if(document.getType(entry) != YamlDocument::SEQUENCE || document.getSize(entry) != count)
+        return false;
+
+    uint32_t item = document.getFirstChild(entry);
+    for(uint32_t i = 0; i < count; ++i) {
+        if(!document.read(item, values[i]))
+            return false;
+        item = document.getNextSibling(item);
+    }
+    return true;
+}
+
+YamlDocument::YamlDocument()
+    : mIsKeyNext(false),
+      mPendingKey(NO_ENTRY),
+      mIsValid(true) {}
+
+bool YamlDocument::load(std::istream& input) {
+    mEntries.clear();
+    mScalars.clear();
+    mKeyIds.clear();
+    mOpenContainers.clear();
+    mIsKeyNextStack.clear();
+    mIsKeyNext = false;
+    mPendingKey = NO_ENTRY;
+    mIsValid = true;
+
+    // the parser only throws on malformed documents
+    try {
+        YAML::Parser parser(input);
+        if(!parser.HandleNextDocument(*this))
+            return false;
+    } catch(YAML::Exception& e) {
+        Logger::get().error(QString("YamlDocument: Cannot parse the document: ") + e.what());
+        mEntries.clear();
+        return false;
+    }
+
+    if(!mIsValid) {
+        Logger::get().error("YamlDocument: The document has keys that are not scalars, which are not supported.");
+        mEntries.clear();
+        return false;
+    }
+    return true;
+}
+
+uint32_t YamlDocument::getRoot() const {
+    return mEntries.empty() ? NO_ENTRY : 0;
+}
+
+uint32_t YamlDocument::getEntryCount() const {
+    return mEntries.size();
+}
+
+YamlDocument::Type YamlDocument::getType(uint32_t entry) const {
+    return entry < mEntries.size() ? mEntries[entry].mType : NONE;
+}
+
+uint32_t YamlDocument::getSize(uint32_t entry) const {
+    return entry < mEntries.size() ? mEntries[entry].mSize : 0;
+}
+
+uint32_t YamlDocument::getFirstChild(uint32_t entry) const {
+    return getSize(entry) > 0 ? entry + 1 : NO_ENTRY;
+}
+
+uint32_t YamlDocument::getNextSibling(uint32_t entry) const {
+    return entry < mEntries.size() ? mEntries[entry].mEnd : NO_ENTRY;
+}
+
+uint32_t YamlDocument::getKeyId(const char* key) const {
+    auto iter = mKeyIds.find(key);
+    return iter != mKeyIds.end() ? iter->second : NO_ENTRY;
+}
+
+uint32_t YamlDocument::find(uint32_t map, uint32_t key, uint32_t hint) const {
+    if(getType(map) != MAP || key == NO_ENTRY)
+        return NO_ENTRY;
+
+    uint32_t end = mEntries[map].mEnd;
+    if(hint <= map || hint >= end)
+        hint = map + 1;
+
+    for(uint32_t value = hint; value < end; value = mEntries[value].mEnd) {
+        if(mEntries[value].mKey == key)
+            return value;
+    }
+    for(uint32_t value = map + 1; value < hint; value = mEntries[value].mEnd) {
+        if(mEntries[value].mKey == key)
+            return value;
+    }
+    return NO_ENTRY;
+}
+
+bool YamlDocument::read(uint32_t entry, std::string& value) const {
+    const char* scalar = _getScalar(entry);
+    if(scalar == nullptr)
+        return false;
+    value.assign(scalar, mEntries[entry].mSize);
+    return true;
+}
+
+bool YamlDocument::read(uint32_t entry, bool& value) const {
+    const char* scalar = _getScalar(entry);
+    if(scalar == nullptr)
+        return false;
+
+    static const char* TRUE_VALUES[] = {"true", "True", "TRUE", "yes", "Yes", "YES", "on", "On", "ON"};
+    static const char* FALSE_VALUES[] = {"false", "False", "FALSE", "no", "No", "NO", "off", "Off", "OFF"};
+    for(uint32_t i = 0; i < sizeof(TRUE_VALUES) / sizeof(TRUE_VALUES[0]); ++i) {
+        if(strcmp(scalar, TRUE_VALUES[i]) == 0) {
+            value = true;
+            return true;
+        }
+        if(strcmp(scalar, FALSE_VALUES[i]) == 0) {
+            value = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool YamlDocument::read(uint32_t entry, float& value) const {
+    double result = 0.0;
+    if(!read(entry, result))
+        return false;
+    value = static_cast<float>(result);
+    return true;
+}
+
+bool YamlDocument::read(uint32_t entry, double& value) const {
+    const char* scalar = _getScalar(entry);
+    if(scalar == nullptr || *scalar == '\0')
+        return false;
+
+    char* end = nullptr;
+    double result = strtod(scalar, &end);
+    if(*end != '\0')
+        return false;
+    value = result;
+    return true;
+}
+
+bool YamlDocument::read(uint32_t entry, Ogre::Vector3& value) const {
+    float values[3];
+    if(!readFloats(*this, entry, values, 3))
+        return false;
+    value = Ogre::Vector3(values[0], values[1], values[2]);
+    return true;
+}
+
+bool YamlDocument::read(uint32_t entry, Ogre::Quaternion& value) const {
+    float values[4];
+    if(!readFloats(*this, entry, values, 4))
+        return false;
+    value = Ogre::Quaternion(values[0], values[1], values[2], values[3]);
+    return true;
+}
+
+void YamlDocument::OnDocumentStart(const YAML::Mark& mark) {}
+
+void YamlDocument::OnDocumentEnd() {}
+
+void YamlDocument::OnNull(const YAML::Mark& mark, YAML::anchor_t anchor) {
+    if(mIsKeyNext && !mOpenContainers.empty()) {
+        // a null key, which is the empty string
+        mPendingKey = mKeyIds.insert(std::make_pair(std::string(), mKeyIds.size())).first->second;
+        mIsKeyNext = false;
+        return;
+    }
+    uint32_t entry = _addEntry(NONE);
+    mEntries[entry].mEnd = entry + 1;
+}
+
+void YamlDocument::OnAlias(const YAML::Mark& mark, YAML::anchor_t anchor) {
+    // the emitter never writes aliases, they are read as null
+    OnNull(mark, anchor);
+}
+
+void YamlDocument::OnScalar(const YAML::Mark& mark, const std::string& tag, YAML::anchor_t anchor, const std::string& value) {
+    if(mIsKeyNext && !mOpenContainers.empty()) {
+        // each key is stored once, the values refer to it by id
+        mPendingKey = mKeyIds.insert(std::make_pair(value, mKeyIds.size())).first->second;
+        mIsKeyNext = false;
+        return;
+    }
+
+    uint32_t entry = _addEntry(SCALAR);
+    mEntries[entry].mSize = value.size();
+    mEntries[entry].mEnd = entry + 1;
+    mEntries[entry].mOffset = mScalars.size();
+    mScalars.append(value);
+    mScalars.push_back('\0');
+}
+
+void YamlDocument::OnSequenceStart(const YAML::Mark& mark, const std::string& tag, YAML::anchor_t anchor) {
+    _beginContainer(SEQUENCE);
+}
+
+void YamlDocument::OnSequenceEnd() {
+    _endContainer();
+}
+
+void YamlDocument::OnMapStart(const YAML::Mark& mark, const std::string& tag, YAML::anchor_t anchor) {
+    _beginContainer(MAP);
+}
+
+void YamlDocument::OnMapEnd() {
+    _endContainer();
+}
+
+uint32_t YamlDocument::_addEntry(Type type) {
+    Entry entry;
+    entry.mType = type;
+    entry.mKey = NO_ENTRY;
+    entry.mSize = 0;
+    entry.mEnd = NO_ENTRY;
+    entry.mOffset = 0;
+
+    if(!mOpenContainers.empty()) {
+        Entry& container = mEntries[mOpenContainers.back()];
+        if(container.mType == MAP) {
+            if(mIsKeyNext) {
+                // a sequence or map as key
+                mIsValid = false;
+            } else {
+                entry.mKey = mPendingKey;
+            }
+            mIsKeyNext = !mIsKeyNext;
+        }
+        ++container.mSize;
+    }
+
+    mEntries.push_back(entry);
+    return mEntries.size() - 1;
+}
+
+void YamlDocument::_beginContainer(Type type) {
+    uint32_t entry = _addEntry(type);
+    mOpenContainers.push_back(entry);
+    mIsKeyNextStack.push_back(mIsKeyNext);
+    mIsKeyNext = (type == MAP);
+}
+
+void YamlDocument::_endContainer() {
+    if(mOpenContainers.empty())
+        return;
+
+    mEntries[mOpenContainers.back()].mEnd = mEntries.size();
+    mOpenContainers.pop_back();
+    mIsKeyNext = mIsKeyNextStack.back();
+    mIsKeyNextStack.pop_back();
+}
+
+const char* YamlDocument::_getScalar(uint32_t entry) const {
+    if(getType(entry) != SCALAR)
+        return nullptr;
+    return mScalars.c_str() + mEntries[entry].mOffset;
+}
+
+} // namespace dt
@@ -0,0 +1,284 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_NETWORK_YAMLDOCUMENT
+#define DUCTTAPE_ENGINE_NETWORK_YAMLDOCUMENT
+
+#include <Config.hpp>
+
+#include <QtGlobal>
+
+#include <yaml-cpp/eventhandler.h>
+#include <yaml-cpp/yaml.h>
+
+#include <OgreVector3.h>
+#include <OgreQuaternion.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace dt {
+
+/**
+  * A YAML document read with the event parser of yaml-cpp, for loading large scenes. Instead of a tree of
+  * YAML::Nodes, the events are stored as a flat array of entries, with all scalars in one buffer. Map keys
+  * are interned while parsing, so looking up a field compares integers. The entries of a container follow it,
+  * and each entry knows where its subtree ends, so siblings are reached without walking the subtrees.
+  * Nothing throws when reading: a missing key or a value that cannot be converted is reported by the return
+  * value, so the IOPacket can use the default instead.
+  * @code
+  * std::ifstream input("level.yaml");
+  * YamlDocument document;
+  * if(document.load(input)) {
+  *     IOPacket packet(&document);
+  *     level->serialize(packet);
+  * }
+  * @endcode
+  * @see IOPacket
+  */
+class DUCTTAPE_API YamlDocument : public YAML::EventHandler {
+
+    Q_DISABLE_COPY(YamlDocument)
+
+public:
+    /**
+      * The types of entries.
+      */
+    enum Type {
+        NONE,           //!< A null value or an alias.
+        SCALAR,         //!< A scalar.
+        SEQUENCE,       //!< A sequence. Its items follow it.
+        MAP             //!< A map. Its values follow it, each with the id of its key.
+    };
+
+    /**
+      * Returned instead of an entry or key if there is none.
+      */
+    static const uint32_t NO_ENTRY = 0xffffffff;
+
+    /**
+      * Default constructor.
+      */
+    YamlDocument();
+
+    /**
+      * Parses the next document of a stream. The previous document is replaced.
+      * @param input The stream.
+      * @returns False if the stream holds no further document or it is malformed.
+      */
+    bool load(std::istream& input);
+
+    /**
+      * Returns the root entry.
+      * @returns The first entry, or NO_ENTRY if the document is empty.
+      */
+    uint32_t getRoot() const;
+
+    /**
+      * Returns the number of entries, which is the number of values in the document.
+      * @returns The number of entries.
+      */
+    uint32_t getEntryCount() const;
+
+    /**
+      * Returns the type of an entry.
+      * @param entry The entry.
+      * @returns The type, or NONE if the entry does not exist.
+      */
+    Type getType(uint32_t entry) const;
+
+    /**
+      * Returns the number of items of a sequence or values of a map.
+      * @param entry The entry.
+      * @returns The number of children, 0 for scalars.
+      */
+    uint32_t getSize(uint32_t entry) const;
+
+    /**
+      * Returns the first item of a sequence or value of a map.
+      * @param entry The entry.
+      * @returns The first child, or NO_ENTRY if there is none.
+      */
+    uint32_t getFirstChild(uint32_t entry) const;
+
+    /**
+      * Returns the entry following an entry and its children. For the children of a container, this is the next one.
+      * @param entry The entry.
+      * @returns The next sibling, if the entry is not the last child of its container.
+      */
+    uint32_t getNextSibling(uint32_t entry) const;
+
+    /**
+      * Returns the id of a key.
+      * @param key The key.
+      * @returns The id, or NO_ENTRY if no map in the document has the key.
+      */
+    uint32_t getKeyId(const char* key) const;
+
+    /**
+      * Finds the value of a key in a map.
+      * @param map The map.
+      * @param key The id of the key.
+      * @param hint The value to start searching at, wrapping around. When reading the values in the order they
+      * were written, passing the sibling of the last value found finds the next one right away.
+      * @returns The value, or NO_ENTRY if the map has no such key.
+      */
+    uint32_t find(uint32_t map, uint32_t key, uint32_t hint = NO_ENTRY) const;
+
+    /**
+      * Reads a scalar.
+      * @param entry The entry.
+      * @param value The value read.
+      * @returns False if the entry is not a scalar.
+      */
+    bool read(uint32_t entry, std::string& value) const;
+
+    /**
+      * Reads a boolean, written as true, yes, on, false, no or off.
+      * @param entry The entry.
+      * @param value The value read.
+      * @returns False if the entry is not a boolean.
+      */
+    bool read(uint32_t entry, bool& value) const;
+
+    /**
+      * Reads a float.
+      * @param entry The entry.
+      * @param value The value read.
+      * @returns False if the entry is not a number.
+      */
+    bool read(uint32_t entry, float& value) const;
+
+    /**
+      * Reads a double.
+      * @param entry The entry.
+      * @param value The value read.
+      * @returns False if the entry is not a number.
+      */
+    bool read(uint32_t entry, double& value) const;
+
+    /**
+      * Reads a vector, written as a sequence of x, y and z.
+      * @param entry The entry.
+      * @param value The value read.
+      * @returns False if the entry is not such a sequence.
+      */
+    bool read(uint32_t entry, Ogre::Vector3& value) const;
+
+    /**
+      * Reads a quaternion, written as a sequence of w, x, y and z.
+      * @param entry The entry.
+      * @param value The value read.
+      * @returns False if the entry is not such a sequence.
+      */
+    bool read(uint32_t entry, Ogre::Quaternion& value) const;
+
+    /**
+      * Reads an integer.
+      * @param entry The entry.
+      * @param value The value read.
+      * @returns False if the entry is not an integer or is out of the range of the type. 8 bit integers have to be
+      * a single character.
+      */
+    template <typename T>
+    bool read(uint32_t entry, T& value) const {
+        static_assert(std::is_integral<T>::value, "YamlDocument can only read numbers, strings, vectors and quaternions.");
+
+        const char* scalar = _getScalar(entry);
+        if(scalar == nullptr || *scalar == '\0')
+            return false;
+
+        // the emitter writes 8 bit integers as characters
+        if(sizeof(T) == 1) {
+            if(mEntries[entry].mSize != 1)
+                return false;
+            value = static_cast<T>(*scalar);
+            return true;
+        }
+
+        char* end = nullptr;
+        if(std::is_signed<T>::value) {
+            long long result = strtoll(scalar, &end, 0);
+            if(*end != '\0' || static_cast<long long>(static_cast<T>(result)) != result)
+                return false;
+            value = static_cast<T>(result);
+        } else {
+            unsigned long long result = strtoull(scalar, &end, 0);
+            if(*end != '\0' || *scalar == '-' || static_cast<unsigned long long>(static_cast<T>(result)) != result)
+                return false;
+            value = static_cast<T>(result);
+        }
+        return true;
+    }
+
+    // YAML::EventHandler
+    void OnDocumentStart(const YAML::Mark& mark);
+    void OnDocumentEnd();
+    void OnNull(const YAML::Mark& mark, YAML::anchor_t anchor);
+    void OnAlias(const YAML::Mark& mark, YAML::anchor_t anchor);
+    void OnScalar(const YAML::Mark& mark, const std::string& tag, YAML::anchor_t anchor, const std::string& value);
+    void OnSequenceStart(const YAML::Mark& mark, const std::string& tag, YAML::anchor_t anchor);
+    void OnSequenceEnd();
+    void OnMapStart(const YAML::Mark& mark, const std::string& tag, YAML::anchor_t anchor);
+    void OnMapEnd();
+
+private:
+    /**
+      * A value in the document.
+      */
+    struct Entry {
+        Type mType;         //!< The type.
+        uint32_t mKey;      //!< The id of the key if the entry is a value in a map, otherwise NO_ENTRY.
+        uint32_t mSize;     //!< The number of children.
+        uint32_t mEnd;      //!< The entry after the last child.
+        uint32_t mOffset;   //!< The offset of a scalar in the buffer.
+    };
+
+    /**
+      * Private method. Adds an entry for the next value, taking the pending key if it is in a map.
+      * @param type The type of the entry.
+      * @returns The index of the new entry.
+      */
+    uint32_t _addEntry(Type type);
+
+    /**
+      * Private method. Opens a sequence or map, so the following values are its children.
+      * @param type The type of the container.
+      */
+    void _beginContainer(Type type);
+
+    /**
+      * Private method. Closes the innermost sequence or map.
+      */
+    void _endContainer();
+
+    /**
+      * Private method. Returns the text of a scalar.
+      * @param entry The entry.
+      * @returns The null-terminated text, or nullptr if the entry is not a scalar.
+      */
+    const char* _getScalar(uint32_t entry) const;
+
+    std::vector<Entry> mEntries;                        //!< All values, in the order of the document.
+    std::string mScalars;                               //!< The text of all scalars, each null-terminated.
+    std::unordered_map<std::string, uint32_t> mKeyIds;  //!< The ids of the interned keys.
+    std::vector<uint32_t> mOpenContainers;              //!< The sequences and maps being parsed.
+    std::vector<bool> mIsKeyNextStack;                  //!< Whether a key was expected before each open container.
+    bool mIsKeyNext;                                    //!< Whether the next scalar is a key of the innermost map.
+    uint32_t mPendingKey;                               //!< The id of the key of the next value.
+    bool mIsValid;                                      //!< False if the document uses features that are not supported.
+};
+
+} // namespace dt
+
+#endif
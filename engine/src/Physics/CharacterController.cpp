@@ -0,0 +1,87 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Physics/CharacterController.hpp>
+
+#include <Physics/CharacterControllerPool.hpp>
+
+namespace dt {
+
+CharacterController::CharacterController(CharacterControllerPool* pool, btConvexShape* shape, btScalar step_height)
+    : mPool(pool),
+      mShape(shape),
+      mStepHeight(step_height),
+      mGhostObject(new btPairCachingGhostObject()),
+      mController(nullptr),
+      mWalkVelocity(0, 0, 0),
+      mVelocityChanged(false),
+      mIsEnabled(false),
+      mActiveIndex(0) {
+    mGhostObject->setCollisionShape(mShape);
+    mGhostObject->setCollisionFlags(btCollisionObject::CF_CHARACTER_OBJECT);
+    // Characters have no PhysicsBodyComponent, the null pointer tells them apart in the collision callback.
+    mGhostObject->setUserPointer(nullptr);
+
+    mController = new btKinematicCharacterController(mGhostObject, mShape, mStepHeight);
+}
+
+CharacterController::~CharacterController() {
+    delete mController;
+    delete mGhostObject;
+}
+
+void CharacterController::setWalkVelocity(const btVector3& velocity) {
+    if(velocity != mWalkVelocity) {
+        mWalkVelocity = velocity;
+        mVelocityChanged = true;
+    }
+}
+
+const btVector3& CharacterController::getWalkVelocity() const {
+    return mWalkVelocity;
+}
+
+void CharacterController::jump() {
+    mController->jump();
+}
+
+bool CharacterController::onGround() const {
+    return mController->onGround();
+}
+
+const btTransform& CharacterController::getWorldTransform() const {
+    return mGhostObject->getWorldTransform();
+}
+
+void CharacterController::setWorldTransform(const btTransform& transform) {
+    mGhostObject->setWorldTransform(transform);
+}
+
+void CharacterController::setEnabled(bool enabled) {
+    if(enabled == mIsEnabled)
+        return;
+
+    if(enabled)
+        mPool->_enable(this);
+    else
+        mPool->_disable(this);
+}
+
+bool CharacterController::isEnabled() const {
+    return mIsEnabled;
+}
+
+btPairCachingGhostObject* CharacterController::getGhostObject() {
+    return mGhostObject;
+}
+
+btKinematicCharacterController* CharacterController::getBulletController() {
+    return mController;
+}
+
+}
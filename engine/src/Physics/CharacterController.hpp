@@ -0,0 +1,116 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_PHYSICS_CHARACTERCONTROLLER
+#define DUCTTAPE_ENGINE_PHYSICS_CHARACTERCONTROLLER
+
+#include <Config.hpp>
+
+#include <btBulletDynamicsCommon.h>
+#include <BulletCollision/CollisionDispatch/btGhostObject.h>
+#include <BulletDynamics/Character/btKinematicCharacterController.h>
+
+#include <cstdint>
+
+namespace dt {
+
+class CharacterControllerPool;
+
+/**
+  * A kinematic character (a player or an NPC) walking through a physics world. Instances are
+  * created and owned by the CharacterControllerPool of a PhysicsWorld.
+  * @see CharacterControllerPool
+  */
+class DUCTTAPE_API CharacterController {
+public:
+    /**
+      * Sets the velocity the character walks at. It is handed to Bullet by the pool before each
+      * simulation step, together with the velocities of all other characters.
+      * @param velocity The velocity, in units per second.
+      */
+    void setWalkVelocity(const btVector3& velocity);
+
+    /**
+      * Returns the velocity the character walks at.
+      * @returns The velocity the character walks at, in units per second.
+      */
+    const btVector3& getWalkVelocity() const;
+
+    /**
+      * Makes the character jump.
+      */
+    void jump();
+
+    /**
+      * Returns whether the character stands on the ground.
+      * @returns Whether the character stands on the ground.
+      */
+    bool onGround() const;
+
+    /**
+      * Returns the transform of the character.
+      * @returns The transform of the character.
+      */
+    const btTransform& getWorldTransform() const;
+
+    /**
+      * Moves the character to a new position, without sweeping through the world.
+      * @param transform The new transform.
+      */
+    void setWorldTransform(const btTransform& transform);
+
+    /**
+      * Adds the character to or removes it from the world.
+      * @param enabled Whether the character is part of the world.
+      */
+    void setEnabled(bool enabled);
+
+    /**
+      * Returns whether the character is part of the world.
+      * @returns Whether the character is part of the world.
+      */
+    bool isEnabled() const;
+
+    /**
+      * Returns Bullet's ghost object of the character.
+      * @returns Bullet's ghost object of the character.
+      */
+    btPairCachingGhostObject* getGhostObject();
+
+    /**
+      * Returns Bullet's character controller.
+      * @returns Bullet's character controller.
+      */
+    btKinematicCharacterController* getBulletController();
+
+private:
+    friend class CharacterControllerPool;
+
+    /**
+      * Advanced constructor. Only the pool creates characters.
+      * @param pool The pool owning the character.
+      * @param shape The (shared) collision shape.
+      * @param step_height The height of the steps the character can walk up.
+      */
+    CharacterController(CharacterControllerPool* pool, btConvexShape* shape, btScalar step_height);
+    ~CharacterController();
+
+    CharacterControllerPool* mPool;                 //!< The pool owning the character.
+    btConvexShape* mShape;                          //!< The collision shape, owned by the pool.
+    btScalar mStepHeight;                           //!< The height of the steps the character can walk up.
+    btPairCachingGhostObject* mGhostObject;         //!< The bullet ghost object.
+    btKinematicCharacterController* mController;    //!< The bullet character controller.
+    btVector3 mWalkVelocity;                        //!< The velocity to walk at.
+    bool mVelocityChanged;                          //!< Whether mWalkVelocity has to be handed to Bullet.
+    bool mIsEnabled;                                //!< Whether the character is part of the world.
+    uint32_t mActiveIndex;                          //!< The index in the pool's list of enabled characters.
+};
+
+}
+
+#endif
@@ -0,0 +1,140 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Physics/CharacterControllerPool.hpp>
+
+#include <algorithm>
+
+namespace dt {
+
+CharacterControllerPool::CharacterControllerPool(btDiscreteDynamicsWorld* world)
+    : mWorld(world),
+      mVelocityInterval(0.5) {}
+
+CharacterControllerPool::~CharacterControllerPool() {
+    for(auto iter = mAll.begin(); iter != mAll.end(); ++iter) {
+        if((*iter)->isEnabled())
+            _disable(*iter);
+        delete *iter;
+    }
+
+    for(auto iter = mFree.begin(); iter != mFree.end(); ++iter) {
+        delete *iter;
+    }
+
+    for(auto iter = mShapes.begin(); iter != mShapes.end(); ++iter) {
+        delete iter->second;
+    }
+}
+
+CharacterController* CharacterControllerPool::create(const btTransform& transform, btScalar width,
+                                                     btScalar height, btScalar step_height) {
+    btConvexShape* shape = _getCapsule(width, height);
+    CharacterController* controller = nullptr;
+
+    // reuse a destroyed character of the same size
+    for(auto iter = mFree.begin(); iter != mFree.end(); ++iter) {
+        if((*iter)->mShape == shape && (*iter)->mStepHeight == step_height) {
+            controller = *iter;
+            *iter = mFree.back();
+            mFree.pop_back();
+            break;
+        }
+    }
+
+    if(controller == nullptr) {
+        controller = new CharacterController(this, shape, step_height);
+    } else {
+        // forget the vertical velocity, jump state and overlapping pairs of the destroyed character
+        controller->mController->reset(mWorld);
+    }
+
+    controller->setWorldTransform(transform);
+    controller->mWalkVelocity.setZero();
+    controller->mVelocityChanged = true;    // clears the walk direction of a reused controller
+
+    mAll.push_back(controller);
+    return controller;
+}
+
+void CharacterControllerPool::destroy(CharacterController* controller) {
+    if(controller == nullptr)
+        return;
+
+    auto iter = std::find(mAll.begin(), mAll.end(), controller);
+    if(iter == mAll.end())
+        return;
+
+    if(controller->isEnabled())
+        _disable(controller);
+
+    *iter = mAll.back();
+    mAll.pop_back();
+    mFree.push_back(controller);
+}
+
+uint32_t CharacterControllerPool::getActiveCount() const {
+    return mActive.size();
+}
+
+void CharacterControllerPool::setVelocityInterval(btScalar interval) {
+    mVelocityInterval = interval;
+}
+
+void CharacterControllerPool::updateAction(btCollisionWorld* world, btScalar time_diff) {
+    // hand all walk velocities to Bullet first, idle characters only once
+    for(auto iter = mActive.begin(); iter != mActive.end(); ++iter) {
+        CharacterController* controller = *iter;
+        if(controller->mVelocityChanged || !controller->mWalkVelocity.isZero()) {
+            controller->mController->setVelocityForTimeInterval(controller->mWalkVelocity, mVelocityInterval);
+            controller->mVelocityChanged = false;
+        }
+    }
+
+    for(auto iter = mActive.begin(); iter != mActive.end(); ++iter) {
+        (*iter)->mController->updateAction(world, time_diff);
+    }
+}
+
+void CharacterControllerPool::debugDraw(btIDebugDraw* debug_drawer) {
+    for(auto iter = mActive.begin(); iter != mActive.end(); ++iter) {
+        (*iter)->mController->debugDraw(debug_drawer);
+    }
+}
+
+btConvexShape* CharacterControllerPool::_getCapsule(btScalar width, btScalar height) {
+    auto key = std::make_pair(width, height);
+    auto iter = mShapes.find(key);
+    if(iter != mShapes.end())
+        return iter->second;
+
+    btConvexShape* shape = new btCapsuleShape(width, height);
+    mShapes.insert(std::make_pair(key, shape));
+    return shape;
+}
+
+void CharacterControllerPool::_enable(CharacterController* controller) {
+    mWorld->addCollisionObject(controller->mGhostObject);
+
+    controller->mActiveIndex = mActive.size();
+    controller->mIsEnabled = true;
+    mActive.push_back(controller);
+}
+
+void CharacterControllerPool::_disable(CharacterController* controller) {
+    mWorld->removeCollisionObject(controller->mGhostObject);
+
+    // swap with the last enabled character
+    CharacterController* last = mActive.back();
+    mActive[controller->mActiveIndex] = last;
+    last->mActiveIndex = controller->mActiveIndex;
+    mActive.pop_back();
+    controller->mIsEnabled = false;
+}
+
+}
@@ -0,0 +1,111 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_PHYSICS_CHARACTERCONTROLLERPOOL
+#define DUCTTAPE_ENGINE_PHYSICS_CHARACTERCONTROLLERPOOL
+
+#include <Config.hpp>
+
+#include <Physics/CharacterController.hpp>
+
+#include <btBulletDynamicsCommon.h>
+#include <BulletDynamics/Dynamics/btActionInterface.h>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace dt {
+
+/**
+  * Manages all kinematic characters of a PhysicsWorld. The pool is registered with the Bullet world
+  * as a single action, which first hands the walk velocities of all characters to Bullet and then
+  * steps them, instead of every character being an action of its own. Characters of the same size
+  * share one collision shape, and destroyed characters are kept and reused by the next create().
+  * @see PhysicsWorld::getCharacterControllerPool();
+  */
+class DUCTTAPE_API CharacterControllerPool : public btActionInterface {
+public:
+    /**
+      * Advanced constructor.
+      * @param world The Bullet world the characters walk in.
+      */
+    CharacterControllerPool(btDiscreteDynamicsWorld* world);
+
+    /**
+      * Destructor. Destroys all characters and shapes.
+      */
+    ~CharacterControllerPool();
+
+    /**
+      * Creates a character with a capsule shape. The character is disabled until setEnabled(true) is called.
+      * @param transform The start transform.
+      * @param width The radius of the capsule.
+      * @param height The height of the cylindrical part of the capsule.
+      * @param step_height The height of the steps the character can walk up.
+      * @returns The new character.
+      */
+    CharacterController* create(const btTransform& transform, btScalar width = 0.44, btScalar height = 1.75,
+                                btScalar step_height = 1);
+
+    /**
+      * Removes a character from the world. The pointer must not be used anymore.
+      * @param controller The character to destroy.
+      */
+    void destroy(CharacterController* controller);
+
+    /**
+      * Returns the number of enabled characters.
+      * @returns The number of enabled characters.
+      */
+    uint32_t getActiveCount() const;
+
+    /**
+      * Sets the time interval passed to btKinematicCharacterController::setVelocityForTimeInterval.
+      * @param interval The interval, in seconds. Default: 0.5.
+      */
+    void setVelocityInterval(btScalar interval);
+
+    // btActionInterface
+    void updateAction(btCollisionWorld* world, btScalar time_diff);
+    void debugDraw(btIDebugDraw* debug_drawer);
+
+private:
+    friend class CharacterController;
+
+    /**
+      * Returns the shared capsule shape of the given size, creating it if needed.
+      * @param width The radius of the capsule.
+      * @param height The height of the cylindrical part of the capsule.
+      * @returns The capsule shape.
+      */
+    btConvexShape* _getCapsule(btScalar width, btScalar height);
+
+    /**
+      * Adds a character to the world and the list of enabled characters.
+      * @param controller The character.
+      */
+    void _enable(CharacterController* controller);
+
+    /**
+      * Removes a character from the world and the list of enabled characters.
+      * @param controller The character.
+      */
+    void _disable(CharacterController* controller);
+
+    btDiscreteDynamicsWorld* mWorld;                                    //!< The Bullet world.
+    std::vector<CharacterController*> mActive;                          //!< The enabled characters.
+    std::vector<CharacterController*> mAll;                             //!< All characters in use.
+    std::vector<CharacterController*> mFree;                            //!< Destroyed characters, ready to be reused.
+    std::map<std::pair<btScalar, btScalar>, btConvexShape*> mShapes;    //!< The shared capsule shapes by size.
+    btScalar mVelocityInterval;                                         //!< The interval for setVelocityForTimeInterval.
+};
+
+}
+
+#endif
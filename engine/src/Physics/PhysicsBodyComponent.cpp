@@ -9,6 +9,7 @@
 #include <Physics/PhysicsBodyComponent.hpp>
 
 #include <Graphics/MeshComponent.hpp>
+#include <Network/Archive.hpp>
 #include <Scene/Node.hpp>
 #include <Scene/Scene.hpp>
 
@@ -32,7 +33,9 @@ PhysicsBodyComponent::PhysicsBodyComponent(const QString mesh_component_name,
       mCollisionMask(0),
       mCollisionGroup(0),
       mCollisionMaskInUse(false),
-      mMass(mass) {}
+      mMass(mass),
+      mIsResting(false),
+      mIsSyncingNode(false) {}
 
 void PhysicsBodyComponent::onInitialize() {
     if(! mNode->hasComponent(mMeshComponentName)) {
@@ -90,6 +93,9 @@ void PhysicsBodyComponent::onInitialize() {
     // collisions, for instance)
     mBody->setFriction(1.0);
     mBody->setUserPointer((void *)(this));
+
+    mSyncedPosition = getNode()->getPosition();
+    mSyncedRotation = getNode()->getRotation();
 }
 
 void PhysicsBodyComponent::SetFriction(double friction) {
@@ -130,6 +136,17 @@ void PhysicsBodyComponent::onDisable() {
     getNode()->getScene()->getPhysicsWorld()->getBulletWorld()->removeRigidBody(mBody);
 }
 
+void PhysicsBodyComponent::onSerialize(IOPacket& packet) {
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void PhysicsBodyComponent::streamFields(Archive& archive) {
+    archive.stream(mMeshComponentName, "mesh_component");
+    archive.stream(EnumHelper(&mCollisionShapeType), "collision_shape", CONVEX);
+    archive.stream(mMass, "mass", btScalar(5.0f));
+}
+
 void PhysicsBodyComponent::onCollide(PhysicsBodyComponent* other_body) {
     emit collided(other_body, this);
 }
@@ -148,6 +165,10 @@ void PhysicsBodyComponent::applyCentralImpulse(float x, float y, float z) {
 
 void PhysicsBodyComponent::setCentralForce(const btVector3& force) {
     mCentralForce = force;
+
+    // a sleeping body would ignore the force
+    if(mBody != nullptr && !force.isZero())
+        activate();
 }
 
 void PhysicsBodyComponent::setCentralForce(float x, float y, float z) {
@@ -156,6 +177,9 @@ void PhysicsBodyComponent::setCentralForce(float x, float y, float z) {
 
 void PhysicsBodyComponent::setTorque(const btVector3& torque) {
     mTorque = torque;
+
+    if(mBody != nullptr && !torque.isZero())
+        activate();
 }
 
 void PhysicsBodyComponent::setTorque(float x, float y, float z) {
@@ -225,21 +249,58 @@ void PhysicsBodyComponent::setDampingAmount(btScalar lindamping, btScalar angdam
 }
 
 void PhysicsBodyComponent::onUpdate(double time_diff) {
-    btTransform trans;
-    mBody->getMotionState()->getWorldTransform(trans);
-    /*std::cout << "x: " << trans.getOrigin().getX() << " y: "
-        << trans.getOrigin().getY() << " z: " << trans.getOrigin().getZ() << std::endl;*/
-
-    if(!mCentralForce.isZero()) {
-        mBody->applyCentralForce(mCentralForce);
+    if(mIsSyncingNode)
+        return;
+
+    if(time_diff == 0) {
+        if(getNode()->getPosition() == mSyncedPosition && getNode()->getRotation() == mSyncedRotation) {
+            // an ancestor moved, or the node was rescaled or re-parented. The body stays where it is
+            // and the node follows it on the next frame, without waking the body up.
+            mIsResting = false;
+            return;
+        }
+
+        // the node has been moved by game code, move the body along with it
+        btTransform trans(BtOgre::Convert::toBullet(getNode()->getRotation(Node::SCENE)),
+                          BtOgre::Convert::toBullet(getNode()->getPosition(Node::SCENE)));
+        mBody->setWorldTransform(trans);
+        mBody->setInterpolationWorldTransform(trans);
+        mBody->getMotionState()->setWorldTransform(trans);
+        if(!mBody->isStaticOrKinematicObject())
+            mBody->activate();
+        mIsResting = false;
+        mSyncedPosition = getNode()->getPosition();
+        mSyncedRotation = getNode()->getRotation();
+        return;
     }
 
-    if(!mTorque.isZero()) {
-        mBody->applyTorque(mTorque);
+    // Static and kinematic bodies are never moved by the simulation, sleeping ones are not
+    // integrated. Synchronize the node once, then leave it alone until the body wakes up.
+    if(mBody->isStaticOrKinematicObject() || !mBody->isActive()) {
+        if(mIsResting)
+            return;
+        mIsResting = true;
+    } else {
+        mIsResting = false;
+
+        if(!mCentralForce.isZero()) {
+            mBody->applyCentralForce(mCentralForce);
+        }
+
+        if(!mTorque.isZero()) {
+            mBody->applyTorque(mTorque);
+        }
     }
 
+    btTransform trans;
+    mBody->getMotionState()->getWorldTransform(trans);
+
+    mIsSyncingNode = true;
     getNode()->setPosition(BtOgre::Convert::toOgre(trans.getOrigin()), Node::SCENE);
     getNode()->setRotation(BtOgre::Convert::toOgre(trans.getRotation()), Node::SCENE);
+    mIsSyncingNode = false;
+    mSyncedPosition = getNode()->getPosition();
+    mSyncedRotation = getNode()->getRotation();
 }
 
 void PhysicsBodyComponent::setMass(btScalar mass) {
@@ -257,5 +318,10 @@ void PhysicsBodyComponent::SetCollisionShapeType(CollisionShapeType type) {
 
 void PhysicsBodyComponent::activate() {
     mBody->activate();
+    mIsResting = false;
+}
+
+bool PhysicsBodyComponent::isResting() const {
+    return mIsResting;
 }
 }
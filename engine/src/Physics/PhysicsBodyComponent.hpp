@@ -15,6 +15,7 @@
 #include <btBulletDynamicsCommon.h>
 #include <btBulletCollisionCommon.h>
 
+#include <OgreQuaternion.h>
 #include <OgreVector3.h>
 #include <BtOgrePG.h>
 
@@ -50,14 +51,32 @@ public:
       * @see MeshComponent
       * @see Component
       */
-    PhysicsBodyComponent(const QString mesh_component_name,
+    PhysicsBodyComponent(const QString mesh_component_name = "",
                          const QString name = "", CollisionShapeType collision_shape_type = CONVEX, btScalar mass = 5.0f);
 
     void onInitialize();
     void onDeinitialize();
     void onEnable();
     void onDisable();
+
+    /**
+      * Synchronizes the node with the rigid body. Static, kinematic and sleeping bodies are skipped
+      * once their node has been synchronized, until they are woken up again. When the node has been
+      * moved by game code, its transform is pushed into the rigid body instead. The node counts as moved
+      * if its transform relative to its parent differs from the one last synchronized, so moving an
+      * ancestor, rescaling or re-parenting only moves the node back to the body on the next frame.
+      * @param time_diff The frame time.
+      */
     void onUpdate(double time_diff);
+    void onSerialize(IOPacket &packet);
+
+    /**
+      * Streams the fields of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
 
     /**
       * Called when the PhysicsBodyComponent collides with another one.
@@ -173,6 +192,13 @@ public:
 
     void activate();
 
+    /**
+      * Returns whether the body is static, kinematic or sleeping and its node is up to date,
+      * i.e. whether onUpdate currently skips it.
+      * @returns Whether the body is resting.
+      */
+    bool isResting() const;
+
 signals:
     void collided(dt::PhysicsBodyComponent* other_body, dt::PhysicsBodyComponent* this_body);
 
@@ -188,6 +214,10 @@ private:
     uint16_t mCollisionGroup;
     bool mCollisionMaskInUse;
     btScalar mMass;
+    bool mIsResting;                        //!< Whether the node has been synchronized since the body stopped moving.
+    bool mIsSyncingNode;                    //!< Whether the node is being moved by this component, to tell it apart from moves by game code.
+    Ogre::Vector3 mSyncedPosition;          //!< The position of the node relative to its parent when it was last synchronized.
+    Ogre::Quaternion mSyncedRotation;       //!< The rotation of the node relative to its parent when it was last synchronized.
 
 };
 
@@ -0,0 +1,235 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Physics/PhysicsDebugDrawer.hpp>
+
+#include <Utils/Logger.hpp>
+
+#include <OgreHardwareBufferManager.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace dt {
+
+PhysicsDebugDrawer::PhysicsDebugDrawer(Ogre::SceneNode* node, btDiscreteDynamicsWorld* world)
+    : mWorld(world),
+      mSceneNode(node),
+      mCamera(nullptr),
+      mMaxDistance(100.f),
+      mUpdateInterval(1),
+      mTickCount(0),
+      mDebugMode(DBG_NoDebug),
+      mColourType(Ogre::VertexElement::getBestColourVertexElementType()),
+      mBufferCapacity(0) {
+    mRenderOp.operationType = Ogre::RenderOperation::OT_LINE_LIST;
+    mRenderOp.useIndexes = false;
+    mRenderOp.vertexData = new Ogre::VertexData();
+    mRenderOp.vertexData->vertexCount = 0;
+    mRenderOp.vertexData->vertexStart = 0;
+
+    Ogre::VertexDeclaration* decl = mRenderOp.vertexData->vertexDeclaration;
+    decl->addElement(0, 0, Ogre::VET_FLOAT3, Ogre::VES_POSITION);
+    decl->addElement(0, Ogre::VertexElement::getTypeSize(Ogre::VET_FLOAT3), mColourType, Ogre::VES_DIFFUSE);
+
+    // the lines are in world coordinates and may be anywhere
+    setBoundingBox(Ogre::AxisAlignedBox(Ogre::AxisAlignedBox::EXTENT_INFINITE));
+    setMaterial("BaseWhiteNoLighting");
+    setCastShadows(false);
+    setVisible(false);
+
+    mSceneNode->attachObject(this);
+}
+
+PhysicsDebugDrawer::~PhysicsDebugDrawer() {
+    mSceneNode->detachObject(this);
+    delete mRenderOp.vertexData;
+}
+
+void PhysicsDebugDrawer::step() {
+    if(mDebugMode == DBG_NoDebug)
+        return;
+
+    if(++mTickCount < mUpdateInterval)
+        return;
+    mTickCount = 0;
+
+    mVertices.clear();
+
+    // Draw the objects ourselves instead of calling debugDrawWorld(), so they can be culled
+    // before Bullet generates the lines for their shapes.
+    if(mDebugMode & (DBG_DrawWireframe | DBG_DrawAabb)) {
+        const btCollisionObjectArray& objects = mWorld->getCollisionObjectArray();
+        for(int32_t i = 0; i < objects.size(); ++i) {
+            btCollisionObject* object = objects[i];
+
+            btVector3 min, max;
+            object->getCollisionShape()->getAabb(object->getWorldTransform(), min, max);
+            if(!_isVisible(min, max))
+                continue;
+
+            if(mDebugMode & DBG_DrawWireframe) {
+                btVector3 color(1, 1, 1);
+                switch(object->getActivationState()) {
+                case ACTIVE_TAG:
+                    color = btVector3(1, 1, 1); break;
+                case ISLAND_SLEEPING:
+                    color = btVector3(0, 1, 0); break;
+                case WANTS_DEACTIVATION:
+                    color = btVector3(0, 1, 1); break;
+                case DISABLE_DEACTIVATION:
+                    color = btVector3(1, 0, 0); break;
+                case DISABLE_SIMULATION:
+                    color = btVector3(1, 1, 0); break;
+                default:
+                    color = btVector3(1, 0, 0);
+                }
+                mWorld->debugDrawObject(object->getWorldTransform(), object->getCollisionShape(), color);
+            }
+
+            if(mDebugMode & DBG_DrawAabb) {
+                drawAabb(min, max, btVector3(1, 0, 0));
+            }
+        }
+    }
+
+    if(mDebugMode & DBG_DrawContactPoints) {
+        btDispatcher* dispatcher = mWorld->getDispatcher();
+        int32_t num_manifolds = dispatcher->getNumManifolds();
+        for(int32_t i = 0; i < num_manifolds; ++i) {
+            btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+            for(int32_t j = 0; j < manifold->getNumContacts(); ++j) {
+                const btManifoldPoint& point = manifold->getContactPoint(j);
+                const btVector3& position = point.getPositionWorldOnB();
+                if(!_isVisible(position, position))
+                    continue;
+
+                drawContactPoint(position, point.m_normalWorldOnB, point.getDistance(),
+                                 point.getLifeTime(), btVector3(1, 1, 0));
+            }
+        }
+    }
+
+    if(mDebugMode & (DBG_DrawConstraints | DBG_DrawConstraintLimits)) {
+        for(int32_t i = 0; i < mWorld->getNumConstraints(); ++i) {
+            mWorld->debugDrawConstraint(mWorld->getConstraint(i));
+        }
+    }
+
+    _upload();
+}
+
+void PhysicsDebugDrawer::setCamera(Ogre::Camera* camera) {
+    mCamera = camera;
+}
+
+void PhysicsDebugDrawer::setMaxDistance(float max_distance) {
+    mMaxDistance = max_distance;
+}
+
+void PhysicsDebugDrawer::setUpdateInterval(uint32_t ticks) {
+    mUpdateInterval = ticks > 0 ? ticks : 1;
+}
+
+uint32_t PhysicsDebugDrawer::getLineCount() const {
+    return mRenderOp.vertexData->vertexCount / 2;
+}
+
+void PhysicsDebugDrawer::drawLine(const btVector3& from, const btVector3& to, const btVector3& color) {
+    Ogre::ColourValue colour(color.x(), color.y(), color.z());
+    Ogre::RGBA packed = (mColourType == Ogre::VET_COLOUR_ARGB) ? colour.getAsARGB() : colour.getAsABGR();
+
+    Vertex vertex;
+    vertex.mColour = packed;
+
+    vertex.mX = from.x();
+    vertex.mY = from.y();
+    vertex.mZ = from.z();
+    mVertices.push_back(vertex);
+
+    vertex.mX = to.x();
+    vertex.mY = to.y();
+    vertex.mZ = to.z();
+    mVertices.push_back(vertex);
+}
+
+void PhysicsDebugDrawer::drawContactPoint(const btVector3& point_on_b, const btVector3& normal_on_b,
+                                          btScalar distance, int life_time, const btVector3& color) {
+    drawLine(point_on_b, point_on_b + normal_on_b * 0.1f, color);
+}
+
+void PhysicsDebugDrawer::reportErrorWarning(const char* warning) {
+    Logger::get().warning(QString("Bullet: ") + warning);
+}
+
+void PhysicsDebugDrawer::draw3dText(const btVector3& location, const char* text) {}
+
+void PhysicsDebugDrawer::setDebugMode(int debug_mode) {
+    mDebugMode = debug_mode;
+    mTickCount = mUpdateInterval;   // update right away on the next step
+
+    if(mDebugMode == DBG_NoDebug) {
+        setVisible(false);
+        // free the memory, it will not be needed for a while
+        std::vector<Vertex>().swap(mVertices);
+        mBuffer.setNull();
+        mBufferCapacity = 0;
+        mRenderOp.vertexData->vertexBufferBinding->unsetAllBindings();
+        mRenderOp.vertexData->vertexCount = 0;
+    }
+}
+
+int PhysicsDebugDrawer::getDebugMode() const {
+    return mDebugMode;
+}
+
+Ogre::Real PhysicsDebugDrawer::getSquaredViewDepth(const Ogre::Camera* camera) const {
+    return 0;
+}
+
+Ogre::Real PhysicsDebugDrawer::getBoundingRadius() const {
+    return 0;
+}
+
+bool PhysicsDebugDrawer::_isVisible(const btVector3& min, const btVector3& max) const {
+    if(mCamera == nullptr)
+        return true;
+
+    Ogre::AxisAlignedBox box(min.x(), min.y(), min.z(), max.x(), max.y(), max.z());
+    if(box.squaredDistance(mCamera->getDerivedPosition()) > mMaxDistance * mMaxDistance)
+        return false;
+
+    return mCamera->isVisible(box);
+}
+
+void PhysicsDebugDrawer::_upload() {
+    uint32_t count = mVertices.size();
+
+    if(count > mBufferCapacity) {
+        // grow geometrically so the buffer is rarely recreated
+        uint32_t capacity = std::max<uint32_t>(mBufferCapacity * 2, 1024);
+        while(capacity < count)
+            capacity *= 2;
+
+        mBuffer = Ogre::HardwareBufferManager::getSingleton().createVertexBuffer(
+            sizeof(Vertex), capacity, Ogre::HardwareBuffer::HBU_DYNAMIC_WRITE_ONLY_DISCARDABLE);
+        mRenderOp.vertexData->vertexBufferBinding->setBinding(0, mBuffer);
+        mBufferCapacity = capacity;
+    }
+
+    if(count > 0) {
+        void* data = mBuffer->lock(0, count * sizeof(Vertex), Ogre::HardwareBuffer::HBL_DISCARD);
+        std::memcpy(data, &mVertices[0], count * sizeof(Vertex));
+        mBuffer->unlock();
+    }
+
+    mRenderOp.vertexData->vertexCount = count;
+    setVisible(count > 0);
+}
+
+}
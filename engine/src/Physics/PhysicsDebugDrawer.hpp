@@ -0,0 +1,129 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_PHYSICS_PHYSICSDEBUGDRAWER
+#define DUCTTAPE_ENGINE_PHYSICS_PHYSICSDEBUGDRAWER
+
+#include <Config.hpp>
+
+#include <btBulletDynamicsCommon.h>
+
+#include <OgreCamera.h>
+#include <OgreHardwareVertexBuffer.h>
+#include <OgreSceneNode.h>
+#include <OgreSimpleRenderable.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace dt {
+
+/**
+  * Draws the debug lines of a Bullet world. All lines and contact points of a frame are collected
+  * in one array and uploaded into a single dynamic vertex buffer with one lock, which is only
+  * reallocated when it has to grow. Collision objects outside the camera frustum or farther away
+  * than the maximum distance are skipped before Bullet generates their lines.
+  * @see PhysicsWorld::setShowDebug(bool show_debug);
+  */
+class DUCTTAPE_API PhysicsDebugDrawer : public btIDebugDraw, public Ogre::SimpleRenderable {
+public:
+    /**
+      * Advanced constructor.
+      * @param node The scene node to attach the lines to. The lines are in world coordinates.
+      * @param world The Bullet world to draw.
+      */
+    PhysicsDebugDrawer(Ogre::SceneNode* node, btDiscreteDynamicsWorld* world);
+
+    /**
+      * Destructor.
+      */
+    ~PhysicsDebugDrawer();
+
+    /**
+      * Collects and uploads the lines of the world. Does nothing while the debug mode is 0
+      * and between updates when an update interval is set.
+      */
+    void step();
+
+    /**
+      * Sets the camera used for culling. Pass nullptr to disable culling.
+      * @param camera The camera.
+      */
+    void setCamera(Ogre::Camera* camera);
+
+    /**
+      * Sets the distance from the camera beyond which objects are not drawn.
+      * @param max_distance The maximum distance. Default: 100.
+      */
+    void setMaxDistance(float max_distance);
+
+    /**
+      * Sets how often the lines are regenerated.
+      * @param ticks The number of ticks between updates. 1 updates every tick.
+      */
+    void setUpdateInterval(uint32_t ticks);
+
+    /**
+      * Returns the number of lines drawn in the last update.
+      * @returns The number of lines drawn in the last update.
+      */
+    uint32_t getLineCount() const;
+
+    // btIDebugDraw
+    void drawLine(const btVector3& from, const btVector3& to, const btVector3& color);
+    void drawContactPoint(const btVector3& point_on_b, const btVector3& normal_on_b,
+                          btScalar distance, int life_time, const btVector3& color);
+    void reportErrorWarning(const char* warning);
+    void draw3dText(const btVector3& location, const char* text);
+    void setDebugMode(int debug_mode);
+    int getDebugMode() const;
+
+    // Ogre::SimpleRenderable
+    Ogre::Real getSquaredViewDepth(const Ogre::Camera* camera) const;
+    Ogre::Real getBoundingRadius() const;
+
+private:
+    /**
+      * A line vertex, as laid out in the vertex buffer.
+      */
+    struct Vertex {
+        float mX;
+        float mY;
+        float mZ;
+        Ogre::RGBA mColour;
+    };
+
+    /**
+      * Returns whether a bounding box passes the frustum and distance culling.
+      * @param min The minimum corner.
+      * @param max The maximum corner.
+      * @returns Whether the box should be drawn.
+      */
+    bool _isVisible(const btVector3& min, const btVector3& max) const;
+
+    /**
+      * Copies the collected vertices into the vertex buffer, growing it if needed.
+      */
+    void _upload();
+
+    btDiscreteDynamicsWorld* mWorld;                //!< The world to draw.
+    Ogre::SceneNode* mSceneNode;                    //!< The node the lines are attached to.
+    Ogre::Camera* mCamera;                          //!< The camera used for culling, or nullptr.
+    float mMaxDistance;                             //!< The culling distance.
+    uint32_t mUpdateInterval;                       //!< The number of ticks between updates.
+    uint32_t mTickCount;                            //!< The number of ticks since the last update.
+    int mDebugMode;                                 //!< The Bullet debug mode flags.
+    Ogre::VertexElementType mColourType;            //!< The packed colour format of the render system.
+    std::vector<Vertex> mVertices;                  //!< The vertices collected this update. Keeps its capacity.
+    Ogre::HardwareVertexBufferSharedPtr mBuffer;    //!< The vertex buffer.
+    uint32_t mBufferCapacity;                       //!< The number of vertices the buffer can hold.
+};
+
+}
+
+#endif
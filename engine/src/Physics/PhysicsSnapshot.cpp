@@ -0,0 +1,50 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Physics/PhysicsSnapshot.hpp>
+
+namespace dt {
+
+PhysicsSnapshot::PhysicsSnapshot()
+    : mLocalTime(0),
+      mIsEmpty(true) {}
+
+void PhysicsSnapshot::reserve(uint32_t body_count, uint32_t constraint_count) {
+    mBodies.reserve(body_count);
+    mConstraints.reserve(constraint_count);
+}
+
+void PhysicsSnapshot::clear() {
+    // btAlignedObjectArray::resize never shrinks the capacity
+    mBodies.resize(0);
+    mConstraints.resize(0);
+    mLocalTime = 0;
+    mIsEmpty = true;
+}
+
+bool PhysicsSnapshot::isEmpty() const {
+    return mIsEmpty;
+}
+
+uint32_t PhysicsSnapshot::getBodyCount() const {
+    return mBodies.size();
+}
+
+uint32_t PhysicsSnapshot::getConstraintCount() const {
+    return mConstraints.size();
+}
+
+const PhysicsSnapshot::BodyState& PhysicsSnapshot::getBodyState(uint32_t index) const {
+    return mBodies[index];
+}
+
+btScalar PhysicsSnapshot::getConstraintImpulse(uint32_t index) const {
+    return mConstraints[index];
+}
+
+} // namespace dt
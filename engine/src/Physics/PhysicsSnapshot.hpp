@@ -0,0 +1,105 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_PHYSICS_PHYSICSSNAPSHOT
+#define DUCTTAPE_ENGINE_PHYSICS_PHYSICSSNAPSHOT
+
+#include <Config.hpp>
+
+#include <btBulletDynamicsCommon.h>
+
+#include <LinearMath/btAlignedObjectArray.h>
+
+#include <cstdint>
+
+namespace dt {
+
+/**
+  * A flat buffer holding the complete dynamic state of a PhysicsWorld at one point in time.
+  * The buffer is meant to be allocated once and reused for every snapshot, so saving and
+  * restoring does not allocate as long as the number of bodies and constraints does not grow.
+  * @see PhysicsWorld::saveSnapshot(PhysicsSnapshot& snapshot);
+  * @see PhysicsWorld::restoreSnapshot(const PhysicsSnapshot& snapshot);
+  */
+class DUCTTAPE_API PhysicsSnapshot {
+public:
+    /**
+      * The dynamic state of a single collision object.
+      */
+    ATTRIBUTE_ALIGNED16(struct) BodyState {
+        btTransform mWorldTransform;                //!< The world transform.
+        btTransform mInterpolationWorldTransform;   //!< The transform used for motion state interpolation.
+        btVector3 mLinearVelocity;                  //!< The linear velocity (rigid bodies only).
+        btVector3 mAngularVelocity;                 //!< The angular velocity (rigid bodies only).
+        btVector3 mInterpolationLinearVelocity;     //!< The linear velocity used for interpolation.
+        btVector3 mInterpolationAngularVelocity;    //!< The angular velocity used for interpolation.
+        btScalar mDeactivationTime;                 //!< The time the object has been resting.
+        int32_t mActivationState;                   //!< The activation state (ACTIVE_TAG, ISLAND_SLEEPING, ...).
+    };
+
+    /**
+      * Default constructor.
+      */
+    PhysicsSnapshot();
+
+    /**
+      * Preallocates the buffer.
+      * @param body_count The number of collision objects to reserve space for.
+      * @param constraint_count The number of constraints to reserve space for.
+      */
+    void reserve(uint32_t body_count, uint32_t constraint_count);
+
+    /**
+      * Clears the snapshot. The allocated memory is kept.
+      */
+    void clear();
+
+    /**
+      * Returns whether the snapshot holds any state.
+      * @returns Whether the snapshot holds any state.
+      */
+    bool isEmpty() const;
+
+    /**
+      * Returns the number of collision objects stored in the snapshot.
+      * @returns The number of collision objects stored in the snapshot.
+      */
+    uint32_t getBodyCount() const;
+
+    /**
+      * Returns the number of constraints stored in the snapshot.
+      * @returns The number of constraints stored in the snapshot.
+      */
+    uint32_t getConstraintCount() const;
+
+    /**
+      * Returns the stored state of a collision object.
+      * @param index The index of the collision object in the world's collision object array.
+      * @returns The stored state of the collision object.
+      */
+    const BodyState& getBodyState(uint32_t index) const;
+
+    /**
+      * Returns the stored applied impulse of a constraint.
+      * @param index The index of the constraint in the world.
+      * @returns The stored applied impulse of the constraint.
+      */
+    btScalar getConstraintImpulse(uint32_t index) const;
+
+private:
+    friend class PhysicsWorld;
+
+    btAlignedObjectArray<BodyState> mBodies;        //!< The states of all collision objects, in world order.
+    btAlignedObjectArray<btScalar> mConstraints;    //!< The applied impulses of all constraints, in world order.
+    btScalar mLocalTime;                            //!< The world's accumulated time that has not been simulated yet.
+    bool mIsEmpty;                                  //!< Whether the snapshot holds any state.
+};
+
+} // namespace dt
+
+#endif
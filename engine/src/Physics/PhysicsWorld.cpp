@@ -11,14 +11,35 @@
 #include <Scene/Scene.hpp>
 #include <Utils/Logger.hpp>
 
-#include <BulletCollision/CollisionDispatch/btGhostObject.h>
+#include <BtOgreExtras.h>
 
 #include <OgreSceneManager.h>
 
 namespace dt {
 
+/**
+  * Exposes the time the Bullet world has accumulated but not simulated yet, which is part of the
+  * state that has to be saved for snapshots.
+  */
+class SnapshotDynamicsWorld : public btDiscreteDynamicsWorld {
+public:
+    SnapshotDynamicsWorld(btDispatcher* dispatcher, btBroadphaseInterface* broadphase,
+                          btConstraintSolver* solver, btCollisionConfiguration* configuration)
+        : btDiscreteDynamicsWorld(dispatcher, broadphase, solver, configuration) {}
+
+    btScalar getLocalTime() const {
+        return m_localTime;
+    }
+
+    void setLocalTime(btScalar local_time) {
+        m_localTime = local_time;
+    }
+};
+
 PhysicsWorld::PhysicsWorld(const QString name, Scene* scene)
     : mDynamicsWorld(nullptr),
+      mGhostPairCallback(nullptr),
+      mCharacterControllers(nullptr),
       mDebugDrawer(nullptr),
       mShowDebug(false),
       mScene(scene),
@@ -34,36 +55,47 @@ void PhysicsWorld::initialize() {
     mCollisionConfiguration = new btDefaultCollisionConfiguration;
     mCollisionDispatcher = new btCollisionDispatcher(mCollisionConfiguration);
     mSolver = new btSequentialImpulseConstraintSolver();
-    mDynamicsWorld = new btDiscreteDynamicsWorld(mCollisionDispatcher,
-                                                 mBroadphase, mSolver,
-                                                 mCollisionConfiguration);
+    mDynamicsWorld = new SnapshotDynamicsWorld(mCollisionDispatcher,
+                                               mBroadphase, mSolver,
+                                               mCollisionConfiguration);
 
     // setup world
     setGravity(mGravity);
     mDynamicsWorld->setInternalTickCallback(PhysicsWorld::BulletTickCallback, static_cast<void *>(this));
 
-    // setup debug drawer
-    mDebugDrawer = new BtOgre::DebugDrawer(mScene->getSceneManager()->getRootSceneNode(), mDynamicsWorld);
-    mDebugDrawer->setDebugMode(mShowDebug);
-    mDynamicsWorld->setDebugDrawer(mDebugDrawer);
+    // setup debug drawer (headless worlds have no scene to draw into)
+    if(mScene != nullptr) {
+        mDebugDrawer = new PhysicsDebugDrawer(mScene->getSceneManager()->getRootSceneNode(), mDynamicsWorld);
+        setShowDebug(mShowDebug);
+        mDynamicsWorld->setDebugDrawer(mDebugDrawer);
+    }
+
+    mGhostPairCallback = new btGhostPairCallback();
+    mDynamicsWorld->getBroadphase()->getOverlappingPairCache()->setInternalGhostPairCallback(mGhostPairCallback);
 
-    mDynamicsWorld->getBroadphase()->getOverlappingPairCache()->setInternalGhostPairCallback(new btGhostPairCallback());
+    mCharacterControllers = new CharacterControllerPool(mDynamicsWorld);
+    mDynamicsWorld->addAction(mCharacterControllers);
 }
 
 void PhysicsWorld::deinitialize() {
     // Delete in reverse order.
+    mDynamicsWorld->removeAction(mCharacterControllers);
+    delete mCharacterControllers;
+    mCharacterControllers = nullptr;
     delete mDebugDrawer;
     delete mDynamicsWorld;
     delete mSolver;
     delete mCollisionDispatcher;
     delete mCollisionConfiguration;
+    delete mGhostPairCallback;
     delete mBroadphase;
 }
 
 void PhysicsWorld::stepSimulation(double time_diff) {
     if(mIsEnabled) {
         mDynamicsWorld->stepSimulation(time_diff, 10);
-        mDebugDrawer->step();
+        if(mShowDebug && mDebugDrawer != nullptr)
+            mDebugDrawer->step();
     }
 }
 
@@ -112,8 +144,9 @@ const QString PhysicsWorld::getName() const {
 
 void PhysicsWorld::setShowDebug(bool show_debug) {
     mShowDebug = show_debug;
-    if(mDebugDrawer != nullptr) {
-        mDebugDrawer->setDebugMode(mShowDebug);
+    if(mDebugDrawer != nullptr && (mDebugDrawer->getDebugMode() != btIDebugDraw::DBG_NoDebug) != mShowDebug) {
+        mDebugDrawer->setDebugMode(mShowDebug ? btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawContactPoints
+                                              : btIDebugDraw::DBG_NoDebug);
     }
 }
 
@@ -121,6 +154,14 @@ bool PhysicsWorld::getShowDebug() const {
     return mShowDebug;
 }
 
+PhysicsDebugDrawer* PhysicsWorld::getDebugDrawer() {
+    return mDebugDrawer;
+}
+
+CharacterControllerPool* PhysicsWorld::getCharacterControllerPool() {
+    return mCharacterControllers;
+}
+
 
 void PhysicsWorld::setEnabled(bool enabled) {
     mIsEnabled = enabled;
@@ -130,6 +171,95 @@ bool PhysicsWorld::isEnabled() const {
     return mIsEnabled;
 }
 
+void PhysicsWorld::saveSnapshot(PhysicsSnapshot& snapshot) {
+    const btCollisionObjectArray& objects = mDynamicsWorld->getCollisionObjectArray();
+    int32_t num_objects = objects.size();
+    int32_t num_constraints = mDynamicsWorld->getNumConstraints();
+
+    // resize() only reallocates if the snapshot has never been this large before
+    snapshot.mBodies.resize(num_objects);
+    snapshot.mConstraints.resize(num_constraints);
+
+    for(int32_t i = 0; i < num_objects; ++i) {
+        const btCollisionObject* object = objects[i];
+        PhysicsSnapshot::BodyState& state = snapshot.mBodies[i];
+
+        state.mWorldTransform = object->getWorldTransform();
+        state.mInterpolationWorldTransform = object->getInterpolationWorldTransform();
+        state.mInterpolationLinearVelocity = object->getInterpolationLinearVelocity();
+        state.mInterpolationAngularVelocity = object->getInterpolationAngularVelocity();
+        state.mDeactivationTime = object->getDeactivationTime();
+        state.mActivationState = object->getActivationState();
+
+        const btRigidBody* body = btRigidBody::upcast(object);
+        if(body != nullptr) {
+            state.mLinearVelocity = body->getLinearVelocity();
+            state.mAngularVelocity = body->getAngularVelocity();
+        } else {
+            state.mLinearVelocity.setZero();
+            state.mAngularVelocity.setZero();
+        }
+    }
+
+    for(int32_t i = 0; i < num_constraints; ++i) {
+        snapshot.mConstraints[i] = mDynamicsWorld->getConstraint(i)->internalGetAppliedImpulse();
+    }
+
+    snapshot.mLocalTime = static_cast<SnapshotDynamicsWorld*>(mDynamicsWorld)->getLocalTime();
+    snapshot.mIsEmpty = false;
+}
+
+bool PhysicsWorld::restoreSnapshot(const PhysicsSnapshot& snapshot) {
+    btCollisionObjectArray& objects = mDynamicsWorld->getCollisionObjectArray();
+
+    if(snapshot.isEmpty()) {
+        Logger::get().error("Cannot restore an empty snapshot into physics world " + mName + ".");
+        return false;
+    }
+    if(snapshot.mBodies.size() != objects.size() || snapshot.mConstraints.size() != mDynamicsWorld->getNumConstraints()) {
+        Logger::get().error("Cannot restore snapshot into physics world " + mName + ": the world's objects have changed.");
+        return false;
+    }
+
+    btOverlappingPairCache* pair_cache = mDynamicsWorld->getBroadphase()->getOverlappingPairCache();
+
+    for(int32_t i = 0; i < objects.size(); ++i) {
+        btCollisionObject* object = objects[i];
+        const PhysicsSnapshot::BodyState& state = snapshot.mBodies[i];
+
+        object->setWorldTransform(state.mWorldTransform);
+        object->setInterpolationWorldTransform(state.mInterpolationWorldTransform);
+        object->setInterpolationLinearVelocity(state.mInterpolationLinearVelocity);
+        object->setInterpolationAngularVelocity(state.mInterpolationAngularVelocity);
+        object->setDeactivationTime(state.mDeactivationTime);
+        // forceActivationState, as setActivationState refuses to touch DISABLE_DEACTIVATION bodies
+        object->forceActivationState(state.mActivationState);
+
+        btRigidBody* body = btRigidBody::upcast(object);
+        if(body != nullptr) {
+            body->setLinearVelocity(state.mLinearVelocity);
+            body->setAngularVelocity(state.mAngularVelocity);
+            body->clearForces();
+        }
+
+        // Drop the cached contact points, their warmstarting impulses belong to the state we are rolling back from.
+        if(object->getBroadphaseHandle() != nullptr) {
+            pair_cache->cleanProxyFromPairs(object->getBroadphaseHandle(), mDynamicsWorld->getDispatcher());
+        }
+    }
+
+    for(int32_t i = 0; i < snapshot.mConstraints.size(); ++i) {
+        mDynamicsWorld->getConstraint(i)->internalSetAppliedImpulse(snapshot.mConstraints[i]);
+    }
+
+    static_cast<SnapshotDynamicsWorld*>(mDynamicsWorld)->setLocalTime(snapshot.mLocalTime);
+
+    mSolver->reset();
+    mDynamicsWorld->updateAabbs();
+    mDynamicsWorld->synchronizeMotionStates();
+    return true;
+}
+
 // Callback stuff for Bullet (static)
 void PhysicsWorld::BulletTickCallback(btDynamicsWorld* world, btScalar time_diff) {
     PhysicsWorld* physics_world = static_cast<PhysicsWorld*>(world->getWorldUserInfo());
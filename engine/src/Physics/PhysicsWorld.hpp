@@ -13,11 +13,13 @@
 
 #include <Core/Manager.hpp>
 
+#include <Physics/CharacterControllerPool.hpp>
 #include <Physics/PhysicsBodyComponent.hpp>
+#include <Physics/PhysicsDebugDrawer.hpp>
+#include <Physics/PhysicsSnapshot.hpp>
 
 #include <btBulletCollisionCommon.h>
-
-#include <BtOgreExtras.h>
+#include <BulletCollision/CollisionDispatch/btGhostObject.h>
 
 #include <QString>
 
@@ -38,7 +40,7 @@ public:
     /**
       * Default constructor.
       * @param name The name for this PhysicsWorld.
-      * @param scene The scene to link this world to.
+      * @param scene The scene to link this world to. Can be nullptr for a headless world without debug drawing.
       */
     PhysicsWorld(const QString name, Scene* scene);
 
@@ -90,6 +92,18 @@ public:
       */
     bool getShowDebug() const;
 
+    /**
+      * Returns the debug drawer, e.g. to set up culling or the update interval.
+      * @returns The debug drawer, or nullptr for headless worlds.
+      */
+    PhysicsDebugDrawer* getDebugDrawer();
+
+    /**
+      * Returns the pool managing the kinematic characters of this world.
+      * @returns The pool managing the kinematic characters of this world, or nullptr if the world is not initialized.
+      */
+    CharacterControllerPool* getCharacterControllerPool();
+
     /**
       * Sets whether the world is enabled.
       * @param enabled Whether the world is enabled.
@@ -102,6 +116,22 @@ public:
       */
     bool isEnabled() const;
 
+    /**
+      * Saves the complete dynamic state of the world (transforms, velocities, activation states and
+      * constraint impulses) into a snapshot. The snapshot buffer is reused, so keep it around between calls.
+      * @param snapshot The snapshot to write into.
+      */
+    void saveSnapshot(PhysicsSnapshot& snapshot);
+
+    /**
+      * Restores the dynamic state of the world from a snapshot. The world has to contain the same collision
+      * objects and constraints, in the same order, as when the snapshot was saved. Cached contact points and
+      * the solver's random seed are reset as well, so stepping after a restore always yields the same result.
+      * @param snapshot The snapshot to restore.
+      * @returns Whether the snapshot could be restored.
+      */
+    bool restoreSnapshot(const PhysicsSnapshot& snapshot);
+
     /**
       * Bullet tick callback.
       * @param world The bullet world that was stepped.
@@ -116,8 +146,10 @@ private:
     btCollisionDispatcher* mCollisionDispatcher;                //!< The Bullet collision dispatcher.
     btSequentialImpulseConstraintSolver* mSolver;               //!< The Bullet solver.
     btDiscreteDynamicsWorld* mDynamicsWorld;                    //!< The Bullet world.
+    btGhostPairCallback* mGhostPairCallback;                    //!< Keeps the pair caches of all ghost objects up to date.
+    CharacterControllerPool* mCharacterControllers;             //!< The kinematic characters.
 
-    BtOgre::DebugDrawer* mDebugDrawer;  //!< The debug drawer.
+    PhysicsDebugDrawer* mDebugDrawer;   //!< The debug drawer.
     bool mShowDebug;                    //!< Whether to show debug drawings or not.
     Scene* mScene;                      //!< The scene associated with this PhysicsWorld.
     Ogre::Vector3 mGravity;             //!< The gravity of this world.
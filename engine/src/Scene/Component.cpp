@@ -9,6 +9,7 @@
 #include <Scene/Component.hpp>
 
 #include <Logic/ScriptManager.hpp>
+#include <Network/Archive.hpp>
 #include <Scene/Node.hpp>
 #include <Utils/Utils.hpp>
 
@@ -51,17 +52,21 @@ void Component::setNode(Node* node) {
 }
 
 void Component::serialize(IOPacket& packet) {
+    packet.dispatch(*this);
+    onSerialize(packet);
+}
+
+template <typename Archive>
+void Component::streamFields(Archive& archive) {
     // only write type when serializing, it will be read by the Node on deserialization
-    if(packet.getDirection() == IOPacket::SERIALIZE) {
+    if(archive.getDirection() == IOPacket::SERIALIZE) {
         std::string type(metaObject()->className());
-        packet.stream(type, "type");
+        archive.stream(type, "type");
     }
 
-    packet.stream(mId, "uuid");
-    packet.stream(mName, "name");
-    packet.stream(mIsEnabled, "enabled", true);
-
-    onSerialize(packet);
+    archive.stream(mId, "uuid");
+    archive.stream(mName, "name");
+    archive.stream(mIsEnabled, "enabled", true);
 }
 
 void Component::onSerialize(IOPacket& packet) {}
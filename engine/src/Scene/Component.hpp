@@ -87,6 +87,14 @@ public:
 
     void serialize(IOPacket& packet);
 
+    /**
+      * Streams the type, uuid, name and state of the component with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
+
     virtual void onSerialize(IOPacket& packet);
 
 public slots:
@@ -159,6 +167,8 @@ protected:
     Node* mNode;        //!< The parent Node.
 
 private:
+    friend class SceneFile;
+
     bool mIsEnabled;    //!< Whether the component is enabled or not.
     bool mIsInitialized;    //!< Whether the component has been created or not.
     QUuid mId;    //!< The id for the component.
@@ -0,0 +1,73 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Scene/ComponentFactory.hpp>
+
+#include <Scene/Component.hpp>
+#include <Utils/Logger.hpp>
+#include <Utils/Utils.hpp>
+
+namespace dt {
+
+ComponentFactory::ComponentFactory() {}
+
+int ComponentFactory::registerComponent(const std::string& name, Creator creator) {
+    auto iter = mTypes.find(name);
+    if(iter != mTypes.end()) {
+        mCreators[iter->second - 1] = creator;
+        return iter->second;
+    }
+
+    mNames.push_back(name);
+    mCreators.push_back(creator);
+    mTypes[name] = mCreators.size();
+    return mCreators.size();
+}
+
+int ComponentFactory::getType(const std::string& name) const {
+    auto iter = mTypes.find(name);
+    return iter != mTypes.end() ? iter->second : NO_TYPE;
+}
+
+std::string ComponentFactory::getName(int type) const {
+    if(type <= NO_TYPE || type > static_cast<int>(mNames.size()))
+        return "";
+    return mNames[type - 1];
+}
+
+uint32_t ComponentFactory::getTypeCount() const {
+    return mCreators.size();
+}
+
+std::shared_ptr<Component> ComponentFactory::create(int type) const {
+    if(type <= NO_TYPE || type > static_cast<int>(mCreators.size()))
+        return std::shared_ptr<Component>();
+    return mCreators[type - 1]();
+}
+
+std::shared_ptr<Component> ComponentFactory::create(const std::string& name) const {
+    int type = getType(name);
+    if(type == NO_TYPE) {
+        // a scene full of them would flood the log otherwise
+        if(mReportedNames.insert(name).second) {
+            Logger::get().error("ComponentFactory: Invalid component type: " + Utils::toString(name)
+                                + ". Did you forget to register it? Watch out for namespaces!");
+        }
+        return std::shared_ptr<Component>();
+    }
+    return create(type);
+}
+
+void ComponentFactory::clear() {
+    mNames.clear();
+    mCreators.clear();
+    mTypes.clear();
+    mReportedNames.clear();
+}
+
+} // namespace dt
@@ -0,0 +1,259 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_SCENE_COMPONENTFACTORY
+#define DUCTTAPE_ENGINE_SCENE_COMPONENTFACTORY
+
+#include <Config.hpp>
+
+#include <QtGlobal>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace dt {
+
+// forward declaration
+class Component;
+
+/**
+  * Memory for the components of one class. The memory of a destroyed component is kept and used for the
+  * next one, so loading and unloading many components of the class does not allocate each time. The
+  * components are constructed anew every time, only their memory is reused.
+  * @note The pool is not thread-safe, the components have to be created and destroyed on one thread.
+  * @see ComponentFactory::registerPooledComponent
+  */
+template <typename ComponentType>
+class ComponentPool : public std::enable_shared_from_this<ComponentPool<ComponentType> > {
+
+    Q_DISABLE_COPY(ComponentPool)
+
+public:
+    /**
+      * Advanced constructor. The pool has to be owned by a shared_ptr.
+      * @param max_size The maximum number of blocks of memory to keep.
+      */
+    ComponentPool(uint32_t max_size = 64)
+        : mMaxSize(max_size),
+          mAllocationCount(0) {}
+
+    /**
+      * Destructor. Frees the memory kept.
+      */
+    ~ComponentPool() {
+        clear();
+    }
+
+    /**
+      * Constructs a component in memory from the pool.
+      * @returns The component. It returns its memory to the pool when destroyed.
+      */
+    std::shared_ptr<ComponentType> create() {
+        void* block = nullptr;
+        if(mBlocks.empty()) {
+            block = ::operator new(sizeof(ComponentType));
+            ++mAllocationCount;
+        } else {
+            block = mBlocks.back();
+            mBlocks.pop_back();
+        }
+
+        // the deleter keeps the pool alive until the last of its components is destroyed
+        std::shared_ptr<ComponentPool> pool = this->shared_from_this();
+        return std::shared_ptr<ComponentType>(new(block) ComponentType, [pool](ComponentType* component) {
+            pool->_release(component);
+        });
+    }
+
+    /**
+      * Sets the maximum number of blocks of memory to keep. Memory of components destroyed while the pool
+      * is full is freed.
+      * @param max_size The maximum number of blocks.
+      */
+    void setMaxSize(uint32_t max_size) {
+        mMaxSize = max_size;
+    }
+
+    /**
+      * Returns the maximum number of blocks of memory to keep.
+      * @returns The maximum number of blocks.
+      */
+    uint32_t getMaxSize() const {
+        return mMaxSize;
+    }
+
+    /**
+      * Returns the number of blocks of memory kept for new components.
+      * @returns The number of blocks.
+      */
+    uint32_t getSize() const {
+        return mBlocks.size();
+    }
+
+    /**
+      * Returns the number of blocks of memory allocated so far.
+      * @returns The number of allocations.
+      */
+    uint64_t getAllocationCount() const {
+        return mAllocationCount;
+    }
+
+    /**
+      * Frees the memory kept. Components still alive are not affected.
+      */
+    void clear() {
+        for(auto iter = mBlocks.begin(); iter != mBlocks.end(); ++iter) {
+            ::operator delete(*iter);
+        }
+        mBlocks.clear();
+    }
+
+private:
+    /**
+      * Private method. Destroys a component and keeps its memory.
+      * @param component The component.
+      */
+    void _release(ComponentType* component) {
+        component->~ComponentType();
+        if(mBlocks.size() < mMaxSize)
+            mBlocks.push_back(component);
+        else
+            ::operator delete(component);
+    }
+
+    std::vector<void*> mBlocks;     //!< The memory kept for new components.
+    uint32_t mMaxSize;              //!< The maximum number of blocks to keep.
+    uint64_t mAllocationCount;      //!< The number of blocks allocated.
+};
+
+/**
+  * Creates components by the name of their class, e.g. when loading a scene. Each class is registered once
+  * with a function that constructs it, and gets a type, which is its index in the table of those functions.
+  * Looking up the type of a name once and creating components by type skips the lookup per component.
+  * Components of a class can be constructed in memory from a ComponentPool instead of new memory each.
+  * @code
+  * factory.registerComponent<MeshComponent>("dt::MeshComponent");
+  * factory.registerPooledComponent<TriggerComponent>("dt::TriggerComponent", 256);
+  *
+  * int type = factory.getType("dt::MeshComponent");
+  * for(...)
+  *     node->addComponent(factory.create(type));
+  * @endcode
+  * @see Serializer
+  */
+class DUCTTAPE_API ComponentFactory {
+
+    Q_DISABLE_COPY(ComponentFactory)
+
+public:
+    /**
+      * A function constructing a component.
+      */
+    typedef std::function<std::shared_ptr<Component>()> Creator;
+
+    /**
+      * Returned instead of a type if a class is not registered.
+      */
+    static const int NO_TYPE = 0;
+
+    /**
+      * Default constructor.
+      */
+    ComponentFactory();
+
+    /**
+      * Registers a class with a function constructing its components. Registering a class again replaces
+      * the function, the type stays the same.
+      * @param name The name of the class, including the namespace.
+      * @param creator The function.
+      * @returns The type of the class.
+      */
+    int registerComponent(const std::string& name, Creator creator);
+
+    /**
+      * Registers a class whose components are constructed with new.
+      * @param name The name of the class, including the namespace.
+      * @returns The type of the class.
+      */
+    template <typename ComponentType>
+    int registerComponent(const std::string& name) {
+        return registerComponent(name, []() {
+            return std::shared_ptr<Component>(new ComponentType);
+        });
+    }
+
+    /**
+      * Registers a class whose components are constructed in memory from a pool.
+      * @param name The name of the class, including the namespace.
+      * @param max_size The maximum number of blocks of memory the pool keeps.
+      * @returns The pool.
+      */
+    template <typename ComponentType>
+    std::shared_ptr<ComponentPool<ComponentType> > registerPooledComponent(const std::string& name, uint32_t max_size = 64) {
+        std::shared_ptr<ComponentPool<ComponentType> > pool = std::make_shared<ComponentPool<ComponentType> >(max_size);
+        registerComponent(name, [pool]() -> std::shared_ptr<Component> {
+            return pool->create();
+        });
+        return pool;
+    }
+
+    /**
+      * Returns the type of a class.
+      * @param name The name of the class, including the namespace.
+      * @returns The type, or NO_TYPE if the class is not registered.
+      */
+    int getType(const std::string& name) const;
+
+    /**
+      * Returns the name of the class of a type.
+      * @param type The type.
+      * @returns The name, or an empty string if the type does not exist.
+      */
+    std::string getName(int type) const;
+
+    /**
+      * Returns the number of registered classes. The types are 1 up to this number.
+      * @returns The number of classes.
+      */
+    uint32_t getTypeCount() const;
+
+    /**
+      * Creates a component of a type.
+      * @param type The type.
+      * @returns The component, or nullptr if the type does not exist.
+      */
+    std::shared_ptr<Component> create(int type) const;
+
+    /**
+      * Creates a component of a class. An unknown class is reported as an error, once per name.
+      * @param name The name of the class, including the namespace.
+      * @returns The component, or nullptr if the class is not registered.
+      */
+    std::shared_ptr<Component> create(const std::string& name) const;
+
+    /**
+      * Unregisters all classes.
+      */
+    void clear();
+
+private:
+    std::vector<std::string> mNames;                        //!< The class name of each type.
+    std::vector<Creator> mCreators;                         //!< The function constructing each type.
+    std::unordered_map<std::string, int> mTypes;            //!< The type of each class name.
+    mutable std::unordered_set<std::string> mReportedNames; //!< The unknown class names reported so far.
+};
+
+} // namespace dt
+
+#endif
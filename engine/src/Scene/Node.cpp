@@ -10,9 +10,11 @@
 
 #include <Scene/StateManager.hpp>
 #include <Logic/ScriptManager.hpp>
+#include <Network/Archive.hpp>
 #include <Utils/Utils.hpp>
 #include <Scene/Scene.hpp>
 #include <Scene/Serializer.hpp>
+#include <Scene/SpatialIndex.hpp>
 
 namespace dt {
 
@@ -24,7 +26,10 @@ Node::Node(const QString name)
       mRotation(Ogre::Quaternion::IDENTITY),
       mParent(nullptr),
       mDeathMark(false),
-      mIsEnabled(true) {
+      mIsEnabled(true),
+      mSpatialIndex(nullptr),
+      mSpatialIndexEntry(0),
+      mIndexedNodeCount(0) {
 
     // auto-generate name
     if(mName == "") {
@@ -41,6 +46,10 @@ void Node::initialize() {
 void Node::deinitialize() {
     onDeinitialize();
 
+    if(mSpatialIndex != nullptr) {
+        mSpatialIndex->removeNode(this);
+    }
+
     // clear all children
     while(mChildren.size() > 0) {
         removeChildNode(mChildren.begin()->first);
@@ -138,6 +147,7 @@ void Node::setPosition(Ogre::Vector3 position, Node::RelativeTo rel) {
     } else {
         mPosition = mParent->getRotation() * position - mParent->getPosition(SCENE);
     }
+    _onTransformChanged();
     onUpdate(0);
 }
 
@@ -185,6 +195,9 @@ void Node::setRotation(Ogre::Quaternion rotation, Node::RelativeTo rel) {
         // TODO: implement backward rotation
         mRotation = mParent->getRotation(SCENE) * (-rotation);
     }
+    // children's scene positions depend on this rotation
+    if(!mChildren.empty())
+        _onTransformChanged();
     onUpdate(0);
 }
 
@@ -203,7 +216,10 @@ void Node::setParent(Node* parent) {
                 auto iter = mParent->mChildren.find(mName);
                 parent->mChildren.insert(std::make_pair(mName, iter->second));
                 mParent->mChildren.erase(iter);
+                mParent->_addIndexedNodeCount(-static_cast<int32_t>(mIndexedNodeCount));
                 mParent = parent;
+                mParent->_addIndexedNodeCount(mIndexedNodeCount);
+                _onTransformChanged();
             }
             else {
                 parent->addChildNode(this);
@@ -217,9 +233,14 @@ void Node::setParent(Node* parent) {
         mParent->RemoveChildNode(mName);
     } */
 
+    if(mParent != nullptr)
+        mParent->_addIndexedNodeCount(-static_cast<int32_t>(mIndexedNodeCount));
     mParent = parent;
+    if(mParent != nullptr)
+        mParent->_addIndexedNodeCount(mIndexedNodeCount);
 
     // the absolute position might have changed!
+    _onTransformChanged();
     _updateAllComponents(0);
 }
 
@@ -244,56 +265,82 @@ void Node::onUpdate(double time_diff) {
 }
 
 void Node::serialize(IOPacket& packet) {
-    packet.stream(mId, "uuid");
-    packet.stream(mName, "name", mName);
-    packet.stream(mPosition, "position");
-    packet.stream(mScale, "scale", Ogre::Vector3::UNIT_SCALE);
-    packet.stream(mRotation, "rotation");
-    packet.stream(mIsEnabled, "enabled");
-    onSerialize(packet);
+    packet.dispatch(*this);
+}
+
+template <typename Archive>
+void Node::streamFields(Archive& archive) {
+    // the data after an unreadable part is garbage
+    if(archive.getDirection() == IOPacket::DESERIALIZE && archive.getIOPacket().hasFailed())
+        return;
+
+    archive.stream(mId, "uuid");
+    archive.stream(mName, "name", mName);
+    archive.stream(mPosition, "position");
+    archive.stream(mScale, "scale", Ogre::Vector3::UNIT_SCALE);
+    archive.stream(mRotation, "rotation");
+    archive.stream(mIsEnabled, "enabled");
+    onSerialize(archive.getIOPacket());
 
     // Components
-    uint32_t count = packet.beginList(mComponents.size(), "components");
+    uint32_t count = archive.beginList(mComponents.size(), "components");
 
-    if(packet.getDirection() == IOPacket::SERIALIZE) {
+    if(archive.getDirection() == IOPacket::SERIALIZE) {
         // serialize
         for(auto iter = mComponents.begin(); iter != mComponents.end(); ++iter) {
-            packet.beginObject();
-            iter->second->serialize(packet);
-            packet.endObject();
+            archive.beginObject();
+            iter->second->serialize(archive.getIOPacket());
+            archive.endObject();
         }
     } else {
         for(uint32_t i = 0; i < count; ++i) {
-            packet.beginObject();
+            archive.beginObject();
             std::string type;
-            packet.stream(type, "type", std::string(""));
-            Component* c = Serializer::createComponent(type);
-            c->serialize(packet);
+            archive.stream(type, "type", std::string(""));
+            std::shared_ptr<Component> c = Serializer::createComponent(type);
+            if(c == nullptr) {
+                archive.endObject();
+                if(archive.getIOPacket().getMode() == IOPacket::TEXT)
+                    continue;
+
+                // binary streams carry no sizes, the fields of an unknown component cannot be skipped,
+                // and neither can anything after them
+                Logger::get().error("Cannot read the rest of node " + mName + " after a component of unknown type.");
+                archive.getIOPacket().setFailed();
+                archive.endList();
+                return;
+            }
+            c->serialize(archive.getIOPacket());
             addComponent(c);
-            packet.endObject();
+            archive.endObject();
         }
     }
-    packet.endList();
+    archive.endList();
 
     // Children
-    count = packet.beginList(mChildren.size(), "children");
+    count = archive.beginList(mChildren.size(), "children");
 
-    if(packet.getDirection() == IOPacket::SERIALIZE) {
+    if(archive.getDirection() == IOPacket::SERIALIZE) {
         for(auto iter = mChildren.begin(); iter != mChildren.end(); ++iter) {
-            packet.beginObject();
-            iter->second->serialize(packet);
-            packet.endObject();
+            archive.beginObject();
+            iter->second->serialize(archive.getIOPacket());
+            archive.endObject();
         }
     } else {
         for(uint32_t i = 0; i < count; ++i) {
-            packet.beginObject();
+            archive.beginObject();
             Node* n = new Node;
-            n->serialize(packet);
+            n->serialize(archive.getIOPacket());
             addChildNode(n);
-            packet.endObject();
+            archive.endObject();
+            if(archive.getIOPacket().hasFailed()) {
+                // the parents stop reading as well
+                archive.endList();
+                return;
+            }
         }
     }
-    packet.endList();
+    archive.endList();
 }
 
 void Node::onSerialize(IOPacket &packet) {}
@@ -339,6 +386,25 @@ void Node::_updateAllChildren(double time_diff) {
     mIsUpdatingAfterChange = false;
 }
 
+void Node::_onTransformChanged() {
+    if(mIndexedNodeCount == 0)
+        return;
+
+    if(mSpatialIndex != nullptr) {
+        mSpatialIndex->updateNode(this);
+    }
+
+    for(auto iter = mChildren.begin(); iter != mChildren.end(); ++iter) {
+        iter->second->_onTransformChanged();
+    }
+}
+
+void Node::_addIndexedNodeCount(int32_t count) {
+    for(Node* node = this; node != nullptr; node = node->mParent) {
+        node->mIndexedNodeCount += count;
+    }
+}
+
 void Node::kill() {
     if(mIsEnabled)
         mDeathMark = true;
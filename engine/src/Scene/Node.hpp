@@ -28,7 +28,10 @@
 namespace dt {
 
 // forward declaration due to circular dependency
+class NodeReplicator;
 class Scene;
+class SceneFile;
+class SpatialIndex;
 class State;
 
 /**
@@ -99,6 +102,21 @@ public:
       */
     template <typename ComponentType>
     std::shared_ptr<ComponentType> addComponent(ComponentType* component) {
+        const QString cname = component->getName();
+        if(hasComponent(cname)) {
+            Logger::get().error("Cannot add component " + cname + ": a component with this name already exists.");
+            return findComponent<ComponentType>(cname);
+        }
+        return addComponent(std::shared_ptr<ComponentType>(component));
+    }
+
+    /**
+      * Assigns a component to this node, e.g. one created by the ComponentFactory.
+      * @param component The Component to be assigned.
+      * @returns A pointer to the new component.
+      */
+    template <typename ComponentType>
+    std::shared_ptr<ComponentType> addComponent(std::shared_ptr<ComponentType> component) {
         const QString cname = component->getName();
         if(!hasComponent(cname)) {
             std::shared_ptr<Component> ptr(component);
@@ -144,6 +162,19 @@ public:
       */
     bool hasComponent(const QString name);
 
+    /**
+      * Returns whether this node has a component of the given type assigned.
+      * @returns true if a component of this type is assigned, otherwise false
+      */
+    template <typename ComponentType>
+    bool hasComponentOfType() {
+        for(auto iter = mComponents.begin(); iter != mComponents.end(); ++iter) {
+            if(dynamic_cast<ComponentType*>(iter->second.get()) != nullptr)
+                return true;
+        }
+        return false;
+    }
+
     /**
       * Removes a child Node with a specific name.
       * @param name The name of the Node to be removed.
@@ -234,6 +265,14 @@ public:
 
     void serialize(IOPacket& packet);
 
+    /**
+      * Streams the node, its components and its children with an archive.
+      * @param archive The archive.
+      * @see IOPacket::dispatch
+      */
+    template <typename Archive>
+    void streamFields(Archive& archive);
+
     virtual void onSerialize(IOPacket& packet);
 
     /**
@@ -354,11 +393,28 @@ protected:
       */
     void _updateAllChildren(double time_diff);
 
+    /**
+      * Called when the scene position of this Node changed. Updates the spatial index entries of this Node
+      * and all its children. Subtrees without any node in a spatial index are skipped.
+      * @see SpatialIndex
+      */
+    void _onTransformChanged();
+
+    /**
+      * Adds to the number of indexed nodes of this Node and all its ancestors.
+      * @param count The number of nodes that joined (positive) or left (negative) a spatial index.
+      */
+    void _addIndexedNodeCount(int32_t count);
+
     std::map<QString, std::shared_ptr<Component> > mComponents;   //!< The list of Components.
     QString mName;                                                //!< The Node name.
     bool mIsUpdatingAfterChange;                                  //!< Whether the node is just in the process of updating all components after a change occurred. This is to prevent infinite stack loops.
 
 private:
+    friend class NodeReplicator;
+    friend class SpatialIndex;
+    friend class SceneFile;
+
     std::map<QString, NodeSP> mChildren;                          //!< List of child nodes.
     Ogre::Vector3 mPosition;                                      //!< The Node position.
     Ogre::Vector3 mScale;                                         //!< The Node scale.
@@ -367,6 +423,9 @@ private:
     QUuid mId;                                                    //!< The node's uuid.
     bool mDeathMark;                                              //!< Whether the node is marked to be killed. If it's true, the node will be killed when it updates.
     bool mIsEnabled;                                              //!< Whether the node is enabled or not.
+    SpatialIndex* mSpatialIndex;                                  //!< The spatial index this node is registered in, or nullptr.
+    uint32_t mSpatialIndexEntry;                                  //!< The id of this node's entry in the spatial index.
+    uint32_t mIndexedNodeCount;                                   //!< The number of nodes in this subtree, this one included, registered in a spatial index.
 };
 
 } // namespace dt
@@ -51,4 +51,8 @@ PhysicsWorld::PhysicsWorldSP Scene::getPhysicsWorld() {
     return mgr->getWorld(mName);
 }
 
+SpatialIndex* Scene::getSpatialIndex() {
+    return &mSpatialIndex;
+}
+
 } // namespace dt
@@ -15,6 +15,7 @@
 //#include <Event/EventListener.hpp>
 #include <Physics/PhysicsWorld.hpp>
 #include <Scene/Node.hpp>
+#include <Scene/SpatialIndex.hpp>
 
 #include <QObject>
 #include <QString>
@@ -52,11 +53,20 @@ public:
       * @returns The PhysicsWorld of this Scene.
       */
     PhysicsWorld::PhysicsWorldSP getPhysicsWorld();
+
+    /**
+      * Returns the SpatialIndex of this Scene, used for proximity queries on nodes.
+      * @returns The SpatialIndex of this Scene.
+      */
+    SpatialIndex* getSpatialIndex();
 public slots:
     void updateFrame(double simulation_frame_time);
 protected:
     bool _isScene();
 
+private:
+    SpatialIndex mSpatialIndex;     //!< The index of nodes for proximity queries.
+
 };
 
 } // namespace dt
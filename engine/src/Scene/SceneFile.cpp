@@ -0,0 +1,512 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Scene/SceneFile.hpp>
+
+#include <Network/BitStream.hpp>
+#include <Network/IOPacket.hpp>
+#include <Scene/Component.hpp>
+#include <Scene/Node.hpp>
+#include <Scene/Serializer.hpp>
+#include <Utils/Logger.hpp>
+#include <Utils/Utils.hpp>
+
+#include <QHash>
+
+#include <cstring>
+
+namespace dt {
+
+/**
+  * The magic number every scene file starts with.
+  */
+static const char MAGIC[4] = {'D', 'T', 'S', 'C'};
+
+/**
+  * Written in the byte order of the machine, to detect files written with another one.
+  */
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/**
+  * Set in the flags of enabled nodes and components.
+  */
+static const uint32_t ENABLED_FLAG = 0x1;
+
+/**
+  * The header at the start of the file. The sections follow in this order.
+  */
+struct SceneFile::Header {
+    char mMagic[4];                 //!< "DTSC".
+    uint16_t mVersion;              //!< The version of the format.
+    uint16_t mHeaderSize;           //!< The size of this header.
+    uint32_t mByteOrder;            //!< BYTE_ORDER_MARK.
+    uint32_t mNodeCount;            //!< The number of node records.
+    uint32_t mNodeOffset;           //!< The offset of the node records.
+    uint32_t mComponentCount;       //!< The number of component records.
+    uint32_t mComponentOffset;      //!< The offset of the component records.
+    uint32_t mTypeCount;            //!< The number of component types.
+    uint32_t mTypeOffset;           //!< The offset of the type table, holding the string of each type's class name.
+    uint32_t mStringCount;          //!< The number of strings.
+    uint32_t mStringOffset;         //!< The offset of the string table.
+    uint32_t mCharsOffset;          //!< The offset of the UTF-8 characters of the strings.
+    uint32_t mCharsSize;            //!< The size of the characters.
+    uint32_t mDataOffset;           //!< The offset of the onSerialize() data.
+    uint32_t mDataSize;             //!< The size of the onSerialize() data.
+};
+
+/**
+  * A node. The nodes are stored breadth-first, starting with the root.
+  */
+struct SceneFile::NodeRecord {
+    uint8_t mId[16];                //!< The UUID.
+    uint32_t mName;                 //!< The string of the name.
+    float mPosition[3];             //!< The position.
+    float mScale[3];                //!< The scale.
+    float mRotation[4];             //!< The rotation, w first.
+    uint32_t mFirstChild;           //!< The record of the first child.
+    uint32_t mChildCount;           //!< The number of children.
+    uint32_t mFirstComponent;       //!< The record of the first component.
+    uint32_t mComponentCount;       //!< The number of components.
+    uint32_t mDataOffset;           //!< The offset of the data written by Node::onSerialize().
+    uint32_t mDataSize;             //!< The size of the data.
+    uint32_t mFlags;                //!< ENABLED_FLAG.
+};
+
+/**
+  * A component. The components of a node are consecutive.
+  */
+struct SceneFile::ComponentRecord {
+    uint8_t mId[16];                //!< The UUID.
+    uint32_t mType;                 //!< The index in the type table.
+    uint32_t mName;                 //!< The string of the name.
+    uint32_t mFlags;                //!< ENABLED_FLAG.
+    uint32_t mDataOffset;           //!< The offset of the data written by Component::onSerialize().
+    uint32_t mDataSize;             //!< The size of the data.
+};
+
+/**
+  * A string in the string table.
+  */
+struct SceneFile::StringEntry {
+    uint32_t mOffset;               //!< The offset of the characters.
+    uint32_t mSize;                 //!< The number of bytes.
+};
+
+/**
+  * Writes a UUID into 16 bytes.
+  */
+static void writeUuid(const QUuid& id, uint8_t* out) {
+    memcpy(out, &id.data1, 4);
+    memcpy(out + 4, &id.data2, 2);
+    memcpy(out + 6, &id.data3, 2);
+    memcpy(out + 8, id.data4, 8);
+}
+
+/**
+  * Reads a UUID from 16 bytes.
+  */
+static QUuid readUuid(const uint8_t* in) {
+    QUuid id;
+    memcpy(&id.data1, in, 4);
+    memcpy(&id.data2, in + 4, 2);
+    memcpy(&id.data3, in + 6, 2);
+    memcpy(id.data4, in + 8, 8);
+    return id;
+}
+
+/**
+  * Returns whether a section lies within the file and is aligned for its records.
+  */
+static bool isSectionValid(uint32_t offset, uint32_t count, uint32_t record_size, uint32_t file_size) {
+    return offset % 4 == 0 && static_cast<uint64_t>(offset) + static_cast<uint64_t>(count) * record_size <= file_size;
+}
+
+/**
+  * Appends the data an object writes in onSerialize(), bit-packed.
+  */
+template <typename T>
+static void writeData(T* object, std::vector<char>& scratch, std::vector<char>& data, uint32_t& offset, uint32_t& size) {
+    // the size is not known beforehand, retry with a larger buffer until it fits
+    while(true) {
+        BitStream stream(&scratch[0], scratch.size(), BitStream::WRITE);
+        IOPacket packet(&stream);
+        object->onSerialize(packet);
+
+        if(!stream.isOverflowed()) {
+            offset = data.size();
+            size = stream.getSize();
+            data.insert(data.end(), scratch.begin(), scratch.begin() + size);
+            return;
+        }
+        scratch.resize(scratch.size() * 2);
+    }
+}
+
+SceneFile::SceneFile()
+    : mMapping(nullptr),
+      mSize(0),
+      mHeader(nullptr),
+      mNodes(nullptr),
+      mComponents(nullptr),
+      mStrings(nullptr) {
+    // the records are read in place, their layout must not depend on the compiler
+    static_assert(sizeof(Header) == 60, "The scene file header has padding.");
+    static_assert(sizeof(NodeRecord) == 88, "The scene file node record has padding.");
+    static_assert(sizeof(ComponentRecord) == 36, "The scene file component record has padding.");
+}
+
+SceneFile::~SceneFile() {
+    close();
+}
+
+bool SceneFile::save(Node* node, const QString& path) {
+    std::vector<Node*> nodes(1, node);
+    std::vector<NodeRecord> node_records;
+    std::vector<ComponentRecord> component_records;
+    std::vector<uint32_t> types;
+    QHash<QString, uint32_t> type_ids;
+    std::vector<StringEntry> strings;
+    QHash<QString, uint32_t> string_ids;
+    std::vector<char> chars;
+    std::vector<char> data;
+    std::vector<char> scratch(1024);
+
+    // every string is stored once
+    auto add_string = [&](const QString& string) -> uint32_t {
+        auto iter = string_ids.find(string);
+        if(iter != string_ids.end())
+            return iter.value();
+
+        QByteArray utf8 = string.toUtf8();
+        StringEntry entry;
+        entry.mOffset = chars.size();
+        entry.mSize = utf8.size();
+        chars.insert(chars.end(), utf8.constData(), utf8.constData() + utf8.size());
+        strings.push_back(entry);
+        string_ids.insert(string, strings.size() - 1);
+        return strings.size() - 1;
+    };
+
+    for(uint32_t i = 0; i < nodes.size(); ++i) {
+        Node* current = nodes[i];
+
+        NodeRecord record;
+        memset(&record, 0, sizeof(NodeRecord));
+        writeUuid(current->mId, record.mId);
+        record.mName = add_string(current->mName);
+        for(uint32_t j = 0; j < 3; ++j) {
+            record.mPosition[j] = current->mPosition[j];
+            record.mScale[j] = current->mScale[j];
+        }
+        record.mRotation[0] = current->mRotation.w;
+        record.mRotation[1] = current->mRotation.x;
+        record.mRotation[2] = current->mRotation.y;
+        record.mRotation[3] = current->mRotation.z;
+        record.mFlags = current->mIsEnabled ? ENABLED_FLAG : 0;
+        writeData(current, scratch, data, record.mDataOffset, record.mDataSize);
+
+        // breadth-first, so the children follow each other
+        record.mFirstChild = nodes.size();
+        record.mChildCount = current->mChildren.size();
+        for(auto iter = current->mChildren.begin(); iter != current->mChildren.end(); ++iter) {
+            nodes.push_back(iter->second.get());
+        }
+
+        record.mFirstComponent = component_records.size();
+        record.mComponentCount = current->mComponents.size();
+        for(auto iter = current->mComponents.begin(); iter != current->mComponents.end(); ++iter) {
+            Component* component = iter->second.get();
+            QString type(component->metaObject()->className());
+            if(!type_ids.contains(type)) {
+                type_ids.insert(type, types.size());
+                types.push_back(add_string(type));
+            }
+
+            ComponentRecord component_record;
+            memset(&component_record, 0, sizeof(ComponentRecord));
+            writeUuid(component->mId, component_record.mId);
+            component_record.mType = type_ids.value(type);
+            component_record.mName = add_string(component->mName);
+            component_record.mFlags = component->mIsEnabled ? ENABLED_FLAG : 0;
+            writeData(component, scratch, data, component_record.mDataOffset, component_record.mDataSize);
+            component_records.push_back(component_record);
+        }
+
+        node_records.push_back(record);
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.mMagic, MAGIC, 4);
+    header.mVersion = VERSION;
+    header.mHeaderSize = sizeof(Header);
+    header.mByteOrder = BYTE_ORDER_MARK;
+    header.mNodeCount = node_records.size();
+    header.mNodeOffset = sizeof(Header);
+    header.mComponentCount = component_records.size();
+    header.mComponentOffset = header.mNodeOffset + node_records.size() * sizeof(NodeRecord);
+    header.mTypeCount = types.size();
+    header.mTypeOffset = header.mComponentOffset + component_records.size() * sizeof(ComponentRecord);
+    header.mStringCount = strings.size();
+    header.mStringOffset = header.mTypeOffset + types.size() * sizeof(uint32_t);
+    header.mCharsOffset = header.mStringOffset + strings.size() * sizeof(StringEntry);
+    header.mCharsSize = chars.size();
+    header.mDataOffset = header.mCharsOffset + chars.size();
+    header.mDataSize = data.size();
+
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        Logger::get().error("SceneFile: Cannot open " + path + " for writing.");
+        return false;
+    }
+
+    bool is_written = true;
+    auto write = [&](const void* section, std::size_t size) {
+        if(size > 0)
+            is_written = is_written && file.write(static_cast<const char*>(section), size) == static_cast<qint64>(size);
+    };
+    write(&header, sizeof(Header));
+    write(node_records.data(), node_records.size() * sizeof(NodeRecord));
+    write(component_records.data(), component_records.size() * sizeof(ComponentRecord));
+    write(types.data(), types.size() * sizeof(uint32_t));
+    write(strings.data(), strings.size() * sizeof(StringEntry));
+    write(chars.data(), chars.size());
+    write(data.data(), data.size());
+    file.close();
+
+    if(!is_written)
+        Logger::get().error("SceneFile: Cannot write " + path + ".");
+    return is_written;
+}
+
+bool SceneFile::open(const QString& path) {
+    close();
+
+    mFile.setFileName(path);
+    if(!mFile.open(QIODevice::ReadOnly)) {
+        Logger::get().error("SceneFile: Cannot open " + path + ".");
+        return false;
+    }
+    if(mFile.size() < static_cast<qint64>(sizeof(Header)) || mFile.size() > 0xffffffff) {
+        Logger::get().error("SceneFile: " + path + " is not a scene file.");
+        close();
+        return false;
+    }
+
+    mSize = static_cast<uint32_t>(mFile.size());
+    mMapping = reinterpret_cast<const char*>(mFile.map(0, mSize));
+    if(mMapping == nullptr) {
+        Logger::get().error("SceneFile: Cannot map " + path + " into memory.");
+        close();
+        return false;
+    }
+
+    mHeader = reinterpret_cast<const Header*>(mMapping);
+    if(memcmp(mHeader->mMagic, MAGIC, 4) != 0 || mHeader->mHeaderSize != sizeof(Header)) {
+        Logger::get().error("SceneFile: " + path + " is not a scene file.");
+        close();
+        return false;
+    }
+    if(mHeader->mByteOrder != BYTE_ORDER_MARK) {
+        Logger::get().error("SceneFile: " + path + " was written on a machine with another byte order.");
+        close();
+        return false;
+    }
+    if(mHeader->mVersion != VERSION) {
+        Logger::get().error("SceneFile: " + path + " has the unsupported version " + Utils::toString(mHeader->mVersion) + ".");
+        close();
+        return false;
+    }
+    if(!isSectionValid(mHeader->mNodeOffset, mHeader->mNodeCount, sizeof(NodeRecord), mSize)
+       || !isSectionValid(mHeader->mComponentOffset, mHeader->mComponentCount, sizeof(ComponentRecord), mSize)
+       || !isSectionValid(mHeader->mTypeOffset, mHeader->mTypeCount, sizeof(uint32_t), mSize)
+       || !isSectionValid(mHeader->mStringOffset, mHeader->mStringCount, sizeof(StringEntry), mSize)
+       || static_cast<uint64_t>(mHeader->mCharsOffset) + mHeader->mCharsSize > mSize
+       || static_cast<uint64_t>(mHeader->mDataOffset) + mHeader->mDataSize > mSize) {
+        Logger::get().error("SceneFile: " + path + " is truncated or damaged.");
+        close();
+        return false;
+    }
+
+    mNodes = reinterpret_cast<const NodeRecord*>(mMapping + mHeader->mNodeOffset);
+    mComponents = reinterpret_cast<const ComponentRecord*>(mMapping + mHeader->mComponentOffset);
+    mStrings = reinterpret_cast<const StringEntry*>(mMapping + mHeader->mStringOffset);
+
+    // look up each type once instead of once per component
+    const uint32_t* types = reinterpret_cast<const uint32_t*>(mMapping + mHeader->mTypeOffset);
+    mComponentTypes.resize(mHeader->mTypeCount);
+    for(uint32_t i = 0; i < mHeader->mTypeCount; ++i) {
+        QString name = _getString(types[i]);
+        mComponentTypes[i] = Serializer::getComponentType(Utils::toStdString(name));
+        if(mComponentTypes[i] == 0)
+            Logger::get().error("SceneFile: The component type " + name + " is not registered. Its components are skipped.");
+    }
+    return true;
+}
+
+void SceneFile::close() {
+    if(mMapping != nullptr)
+        mFile.unmap(reinterpret_cast<uchar*>(const_cast<char*>(mMapping)));
+    mFile.close();
+
+    mMapping = nullptr;
+    mSize = 0;
+    mHeader = nullptr;
+    mNodes = nullptr;
+    mComponents = nullptr;
+    mStrings = nullptr;
+    mComponentTypes.clear();
+    for(auto iter = mPending.begin(); iter != mPending.end(); ++iter) {
+        QObject::disconnect(iter->first, SIGNAL(destroyed(QObject*)), this, SLOT(_onNodeDestroyed(QObject*)));
+    }
+    mPending.clear();
+}
+
+bool SceneFile::isOpen() const {
+    return mMapping != nullptr;
+}
+
+uint32_t SceneFile::getNodeCount() const {
+    return isOpen() ? mHeader->mNodeCount : 0;
+}
+
+uint32_t SceneFile::getComponentCount() const {
+    return isOpen() ? mHeader->mComponentCount : 0;
+}
+
+uint32_t SceneFile::findRecord(const QString& name) const {
+    if(!isOpen())
+        return NO_RECORD;
+
+    // compare the string indices instead of the names
+    QByteArray utf8 = name.toUtf8();
+    const char* chars = mMapping + mHeader->mCharsOffset;
+    for(uint32_t id = 0; id < mHeader->mStringCount; ++id) {
+        const StringEntry& entry = mStrings[id];
+        if(entry.mSize != static_cast<uint32_t>(utf8.size())
+           || static_cast<uint64_t>(entry.mOffset) + entry.mSize > mHeader->mCharsSize
+           || memcmp(chars + entry.mOffset, utf8.constData(), entry.mSize) != 0)
+            continue;
+
+        for(uint32_t i = 0; i < mHeader->mNodeCount; ++i) {
+            if(mNodes[i].mName == id)
+                return i;
+        }
+        return NO_RECORD;
+    }
+    return NO_RECORD;
+}
+
+Node* SceneFile::load(uint32_t record, uint32_t depth) {
+    if(!isOpen() || record >= mHeader->mNodeCount)
+        return nullptr;
+    return _createNode(record, depth);
+}
+
+bool SceneFile::expand(Node* node, uint32_t depth) {
+    auto iter = mPending.find(node);
+    if(!isOpen() || iter == mPending.end() || depth == 0)
+        return false;
+
+    uint32_t index = iter->second;
+    mPending.erase(iter);
+    QObject::disconnect(node, SIGNAL(destroyed(QObject*)), this, SLOT(_onNodeDestroyed(QObject*)));
+    _createChildren(node, index, depth - 1);
+    return true;
+}
+
+bool SceneFile::hasPendingChildren(Node* node) const {
+    return mPending.find(node) != mPending.end();
+}
+
+void SceneFile::_onNodeDestroyed(QObject* object) {
+    mPending.erase(static_cast<Node*>(object));
+}
+
+Node* SceneFile::_createNode(uint32_t index, uint32_t depth) {
+    const NodeRecord& record = mNodes[index];
+
+    Node* node = new Node(_getString(record.mName));
+    node->mId = readUuid(record.mId);
+    node->mPosition = Ogre::Vector3(record.mPosition[0], record.mPosition[1], record.mPosition[2]);
+    node->mScale = Ogre::Vector3(record.mScale[0], record.mScale[1], record.mScale[2]);
+    node->mRotation = Ogre::Quaternion(record.mRotation[0], record.mRotation[1], record.mRotation[2], record.mRotation[3]);
+    node->mIsEnabled = (record.mFlags & ENABLED_FLAG) != 0;
+
+    const char* data = _getData(record.mDataOffset, record.mDataSize);
+    if(data != nullptr) {
+        BitStream stream(data, record.mDataSize);
+        IOPacket packet(&stream);
+        node->onSerialize(packet);
+    }
+
+    if(static_cast<uint64_t>(record.mFirstComponent) + record.mComponentCount > mHeader->mComponentCount) {
+        Logger::get().error("SceneFile: The components of the node " + node->getName() + " are damaged.");
+    } else {
+        for(uint32_t i = record.mFirstComponent; i < record.mFirstComponent + record.mComponentCount; ++i) {
+            const ComponentRecord& component_record = mComponents[i];
+            int type = component_record.mType < mComponentTypes.size() ? mComponentTypes[component_record.mType] : 0;
+            std::shared_ptr<Component> component = Serializer::createComponent(type);
+            if(component == nullptr)
+                continue;
+
+            component->mId = readUuid(component_record.mId);
+            component->mName = _getString(component_record.mName);
+            component->mIsEnabled = (component_record.mFlags & ENABLED_FLAG) != 0;
+
+            data = _getData(component_record.mDataOffset, component_record.mDataSize);
+            if(data != nullptr) {
+                BitStream stream(data, component_record.mDataSize);
+                IOPacket packet(&stream);
+                component->onSerialize(packet);
+            }
+            node->addComponent(component);
+        }
+    }
+
+    if(record.mChildCount > 0) {
+        if(depth == 0) {
+            // another node might be created at the same address once this one is deleted
+            mPending[node] = index;
+            QObject::connect(node, SIGNAL(destroyed(QObject*)), this, SLOT(_onNodeDestroyed(QObject*)));
+        } else
+            _createChildren(node, index, depth - 1);
+    }
+    return node;
+}
+
+void SceneFile::_createChildren(Node* node, uint32_t index, uint32_t depth) {
+    const NodeRecord& record = mNodes[index];
+    // children always come after their parent, which also rules out cycles
+    if(record.mFirstChild <= index || static_cast<uint64_t>(record.mFirstChild) + record.mChildCount > mHeader->mNodeCount) {
+        Logger::get().error("SceneFile: The children of the node " + node->getName() + " are damaged.");
+        return;
+    }
+
+    for(uint32_t i = record.mFirstChild; i < record.mFirstChild + record.mChildCount; ++i) {
+        node->addChildNode(_createNode(i, depth));
+    }
+}
+
+QString SceneFile::_getString(uint32_t id) const {
+    if(id >= mHeader->mStringCount)
+        return "";
+
+    const StringEntry& entry = mStrings[id];
+    if(static_cast<uint64_t>(entry.mOffset) + entry.mSize > mHeader->mCharsSize)
+        return "";
+    return QString::fromUtf8(mMapping + mHeader->mCharsOffset + entry.mOffset, entry.mSize);
+}
+
+const char* SceneFile::_getData(uint32_t offset, uint32_t size) const {
+    if(size == 0 || static_cast<uint64_t>(offset) + size > mHeader->mDataSize)
+        return nullptr;
+    return mMapping + mHeader->mDataOffset + offset;
+}
+
+} // namespace dt
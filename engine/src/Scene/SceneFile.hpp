@@ -0,0 +1,206 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_SCENE_SCENEFILE
+#define DUCTTAPE_ENGINE_SCENE_SCENEFILE
+
+#include <Config.hpp>
+
+#include <QFile>
+#include <QObject>
+#include <QString>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace dt {
+
+class Node;
+
+/**
+  * A binary file holding a tree of nodes and their components. It starts with a versioned header, followed
+  * by fixed-size records for all nodes and components, a table of the component types, a table of all names
+  * and type names, each stored once, and the data the nodes and components write in onSerialize(), bit-packed.
+  * Nodes are stored breadth-first, so the children of a node are consecutive records.
+  * The file is mapped into memory when opened, and nothing is read until nodes are loaded. Loading may stop
+  * at a given depth; the children of the deepest nodes are created later by expand(), e.g. when the player
+  * gets close to them. The records are read in place, so the file has the byte order of the machine that
+  * wrote it (little-endian on all supported platforms) and is rejected on others.
+  * @code
+  * SceneFile::save(level, "level.dts");
+  *
+  * SceneFile file;
+  * if(file.open("level.dts")) {
+  *     Node* level = file.load(0, 1);     // the level and its direct children
+  *     scene->addChildNode(level);
+  *     ...
+  *     file.expand(level->findChildNode("Castle").get());
+  * }
+  * @endcode
+  * @see Node::serialize
+  */
+class DUCTTAPE_API SceneFile : public QObject {
+    Q_OBJECT
+    Q_DISABLE_COPY(SceneFile)
+
+public:
+    /**
+      * The version of the format written by save().
+      */
+    static const uint16_t VERSION = 1;
+
+    /**
+      * Returned instead of a record index if there is none.
+      */
+    static const uint32_t NO_RECORD = 0xffffffff;
+
+    /**
+      * Passed as depth to create all levels of children.
+      */
+    static const uint32_t ALL_LEVELS = 0xffffffff;
+
+    /**
+      * Default constructor.
+      */
+    SceneFile();
+
+    /**
+      * Destructor. Closes the file.
+      */
+    ~SceneFile();
+
+    /**
+      * Writes a node with all its components and children to a file.
+      * @param node The node.
+      * @param path The path of the file.
+      * @returns False if the file could not be written.
+      */
+    static bool save(Node* node, const QString& path);
+
+    /**
+      * Maps a file into memory and checks its header.
+      * @param path The path of the file.
+      * @returns False if the file could not be opened or is not a scene file of a supported version.
+      */
+    bool open(const QString& path);
+
+    /**
+      * Unmaps the file. Nodes loaded from it stay valid, but cannot be expanded any more.
+      */
+    void close();
+
+    /**
+      * Returns whether a file is open.
+      * @returns True if a file is open.
+      */
+    bool isOpen() const;
+
+    /**
+      * Returns the number of nodes in the file.
+      * @returns The number of node records.
+      */
+    uint32_t getNodeCount() const;
+
+    /**
+      * Returns the number of components in the file.
+      * @returns The number of component records.
+      */
+    uint32_t getComponentCount() const;
+
+    /**
+      * Finds the record of a node by its name, without creating any node.
+      * @param name The name of the node.
+      * @returns The index of the first node record with that name, or NO_RECORD.
+      */
+    uint32_t findRecord(const QString& name) const;
+
+    /**
+      * Creates the node of a record with its components, and its children down to a depth. The first record
+      * holds the node save() was called with.
+      * @param record The index of the record.
+      * @param depth The number of levels of children to create. The children of the nodes at the last
+      * level are left for expand().
+      * @returns The node, owned by the caller, e.g. by adding it to a parent. nullptr if the record does not
+      * exist. Damaged components and children are skipped with an error.
+      */
+    Node* load(uint32_t record = 0, uint32_t depth = ALL_LEVELS);
+
+    /**
+      * Creates the children of a node that was loaded without them.
+      * @param node The node. It has to be a node loaded from this file.
+      * @param depth The number of levels of children to create.
+      * @returns False if the children of the node have already been created or the file is closed.
+      */
+    bool expand(Node* node, uint32_t depth = 1);
+
+    /**
+      * Returns whether the children of a node have not been created yet.
+      * @param node The node.
+      * @returns True if the node has children left for expand().
+      */
+    bool hasPendingChildren(Node* node) const;
+
+private slots:
+    /**
+      * Forgets the pending children of a node that has been destroyed.
+      * @param object The node.
+      */
+    void _onNodeDestroyed(QObject* object);
+
+private:
+    struct Header;
+    struct NodeRecord;
+    struct ComponentRecord;
+    struct StringEntry;
+
+    /**
+      * Private method. Creates the node of a record.
+      * @param index The index of the record.
+      * @param depth The number of levels of children to create.
+      * @returns The node.
+      */
+    Node* _createNode(uint32_t index, uint32_t depth);
+
+    /**
+      * Private method. Creates the children of the node of a record.
+      * @param node The node.
+      * @param index The index of the record of the node.
+      * @param depth The number of levels of children to create below the children.
+      */
+    void _createChildren(Node* node, uint32_t index, uint32_t depth);
+
+    /**
+      * Private method. Returns a string from the string table.
+      * @param id The index of the string.
+      * @returns The string, or an empty one if the index is invalid.
+      */
+    QString _getString(uint32_t id) const;
+
+    /**
+      * Private method. Returns a block of the onSerialize() data.
+      * @param offset The offset in the data section.
+      * @param size The size of the block.
+      * @returns The block, or nullptr if it is not within the data section.
+      */
+    const char* _getData(uint32_t offset, uint32_t size) const;
+
+    QFile mFile;                                        //!< The open file.
+    const char* mMapping;                               //!< The file mapped into memory, or nullptr.
+    uint32_t mSize;                                     //!< The size of the file.
+    const Header* mHeader;                              //!< The header, at the start of the mapping.
+    const NodeRecord* mNodes;                           //!< The node records.
+    const ComponentRecord* mComponents;                 //!< The component records.
+    const StringEntry* mStrings;                        //!< The string table.
+    std::vector<int> mComponentTypes;                   //!< The Serializer types of the component types, 0 if unknown.
+    std::unordered_map<Node*, uint32_t> mPending;       //!< The records of the loaded nodes whose children have not been created.
+};
+
+} // namespace dt
+
+#endif
@@ -35,39 +35,44 @@
 namespace dt {
 
 void Serializer::initialize() {
-    // TODO: add OnSerialize functions to these other components
     registerComponent<SoundComponent>("dt::SoundComponent");
     registerComponent<MusicComponent>("dt::MusicComponent");
-    //RegisterComponent<BillboardSetComponent>("dt::BillboardSetComponent");
+    registerComponent<BillboardSetComponent>("dt::BillboardSetComponent");
     registerComponent<CameraComponent>("dt::CameraComponent");
     registerComponent<LightComponent>("dt::LightComponent");
     registerComponent<MeshComponent>("dt::MeshComponent");
-    //RegisterComponent<ParticleSystemComponent>("dt::ParticleSystemComponent");
-    //RegisterComponent<TextComponent>("dt::TextComponent");
+    registerComponent<ParticleSystemComponent>("dt::ParticleSystemComponent");
+    registerComponent<TextComponent>("dt::TextComponent");
     registerComponent<TriggerComponent>("dt::TriggerComponent");
-    //RegisterComponent<AdvancedPlayerComponent>("dt::AdvancedPlayerComponent");
-    //RegisterComponent<CollisionComponent>("dt::CollisionComponent");
-    //RegisterComponent<FollowPathComponent>("dt::FollowPathComponent");
-    //RegisterComponent<InteractionComponent>("dt::InteractionComponent");
-    //RegisterComponent<RaycastComponent>("dt::RaycastComponent");
-    //RegisterComponent<ScriptComponent>("dt::ScriptComponent");
-    //RegisterComponent<SimplePlayerComponent>("dt::SimplePlayerComponent");
-    //RegisterComponent<PhysicsBodyComponent>("dt::PhysicsBodyComponent");
+    registerComponent<AdvancedPlayerComponent>("dt::AdvancedPlayerComponent");
+    registerComponent<CollisionComponent>("dt::CollisionComponent");
+    registerComponent<FollowPathComponent>("dt::FollowPathComponent");
+    registerComponent<RaycastComponent>("dt::RaycastComponent");
+    registerComponent<ScriptComponent>("dt::ScriptComponent");
+    registerComponent<SimplePlayerComponent>("dt::SimplePlayerComponent");
+    registerComponent<PhysicsBodyComponent>("dt::PhysicsBodyComponent");
+    // InteractionComponent is abstract, and TriggerAreaComponent cannot be created without its collision shape
 }
 
 void Serializer::deinitialize() {
+    getComponentFactory().clear();
+}
+
+ComponentFactory& Serializer::getComponentFactory() {
+    static ComponentFactory factory;
+    return factory;
+}
+
+std::shared_ptr<Component> Serializer::createComponent(const std::string& name) {
+    return getComponentFactory().create(name);
+}
 
+int Serializer::getComponentType(const std::string& name) {
+    return getComponentFactory().getType(name);
 }
 
-Component* Serializer::createComponent(const std::string& name) {
-    int id = QMetaType::type(name.c_str());
-    Logger::get().debug("Component type ID: " + QString::number(id));
-    if(id == 0) {
-        Logger::get().error("Invalid component type: " + Utils::toString(name) + ". Did you forget to declare it? Watch out for namespaces!");
-        exit(1);
-    }
-    Component* component = static_cast<Component*>(QMetaType::construct(id));
-    return component;
+std::shared_ptr<Component> Serializer::createComponent(int type) {
+    return getComponentFactory().create(type);
 }
 
 }
@@ -12,10 +12,13 @@
 #include <Config.hpp>
 
 #include <Scene/Component.hpp>
+#include <Scene/ComponentFactory.hpp>
 #include <Utils/Logger.hpp>
 #include <Utils/Utils.hpp>
 
-#include <QMetaType>
+#include <memory>
+#include <string>
+
 /**
   * Macro definition for simple creation of "fake copy-constructor".
   * @param class_name The name of the current class
@@ -52,12 +55,53 @@ public:
       */
     static void deinitialize();
 
+    /**
+      * Registers a component class, so nodes can create its components when they are deserialized.
+      * @param name The name of the class, including the namespace.
+      * @returns The type of the class.
+      */
+    template <typename T>
+    static int registerComponent(const std::string& name) {
+        return getComponentFactory().registerComponent<T>(name);
+    }
+
+    /**
+      * Registers a component class whose components are constructed in memory from a pool.
+      * @param name The name of the class, including the namespace.
+      * @param max_size The maximum number of blocks of memory the pool keeps.
+      * @returns The pool.
+      */
     template <typename T>
-    static void registerComponent(const std::string& name) {
-        qRegisterMetaType<T>(name.c_str());
+    static std::shared_ptr<ComponentPool<T> > registerPooledComponent(const std::string& name, uint32_t max_size = 64) {
+        return getComponentFactory().registerPooledComponent<T>(name, max_size);
     }
 
-    static Component* createComponent(const std::string& name);
+    /**
+      * Returns the factory creating the components of the registered classes.
+      * @returns The factory.
+      */
+    static ComponentFactory& getComponentFactory();
+
+    /**
+      * Creates a component of a registered class. An unknown class is reported as an error.
+      * @param name The name of the class, including the namespace.
+      * @returns The component, or nullptr if no class of that name is registered.
+      */
+    static std::shared_ptr<Component> createComponent(const std::string& name);
+
+    /**
+      * Looks up the type of a registered component class, to create many components of it by createComponent(int).
+      * @param name The name of the class, including the namespace.
+      * @returns The type, or 0 if no class of that name is registered.
+      */
+    static int getComponentType(const std::string& name);
+
+    /**
+      * Creates a component of a type returned by getComponentType().
+      * @param type The type.
+      * @returns The component, or nullptr if the type does not exist.
+      */
+    static std::shared_ptr<Component> createComponent(int type);
 
     static void serializeNode(Node* node);
 
@@ -0,0 +1,422 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Scene/SpatialIndex.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace dt {
+
+SpatialIndex::SpatialIndex(float cell_size)
+    : mCellSize(cell_size),
+      mInverseCellSize(1.f / cell_size),
+      mMaxRadius(0.f),
+      mCellEntryCount(0),
+      mMinX(0),
+      mMaxX(-1),
+      mMinZ(0),
+      mMaxZ(-1),
+      mBoundsChanged(false),
+      mNodeCount(0),
+      mVisitedCount(0) {}
+
+SpatialIndex::~SpatialIndex() {
+    // the nodes may outlive us, make sure they do not call back
+    for(auto iter = mEntries.begin(); iter != mEntries.end(); ++iter) {
+        if(iter->mNode != nullptr) {
+            iter->mNode->mSpatialIndex = nullptr;
+            iter->mNode->_addIndexedNodeCount(-1);
+        }
+    }
+}
+
+void SpatialIndex::addNode(Node* node, float radius) {
+    if(node->mSpatialIndex == this) {
+        setNodeRadius(node, radius);
+        return;
+    } else if(node->mSpatialIndex != nullptr) {
+        node->mSpatialIndex->removeNode(node);
+    }
+
+    uint32_t id;
+    if(!mFreeEntries.empty()) {
+        id = mFreeEntries.back();
+        mFreeEntries.pop_back();
+    } else {
+        id = mEntries.size();
+        mEntries.push_back(Entry());
+    }
+
+    Entry& entry = mEntries[id];
+    entry.mNode = node;
+    entry.mPosition = node->getPosition(Node::SCENE);
+    entry.mRadius = radius;
+    _insertIntoCell(id);
+
+    node->mSpatialIndex = this;
+    node->mSpatialIndexEntry = id;
+    node->_addIndexedNodeCount(1);
+
+    ++mNodeCount;
+}
+
+void SpatialIndex::removeNode(Node* node) {
+    if(node->mSpatialIndex != this)
+        return;
+
+    uint32_t id = node->mSpatialIndexEntry;
+    _removeFromCell(id);
+    mEntries[id].mNode = nullptr;
+    mFreeEntries.push_back(id);
+
+    node->mSpatialIndex = nullptr;
+    node->_addIndexedNodeCount(-1);
+    --mNodeCount;
+}
+
+void SpatialIndex::updateNode(Node* node) {
+    if(node->mSpatialIndex != this)
+        return;
+
+    uint32_t id = node->mSpatialIndexEntry;
+    Entry& entry = mEntries[id];
+    Ogre::Vector3 position = node->getPosition(Node::SCENE);
+
+    if(entry.mIsLarge || _cellKey(_cellCoordinate(position.x), _cellCoordinate(position.z)) == entry.mCell) {
+        // still in the same cell, nothing to move around
+        entry.mPosition = position;
+    } else {
+        _removeFromCell(id);
+        entry.mPosition = position;
+        _insertIntoCell(id);
+    }
+}
+
+void SpatialIndex::setNodeRadius(Node* node, float radius) {
+    if(node->mSpatialIndex != this)
+        return;
+
+    // the entry might have to move between the grid and the large entries
+    uint32_t id = node->mSpatialIndexEntry;
+    _removeFromCell(id);
+    mEntries[id].mRadius = radius;
+    _insertIntoCell(id);
+}
+
+uint32_t SpatialIndex::getNodeCount() const {
+    return mNodeCount;
+}
+
+float SpatialIndex::getCellSize() const {
+    return mCellSize;
+}
+
+uint32_t SpatialIndex::getVisitedCount() const {
+    return mVisitedCount;
+}
+
+template <typename Visitor>
+void SpatialIndex::_visitCells(int32_t min_x, int32_t max_x, int32_t min_z, int32_t max_z, Visitor visit) const {
+    if(min_x > max_x || min_z > max_z)
+        return;
+
+    uint64_t area = static_cast<uint64_t>(static_cast<int64_t>(max_x) - min_x + 1)
+        * static_cast<uint64_t>(static_cast<int64_t>(max_z) - min_z + 1);
+
+    if(area > mCells.size()) {
+        for(auto iter = mCells.begin(); iter != mCells.end(); ++iter) {
+            int32_t x = static_cast<int32_t>(iter->first >> 32);
+            int32_t z = static_cast<int32_t>(static_cast<uint32_t>(iter->first));
+            if(x >= min_x && x <= max_x && z >= min_z && z <= max_z)
+                visit(iter->second);
+        }
+    } else {
+        for(int32_t x = min_x; x <= max_x; ++x) {
+            for(int32_t z = min_z; z <= max_z; ++z) {
+                auto cell = mCells.find(_cellKey(x, z));
+                if(cell != mCells.end())
+                    visit(cell->second);
+            }
+        }
+    }
+}
+
+void SpatialIndex::queryRadius(const Ogre::Vector3& center, float radius, std::vector<Node*>& result, Filter filter) const {
+    mVisitedCount = 0;
+    if(mNodeCount == 0)
+        return;
+
+    auto test = [&](uint32_t id) {
+        ++mVisitedCount;
+        const Entry& entry = mEntries[id];
+        float distance = radius + entry.mRadius;
+        if(entry.mPosition.squaredDistance(center) <= distance * distance && _accept(entry, filter)) {
+            result.push_back(entry.mNode);
+        }
+    };
+
+    _updateBounds();
+    float reach = radius + mMaxRadius;
+    _visitCells(std::max(mMinX, _cellCoordinate(center.x - reach)), std::min(mMaxX, _cellCoordinate(center.x + reach)),
+                std::max(mMinZ, _cellCoordinate(center.z - reach)), std::min(mMaxZ, _cellCoordinate(center.z + reach)),
+                [&](const Cell& cell) {
+        std::for_each(cell.begin(), cell.end(), test);
+    });
+    std::for_each(mLargeEntries.begin(), mLargeEntries.end(), test);
+}
+
+void SpatialIndex::queryBox(const Ogre::AxisAlignedBox& box, std::vector<Node*>& result, Filter filter) const {
+    mVisitedCount = 0;
+    if(mNodeCount == 0 || box.isNull())
+        return;
+
+    auto test = [&](uint32_t id) {
+        ++mVisitedCount;
+        const Entry& entry = mEntries[id];
+        bool inside = box.isInfinite()
+            || box.squaredDistance(entry.mPosition) <= entry.mRadius * entry.mRadius;
+        if(inside && _accept(entry, filter)) {
+            result.push_back(entry.mNode);
+        }
+    };
+
+    _updateBounds();
+    int32_t min_x = mMinX;
+    int32_t max_x = mMaxX;
+    int32_t min_z = mMinZ;
+    int32_t max_z = mMaxZ;
+    if(box.isFinite()) {
+        min_x = std::max(min_x, _cellCoordinate(box.getMinimum().x - mMaxRadius));
+        max_x = std::min(max_x, _cellCoordinate(box.getMaximum().x + mMaxRadius));
+        min_z = std::max(min_z, _cellCoordinate(box.getMinimum().z - mMaxRadius));
+        max_z = std::min(max_z, _cellCoordinate(box.getMaximum().z + mMaxRadius));
+    }
+
+    _visitCells(min_x, max_x, min_z, max_z, [&](const Cell& cell) {
+        std::for_each(cell.begin(), cell.end(), test);
+    });
+    std::for_each(mLargeEntries.begin(), mLargeEntries.end(), test);
+}
+
+void SpatialIndex::queryNearest(const Ogre::Vector3& center, uint32_t count, std::vector<Node*>& result, Filter filter,
+                                float max_distance) const {
+    mVisitedCount = 0;
+    if(mNodeCount == 0 || count == 0)
+        return;
+
+    // max-heap of the best candidates so far, the worst one on top
+    std::vector<std::pair<float, Node*> > best;
+    best.reserve(std::min(count, mNodeCount));
+    float max_squared = max_distance * max_distance;
+
+    auto test = [&](uint32_t id) {
+        ++mVisitedCount;
+        const Entry& entry = mEntries[id];
+        float squared = entry.mPosition.squaredDistance(center);
+        if(squared > max_squared)
+            return;
+
+        if(best.size() < count) {
+            if(_accept(entry, filter)) {
+                best.push_back(std::make_pair(squared, entry.mNode));
+                std::push_heap(best.begin(), best.end());
+            }
+        } else if(squared < best.front().first && _accept(entry, filter)) {
+            std::pop_heap(best.begin(), best.end());
+            best.back() = std::make_pair(squared, entry.mNode);
+            std::push_heap(best.begin(), best.end());
+        }
+    };
+    auto test_cell = [&](const Cell& cell) {
+        std::for_each(cell.begin(), cell.end(), test);
+    };
+
+    std::for_each(mLargeEntries.begin(), mLargeEntries.end(), test);
+
+    _updateBounds();
+    if(mCellEntryCount > 0) {
+        int64_t center_x = _cellCoordinate(center.x);
+        int64_t center_z = _cellCoordinate(center.z);
+        int64_t max_ring = std::max(std::max(center_x - mMinX, mMaxX - center_x),
+                                    std::max(center_z - mMinZ, mMaxZ - center_z));
+        // no ring beyond max_distance can hold a result
+        if(max_distance * mInverseCellSize + 1.f < static_cast<float>(max_ring))
+            max_ring = static_cast<int64_t>(max_distance * mInverseCellSize) + 1;
+        // skip the empty rings between the query point and the occupied area
+        int64_t first_ring = std::max<int64_t>(0, std::max(std::max(mMinX - center_x, center_x - mMaxX),
+                                                           std::max(mMinZ - center_z, center_z - mMaxZ)));
+
+        // no cell in a ring can be closer than (ring - 1) cells
+        auto is_done = [&](int64_t ring) {
+            float ring_distance = (ring - 1) * mCellSize;
+            return ring_distance > max_distance
+                || (ring > 0 && best.size() == count && best.front().first <= ring_distance * ring_distance);
+        };
+
+        int64_t ring = first_ring;
+        for(; ring <= max_ring && !is_done(ring); ++ring) {
+            // the rings grow, once one holds more cells than are occupied the occupied ones are looked at instead
+            if(static_cast<uint64_t>(std::max<int64_t>(1, ring * 8)) > mCells.size())
+                break;
+
+            // walk the border of the ring: top and bottom rows, then the left and right columns in between
+            for(int64_t i = -ring; i <= ring; ++i) {
+                for(int32_t side = 0; side < 4; ++side) {
+                    int64_t x, z;
+                    if(side == 0) {
+                        x = center_x + i; z = center_z - ring;
+                    } else if(side == 1) {
+                        if(ring == 0) continue;
+                        x = center_x + i; z = center_z + ring;
+                    } else if(side == 2) {
+                        if(i == -ring || i == ring) continue;
+                        x = center_x - ring; z = center_z + i;
+                    } else {
+                        if(i == -ring || i == ring) continue;
+                        x = center_x + ring; z = center_z + i;
+                    }
+
+                    if(x < mMinX || x > mMaxX || z < mMinZ || z > mMaxZ)
+                        continue;
+
+                    auto cell = mCells.find(_cellKey(x, z));
+                    if(cell != mCells.end())
+                        test_cell(cell->second);
+                }
+            }
+        }
+
+        if(ring <= max_ring && !is_done(ring)) {
+            // sort the occupied cells of the remaining rings by their ring, so the early-out still applies
+            std::vector<std::pair<int64_t, const Cell*> > cells;
+            for(auto iter = mCells.begin(); iter != mCells.end(); ++iter) {
+                int64_t x = static_cast<int32_t>(iter->first >> 32);
+                int64_t z = static_cast<int32_t>(static_cast<uint32_t>(iter->first));
+                int64_t cell_ring = std::max(std::abs(x - center_x), std::abs(z - center_z));
+                if(cell_ring >= ring && cell_ring <= max_ring && !iter->second.empty())
+                    cells.push_back(std::make_pair(cell_ring, &iter->second));
+            }
+            std::sort(cells.begin(), cells.end(), [](const std::pair<int64_t, const Cell*>& a,
+                                                     const std::pair<int64_t, const Cell*>& b) {
+                return a.first < b.first;
+            });
+
+            for(auto iter = cells.begin(); iter != cells.end() && !is_done(iter->first); ++iter) {
+                test_cell(*iter->second);
+            }
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end());
+    for(auto iter = best.begin(); iter != best.end(); ++iter) {
+        result.push_back(iter->second);
+    }
+}
+
+int64_t SpatialIndex::_cellKey(int32_t x, int32_t z) {
+    return (static_cast<int64_t>(x) << 32) | static_cast<uint32_t>(z);
+}
+
+int32_t SpatialIndex::_cellCoordinate(float value) const {
+    // clamp, so far away positions and infinite query ranges do not overflow
+    float cell = std::floor(value * mInverseCellSize);
+    if(cell < -1e9f)
+        return -1000000000;
+    if(cell > 1e9f)
+        return 1000000000;
+    return static_cast<int32_t>(cell);
+}
+
+void SpatialIndex::_insertIntoCell(uint32_t id) {
+    Entry& entry = mEntries[id];
+    entry.mIsLarge = entry.mRadius > mCellSize;
+    if(entry.mIsLarge) {
+        // it would loosen every query by its radius, test it directly instead
+        entry.mSlot = mLargeEntries.size();
+        mLargeEntries.push_back(id);
+        return;
+    }
+
+    int32_t x = _cellCoordinate(entry.mPosition.x);
+    int32_t z = _cellCoordinate(entry.mPosition.z);
+
+    if(mCellEntryCount == 0) {
+        mMinX = mMaxX = x;
+        mMinZ = mMaxZ = z;
+        mBoundsChanged = false;
+    } else {
+        mMinX = std::min(mMinX, x);
+        mMaxX = std::max(mMaxX, x);
+        mMinZ = std::min(mMinZ, z);
+        mMaxZ = std::max(mMaxZ, z);
+    }
+
+    Cell& cell = mCells[_cellKey(x, z)];
+    entry.mCell = _cellKey(x, z);
+    entry.mSlot = cell.size();
+    cell.push_back(id);
+
+    mMaxRadius = std::max(mMaxRadius, entry.mRadius);
+    ++mCellEntryCount;
+}
+
+void SpatialIndex::_removeFromCell(uint32_t id) {
+    Entry& entry = mEntries[id];
+    Cell& cell = entry.mIsLarge ? mLargeEntries : mCells[entry.mCell];
+
+    // swap with the last entry of the cell
+    uint32_t last = cell.back();
+    cell[entry.mSlot] = last;
+    mEntries[last].mSlot = entry.mSlot;
+    cell.pop_back();
+
+    if(!entry.mIsLarge) {
+        --mCellEntryCount;
+
+        int32_t x = static_cast<int32_t>(entry.mCell >> 32);
+        int32_t z = static_cast<int32_t>(static_cast<uint32_t>(entry.mCell));
+        if(cell.empty() && (x == mMinX || x == mMaxX || z == mMinZ || z == mMaxZ))
+            mBoundsChanged = true;
+    }
+}
+
+void SpatialIndex::_updateBounds() const {
+    if(!mBoundsChanged)
+        return;
+
+    mBoundsChanged = false;
+    mMinX = mMinZ = 0;
+    mMaxX = mMaxZ = -1;
+
+    bool first = true;
+    for(auto iter = mCells.begin(); iter != mCells.end(); ++iter) {
+        if(iter->second.empty())
+            continue;
+
+        int32_t x = static_cast<int32_t>(iter->first >> 32);
+        int32_t z = static_cast<int32_t>(static_cast<uint32_t>(iter->first));
+        if(first) {
+            mMinX = mMaxX = x;
+            mMinZ = mMaxZ = z;
+            first = false;
+        } else {
+            mMinX = std::min(mMinX, x);
+            mMaxX = std::max(mMaxX, x);
+            mMinZ = std::min(mMinZ, z);
+            mMaxZ = std::max(mMaxZ, z);
+        }
+    }
+}
+
+bool SpatialIndex::_accept(const Entry& entry, Filter filter) {
+    return filter == nullptr || filter(entry.mNode);
+}
+
+} // namespace dt
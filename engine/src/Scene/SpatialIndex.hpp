@@ -0,0 +1,230 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_SCENE_SPATIALINDEX
+#define DUCTTAPE_ENGINE_SCENE_SPATIALINDEX
+
+#include <Config.hpp>
+
+#include <Scene/Node.hpp>
+
+#include <OgreAxisAlignedBox.h>
+#include <OgreVector3.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace dt {
+
+/**
+  * A loose uniform grid over the XZ plane for proximity queries on nodes, independent of physics.
+  * Nodes are bucketed by their scene position and carry an optional bounding radius; queries expand
+  * their search area by the largest radius in the grid, so nodes never have to be stored in more
+  * than one cell. Nodes with a radius larger than a cell are kept in a list of their own and tested
+  * by every query instead. Registered nodes update their entry themselves whenever they (or one of
+  * their parents) move.
+  * @code
+  * scene->getSpatialIndex()->addNode(unit.get(), 1.5f);
+  * std::vector<dt::Node*> result;
+  * scene->getSpatialIndex()->queryRadius(position, 20.f, result,
+  *                                       dt::SpatialIndex::componentFilter<MineComponent>());
+  * @endcode
+  * @see Scene::getSpatialIndex();
+  */
+class DUCTTAPE_API SpatialIndex {
+public:
+    /**
+      * Predicate for filtering query results. Return true to accept a node.
+      */
+    typedef bool (*Filter)(Node* node);
+
+    /**
+      * Advanced constructor.
+      * @param cell_size The edge length of a grid cell. Should be about the size of a typical query radius.
+      */
+    SpatialIndex(float cell_size = 10.f);
+
+    /**
+      * Destructor. Unregisters all remaining nodes.
+      */
+    ~SpatialIndex();
+
+    /**
+      * Adds a node to the index. Adding a node that is already part of an index moves it to this one.
+      * @param node The node to add.
+      * @param radius The bounding radius of the node.
+      */
+    void addNode(Node* node, float radius = 0.f);
+
+    /**
+      * Removes a node from the index.
+      * @param node The node to remove.
+      */
+    void removeNode(Node* node);
+
+    /**
+      * Re-reads the scene position of a node. This is called by the node itself when it moves.
+      * @param node The node to update.
+      */
+    void updateNode(Node* node);
+
+    /**
+      * Sets the bounding radius of a node.
+      * @param node The node.
+      * @param radius The new bounding radius.
+      */
+    void setNodeRadius(Node* node, float radius);
+
+    /**
+      * Returns the number of nodes in the index.
+      * @returns The number of nodes in the index.
+      */
+    uint32_t getNodeCount() const;
+
+    /**
+      * Returns the edge length of a grid cell.
+      * @returns The edge length of a grid cell.
+      */
+    float getCellSize() const;
+
+    /**
+      * Returns the number of nodes the last query had to test, to check that queries stay local.
+      * @returns The number of nodes tested by the last query.
+      */
+    uint32_t getVisitedCount() const;
+
+    /**
+      * Finds all nodes whose bounding sphere intersects a sphere.
+      * @param center The center of the sphere, in scene coordinates.
+      * @param radius The radius of the sphere.
+      * @param result The list the nodes found are appended to.
+      * @param filter An optional predicate the nodes have to satisfy.
+      */
+    void queryRadius(const Ogre::Vector3& center, float radius, std::vector<Node*>& result, Filter filter = nullptr) const;
+
+    /**
+      * Finds all nodes whose bounding sphere intersects a box.
+      * @param box The box, in scene coordinates.
+      * @param result The list the nodes found are appended to.
+      * @param filter An optional predicate the nodes have to satisfy.
+      */
+    void queryBox(const Ogre::AxisAlignedBox& box, std::vector<Node*>& result, Filter filter = nullptr) const;
+
+    /**
+      * Finds the nodes closest to a point, sorted by distance.
+      * @param center The point, in scene coordinates.
+      * @param count The maximum number of nodes to return.
+      * @param result The list the nodes found are appended to.
+      * @param filter An optional predicate the nodes have to satisfy.
+      * @param max_distance Nodes farther away than this are ignored.
+      */
+    void queryNearest(const Ogre::Vector3& center, uint32_t count, std::vector<Node*>& result, Filter filter = nullptr,
+                      float max_distance = std::numeric_limits<float>::max()) const;
+
+    /**
+      * Returns a filter accepting only nodes having a component of the given type.
+      * @returns A filter accepting only nodes having a component of the given type.
+      */
+    template <typename ComponentType>
+    static Filter componentFilter() {
+        return &SpatialIndex::_hasComponent<ComponentType>;
+    }
+
+private:
+    /**
+      * A node registered in the index.
+      */
+    struct Entry {
+        Node* mNode;                //!< The node, or nullptr if this entry is unused.
+        Ogre::Vector3 mPosition;    //!< The cached scene position of the node.
+        float mRadius;              //!< The bounding radius of the node.
+        int64_t mCell;              //!< The key of the cell the entry is stored in.
+        uint32_t mSlot;             //!< The index of the entry within its cell, or within mLargeEntries.
+        bool mIsLarge;              //!< Whether the entry is too large for a cell and kept in mLargeEntries.
+    };
+
+    typedef std::vector<uint32_t> Cell;
+
+    template <typename ComponentType>
+    static bool _hasComponent(Node* node) {
+        return node->hasComponentOfType<ComponentType>();
+    }
+
+    /**
+      * Returns the key of the cell containing a position.
+      * @param x The cell x coordinate.
+      * @param z The cell z coordinate.
+      * @returns The key of the cell.
+      */
+    static int64_t _cellKey(int32_t x, int32_t z);
+
+    /**
+      * Returns the cell coordinate of a position.
+      * @param value A position component.
+      * @returns The cell coordinate.
+      */
+    int32_t _cellCoordinate(float value) const;
+
+    /**
+      * Inserts an entry into the cell matching its position, or into mLargeEntries if its radius is larger
+      * than a cell.
+      * @param id The entry id.
+      */
+    void _insertIntoCell(uint32_t id);
+
+    /**
+      * Removes an entry from its cell, or from mLargeEntries.
+      * @param id The entry id.
+      */
+    void _removeFromCell(uint32_t id);
+
+    /**
+      * Recomputes the range of occupied cells if a cell at its border was emptied.
+      */
+    void _updateBounds() const;
+
+    /**
+      * Calls a function for each occupied cell within a range of cells. If the range holds more cells than
+      * are occupied, e.g. for huge or infinite boxes, the occupied cells are looked at instead.
+      * @param min_x The lowest x cell coordinate.
+      * @param max_x The highest x cell coordinate.
+      * @param min_z The lowest z cell coordinate.
+      * @param max_z The highest z cell coordinate.
+      * @param visit The function, taking the cell.
+      */
+    template <typename Visitor>
+    void _visitCells(int32_t min_x, int32_t max_x, int32_t min_z, int32_t max_z, Visitor visit) const;
+
+    /**
+      * Returns whether an entry passes a filter.
+      */
+    static bool _accept(const Entry& entry, Filter filter);
+
+    float mCellSize;                                //!< The edge length of a grid cell.
+    float mInverseCellSize;                         //!< 1 / mCellSize.
+    float mMaxRadius;                               //!< The largest bounding radius ever stored in a cell, at most mCellSize. Used to loosen the queries.
+    std::vector<Entry> mEntries;                    //!< All entries. Unused ones are kept in mFreeEntries.
+    std::vector<uint32_t> mFreeEntries;             //!< Ids of unused entries.
+    std::unordered_map<int64_t, Cell> mCells;       //!< The occupied cells. Cells are never erased to avoid reallocating them.
+    Cell mLargeEntries;                             //!< The entries with a radius larger than a cell.
+    uint32_t mCellEntryCount;                       //!< The number of entries stored in cells.
+    mutable int32_t mMinX;                          //!< The lowest occupied x cell coordinate.
+    mutable int32_t mMaxX;                          //!< The highest occupied x cell coordinate.
+    mutable int32_t mMinZ;                          //!< The lowest occupied z cell coordinate.
+    mutable int32_t mMaxZ;                          //!< The highest occupied z cell coordinate.
+    mutable bool mBoundsChanged;                    //!< Whether a cell at the border of the occupied range was emptied.
+    uint32_t mNodeCount;                            //!< The number of registered nodes.
+    mutable uint32_t mVisitedCount;                 //!< The number of nodes tested by the last query.
+};
+
+} // namespace dt
+
+#endif
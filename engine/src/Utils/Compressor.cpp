@@ -0,0 +1,287 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include <Utils/Compressor.hpp>
+
+#include <Utils/Logger.hpp>
+#include <Utils/Utils.hpp>
+
+#include <QByteArray>
+
+#ifdef DUCTTAPE_USE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+#include <cstring>
+
+namespace dt {
+
+/**
+  * The largest original size of a frame to decompress, by default.
+  */
+static const uint32_t DEFAULT_MAX_SIZE = 64 * 1024 * 1024;
+
+/**
+  * Writes the header of a frame.
+  */
+static void writeFrameHeader(std::vector<char>& output, Compressor::Method method, uint32_t size) {
+    output.resize(Compressor::FRAME_HEADER_SIZE);
+    output[0] = static_cast<char>(method);
+    output[1] = static_cast<char>(size >> 24);
+    output[2] = static_cast<char>((size >> 16) & 0xff);
+    output[3] = static_cast<char>((size >> 8) & 0xff);
+    output[4] = static_cast<char>(size & 0xff);
+}
+
+Compressor::Compressor(Method method, uint32_t threshold)
+    : mMethod(NONE),
+      mThreshold(threshold),
+      mLevel(0),
+      mMaxSize(DEFAULT_MAX_SIZE),
+      mCompressContext(nullptr),
+      mDecompressContext(nullptr),
+      mCompressDictionary(nullptr),
+      mDecompressDictionary(nullptr) {
+    setMethod(method);
+}
+
+Compressor::~Compressor() {
+    _freeDictionaries();
+#ifdef DUCTTAPE_USE_ZSTD
+    ZSTD_freeCCtx(mCompressContext);
+    ZSTD_freeDCtx(mDecompressContext);
+#endif
+}
+
+Compressor::Method Compressor::getDefaultMethod() {
+#ifdef DUCTTAPE_USE_ZSTD
+    return ZSTD;
+#else
+    return ZLIB;
+#endif
+}
+
+bool Compressor::isSupported(Method method) {
+    return method == NONE || method == ZLIB || method == getDefaultMethod();
+}
+
+void Compressor::setMethod(Method method) {
+    if(!isSupported(method)) {
+        Logger::get().error("Compressor: The method [" + Utils::toString(static_cast<uint32_t>(method))
+                            + "] is not supported by this build. Using the default method.");
+        method = getDefaultMethod();
+    }
+    mMethod = method;
+}
+
+Compressor::Method Compressor::getMethod() const {
+    return mMethod;
+}
+
+void Compressor::setThreshold(uint32_t threshold) {
+    mThreshold = threshold;
+}
+
+uint32_t Compressor::getThreshold() const {
+    return mThreshold;
+}
+
+void Compressor::setLevel(int32_t level) {
+    mLevel = level;
+    // the prepared dictionary depends on the level
+    if(mCompressDictionary != nullptr)
+        _createDictionaries();
+}
+
+int32_t Compressor::getLevel() const {
+    return mLevel;
+}
+
+void Compressor::setMaxSize(uint32_t max_size) {
+    mMaxSize = max_size;
+}
+
+bool Compressor::setDictionary(const std::vector<char>& dictionary) {
+    if(!dictionary.empty() && !isSupported(ZSTD)) {
+        Logger::get().error("Compressor: Dictionaries need zstd, which is not supported by this build.");
+        return false;
+    }
+
+    mDictionary = dictionary;
+    if(!_createDictionaries()) {
+        mDictionary.clear();
+        return false;
+    }
+    return true;
+}
+
+const std::vector<char>& Compressor::getDictionary() const {
+    return mDictionary;
+}
+
+bool Compressor::trainDictionary(const std::vector<std::vector<char>>& samples, uint32_t max_size,
+                                 std::vector<char>& dictionary) {
+#ifdef DUCTTAPE_USE_ZSTD
+    // zstd wants the samples back to back
+    std::vector<char> buffer;
+    std::vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    for(auto iter = samples.begin(); iter != samples.end(); ++iter) {
+        buffer.insert(buffer.end(), iter->begin(), iter->end());
+        sizes.push_back(iter->size());
+    }
+
+    dictionary.resize(max_size);
+    size_t result = ZDICT_trainFromBuffer(&dictionary[0], max_size, &buffer[0], &sizes[0], sizes.size());
+    if(ZDICT_isError(result)) {
+        Logger::get().error(QString("Compressor: Cannot train the dictionary: ") + ZDICT_getErrorName(result));
+        dictionary.clear();
+        return false;
+    }
+    dictionary.resize(result);
+    return true;
+#else
+    Logger::get().error("Compressor: Dictionaries need zstd, which is not supported by this build.");
+    return false;
+#endif
+}
+
+bool Compressor::compress(const char* data, uint32_t size, std::vector<char>& output) {
+    if(mMethod != NONE && size >= mThreshold) {
+        if(mMethod == ZLIB) {
+            QByteArray compressed = qCompress(reinterpret_cast<const uchar*>(data), size, mLevel == 0 ? -1 : mLevel);
+            if(static_cast<uint32_t>(compressed.size()) + FRAME_HEADER_SIZE < size) {
+                writeFrameHeader(output, ZLIB, size);
+                output.insert(output.end(), compressed.constData(), compressed.constData() + compressed.size());
+                return true;
+            }
+        }
+#ifdef DUCTTAPE_USE_ZSTD
+        else if(mMethod == ZSTD) {
+            if(mCompressContext == nullptr) {
+                mCompressContext = ZSTD_createCCtx();
+                // like zlib, detect damaged frames
+                ZSTD_CCtx_setParameter(mCompressContext, ZSTD_c_checksumFlag, 1);
+            }
+            ZSTD_CCtx_setParameter(mCompressContext, ZSTD_c_compressionLevel, mLevel);
+            ZSTD_CCtx_refCDict(mCompressContext, mCompressDictionary);
+
+            writeFrameHeader(output, ZSTD, size);
+            output.resize(FRAME_HEADER_SIZE + ZSTD_compressBound(size));
+            size_t result = ZSTD_compress2(mCompressContext, &output[FRAME_HEADER_SIZE], output.size() - FRAME_HEADER_SIZE,
+                                           data, size);
+            if(!ZSTD_isError(result) && result + FRAME_HEADER_SIZE < size) {
+                output.resize(FRAME_HEADER_SIZE + result);
+                return true;
+            }
+        }
+#endif
+    }
+
+    // too small, incompressible or no method: store the data as it is
+    writeFrameHeader(output, NONE, size);
+    output.insert(output.end(), data, data + size);
+    return false;
+}
+
+bool Compressor::decompress(const char* data, uint32_t size, std::vector<char>& output) {
+    if(size < FRAME_HEADER_SIZE) {
+        Logger::get().error("Compressor: The frame is too short.");
+        return false;
+    }
+
+    Method method = static_cast<Method>(static_cast<uint8_t>(data[0]));
+    uint32_t original_size = (static_cast<uint32_t>(static_cast<uint8_t>(data[1])) << 24)
+                             | (static_cast<uint32_t>(static_cast<uint8_t>(data[2])) << 16)
+                             | (static_cast<uint32_t>(static_cast<uint8_t>(data[3])) << 8)
+                             | static_cast<uint32_t>(static_cast<uint8_t>(data[4]));
+    const char* payload = data + FRAME_HEADER_SIZE;
+    uint32_t payload_size = size - FRAME_HEADER_SIZE;
+
+    if(original_size > mMaxSize) {
+        Logger::get().error("Compressor: The frame holds " + Utils::toString(original_size) + " bytes, more than the maximum size.");
+        return false;
+    }
+
+    if(method == NONE) {
+        if(payload_size != original_size) {
+            Logger::get().error("Compressor: The stored frame is damaged.");
+            return false;
+        }
+        output.assign(payload, payload + payload_size);
+        return true;
+    } else if(method == ZLIB) {
+        // qCompress prepends the size as well, check it before qUncompress allocates anything
+        if(payload_size < 4 || memcmp(payload, data + 1, 4) != 0) {
+            Logger::get().error("Compressor: The zlib frame is damaged.");
+            return false;
+        }
+        QByteArray decompressed = qUncompress(reinterpret_cast<const uchar*>(payload), payload_size);
+        if(static_cast<uint32_t>(decompressed.size()) != original_size) {
+            Logger::get().error("Compressor: The zlib frame is damaged.");
+            return false;
+        }
+        output.assign(decompressed.constData(), decompressed.constData() + decompressed.size());
+        return true;
+    }
+#ifdef DUCTTAPE_USE_ZSTD
+    else if(method == ZSTD) {
+        if(mDecompressContext == nullptr)
+            mDecompressContext = ZSTD_createDCtx();
+
+        output.resize(original_size);
+        size_t result;
+        if(mDecompressDictionary != nullptr) {
+            result = ZSTD_decompress_usingDDict(mDecompressContext, output.empty() ? nullptr : &output[0], original_size,
+                                                payload, payload_size, mDecompressDictionary);
+        } else {
+            result = ZSTD_decompressDCtx(mDecompressContext, output.empty() ? nullptr : &output[0], original_size,
+                                         payload, payload_size);
+        }
+        if(ZSTD_isError(result) || result != original_size) {
+            Logger::get().error(QString("Compressor: The zstd frame is damaged: ")
+                                + (ZSTD_isError(result) ? ZSTD_getErrorName(result) : "wrong size"));
+            output.clear();
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    Logger::get().error("Compressor: The frame uses the unsupported method [" + Utils::toString(static_cast<uint32_t>(method)) + "].");
+    return false;
+}
+
+bool Compressor::_createDictionaries() {
+    _freeDictionaries();
+#ifdef DUCTTAPE_USE_ZSTD
+    if(mDictionary.empty())
+        return true;
+
+    mCompressDictionary = ZSTD_createCDict(&mDictionary[0], mDictionary.size(), mLevel);
+    mDecompressDictionary = ZSTD_createDDict(&mDictionary[0], mDictionary.size());
+    if(mCompressDictionary == nullptr || mDecompressDictionary == nullptr) {
+        Logger::get().error("Compressor: Cannot load the dictionary.");
+        _freeDictionaries();
+        return false;
+    }
+#endif
+    return true;
+}
+
+void Compressor::_freeDictionaries() {
+#ifdef DUCTTAPE_USE_ZSTD
+    ZSTD_freeCDict(mCompressDictionary);
+    ZSTD_freeDDict(mDecompressDictionary);
+#endif
+    mCompressDictionary = nullptr;
+    mDecompressDictionary = nullptr;
+}
+
+} // namespace dt
@@ -0,0 +1,197 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_UTILS_COMPRESSOR
+#define DUCTTAPE_ENGINE_UTILS_COMPRESSOR
+
+#include <Config.hpp>
+
+#include <QtGlobal>
+
+#include <cstdint>
+#include <vector>
+
+// zstd is optional, only the context types are declared here
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+namespace dt {
+
+/**
+  * Compresses serialized data, such as network events or save files, into frames. A frame starts with
+  * the method and the size of the original data, so it can be decompressed without knowing how it was
+  * written. zlib is always available through Qt, zstd if the engine was built with USE_ZSTD. Data smaller
+  * than the threshold, or that would not get smaller, is stored as it is.
+  * A dictionary trained on typical data, for example the serialized nodes of a scene, makes even small
+  * messages compress well, as their type names and strings are found in it. Both sides need the same one.
+  * @code
+  * sf::Packet packet;
+  * IOPacket p(&packet, IOPacket::SERIALIZE);
+  * node->serialize(p);
+  *
+  * std::vector<char> frame;
+  * compressor.compress(static_cast<const char*>(packet.getData()), packet.getDataSize(), frame);
+  * file.write(&frame[0], frame.size());
+  * @endcode
+  */
+class DUCTTAPE_API Compressor {
+
+    Q_DISABLE_COPY(Compressor)
+
+public:
+    /**
+      * The compression methods.
+      */
+    enum Method {
+        NONE = 0,       //!< The data is stored as it is.
+        ZLIB = 1,       //!< zlib, through qCompress.
+        ZSTD = 2        //!< zstd. Supports dictionaries.
+    };
+
+    /**
+      * The size of the header every frame starts with: the method and the size of the original data.
+      */
+    static const uint32_t FRAME_HEADER_SIZE = 5;
+
+    /**
+      * Advanced constructor.
+      * @param method The compression method.
+      * @param threshold The minimum size of the data to compress, in bytes.
+      */
+    Compressor(Method method = getDefaultMethod(), uint32_t threshold = 128);
+
+    /**
+      * Destructor.
+      */
+    ~Compressor();
+
+    /**
+      * Returns the best method this build supports.
+      * @returns ZSTD if the engine was built with it, otherwise ZLIB.
+      */
+    static Method getDefaultMethod();
+
+    /**
+      * Returns whether this build can compress and decompress with a method.
+      * @param method The method.
+      * @returns True if the method is supported.
+      */
+    static bool isSupported(Method method);
+
+    /**
+      * Sets the compression method. Frames of any supported method can be decompressed regardless.
+      * @param method The method. An unsupported one is replaced by the default method.
+      */
+    void setMethod(Method method);
+
+    /**
+      * Returns the compression method.
+      * @returns The method.
+      */
+    Method getMethod() const;
+
+    /**
+      * Sets the minimum size of the data to compress. Smaller data does not gain enough to be worth the time.
+      * @param threshold The threshold, in bytes. Default: 128.
+      */
+    void setThreshold(uint32_t threshold);
+
+    /**
+      * Returns the minimum size of the data to compress.
+      * @returns The threshold, in bytes.
+      */
+    uint32_t getThreshold() const;
+
+    /**
+      * Sets the compression level. Higher levels compress better and slower.
+      * @param level The level, 1 to 9 for zlib and 1 to 22 for zstd, or 0 for the default of the method.
+      */
+    void setLevel(int32_t level);
+
+    /**
+      * Returns the compression level.
+      * @returns The level, or 0 for the default of the method.
+      */
+    int32_t getLevel() const;
+
+    /**
+      * Sets the largest original size a frame may have to be decompressed. Protects against damaged or
+      * forged frames that would allocate huge buffers.
+      * @param max_size The size, in bytes. Default: 64 MB.
+      */
+    void setMaxSize(uint32_t max_size);
+
+    /**
+      * Sets the dictionary used to compress and decompress with zstd.
+      * @param dictionary The dictionary, as returned by trainDictionary(). Empty to use none.
+      * @returns False if zstd is not supported or the dictionary could not be loaded.
+      */
+    bool setDictionary(const std::vector<char>& dictionary);
+
+    /**
+      * Returns the dictionary.
+      * @returns The dictionary, or an empty one.
+      */
+    const std::vector<char>& getDictionary() const;
+
+    /**
+      * Trains a zstd dictionary on samples of typical data. It needs a few hundred samples to work well.
+      * @param samples The samples.
+      * @param max_size The maximum size of the dictionary, in bytes.
+      * @param dictionary The vector the dictionary is written to.
+      * @returns False if zstd is not supported or there are too few samples.
+      */
+    static bool trainDictionary(const std::vector<std::vector<char>>& samples, uint32_t max_size,
+                                std::vector<char>& dictionary);
+
+    /**
+      * Writes data into a frame, compressed if it is at least as large as the threshold and gets smaller.
+      * @param data The data.
+      * @param size The size of the data, in bytes.
+      * @param output The vector the frame is written to. Its previous content is replaced.
+      * @returns True if the data was compressed, false if it was stored.
+      */
+    bool compress(const char* data, uint32_t size, std::vector<char>& output);
+
+    /**
+      * Reads the data from a frame.
+      * @param data The frame.
+      * @param size The size of the frame, in bytes.
+      * @param output The vector the data is written to. Its previous content is replaced.
+      * @returns False if the frame is damaged, too large or of an unsupported method.
+      */
+    bool decompress(const char* data, uint32_t size, std::vector<char>& output);
+
+private:
+    /**
+      * Private method. Creates the zstd dictionaries for the current dictionary and level.
+      * @returns False if the dictionary could not be loaded.
+      */
+    bool _createDictionaries();
+
+    /**
+      * Private method. Frees the zstd dictionaries.
+      */
+    void _freeDictionaries();
+
+    Method mMethod;                             //!< The compression method.
+    uint32_t mThreshold;                        //!< The minimum size of the data to compress.
+    int32_t mLevel;                             //!< The compression level, or 0 for the default.
+    uint32_t mMaxSize;                          //!< The largest original size of a frame to decompress.
+    std::vector<char> mDictionary;              //!< The zstd dictionary, or empty.
+    ZSTD_CCtx_s* mCompressContext;              //!< The zstd compression context, created when needed.
+    ZSTD_DCtx_s* mDecompressContext;            //!< The zstd decompression context, created when needed.
+    ZSTD_CDict_s* mCompressDictionary;          //!< The dictionary prepared for compression, or nullptr.
+    ZSTD_DDict_s* mDecompressDictionary;        //!< The dictionary prepared for decompression, or nullptr.
+};
+
+} // namespace dt
+
+#endif
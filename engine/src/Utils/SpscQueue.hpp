@@ -0,0 +1,109 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_UTILS_SPSCQUEUE
+#define DUCTTAPE_ENGINE_UTILS_SPSCQUEUE
+
+#include <Config.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace dt {
+
+/**
+  * A lock-free queue of fixed capacity between one producer thread and one consumer thread. The elements
+  * live in slots that are reused, so a producer can fill a slot in place and the memory the element
+  * owns (e.g. a buffer) is kept for the next time the slot is used.
+  * @code
+  * // producer
+  * Datagram* slot = queue.beginPush();
+  * if(slot != nullptr) {
+  *     slot->mData.assign(data, data + size);
+  *     queue.endPush();
+  * }
+  *
+  * // consumer
+  * while(Datagram* datagram = queue.front()) {
+  *     handle(*datagram);
+  *     queue.pop();
+  * }
+  * @endcode
+  */
+template <typename T>
+class SpscQueue {
+public:
+    /**
+      * Advanced constructor.
+      * @param capacity The maximum number of elements. It is rounded up to a power of two.
+      */
+    SpscQueue(uint32_t capacity)
+        : mMask(1),
+          mHead(0),
+          mTail(0) {
+        while(mMask < capacity)
+            mMask <<= 1;
+        mSlots.resize(mMask);
+        mMask -= 1;
+    }
+
+    /**
+      * Returns the maximum number of elements.
+      * @returns The capacity.
+      */
+    uint32_t getCapacity() const {
+        return mMask + 1;
+    }
+
+    /**
+      * Returns the slot to fill with the next element. Producer only.
+      * @returns The slot, or nullptr if the queue is full.
+      */
+    T* beginPush() {
+        uint32_t tail = mTail.load(std::memory_order_relaxed);
+        if(tail - mHead.load(std::memory_order_acquire) > mMask)
+            return nullptr;
+        return &mSlots[tail & mMask];
+    }
+
+    /**
+      * Hands the slot returned by beginPush() to the consumer. Producer only.
+      */
+    void endPush() {
+        mTail.store(mTail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+      * Returns the oldest element. Consumer only.
+      * @returns The element, or nullptr if the queue is empty.
+      */
+    T* front() {
+        uint32_t head = mHead.load(std::memory_order_relaxed);
+        if(head == mTail.load(std::memory_order_acquire))
+            return nullptr;
+        return &mSlots[head & mMask];
+    }
+
+    /**
+      * Hands the slot of the oldest element back to the producer. Consumer only.
+      */
+    void pop() {
+        mHead.store(mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    std::vector<T> mSlots;          //!< The slots, a power of two of them.
+    uint32_t mMask;                 //!< The number of slots minus one.
+    std::atomic<uint32_t> mHead;    //!< The number of elements popped. Written by the consumer.
+    std::atomic<uint32_t> mTail;    //!< The number of elements pushed. Written by the producer.
+};
+
+}
+
+#endif
@@ -10,22 +10,36 @@
 
 #include "Client.hpp"
 
+#include <Core/Root.hpp>
+#include <Network/NetworkManager.hpp>
 #include <Utils/Utils.hpp>
 
+#include <QStringList>
+
 #include <ctime>
 #include <iostream>
 
 int main(int argc, char** argv) {
+    // --netsim=<options> simulates a bad network, see dt::NetworkSimulator::configure
+    QStringList args;
+    for(int i = 1; i < argc; ++i) {
+        QString arg(argv[i]);
+        if(arg.startsWith("--netsim="))
+            dt::Root::getInstance().getNetworkManager()->getSimulator()->configure(arg.section("=", 1));
+        else
+            args << arg;
+    }
+
     dt::Game game;
     Client* client = new Client();
 
-    if(argc > 1)
-        client->setNick(argv[1]);
+    if(args.size() > 0)
+        client->setNick(args[0]);
     else
         client->setNick("chatter-" + dt::Utils::toString(time(0)));
 
-    if(argc > 2)
-        client->setServerIP(sf::IpAddress(argv[2]));
+    if(args.size() > 1)
+        client->setServerIP(sf::IpAddress(dt::Utils::toStdString(args[1])));
 
     game.run(client, argc, argv);
 
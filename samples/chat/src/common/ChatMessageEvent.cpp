@@ -18,6 +18,10 @@ const QString ChatMessageEvent::getType() const {
     return "CHATMESSAGEEVENT";
 }
 
+dt::NetworkEvent::Channel ChatMessageEvent::getChannel() const {
+    return RELIABLE_ORDERED;
+}
+
 std::shared_ptr<dt::NetworkEvent> ChatMessageEvent::clone() const {
     std::shared_ptr<dt::NetworkEvent> ptr(new ChatMessageEvent(mMessage, mSenderNick));
     return ptr;
@@ -35,3 +39,8 @@ const QString ChatMessageEvent::getSenderNick() const {
 const QString ChatMessageEvent::getMessageText() const {
     return mMessage;
 }
+
+void ChatMessageEvent::setMessage(const QString message, const QString sender) {
+    mSenderNick = sender;
+    mMessage = message;
+}
@@ -18,12 +18,14 @@ class ChatMessageEvent : public dt::NetworkEvent/*, public dt::MessageEvent*/ {
 public:
     ChatMessageEvent(const QString message, const QString sender);
     const QString getType() const;
+    Channel getChannel() const;
 
     std::shared_ptr<dt::NetworkEvent> clone() const;
     void serialize(dt::IOPacket& p);
 
     const QString getSenderNick() const;
     const QString getMessageText() const;
+    void setMessage(const QString message, const QString sender);
 protected:
     QString mSenderNick;
 
@@ -45,17 +45,18 @@ void Server::_handleEvent(std::shared_ptr<dt::NetworkEvent> e) {
                               /help - This message\n\
                               /quit - disconnects from the server\n\
                               /nick [nickname] - changes your nickname";
-                dt::NetworkManager::get()->
-                    queueEvent(std::make_shared<ChatMessageEvent>(msg, c->getSenderNick()));
+                std::shared_ptr<ChatMessageEvent> help = dt::NetworkManager::get()->createEvent<ChatMessageEvent>();
+                help->setMessage(msg, c->getSenderNick());
+                dt::NetworkManager::get()->queueEvent(help);
             } else {
                 std::cout << std::endl << dt::Utils::toStdString(c->getSenderNick()) << ": "
                     << dt::Utils::toStdString(c->getMessageText()) << std::endl;
             }
 
-            // send back to everyone else
-            dt::NetworkManager::get()->
-                queueEvent(std::make_shared<ChatMessageEvent>(c->getMessageText(),
-                c->getSenderNick()));
+            // send back to everyone else, with a pooled event
+            std::shared_ptr<ChatMessageEvent> echo = dt::NetworkManager::get()->createEvent<ChatMessageEvent>();
+            echo->setMessage(c->getMessageText(), c->getSenderNick());
+            dt::NetworkManager::get()->queueEvent(echo);
         //}
 
     } else if(e->getType() == "DT_GOODBYEEVENT") {
@@ -10,11 +10,20 @@
 
 #include "Server.hpp"
 
+#include <Core/Root.hpp>
+#include <Network/NetworkManager.hpp>
 #include <Scene/Game.hpp>
 
 #include <iostream>
 
 int main(int argc, char** argv) {
+    // --netsim=<options> simulates a bad network, see dt::NetworkSimulator::configure
+    for(int i = 1; i < argc; ++i) {
+        QString arg(argv[i]);
+        if(arg.startsWith("--netsim="))
+            dt::Root::getInstance().getNetworkManager()->getSimulator()->configure(arg.section("=", 1));
+    }
+
     dt::Game game;
     Server* server = new Server();
 
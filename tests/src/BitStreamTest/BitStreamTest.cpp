@@ -0,0 +1,162 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "BitStreamTest/BitStreamTest.hpp"
+
+#include <Network/BitStream.hpp>
+#include <Scene/Node.hpp>
+#include <Utils/Utils.hpp>
+
+#include <SFML/System/Clock.hpp>
+
+#include <cmath>
+
+namespace BitStreamTest {
+
+Sample::Sample()
+    : mHealth(0),
+      mScore(0),
+      mIsAlive(false) {
+    mPosition[0] = mPosition[1] = mPosition[2] = 0.f;
+}
+
+void Sample::serialize(dt::IOPacket& packet) {
+    packet.stream(mId, "id");
+    packet.stream(mName, "name");
+    packet.streamRanged(mHealth, 0, 100, "health");
+    packet.streamQuantized(mPosition[0], -1024.f, 1024.f, 20, "x");
+    packet.streamQuantized(mPosition[1], -1024.f, 1024.f, 20, "y");
+    packet.streamQuantized(mPosition[2], -1024.f, 1024.f, 20, "z");
+    packet.stream(mScore, "score");
+    packet.stream(mIsAlive, "alive");
+}
+
+bool BitStreamTest::run(int argc, char** argv) {
+    dt::Root::getInstance().initialize(argc, argv);
+
+    char buffer[1200];
+
+    // raw values
+    dt::BitStream writer(buffer, sizeof(buffer), dt::BitStream::WRITE);
+    writer.writeBits(5, 3);
+    writer.writeVarint(300);
+    writer.writeSignedVarint(-70000);
+    writer.writeRanged(-3, -8, 7);
+    writer.writeString(QString::fromUtf8("Gr\xc3\xbc\xc3\x9f" "e"));
+    // 3 bits, two and three bytes of varints, 4 bits, the length of the string, 1 bit padding and 7 bytes of UTF-8
+    if(writer.getBitPosition() != 3 + 16 + 24 + 4 + 8 + 1 + 7 * 8) {
+        dt::Logger::get().error("Wrong number of bits written: " + dt::Utils::toString(writer.getBitPosition()));
+        return false;
+    }
+
+    dt::BitStream reader(buffer, writer.getSize());
+    if(reader.readBits(3) != 5 || reader.readVarint() != 300 || reader.readSignedVarint() != -70000
+            || reader.readRanged(-8, 7) != -3 || reader.readString() != QString::fromUtf8("Gr\xc3\xbc\xc3\x9f" "e")) {
+        dt::Logger::get().error("The raw values were not read back.");
+        return false;
+    }
+    if(!reader.isAtEnd() || reader.isOverflowed()) {
+        dt::Logger::get().error("The reader did not stop at the end of the data.");
+        return false;
+    }
+    reader.readBits(8);
+    if(!reader.isOverflowed()) {
+        dt::Logger::get().error("Reading past the end was not detected.");
+        return false;
+    }
+
+    dt::BitStream small(buffer, 4, dt::BitStream::WRITE);
+    small.writeBits(0, 30);
+    small.writeBits(0, 3);
+    if(!small.isOverflowed()) {
+        dt::Logger::get().error("Writing past the end of the buffer was not detected.");
+        return false;
+    }
+
+    // a node through the IOPacket
+    dt::Node node1("bitnode");
+    node1.addChildNode(new dt::Node("bitchild"))->setPosition(Ogre::Vector3(1, 2, 3));
+
+    dt::BitStream node_writer(buffer, sizeof(buffer), dt::BitStream::WRITE);
+    dt::IOPacket p1(&node_writer);
+    node1.serialize(p1);
+
+    dt::BitStream node_reader(buffer, node_writer.getSize());
+    dt::IOPacket p2(&node_reader);
+    dt::Node node2("receiver");
+    node2.serialize(p2);
+
+    if(node_writer.isOverflowed() || node_reader.isOverflowed() || node2.getName() != "bitnode"
+            || node2.findChildNode("bitchild") == nullptr
+            || node2.findChildNode("bitchild")->getPosition() != Ogre::Vector3(1, 2, 3)) {
+        dt::Logger::get().error("The node was not transfered.");
+        return false;
+    }
+
+    // compare with the sf::Packet backend
+    Sample sample;
+    sample.mId = QUuid::createUuid();
+    sample.mName = "player";
+    sample.mHealth = 87;
+    sample.mPosition[0] = 12.5f;
+    sample.mPosition[1] = -300.25f;
+    sample.mPosition[2] = 0.75f;
+    sample.mScore = 1234;
+    sample.mIsAlive = true;
+
+    const uint32_t iterations = 100000;
+    sf::Packet packet;
+    sf::Clock clock;
+    for(uint32_t i = 0; i < iterations; ++i) {
+        packet.clear();
+        dt::IOPacket p(&packet, dt::IOPacket::SERIALIZE);
+        sample.serialize(p);
+    }
+    double packet_time = clock.getElapsedTime().asSeconds();
+    uint32_t packet_size = packet.getDataSize();
+
+    uint32_t bits_size = 0;
+    clock.restart();
+    for(uint32_t i = 0; i < iterations; ++i) {
+        dt::BitStream stream(buffer, sizeof(buffer), dt::BitStream::WRITE);
+        dt::IOPacket p(&stream);
+        sample.serialize(p);
+        bits_size = stream.getSize();
+    }
+    double bits_time = clock.getElapsedTime().asSeconds();
+
+    dt::Logger::get().info("sf::Packet: " + dt::Utils::toString(packet_size) + " bytes, "
+                           + dt::Utils::toString(packet_time * 1000000.0 / iterations) + " us per sample");
+    dt::Logger::get().info("BitStream: " + dt::Utils::toString(bits_size) + " bytes, "
+                           + dt::Utils::toString(bits_time * 1000000.0 / iterations) + " us per sample");
+
+    if(bits_size >= packet_size) {
+        dt::Logger::get().error("The bit-packed sample is not smaller.");
+        return false;
+    }
+
+    Sample received;
+    dt::BitStream sample_reader(buffer, bits_size);
+    dt::IOPacket p3(&sample_reader);
+    received.serialize(p3);
+    if(received.mId != sample.mId || received.mName != sample.mName || received.mHealth != sample.mHealth
+            || std::fabs(received.mPosition[1] - sample.mPosition[1]) > 0.01f
+            || received.mScore != sample.mScore || received.mIsAlive != sample.mIsAlive) {
+        dt::Logger::get().error("The sample was not read back.");
+        return false;
+    }
+
+    dt::Root::getInstance().deinitialize();
+    return true;
+}
+
+QString BitStreamTest::getTestName() {
+    return "BitStream";
+}
+
+}
@@ -0,0 +1,46 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_BITSTREAMTEST
+#define DUCTTAPE_ENGINE_TESTS_BITSTREAMTEST
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Network/IOPacket.hpp>
+#include <Utils/Logger.hpp>
+
+namespace BitStreamTest {
+
+/**
+  * The state of an object, as it is typically sent over network.
+  */
+struct Sample {
+    Sample();
+
+    void serialize(dt::IOPacket& packet);
+
+    QUuid mId;
+    QString mName;
+    int32_t mHealth;
+    float mPosition[3];
+    uint32_t mScore;
+    bool mIsAlive;
+};
+
+class BitStreamTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+};
+
+}
+
+#endif
@@ -0,0 +1,259 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "ChannelsTest/ChannelsTest.hpp"
+
+#include <Network/GoodbyeEvent.hpp>
+#include <Utils/Utils.hpp>
+
+#include <SFML/System/Sleep.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+namespace ChannelsTest {
+
+bool ChannelsTest::run(int argc, char** argv) {
+    dt::Root& root = dt::Root::getInstance();
+    root.initialize(argc, argv);
+
+    dt::NetworkManager* nm = root.getNetworkManager();
+    nm->registerNetworkEventPrototype(std::make_shared<NumberEvent>(0, dt::NetworkEvent::RELIABLE_ORDERED));
+    nm->registerNetworkEventPrototype(std::make_shared<NumberEvent>(0, dt::NetworkEvent::RELIABLE_UNORDERED));
+    nm->registerNetworkEventPrototype(std::make_shared<NumberEvent>(0, dt::NetworkEvent::UNRELIABLE_SEQUENCED));
+
+    if(!nm->bindSocket(CHANNELS_PORT)) {
+        std::cerr << "Could not bind the socket." << std::endl;
+        return false;
+    }
+
+    // use the conditions given with --netsim, if any
+    dt::NetworkSimulator* simulator = nm->getSimulator();
+    if(!simulator->isEnabled()) {
+        dt::NetworkSimulator::Conditions conditions;
+        conditions.mLatency = 0.05;
+        conditions.mJitter = 0.02;
+        conditions.mPacketLoss = 0.25f;
+        conditions.mDuplication = 0.05f;
+        conditions.mReordering = 0.05f;
+
+        simulator->setSeed(42);
+        simulator->setConditions(conditions);
+        simulator->setEnabled(true);
+    }
+
+    // talk to ourselves, the connection is both sender and receiver
+    nm->connect(dt::Connection::ConnectionSP(new dt::Connection(sf::IpAddress::LocalHost, CHANNELS_PORT)));
+
+    NumberEventListener listener;
+    for(uint32_t i = 0; i < CHANNELS_EVENT_COUNT; ++i) {
+        nm->queueEvent(std::make_shared<NumberEvent>(i, dt::NetworkEvent::RELIABLE_ORDERED));
+        nm->queueEvent(std::make_shared<NumberEvent>(i, dt::NetworkEvent::RELIABLE_UNORDERED));
+        nm->queueEvent(std::make_shared<NumberEvent>(i, dt::NetworkEvent::UNRELIABLE_SEQUENCED));
+    }
+
+    double start = root.getTimeSinceInitialize();
+    while(listener.mOrdered.size() < CHANNELS_EVENT_COUNT || listener.mUnordered.size() < CHANNELS_EVENT_COUNT) {
+        nm->sendQueuedEvents();
+        nm->handleIncomingEvents();
+        sf::sleep(sf::milliseconds(10));
+
+        if(root.getTimeSinceInitialize() - start > 8.0) {
+            std::cerr << "Reliable events did not arrive: " << listener.mOrdered.size() << " ordered, "
+                      << listener.mUnordered.size() << " unordered." << std::endl;
+            return false;
+        }
+    }
+
+    for(uint32_t i = 0; i < CHANNELS_EVENT_COUNT; ++i) {
+        if(listener.mOrdered[i] != i) {
+            std::cerr << "Reliable-ordered event " << listener.mOrdered[i] << " arrived at position " << i << "." << std::endl;
+            return false;
+        }
+    }
+
+    std::sort(listener.mUnordered.begin(), listener.mUnordered.end());
+    if(std::unique(listener.mUnordered.begin(), listener.mUnordered.end()) != listener.mUnordered.end()) {
+        std::cerr << "A reliable-unordered event arrived twice." << std::endl;
+        return false;
+    }
+
+    if(listener.mSequenced.empty()) {
+        std::cerr << "No unreliable-sequenced event arrived." << std::endl;
+        return false;
+    }
+    for(uint32_t i = 1; i < listener.mSequenced.size(); ++i) {
+        if(listener.mSequenced[i] <= listener.mSequenced[i - 1]) {
+            std::cerr << "Unreliable-sequenced event " << listener.mSequenced[i] << " arrived after "
+                      << listener.mSequenced[i - 1] << "." << std::endl;
+            return false;
+        }
+    }
+
+    dt::ConnectionsManager::ID_t id = nm->getConnectionsManager()->findConnectionID(sf::IpAddress::LocalHost, CHANNELS_PORT);
+    dt::NetworkChannels* channels = nm->getConnectionsManager()->getChannels(id);
+    if(simulator->getConditions().mPacketLoss > 0 && (simulator->getLostCount() == 0 || channels->getResentCount() == 0)) {
+        std::cerr << "The simulator did not drop any datagrams." << std::endl;
+        return false;
+    }
+
+    std::cout << "Datagrams lost: " << simulator->getLostCount() << ", reliable events resent: "
+              << channels->getResentCount() << ", sequenced events handled: " << listener.mSequenced.size()
+              << ", round-trip time: " << channels->getRoundTripTime() << "s" << std::endl;
+
+    // an event that cannot be decoded must neither stall the reliable channels nor the events after it
+    uint64_t dropped = nm->getDroppedCount();
+    nm->queueEvent(std::make_shared<UnknownEvent>(dt::NetworkEvent::RELIABLE_ORDERED));
+    nm->queueEvent(std::make_shared<UnknownEvent>(dt::NetworkEvent::RELIABLE_UNORDERED));
+    for(uint32_t i = CHANNELS_EVENT_COUNT; i < 2 * CHANNELS_EVENT_COUNT; ++i) {
+        nm->queueEvent(std::make_shared<NumberEvent>(i, dt::NetworkEvent::RELIABLE_ORDERED));
+        nm->queueEvent(std::make_shared<NumberEvent>(i, dt::NetworkEvent::RELIABLE_UNORDERED));
+    }
+
+    start = root.getTimeSinceInitialize();
+    while(listener.mOrdered.size() < 2 * CHANNELS_EVENT_COUNT || listener.mUnordered.size() < 2 * CHANNELS_EVENT_COUNT) {
+        nm->sendQueuedEvents();
+        nm->handleIncomingEvents();
+        sf::sleep(sf::milliseconds(10));
+
+        if(root.getTimeSinceInitialize() - start > 8.0) {
+            std::cerr << "Reliable events after an unknown one did not arrive: " << listener.mOrdered.size() << " ordered, "
+                      << listener.mUnordered.size() << " unordered." << std::endl;
+            return false;
+        }
+    }
+
+    for(uint32_t i = CHANNELS_EVENT_COUNT; i < 2 * CHANNELS_EVENT_COUNT; ++i) {
+        if(listener.mOrdered[i] != i) {
+            std::cerr << "Reliable-ordered event " << listener.mOrdered[i] << " arrived at position " << i
+                      << " after an unknown one." << std::endl;
+            return false;
+        }
+    }
+    if(nm->getDroppedCount() == dropped) {
+        std::cerr << "The unknown events were not dropped." << std::endl;
+        return false;
+    }
+
+    // the connection is kept until the lost GoodbyeEvent has been resent
+    dt::ConnectionsManager* cm = nm->getConnectionsManager();
+    cm->setLingerTime(8.0);
+    dt::NetworkSimulator::Conditions conditions = simulator->getConditions();
+    dt::NetworkSimulator::Conditions lost = conditions;
+    lost.mPacketLoss = 1.f;
+    simulator->setConditions(lost);
+    nm->disconnect(dt::Connection(sf::IpAddress::LocalHost, CHANNELS_PORT));
+    simulator->setConditions(conditions);
+
+    if(!cm->isClosing(id) || cm->getConnectionCount() != 0) {
+        std::cerr << "The connection was not kept open for the GoodbyeEvent." << std::endl;
+        return false;
+    }
+
+    start = root.getTimeSinceInitialize();
+    while(listener.mGoodbyes == 0) {
+        nm->sendQueuedEvents();
+        nm->handleIncomingEvents();
+        sf::sleep(sf::milliseconds(10));
+
+        if(root.getTimeSinceInitialize() - start > 8.0) {
+            std::cerr << "The lost GoodbyeEvent was not resent." << std::endl;
+            return false;
+        }
+    }
+    if(cm->isClosing(id)) {
+        std::cerr << "The connection was not removed when the GoodbyeEvent arrived." << std::endl;
+        return false;
+    }
+
+    root.deinitialize();
+    return true;
+}
+
+QString ChannelsTest::getTestName() {
+    return "Channels";
+}
+
+////////////////////////////////////////////////////////////////
+
+NumberEvent::NumberEvent(uint32_t number, Channel channel)
+    : mNumber(number),
+      mChannel(channel) {}
+
+const QString NumberEvent::getType() const {
+    return "CHANNELSTEST_NUMBEREVENT_" + dt::Utils::toString(static_cast<uint32_t>(mChannel));
+}
+
+dt::NetworkEvent::Channel NumberEvent::getChannel() const {
+    return mChannel;
+}
+
+std::shared_ptr<dt::NetworkEvent> NumberEvent::clone() const {
+    std::shared_ptr<dt::NetworkEvent> ptr(new NumberEvent(mNumber, mChannel));
+    return ptr;
+}
+
+void NumberEvent::serialize(dt::IOPacket& p) {
+    p.stream(mNumber, "number");
+}
+
+////////////////////////////////////////////////////////////////
+
+UnknownEvent::UnknownEvent(Channel channel)
+    : mChannel(channel) {}
+
+const QString UnknownEvent::getType() const {
+    return "CHANNELSTEST_UNKNOWNEVENT_" + dt::Utils::toString(static_cast<uint32_t>(mChannel));
+}
+
+dt::NetworkEvent::Channel UnknownEvent::getChannel() const {
+    return mChannel;
+}
+
+std::shared_ptr<dt::NetworkEvent> UnknownEvent::clone() const {
+    std::shared_ptr<dt::NetworkEvent> ptr(new UnknownEvent(mChannel));
+    return ptr;
+}
+
+void UnknownEvent::serialize(dt::IOPacket& p) {
+    uint32_t payload = 0xdeadbeef;
+    p.stream(payload, "payload");
+}
+
+////////////////////////////////////////////////////////////////
+
+NumberEventListener::NumberEventListener()
+    : mGoodbyes(0) {
+    QObject::connect(dt::NetworkManager::get(), SIGNAL(newEvent(std::shared_ptr<dt::NetworkEvent>)),
+                     this,                      SLOT(_handleEvent(std::shared_ptr<dt::NetworkEvent>)));
+}
+
+void NumberEventListener::_handleEvent(std::shared_ptr<dt::NetworkEvent> e) {
+    if(std::dynamic_pointer_cast<dt::GoodbyeEvent>(e) != nullptr && e->isLocalEvent())
+        ++mGoodbyes;
+
+    std::shared_ptr<NumberEvent> n = std::dynamic_pointer_cast<NumberEvent>(e);
+    if(n == nullptr || !n->isLocalEvent())
+        return;
+
+    switch(n->getChannel()) {
+    case dt::NetworkEvent::RELIABLE_ORDERED:
+        mOrdered.push_back(n->mNumber);
+        break;
+    case dt::NetworkEvent::RELIABLE_UNORDERED:
+        mUnordered.push_back(n->mNumber);
+        break;
+    case dt::NetworkEvent::UNRELIABLE_SEQUENCED:
+        mSequenced.push_back(n->mNumber);
+        break;
+    default:
+        break;
+    }
+}
+
+} // namespace ChannelsTest
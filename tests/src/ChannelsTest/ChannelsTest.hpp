@@ -0,0 +1,97 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_CHANNELSTEST
+#define DUCTTAPE_ENGINE_TESTS_CHANNELSTEST
+
+#define CHANNELS_PORT 20503
+#define CHANNELS_EVENT_COUNT 100
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Network/NetworkManager.hpp>
+
+#include <QObject>
+
+#include <vector>
+
+/**
+  * @file
+  * A test for the network channels. The NetworkManager connects to itself over loopback, with the
+  * network simulator dropping a quarter of all datagrams and delaying, duplicating and reordering the
+  * others, unless other conditions are given with --netsim. It sends numbered events
+  * on the reliable-ordered, reliable-unordered and unreliable-sequenced channels and checks that all
+  * reliable ones arrive, the ordered ones in order, and that no sequenced one arrives after a newer one.
+  * Then it sends events of a type the receiver does not know on the reliable channels and checks that the
+  * events after them still arrive. Last it disconnects while the first GoodbyeEvent is lost, and checks
+  * that the GoodbyeEvent is resent before the connection is removed.
+  */
+
+namespace ChannelsTest {
+
+class ChannelsTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+};
+
+////////////////////////////////////////////////////////////////
+
+class NumberEvent : public dt::NetworkEvent {
+public:
+    NumberEvent(uint32_t number, Channel channel);
+    const QString getType() const;
+    Channel getChannel() const;
+    std::shared_ptr<dt::NetworkEvent> clone() const;
+    void serialize(dt::IOPacket& p);
+
+public:
+    uint32_t mNumber;
+    Channel mChannel;
+};
+
+////////////////////////////////////////////////////////////////
+
+/**
+  * An event that is never registered, so the receiver cannot decode it.
+  */
+class UnknownEvent : public dt::NetworkEvent {
+public:
+    UnknownEvent(Channel channel);
+    const QString getType() const;
+    Channel getChannel() const;
+    std::shared_ptr<dt::NetworkEvent> clone() const;
+    void serialize(dt::IOPacket& p);
+
+public:
+    Channel mChannel;
+};
+
+////////////////////////////////////////////////////////////////
+
+class NumberEventListener : public QObject {
+    Q_OBJECT
+public:
+    NumberEventListener();
+
+private slots:
+    void _handleEvent(std::shared_ptr<dt::NetworkEvent> e);
+
+public:
+    std::vector<uint32_t> mOrdered;
+    std::vector<uint32_t> mUnordered;
+    std::vector<uint32_t> mSequenced;
+    uint32_t mGoodbyes;
+};
+
+} // namespace ChannelsTest
+
+#endif
@@ -0,0 +1,108 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "CharacterControllerTest/CharacterControllerTest.hpp"
+
+#include <iostream>
+#include <vector>
+
+namespace CharacterControllerTest {
+
+bool CharacterControllerTest::run(int argc, char** argv) {
+    dt::Root::getInstance().initialize(argc, argv);
+
+    dt::PhysicsWorld world("character-world", nullptr);
+    world.initialize();
+    btDiscreteDynamicsWorld* bullet_world = world.getBulletWorld();
+    dt::CharacterControllerPool* pool = world.getCharacterControllerPool();
+
+    btCollisionShape* ground_shape = new btBoxShape(btVector3(200, 1, 200));
+    btRigidBody* ground = new btRigidBody(0, new btDefaultMotionState(btTransform(btQuaternion::getIdentity(), btVector3(0, -1, 0))),
+                                          ground_shape);
+    bullet_world->addRigidBody(ground);
+
+    // a 10x10 crowd, spread out so they do not bump into each other
+    const uint32_t size = 10;
+    std::vector<dt::CharacterController*> crowd;
+    for(uint32_t i = 0; i < size * size; ++i) {
+        btTransform start(btQuaternion::getIdentity(), btVector3((i % size) * 5.f, 1.5f, (i / size) * 5.f));
+        dt::CharacterController* character = pool->create(start);
+        character->setEnabled(true);
+        crowd.push_back(character);
+    }
+
+    if(pool->getActiveCount() != size * size) {
+        std::cerr << "Not all characters are active." << std::endl;
+        return false;
+    }
+
+    // let them land
+    for(int i = 0; i < 50; ++i)
+        world.stepSimulation(0.02);
+
+    std::vector<btVector3> start_positions;
+    for(uint32_t i = 0; i < size * size; ++i) {
+        start_positions.push_back(crowd[i]->getWorldTransform().getOrigin());
+        // every second character stands still, the others walk along x or z
+        if(i % 2 == 0)
+            crowd[i]->setWalkVelocity(i % 4 == 0 ? btVector3(1, 0, 0) : btVector3(0, 0, 1));
+    }
+
+    for(int i = 0; i < 50; ++i)
+        world.stepSimulation(0.02);
+
+    bool success = true;
+    for(uint32_t i = 0; i < size * size; ++i) {
+        btVector3 moved = crowd[i]->getWorldTransform().getOrigin() - start_positions[i];
+        moved.setY(0);
+
+        btVector3 expected(0, 0, 0);
+        if(i % 2 == 0)
+            expected = (i % 4 == 0 ? btVector3(1, 0, 0) : btVector3(0, 0, 1));
+
+        if(moved.distance(expected) > 0.1f) {
+            std::cerr << "Character " << i << " moved by (" << moved.x() << ", " << moved.z() << ") instead of ("
+                      << expected.x() << ", " << expected.z() << ")." << std::endl;
+            success = false;
+        }
+    }
+
+    // destroyed characters are reused
+    dt::CharacterController* destroyed = crowd.back();
+    pool->destroy(destroyed);
+    crowd.pop_back();
+    dt::CharacterController* reused = pool->create(btTransform::getIdentity());
+    if(reused != destroyed || reused->isEnabled() || !reused->getWalkVelocity().isZero()) {
+        std::cerr << "A destroyed character was not reused properly." << std::endl;
+        success = false;
+    }
+    pool->destroy(reused);
+
+    for(auto iter = crowd.begin(); iter != crowd.end(); ++iter) {
+        pool->destroy(*iter);
+    }
+    if(pool->getActiveCount() != 0) {
+        std::cerr << "Destroyed characters are still active." << std::endl;
+        success = false;
+    }
+
+    bullet_world->removeRigidBody(ground);
+    delete ground->getMotionState();
+    delete ground;
+    delete ground_shape;
+    world.deinitialize();
+    dt::Root::getInstance().deinitialize();
+
+    return success;
+}
+
+QString CharacterControllerTest::getTestName() {
+    return "CharacterController";
+}
+
+}
@@ -0,0 +1,36 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_CHARACTERCONTROLLERTEST
+#define DUCTTAPE_ENGINE_TESTS_CHARACTERCONTROLLERTEST
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Physics/CharacterControllerPool.hpp>
+#include <Physics/PhysicsWorld.hpp>
+
+/**
+  * @file
+  * A headless test for the CharacterControllerPool. A crowd of characters walks in different
+  * directions on a static ground, every one of them has to end up where its own velocity took it.
+  */
+
+namespace CharacterControllerTest {
+
+class CharacterControllerTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+};
+
+} // namespace CharacterControllerTest
+
+#endif
@@ -0,0 +1,246 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "ComponentFactoryTest/ComponentFactoryTest.hpp"
+
+#include <Logic/FollowPathComponent.hpp>
+#include <Logic/TriggerComponent.hpp>
+#include <Network/IOPacket.hpp>
+#include <Scene/ComponentFactory.hpp>
+#include <Scene/Node.hpp>
+#include <Scene/Serializer.hpp>
+#include <Utils/Utils.hpp>
+
+#include <SFML/System/Clock.hpp>
+
+#include <yaml-cpp/yaml.h>
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ComponentFactoryTest {
+
+/**
+  * The number of components created from the pool in each round.
+  */
+static const uint32_t POOL_SIZE = 256;
+
+/**
+  * The number of rounds of creating and destroying components.
+  */
+static const uint32_t ROUNDS = 100;
+
+/**
+  * The classes registered by the engine.
+  */
+static const char* COMPONENT_TYPES[] = {
+    "dt::SoundComponent", "dt::MusicComponent", "dt::BillboardSetComponent", "dt::CameraComponent",
+    "dt::LightComponent", "dt::MeshComponent", "dt::ParticleSystemComponent", "dt::TextComponent",
+    "dt::TriggerComponent", "dt::AdvancedPlayerComponent", "dt::CollisionComponent", "dt::FollowPathComponent",
+    "dt::RaycastComponent", "dt::ScriptComponent", "dt::SimplePlayerComponent", "dt::PhysicsBodyComponent"
+};
+
+bool ComponentFactoryTest::run(int argc, char** argv) {
+    dt::Root& root = dt::Root::getInstance();
+    root.initialize(argc, argv);
+
+    if(!_testRegistry() || !_testUnknownComponent() || !_testUnknownBinaryComponent() || !_testPool())
+        return false;
+
+    root.deinitialize();
+    return true;
+}
+
+QString ComponentFactoryTest::getTestName() {
+    return "ComponentFactory";
+}
+
+bool ComponentFactoryTest::_testRegistry() {
+    for(uint32_t i = 0; i < sizeof(COMPONENT_TYPES) / sizeof(COMPONENT_TYPES[0]); ++i) {
+        const std::string name(COMPONENT_TYPES[i]);
+        int type = dt::Serializer::getComponentType(name);
+        if(type == dt::ComponentFactory::NO_TYPE) {
+            std::cerr << "The component " << name << " is not registered." << std::endl;
+            return false;
+        }
+
+        std::shared_ptr<dt::Component> component = dt::Serializer::createComponent(type);
+        if(component == nullptr || name != component->metaObject()->className()) {
+            std::cerr << "The component " << name << " was not created by its type." << std::endl;
+            return false;
+        }
+        if(dt::Serializer::getComponentFactory().getName(type) != name) {
+            std::cerr << "The type of the component " << name << " has the wrong name." << std::endl;
+            return false;
+        }
+    }
+
+    // these used to end the process
+    if(dt::Serializer::createComponent("dt::MissingComponent") != nullptr
+            || dt::Serializer::createComponent("MeshComponent") != nullptr
+            || dt::Serializer::createComponent(dt::ComponentFactory::NO_TYPE) != nullptr
+            || dt::Serializer::createComponent(1000) != nullptr) {
+        std::cerr << "An unknown component type was created." << std::endl;
+        return false;
+    }
+
+    dt::Logger::get().info("Created " + dt::Utils::toString(sizeof(COMPONENT_TYPES) / sizeof(COMPONENT_TYPES[0]))
+                           + " component types.");
+    return true;
+}
+
+bool ComponentFactoryTest::_testUnknownComponent() {
+    dt::Node node("node");
+    std::shared_ptr<dt::FollowPathComponent> path =
+        node.addComponent(new dt::FollowPathComponent(dt::FollowPathComponent::LOOP, "path"));
+    path->addPoint(0, 0, 0);
+    path->addPoint(1, 2, 3);
+    path->setDuration(4);
+    node.addComponent(new dt::TriggerComponent("trigger"));
+
+    YAML::Emitter emitter;
+    dt::IOPacket packet(&emitter);
+    emitter << YAML::BeginMap;
+    node.serialize(packet);
+    emitter << YAML::EndMap;
+
+    std::string text(emitter.c_str());
+    for(uint32_t pass = 0; pass < 2; ++pass) {
+        // the second pass loads the scene in a game that does not know the FollowPathComponent
+        if(pass == 1)
+            text.replace(text.find("dt::FollowPathComponent"), 23, "dt::MissingComponent");
+
+        std::istringstream input(text);
+        YAML::Parser parser(input);
+        YAML::Node document;
+        if(!parser.GetNextDocument(document)) {
+            std::cerr << "Cannot read the YAML document." << std::endl;
+            return false;
+        }
+
+        dt::IOPacket reader(&document);
+        dt::Node loaded("loaded");
+        loaded.serialize(reader);
+
+        if(loaded.findComponent<dt::TriggerComponent>("trigger") == nullptr) {
+            std::cerr << "The known component was not loaded in pass " << pass << "." << std::endl;
+            return false;
+        }
+
+        std::shared_ptr<dt::FollowPathComponent> loaded_path = loaded.findComponent<dt::FollowPathComponent>("path");
+        if(pass == 0 && (loaded_path == nullptr || loaded_path->getMode() != dt::FollowPathComponent::LOOP
+                         || loaded_path->getTotalLength() != path->getTotalLength())) {
+            std::cerr << "The FollowPathComponent was not loaded." << std::endl;
+            return false;
+        }
+        if(pass == 1 && loaded.hasComponent("path")) {
+            std::cerr << "The unknown component was loaded." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ComponentFactoryTest::_testUnknownBinaryComponent() {
+    dt::Node scene("scene");
+    auto child = scene.addChildNode(new dt::Node("child"));
+    child->addComponent(new dt::FollowPathComponent(dt::FollowPathComponent::LOOP, "path"));
+    child->addComponent(new dt::TriggerComponent("trigger"));
+    child->addChildNode(new dt::Node("grandchild"));
+    scene.addChildNode(new dt::Node("sibling"));
+
+    sf::Packet packet;
+    dt::IOPacket writer(&packet, dt::IOPacket::SERIALIZE);
+    scene.serialize(writer);
+    std::string data(static_cast<const char*>(packet.getData()), packet.getDataSize());
+
+    for(uint32_t pass = 0; pass < 2; ++pass) {
+        // the second pass loads the scene in a game that does not know the FollowPathComponent
+        if(pass == 1)
+            data.replace(data.find("dt::FollowPathComponent"), 23, "dt::MissingComponentXYZ");
+
+        sf::Packet input;
+        input.append(data.data(), data.size());
+        dt::IOPacket reader(&input, dt::IOPacket::DESERIALIZE);
+        dt::Node loaded("loaded");
+        loaded.serialize(reader);
+
+        if(pass == 0 && (reader.hasFailed() || loaded.findChildNode("grandchild") == nullptr
+                         || loaded.findChildNode("sibling") == nullptr)) {
+            std::cerr << "The binary scene was not loaded." << std::endl;
+            return false;
+        }
+        // the fields of the unknown component would be read as the rest of the scene
+        if(pass == 1 && (!reader.hasFailed() || loaded.findChildNode("grandchild") != nullptr
+                         || loaded.findChildNode("sibling") != nullptr)) {
+            std::cerr << "The binary scene was read on after the unknown component." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ComponentFactoryTest::_testPool() {
+    dt::ComponentFactory factory;
+    std::shared_ptr<dt::ComponentPool<dt::TriggerComponent> > pool =
+        factory.registerPooledComponent<dt::TriggerComponent>("dt::TriggerComponent", POOL_SIZE);
+    int type = factory.getType("dt::TriggerComponent");
+
+    sf::Clock clock;
+    for(uint32_t round = 0; round < ROUNDS; ++round) {
+        std::vector<std::shared_ptr<dt::Component> > components;
+        for(uint32_t i = 0; i < POOL_SIZE; ++i) {
+            components.push_back(factory.create(type));
+        }
+        if(std::dynamic_pointer_cast<dt::TriggerComponent>(components.back()) == nullptr) {
+            std::cerr << "The pool created the wrong component." << std::endl;
+            return false;
+        }
+    }
+    double pooled = clock.getElapsedTime().asSeconds();
+
+    if(pool->getAllocationCount() != POOL_SIZE || pool->getSize() != POOL_SIZE) {
+        std::cerr << "The pool allocated " << pool->getAllocationCount() << " blocks and keeps " << pool->getSize()
+                  << ", expected " << POOL_SIZE << "." << std::endl;
+        return false;
+    }
+
+    type = dt::Serializer::getComponentType("dt::TriggerComponent");
+    clock.restart();
+    for(uint32_t round = 0; round < ROUNDS; ++round) {
+        std::vector<std::shared_ptr<dt::Component> > components;
+        for(uint32_t i = 0; i < POOL_SIZE; ++i) {
+            components.push_back(dt::Serializer::createComponent(type));
+        }
+    }
+    double allocated = clock.getElapsedTime().asSeconds();
+
+    dt::Logger::get().info("Created " + dt::Utils::toString(POOL_SIZE * ROUNDS) + " components in "
+                           + dt::Utils::toString(pooled) + "s from the pool and "
+                           + dt::Utils::toString(allocated) + "s with new.");
+
+    // a full pool frees the memory of further components
+    pool->setMaxSize(0);
+    factory.create(type);
+    if(pool->getSize() != POOL_SIZE) {
+        std::cerr << "The full pool kept a block." << std::endl;
+        return false;
+    }
+
+    pool->clear();
+    if(pool->getSize() != 0) {
+        std::cerr << "The pool was not cleared." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace ComponentFactoryTest
@@ -0,0 +1,62 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_COMPONENTFACTORYTEST
+#define DUCTTAPE_ENGINE_TESTS_COMPONENTFACTORYTEST
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+
+/**
+  * @file
+  * A test for the ComponentFactory. It checks that every engine component can be created by the name of its
+  * class, that unknown names give no component instead of ending the process, and that a YAML scene with an
+  * unknown component still loads the others. A binary scene with an unknown component in a nested node has to stop
+  * loading there, as the rest cannot be read. Then a pooled class creates and destroys components a few times,
+  * which has to reuse the memory of the first round.
+  */
+
+namespace ComponentFactoryTest {
+
+class ComponentFactoryTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+
+private:
+    /**
+      * Creates the engine components and unknown ones.
+      * @returns True if the test succeeded.
+      */
+    bool _testRegistry();
+
+    /**
+      * Loads a YAML scene with an unknown component.
+      * @returns True if the test succeeded.
+      */
+    bool _testUnknownComponent();
+
+    /**
+      * Loads a binary scene with an unknown component in a nested node.
+      * @returns True if the test succeeded.
+      */
+    bool _testUnknownBinaryComponent();
+
+    /**
+      * Creates components from a pool.
+      * @returns True if the test succeeded.
+      */
+    bool _testPool();
+};
+
+} // namespace ComponentFactoryTest
+
+#endif
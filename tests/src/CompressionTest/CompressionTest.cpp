@@ -0,0 +1,269 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "CompressionTest/CompressionTest.hpp"
+
+#include <Logic/TriggerComponent.hpp>
+#include <Network/IOPacket.hpp>
+#include <Network/NetworkManager.hpp>
+#include <Scene/Node.hpp>
+#include <Utils/Compressor.hpp>
+#include <Utils/Utils.hpp>
+
+#include <SFML/System/Sleep.hpp>
+
+#include <iostream>
+#include <memory>
+
+namespace CompressionTest {
+
+/**
+  * The number of child nodes of the scene.
+  */
+static const uint32_t NODE_COUNT = 200;
+
+/**
+  * Serializes a node into a vector.
+  */
+static std::vector<char> serializeNode(dt::Node& node) {
+    sf::Packet packet;
+    dt::IOPacket p(&packet, dt::IOPacket::SERIALIZE);
+    node.serialize(p);
+
+    const char* data = static_cast<const char*>(packet.getData());
+    return std::vector<char>(data, data + packet.getDataSize());
+}
+
+/**
+  * Creates a node with a component, as there are many in a scene.
+  */
+static dt::Node* createNode(uint32_t index) {
+    dt::Node* node = new dt::Node("node" + dt::Utils::toString(index));
+    node->addComponent(new dt::TriggerComponent("trigger" + dt::Utils::toString(index)));
+    return node;
+}
+
+bool CompressionTest::run(int argc, char** argv) {
+    dt::Root& root = dt::Root::getInstance();
+    root.initialize(argc, argv);
+
+    if(!_testScene() || !_testNetwork())
+        return false;
+
+    root.deinitialize();
+    return true;
+}
+
+QString CompressionTest::getTestName() {
+    return "Compression";
+}
+
+bool CompressionTest::_testScene() {
+    dt::Node scene("scene");
+    for(uint32_t i = 0; i < NODE_COUNT; ++i) {
+        scene.addChildNode(createNode(i));
+    }
+    std::vector<char> data = serializeNode(scene);
+
+    // the scene is full of repeated type names and UUIDs
+    dt::Compressor compressor;
+    std::vector<char> frame;
+    if(!compressor.compress(&data[0], data.size(), frame) || frame.size() > data.size() / 2) {
+        std::cerr << "The scene of " << data.size() << " bytes was compressed to " << frame.size() << " bytes." << std::endl;
+        return false;
+    }
+
+    std::vector<char> decompressed;
+    if(!compressor.decompress(&frame[0], frame.size(), decompressed) || decompressed != data) {
+        std::cerr << "The scene was not decompressed." << std::endl;
+        return false;
+    }
+
+    sf::Packet packet;
+    packet.append(&decompressed[0], decompressed.size());
+    dt::IOPacket p(&packet, dt::IOPacket::DESERIALIZE);
+    dt::Node loaded("loaded");
+    loaded.serialize(p);
+    if(loaded.findChildNode("node" + dt::Utils::toString(NODE_COUNT - 1)) == nullptr) {
+        std::cerr << "The decompressed scene is missing nodes." << std::endl;
+        return false;
+    }
+
+    std::cout << "Scene: " << data.size() << " bytes, compressed " << frame.size() << " bytes." << std::endl;
+
+    // small data is stored as it is
+    const char small[] = "small";
+    if(compressor.compress(small, sizeof(small), frame) || frame.size() != sizeof(small) + dt::Compressor::FRAME_HEADER_SIZE
+       || !compressor.decompress(&frame[0], frame.size(), decompressed) || decompressed.size() != sizeof(small)) {
+        std::cerr << "The small data was not stored." << std::endl;
+        return false;
+    }
+
+    // a damaged frame is rejected
+    compressor.compress(&data[0], data.size(), frame);
+    frame[frame.size() / 2] ^= 0x5a;
+    if(compressor.decompress(&frame[0], frame.size(), decompressed)) {
+        std::cerr << "A damaged frame was decompressed." << std::endl;
+        return false;
+    }
+
+    std::vector<std::vector<char>> samples;
+    for(uint32_t i = 0; i < 500; ++i) {
+        std::unique_ptr<dt::Node> node(createNode(i));
+        samples.push_back(serializeNode(*node));
+    }
+
+    std::vector<char> dictionary;
+    bool trained = dt::Compressor::trainDictionary(samples, 4096, dictionary);
+    if(trained != dt::Compressor::isSupported(dt::Compressor::ZSTD)) {
+        std::cerr << "A dictionary could only be trained with zstd." << std::endl;
+        return false;
+    }
+    if(!trained)
+        return true;
+
+    // a single node is too small to compress well on its own
+    std::unique_ptr<dt::Node> node(createNode(NODE_COUNT));
+    std::vector<char> single = serializeNode(*node);
+    compressor.setThreshold(0);
+    compressor.compress(&single[0], single.size(), frame);
+    uint32_t without = frame.size();
+
+    if(!compressor.setDictionary(dictionary)) {
+        std::cerr << "The dictionary could not be set." << std::endl;
+        return false;
+    }
+    compressor.compress(&single[0], single.size(), frame);
+    if(frame.size() >= without || frame.size() >= single.size()) {
+        std::cerr << "The node of " << single.size() << " bytes was compressed to " << frame.size() << " bytes with the dictionary, "
+                  << without << " bytes without." << std::endl;
+        return false;
+    }
+
+    dt::Compressor receiver;
+    receiver.setDictionary(dictionary);
+    if(!receiver.decompress(&frame[0], frame.size(), decompressed) || decompressed != single) {
+        std::cerr << "The node was not decompressed with the dictionary." << std::endl;
+        return false;
+    }
+
+    std::cout << "Node: " << single.size() << " bytes, compressed " << without << " bytes, with a dictionary "
+              << frame.size() << " bytes." << std::endl;
+    return true;
+}
+
+bool CompressionTest::_testNetwork() {
+    dt::NetworkManager* nm = dt::NetworkManager::get();
+    nm->registerNetworkEventPrototype(std::make_shared<TextEvent>());
+
+    if(!nm->bindSocket(COMPRESSION_PORT)) {
+        std::cerr << "Could not bind the socket." << std::endl;
+        return false;
+    }
+
+    nm->getCompressor()->setMethod(dt::Compressor::getDefaultMethod());
+    nm->getCompressor()->setThreshold(64);
+    nm->connect(dt::Connection::ConnectionSP(new dt::Connection(sf::IpAddress::LocalHost, COMPRESSION_PORT)));
+
+    // fragmented and compressed, compressed only, too small to compress
+    std::vector<QString> texts;
+    texts.push_back(QString("dt::TriggerComponent ").repeated(1000));
+    texts.push_back(QString("dt::TriggerComponent ").repeated(20));
+    texts.push_back("small");
+
+    uint32_t size = 0;
+    uint64_t sent = nm->getSentBytes();
+    TextEventListener listener;
+    for(auto iter = texts.begin(); iter != texts.end(); ++iter) {
+        nm->queueEvent(std::make_shared<TextEvent>(*iter));
+        size += iter->size();
+    }
+
+    double start = dt::Root::getInstance().getTimeSinceInitialize();
+    while(listener.mTexts.size() < texts.size()) {
+        nm->sendQueuedEvents();
+        nm->handleIncomingEvents();
+        sf::sleep(sf::milliseconds(10));
+
+        if(dt::Root::getInstance().getTimeSinceInitialize() - start > 5.0) {
+            std::cerr << "The events did not arrive, " << listener.mTexts.size() << " of " << texts.size() << " did." << std::endl;
+            return false;
+        }
+    }
+
+    if(listener.mTexts != texts) {
+        std::cerr << "The events arrived damaged." << std::endl;
+        return false;
+    }
+
+    sent = nm->getSentBytes() - sent;
+    if(sent > size / 4) {
+        std::cerr << "Sent " << sent << " bytes for " << size << " bytes of text." << std::endl;
+        return false;
+    }
+
+    // a small compressed event expanding beyond the reassembly limit is dropped
+    nm->getConnectionsManager()->setReassemblyLimits(16 * 1024, 10.0);
+    uint64_t dropped = nm->getDroppedCount();
+    nm->queueEvent(std::make_shared<TextEvent>(QString("dt::TriggerComponent ").repeated(2000)));
+
+    start = dt::Root::getInstance().getTimeSinceInitialize();
+    while(dt::Root::getInstance().getTimeSinceInitialize() - start < 1.0) {
+        nm->sendQueuedEvents();
+        nm->handleIncomingEvents();
+        sf::sleep(sf::milliseconds(10));
+    }
+    nm->getConnectionsManager()->setReassemblyLimits(16 * 1024 * 1024, 10.0);
+
+    if(listener.mTexts.size() != texts.size() || nm->getDroppedCount() == dropped) {
+        std::cerr << "An event larger than the reassembly limit was decompressed." << std::endl;
+        return false;
+    }
+
+    std::cout << "Network: " << size << " bytes of text, sent " << sent << " bytes." << std::endl;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////
+
+TextEvent::TextEvent(const QString& text)
+    : mText(text) {}
+
+const QString TextEvent::getType() const {
+    return "COMPRESSIONTEST_TEXTEVENT";
+}
+
+dt::NetworkEvent::Channel TextEvent::getChannel() const {
+    return RELIABLE_ORDERED;
+}
+
+std::shared_ptr<dt::NetworkEvent> TextEvent::clone() const {
+    std::shared_ptr<dt::NetworkEvent> ptr(new TextEvent(mText));
+    return ptr;
+}
+
+void TextEvent::serialize(dt::IOPacket& p) {
+    p.stream(mText, "text");
+}
+
+////////////////////////////////////////////////////////////////
+
+TextEventListener::TextEventListener() {
+    QObject::connect(dt::NetworkManager::get(), SIGNAL(newEvent(std::shared_ptr<dt::NetworkEvent>)),
+                     this,                      SLOT(_handleEvent(std::shared_ptr<dt::NetworkEvent>)));
+}
+
+void TextEventListener::_handleEvent(std::shared_ptr<dt::NetworkEvent> e) {
+    std::shared_ptr<TextEvent> text = std::dynamic_pointer_cast<TextEvent>(e);
+    if(text == nullptr || !text->isLocalEvent())
+        return;
+
+    mTexts.push_back(text->mText);
+}
+
+} // namespace CompressionTest
@@ -0,0 +1,86 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_COMPRESSIONTEST
+#define DUCTTAPE_ENGINE_TESTS_COMPRESSIONTEST
+
+#define COMPRESSION_PORT 20508
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Network/NetworkEvent.hpp>
+
+#include <QObject>
+#include <QString>
+
+#include <vector>
+
+/**
+  * @file
+  * A test for the Compressor. It compresses a serialized scene, as a save file would, and checks that it gets
+  * smaller and reads back into the same nodes, that small data is stored and damaged frames are rejected. With
+  * zstd, it trains a dictionary on serialized nodes and checks that it makes a single node compress better.
+  * Then the NetworkManager connects to itself over loopback with compression enabled and sends events of
+  * different sizes, which have to arrive intact while sending fewer bytes.
+  */
+
+namespace CompressionTest {
+
+class CompressionTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+
+private:
+    /**
+      * Compresses a serialized scene and single nodes.
+      * @returns True if the test succeeded.
+      */
+    bool _testScene();
+
+    /**
+      * Sends compressed events over loopback.
+      * @returns True if the test succeeded.
+      */
+    bool _testNetwork();
+};
+
+////////////////////////////////////////////////////////////////
+
+class TextEvent : public dt::NetworkEvent {
+public:
+    TextEvent(const QString& text = "");
+    const QString getType() const;
+    Channel getChannel() const;
+    std::shared_ptr<dt::NetworkEvent> clone() const;
+    void serialize(dt::IOPacket& p);
+
+public:
+    QString mText;
+};
+
+////////////////////////////////////////////////////////////////
+
+class TextEventListener : public QObject {
+    Q_OBJECT
+public:
+    TextEventListener();
+
+private slots:
+    void _handleEvent(std::shared_ptr<dt::NetworkEvent> e);
+
+public:
+    std::vector<QString> mTexts;
+};
+
+} // namespace CompressionTest
+
+#endif
@@ -0,0 +1,124 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "CongestionTest/CongestionTest.hpp"
+
+#include <Utils/Utils.hpp>
+
+#include <SFML/Network/Packet.hpp>
+
+namespace CongestionTest {
+
+bool CongestionTest::run(int argc, char** argv) {
+    dt::Root::getInstance().initialize(argc, argv);
+
+    dt::NetworkChannels sender;
+    dt::NetworkChannels receiver;
+    mDatagramCount = 0;
+
+    char message[100] = {0};
+    for(uint32_t i = 0; i < 200; ++i) {
+        sender.queueMessage(dt::NetworkEvent::RELIABLE_ORDERED, message, sizeof(message));
+    }
+    for(uint32_t i = 0; i < 50; ++i) {
+        sender.queueMessage(dt::NetworkEvent::UNRELIABLE, message, sizeof(message), dt::NetworkEvent::LOW);
+    }
+
+    // the first flush only sends what fits into the bucket
+    uint32_t burst = _transfer(sender, receiver, 0.0, 0);
+    if(burst > 4000) {
+        dt::Logger::get().error("The burst was not limited: " + dt::Utils::toString(burst) + " bytes.");
+        return false;
+    }
+    if(sender.getDroppedCount() != 50) {
+        dt::Logger::get().error("Only " + dt::Utils::toString(sender.getDroppedCount())
+                                + " of 50 low-priority messages were dropped under congestion.");
+        return false;
+    }
+
+    // without loss, everything arrives and the rate grows
+    uint32_t initial_rate = sender.getCongestionControl().getRate();
+    double time = 0.0;
+    while(sender.getUnackedCount() > 0 && time < 2.0) {
+        time += 0.01;
+        _transfer(sender, receiver, time, 0);
+    }
+    if(sender.getUnackedCount() > 0) {
+        dt::Logger::get().error(dt::Utils::toString(sender.getUnackedCount()) + " reliable messages were not delivered.");
+        return false;
+    }
+    uint32_t grown_rate = sender.getCongestionControl().getRate();
+    if(grown_rate <= initial_rate) {
+        dt::Logger::get().error("The send rate did not grow: " + dt::Utils::toString(grown_rate) + " bytes/s.");
+        return false;
+    }
+
+    // with every second datagram lost, the rate shrinks
+    for(uint32_t i = 0; i < 400; ++i) {
+        sender.queueMessage(dt::NetworkEvent::RELIABLE_ORDERED, message, sizeof(message));
+    }
+    double end = time + 2.0;
+    while(time < end) {
+        time += 0.01;
+        _transfer(sender, receiver, time, 2);
+    }
+    uint32_t congested_rate = sender.getCongestionControl().getRate();
+    if(congested_rate >= grown_rate / 2) {
+        dt::Logger::get().error("The send rate did not shrink: " + dt::Utils::toString(congested_rate) + " bytes/s.");
+        return false;
+    }
+    if(sender.getStats().getOutgoingLoss() <= 0.f) {
+        dt::Logger::get().error("The loss was not measured.");
+        return false;
+    }
+
+    dt::Logger::get().info("Send rate: " + dt::Utils::toString(initial_rate) + " bytes/s initially, "
+                           + dt::Utils::toString(grown_rate) + " without loss, "
+                           + dt::Utils::toString(congested_rate) + " with loss. " + sender.getStats().toString());
+
+    dt::Root::getInstance().deinitialize();
+    return true;
+}
+
+QString CongestionTest::getTestName() {
+    return "Congestion";
+}
+
+uint32_t CongestionTest::_transfer(dt::NetworkChannels& sender, dt::NetworkChannels& receiver, double time, uint32_t drop_every) {
+    mData.clear();
+    mEnds.clear();
+    sender.writeDatagrams(time, 1200, mData, mEnds);
+
+    uint32_t start = 0;
+    for(auto iter = mEnds.begin(); iter != mEnds.end(); ++iter) {
+        ++mDatagramCount;
+        if(drop_every == 0 || mDatagramCount % drop_every != 0) {
+            sf::Packet packet;
+            packet.append(&mData[start], *iter - start);
+            receiver.readHeader(packet, time);
+        }
+        start = *iter;
+    }
+    uint32_t written = mData.size();
+
+    // the acknowledgements always arrive
+    mData.clear();
+    mEnds.clear();
+    receiver.writeDatagrams(time, 1200, mData, mEnds);
+    start = 0;
+    for(auto iter = mEnds.begin(); iter != mEnds.end(); ++iter) {
+        sf::Packet packet;
+        packet.append(&mData[start], *iter - start);
+        sender.readHeader(packet, time);
+        start = *iter;
+    }
+
+    return written;
+}
+
+} // namespace CongestionTest
@@ -0,0 +1,54 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_CONGESTIONTEST
+#define DUCTTAPE_ENGINE_TESTS_CONGESTIONTEST
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Network/NetworkChannels.hpp>
+#include <Utils/Logger.hpp>
+
+#include <vector>
+
+/**
+  * @file
+  * A test for the congestion control. Two NetworkChannels exchange datagrams directly, without a socket, in
+  * simulated time. It checks that a burst is spread out at the send rate, that low-priority unreliable messages
+  * are dropped first, that the rate grows while everything arrives and that it shrinks when datagrams are lost.
+  */
+
+namespace CongestionTest {
+
+class CongestionTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+
+private:
+    /**
+      * Writes the datagrams of one side and hands them to the other one, which writes its acknowledgements back.
+      * @param sender The sending side.
+      * @param receiver The receiving side.
+      * @param time The simulated time, in seconds.
+      * @param drop_every Drop every n-th datagram of the sender, or 0 to drop none.
+      * @returns The number of bytes the sender wrote.
+      */
+    uint32_t _transfer(dt::NetworkChannels& sender, dt::NetworkChannels& receiver, double time, uint32_t drop_every);
+
+    std::vector<char> mData;        //!< The datagrams written.
+    std::vector<uint32_t> mEnds;    //!< The ends of the datagrams written.
+    uint32_t mDatagramCount;        //!< The number of datagrams the sender wrote so far.
+};
+
+} // namespace CongestionTest
+
+#endif
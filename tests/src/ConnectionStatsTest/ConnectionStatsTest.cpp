@@ -0,0 +1,149 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "ConnectionStatsTest/ConnectionStatsTest.hpp"
+
+#include <Network/ConnectionStats.hpp>
+#include <Network/NetworkManager.hpp>
+#include <Network/PingEvent.hpp>
+#include <Utils/Utils.hpp>
+
+#include <SFML/Network/UdpSocket.hpp>
+#include <SFML/System/Sleep.hpp>
+
+#include <cmath>
+#include <cstdlib>
+
+namespace ConnectionStatsTest {
+
+bool ConnectionStatsTest::run(int argc, char** argv) {
+    dt::Root::getInstance().initialize(argc, argv);
+
+    dt::ConnectionStats stats;
+
+    // loopback round-trip times are well below a millisecond and must not be rounded away
+    for(uint32_t i = 0; i < 50; ++i) {
+        stats.addRoundTripSample(400);
+    }
+    if(std::abs(stats.getRoundTripTime() - 400) > 1 || stats.getJitter() > 1) {
+        dt::Logger::get().error("Constant round-trip times: rtt " + dt::Utils::toString(stats.getRoundTripTime())
+                                + " us, jitter " + dt::Utils::toString(stats.getJitter()) + " us.");
+        return false;
+    }
+
+    // alternating round-trip times average out, but show as jitter
+    for(uint32_t i = 0; i < 200; ++i) {
+        stats.addRoundTripSample(i % 2 == 0 ? 300 : 500);
+    }
+    if(std::abs(stats.getRoundTripTime() - 400) > 30 || stats.getJitter() < 150 || stats.getRoundTripVariance() < 50) {
+        dt::Logger::get().error("Alternating round-trip times: rtt " + dt::Utils::toString(stats.getRoundTripTime())
+                                + " us, variance " + dt::Utils::toString(stats.getRoundTripVariance())
+                                + " us, jitter " + dt::Utils::toString(stats.getJitter()) + " us.");
+        return false;
+    }
+
+    // one second with 40 of 50 datagrams arriving, 100 bytes each way per datagram
+    stats.update(10.0);
+    for(uint32_t i = 0; i < 50; ++i) {
+        stats.addExpected(1);
+        if(i % 5 != 0)
+            stats.addReceived(100);
+        stats.addSent(100);
+    }
+    stats.update(10.5);
+    if(stats.getIncomingBytesPerSecond() != 0.0) {
+        dt::Logger::get().error("The window ended before one second.");
+        return false;
+    }
+    stats.update(11.0);
+
+    if(std::fabs(stats.getLoss() - 0.2f) > 0.001f) {
+        dt::Logger::get().error("Wrong loss: " + dt::Utils::toString(stats.getLoss()));
+        return false;
+    }
+    if(std::fabs(stats.getIncomingBytesPerSecond() - 4000.0) > 0.1 || std::fabs(stats.getOutgoingBytesPerSecond() - 5000.0) > 0.1
+            || std::fabs(stats.getIncomingPacketsPerSecond() - 40.0) > 0.01 || std::fabs(stats.getOutgoingPacketsPerSecond() - 50.0) > 0.01) {
+        dt::Logger::get().error("Wrong rates: " + stats.toString());
+        return false;
+    }
+    if(stats.getReceivedBytes() != 4000 || stats.getSentBytes() != 5000) {
+        dt::Logger::get().error("Wrong totals.");
+        return false;
+    }
+
+    dt::Logger::get().info(stats.toString());
+
+    if(!_testPingReply())
+        return false;
+
+    dt::Root::getInstance().deinitialize();
+    return true;
+}
+
+bool ConnectionStatsTest::_testPingReply() {
+    dt::NetworkManager* nm = dt::NetworkManager::get();
+    if(!nm->bindSocket(CONNECTIONSTATS_PORT)) {
+        dt::Logger::get().error("Cannot bind the socket.");
+        return false;
+    }
+    // no pings of our own while the test runs
+    nm->getConnectionsManager()->setPingInterval(1000.0);
+
+    sf::UdpSocket peers[2];
+    uint16_t ids[2];
+    for(uint32_t i = 0; i < 2; ++i) {
+        if(peers[i].bind(CONNECTIONSTATS_PORT + 1 + i) != sf::Socket::Done) {
+            dt::Logger::get().error("Cannot bind the socket of a peer.");
+            return false;
+        }
+        peers[i].setBlocking(false);
+        dt::Connection::ConnectionSP connection(new dt::Connection(sf::IpAddress::LocalHost, CONNECTIONSTATS_PORT + 1 + i));
+        ids[i] = nm->getConnectionsManager()->addConnection(connection);
+    }
+
+    // as if the first peer sent a ping
+    std::shared_ptr<dt::PingEvent> ping = nm->createEvent<dt::PingEvent>();
+    ping->setTimestamp(1.0);
+    ping->isReply(false);
+    ping->isLocalEvent(true);
+    ping->setSenderID(ids[0]);
+    nm->getConnectionsManager()->handleEvent(ping);
+
+    uint32_t received[2] = {0, 0};
+    for(uint32_t frame = 0; frame < 20; ++frame) {
+        nm->sendQueuedEvents();
+        sf::sleep(sf::milliseconds(10));
+
+        for(uint32_t i = 0; i < 2; ++i) {
+            char data[2048];
+            std::size_t size = 0;
+            sf::IpAddress remote;
+            unsigned short port = 0;
+            while(peers[i].receive(data, sizeof(data), size, remote, port) == sf::Socket::Done) {
+                ++received[i];
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < 2; ++i) {
+        nm->getConnectionsManager()->removeConnection(ids[i]);
+    }
+
+    if(received[0] == 0 || received[1] != 0) {
+        dt::Logger::get().error("The ping reply went to the sender " + dt::Utils::toString(received[0])
+                                + " times and to the other peer " + dt::Utils::toString(received[1]) + " times.");
+        return false;
+    }
+    return true;
+}
+
+QString ConnectionStatsTest::getTestName() {
+    return "ConnectionStats";
+}
+
+} // namespace ConnectionStatsTest
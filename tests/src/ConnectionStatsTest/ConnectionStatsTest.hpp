@@ -0,0 +1,46 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_CONNECTIONSTATSTEST
+#define DUCTTAPE_ENGINE_TESTS_CONNECTIONSTATSTEST
+
+#define CONNECTIONSTATS_PORT 20509
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Utils/Logger.hpp>
+
+/**
+  * @file
+  * A test for the connection statistics. It feeds round-trip times below a millisecond, datagrams with gaps in
+  * their sequence and a known amount of traffic, and checks the smoothed values, the loss and the rates.
+  * Then the NetworkManager gets two peers, and a ping from one of them must only be answered to that one,
+  * as the other would take the echoed timestamp for its own.
+  */
+
+namespace ConnectionStatsTest {
+
+class ConnectionStatsTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+
+private:
+    /**
+      * Checks that a ping is answered to its sender only.
+      * @returns True if the test succeeded.
+      */
+    bool _testPingReply();
+};
+
+} // namespace ConnectionStatsTest
+
+#endif
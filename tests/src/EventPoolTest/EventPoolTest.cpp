@@ -0,0 +1,105 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "EventPoolTest/EventPoolTest.hpp"
+
+#include <Network/NetworkManager.hpp>
+#include <Network/PingEvent.hpp>
+#include <Utils/Utils.hpp>
+
+#include <SFML/System/Clock.hpp>
+
+#include <vector>
+
+namespace EventPoolTest {
+
+bool EventPoolTest::run(int argc, char** argv) {
+    dt::Root& root = dt::Root::getInstance();
+    root.initialize(argc, argv);
+    dt::NetworkManager* nm = root.getNetworkManager();
+
+    std::shared_ptr<dt::PingEvent> first = nm->createEvent<dt::PingEvent>();
+    if(first == nullptr) {
+        dt::Logger::get().error("Could not create a pooled PingEvent.");
+        return false;
+    }
+    dt::NetworkEventPool* pool = nm->getEventPool(first->getTypeId());
+    if(pool == nullptr) {
+        dt::Logger::get().error("The PingEvent has no pool.");
+        return false;
+    }
+
+    // an event in use is not handed out again
+    std::shared_ptr<dt::PingEvent> second = nm->createEvent<dt::PingEvent>();
+    if(second == first) {
+        dt::Logger::get().error("An event in use was handed out again.");
+        return false;
+    }
+
+    // a released event is, and looks like a new one
+    first->setSenderID(5);
+    first->isLocalEvent(true);
+    first->addRecipient(7);
+    dt::PingEvent* released = first.get();
+    first.reset();
+    second.reset();
+    std::shared_ptr<dt::PingEvent> reused = nm->createEvent<dt::PingEvent>();
+    if(reused.get() != released) {
+        dt::Logger::get().error("The released event was not reused.");
+        return false;
+    }
+    if(reused->getSenderID() != 0 || reused->isLocalEvent() || !reused->getRecipients().empty()) {
+        dt::Logger::get().error("The reused event was not reset.");
+        return false;
+    }
+    reused.reset();
+
+    // steady state: create and release events without cloning
+    const uint32_t iterations = 100000;
+    uint64_t allocations = pool->getAllocationCount();
+    sf::Clock clock;
+    for(uint32_t i = 0; i < iterations; ++i) {
+        std::shared_ptr<dt::PingEvent> ping = nm->createEvent<dt::PingEvent>();
+        ping->setTimestamp(i);
+    }
+    double pooled_time = clock.getElapsedTime().asSeconds();
+    if(pool->getAllocationCount() != allocations) {
+        dt::Logger::get().error("The pool cloned " + dt::Utils::toString(pool->getAllocationCount() - allocations)
+                                + " events in the steady state.");
+        return false;
+    }
+
+    clock.restart();
+    for(uint32_t i = 0; i < iterations; ++i) {
+        std::shared_ptr<dt::PingEvent> ping = std::make_shared<dt::PingEvent>(i);
+    }
+    double new_time = clock.getElapsedTime().asSeconds();
+
+    dt::Logger::get().info("Pooled: " + dt::Utils::toString(pooled_time * 1000000.0 / iterations) + " us per event");
+    dt::Logger::get().info("make_shared: " + dt::Utils::toString(new_time * 1000000.0 / iterations) + " us per event");
+
+    // a full pool clones the events it cannot keep
+    pool->setMaxSize(2);
+    std::vector<std::shared_ptr<dt::PingEvent>> held;
+    for(uint32_t i = 0; i < 5; ++i) {
+        held.push_back(nm->createEvent<dt::PingEvent>());
+    }
+    if(pool->getSize() > 2) {
+        dt::Logger::get().error("The pool keeps " + dt::Utils::toString(pool->getSize()) + " events, not more than 2.");
+        return false;
+    }
+
+    root.deinitialize();
+    return true;
+}
+
+QString EventPoolTest::getTestName() {
+    return "EventPool";
+}
+
+} // namespace EventPoolTest
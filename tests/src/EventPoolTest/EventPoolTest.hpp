@@ -0,0 +1,35 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_EVENTPOOLTEST
+#define DUCTTAPE_ENGINE_TESTS_EVENTPOOLTEST
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Utils/Logger.hpp>
+
+/**
+  * @file
+  * A test for the pools of network events. It checks that released events are handed out again, that events
+  * still in use are not, that reused events look like new ones and that a pool does not outgrow its size.
+  */
+
+namespace EventPoolTest {
+
+class EventPoolTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+};
+
+} // namespace EventPoolTest
+
+#endif
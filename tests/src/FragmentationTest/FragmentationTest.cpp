@@ -0,0 +1,239 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "FragmentationTest/FragmentationTest.hpp"
+
+#include <Utils/Utils.hpp>
+
+#include <SFML/System/Sleep.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace FragmentationTest {
+
+bool FragmentationTest::run(int argc, char** argv) {
+    dt::Root& root = dt::Root::getInstance();
+    root.initialize(argc, argv);
+
+    dt::NetworkManager* nm = root.getNetworkManager();
+    nm->registerNetworkEventPrototype(std::make_shared<BlobEvent>());
+
+    if(!nm->bindSocket(FRAGMENTATION_PORT)) {
+        std::cerr << "Could not bind the socket." << std::endl;
+        return false;
+    }
+
+    // use the conditions given with --netsim, if any
+    dt::NetworkSimulator* simulator = nm->getSimulator();
+    if(!simulator->isEnabled()) {
+        dt::NetworkSimulator::Conditions conditions;
+        conditions.mLatency = 0.02;
+        conditions.mPacketLoss = 0.1f;
+
+        simulator->setSeed(11);
+        simulator->setConditions(conditions);
+        simulator->setEnabled(true);
+    }
+
+    // fast enough to finish in a few seconds, but still limited
+    nm->getConnectionsManager()->setSendRateLimits(1000000, 0);
+    nm->connect(dt::Connection::ConnectionSP(new dt::Connection(sf::IpAddress::LocalHost, FRAGMENTATION_PORT)));
+
+    BlobEventListener listener;
+    nm->queueEvent(std::make_shared<BlobEvent>(FRAGMENTATION_BLOB_SIZE));
+    nm->queueEvent(std::make_shared<BlobEvent>(100));
+
+    double start = root.getTimeSinceInitialize();
+    uint64_t max_flush = 0;
+    while(listener.mSizes.size() < 2) {
+        uint64_t sent = nm->getSentBytes();
+        nm->sendQueuedEvents();
+        max_flush = std::max(max_flush, nm->getSentBytes() - sent);
+        nm->handleIncomingEvents();
+        sf::sleep(sf::milliseconds(10));
+
+        if(root.getTimeSinceInitialize() - start > 20.0) {
+            std::cerr << "The events did not arrive, " << listener.mSizes.size() << " of 2 did." << std::endl;
+            return false;
+        }
+    }
+
+    if(listener.mSizes[0] != FRAGMENTATION_BLOB_SIZE || listener.mSizes[1] != 100) {
+        std::cerr << "The events arrived out of order." << std::endl;
+        return false;
+    }
+    if(!listener.mIsIntact) {
+        std::cerr << "The data of an event was damaged." << std::endl;
+        return false;
+    }
+    if(max_flush > FRAGMENTATION_BLOB_SIZE / 4) {
+        std::cerr << "A single flush sent " << max_flush << " bytes." << std::endl;
+        return false;
+    }
+
+    dt::ConnectionsManager::ID_t id = nm->getConnectionsManager()->findConnectionID(sf::IpAddress::LocalHost, FRAGMENTATION_PORT);
+    dt::NetworkChannels* channels = nm->getConnectionsManager()->getChannels(id);
+    if(channels->getReassemblyBytes() != 0) {
+        std::cerr << channels->getReassemblyBytes() << " bytes were left in the reassembly buffers." << std::endl;
+        return false;
+    }
+
+    std::cout << "Transferred " << FRAGMENTATION_BLOB_SIZE << " bytes in " << root.getTimeSinceInitialize() - start
+              << "s, at most " << max_flush << " bytes per flush, " << channels->getResentCount() << " fragments resent." << std::endl;
+
+    if(!_testReassembly())
+        return false;
+
+    root.deinitialize();
+    return true;
+}
+
+QString FragmentationTest::getTestName() {
+    return "Fragmentation";
+}
+
+bool FragmentationTest::_testReassembly() {
+    dt::NetworkChannels channels;
+    channels.setReassemblyLimits(4096, 1.0);
+
+    // the fragments may arrive in any order
+    const char* parts[] = {"frag", "ment", "ed"};
+    uint16_t order[] = {2, 0, 1};
+    const std::vector<char>* message = nullptr;
+    for(uint32_t i = 0; i < 3; ++i) {
+        std::string data(parts[order[i]]);
+        message = channels.receiveFragment(dt::NetworkEvent::UNRELIABLE, 0, 1, order[i], 3, data, 0.0);
+        if(message != nullptr && i < 2) {
+            std::cerr << "An incomplete message was returned." << std::endl;
+            return false;
+        }
+    }
+    if(message == nullptr || std::string(message->begin(), message->end()) != "fragmented") {
+        std::cerr << "The message was not reassembled." << std::endl;
+        return false;
+    }
+
+    // a message larger than the memory cap is discarded once it exceeds it
+    for(uint16_t i = 0; i < 4; ++i) {
+        std::string data(1024, 'x');
+        channels.receiveFragment(dt::NetworkEvent::UNRELIABLE, 0, 2, i, 5, data, 0.0);
+    }
+    if(channels.getDiscardedCount() != 1 || channels.getReassemblyBytes() != 0) {
+        std::cerr << "The memory cap was not kept: " << channels.getReassemblyBytes() << " bytes buffered." << std::endl;
+        return false;
+    }
+
+    // an incomplete message is discarded after the timeout
+    std::string data(100, 'y');
+    channels.receiveFragment(dt::NetworkEvent::UNRELIABLE, 0, 3, 0, 2, data, 0.0);
+    std::vector<char> datagrams;
+    std::vector<uint32_t> ends;
+    channels.writeDatagrams(0.5, 1200, datagrams, ends);
+    if(channels.getDiscardedCount() != 1) {
+        std::cerr << "An incomplete message was discarded before the timeout." << std::endl;
+        return false;
+    }
+    channels.writeDatagrams(2.0, 1200, datagrams, ends);
+    if(channels.getDiscardedCount() != 2 || channels.getReassemblyBytes() != 0) {
+        std::cerr << "The incomplete messages did not time out." << std::endl;
+        return false;
+    }
+    return _testForgedFragments();
+}
+
+bool FragmentationTest::_testForgedFragments() {
+    dt::NetworkChannels channels;
+    channels.setReassemblyLimits(1024 * 1024, 10.0);
+
+    // a single byte claiming to be the first of the most fragments possible
+    std::string data("x");
+    channels.receiveFragment(dt::NetworkEvent::UNRELIABLE, 0, 0, 0, 65535, data, 0.0);
+    if(channels.getReassemblyCount() != 0 || channels.getReassemblyBytes() != 0 || channels.getDiscardedCount() != 1) {
+        std::cerr << "A message of more fragments than the memory cap holds was accepted." << std::endl;
+        return false;
+    }
+
+    // one byte for each message number, with as many fragments as the cap allows
+    for(uint32_t group = 0; group <= 0xffff; ++group) {
+        std::string data("x");
+        channels.receiveFragment(dt::NetworkEvent::UNRELIABLE, 0, group, 0, 1025, data, 0.0);
+        if(channels.getReassemblyBytes() > 1024 * 1024) {
+            std::cerr << "The bookkeeping of " << channels.getReassemblyCount() << " messages exceeded the memory cap: "
+                      << channels.getReassemblyBytes() << " bytes." << std::endl;
+            return false;
+        }
+    }
+    if(channels.getReassemblyCount() > 64) {
+        std::cerr << "The number of messages being reassembled is not limited: " << channels.getReassemblyCount()
+                  << " messages." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////
+
+/**
+  * Returns the byte at an offset of the pattern the events are filled with.
+  */
+static char patternAt(uint32_t offset) {
+    return static_cast<char>((offset * 31) % 251);
+}
+
+BlobEvent::BlobEvent(uint32_t size)
+    : mData(size) {
+    for(uint32_t i = 0; i < size; ++i) {
+        mData[i] = patternAt(i);
+    }
+}
+
+const QString BlobEvent::getType() const {
+    return "FRAGMENTATIONTEST_BLOBEVENT";
+}
+
+dt::NetworkEvent::Channel BlobEvent::getChannel() const {
+    return RELIABLE_ORDERED;
+}
+
+std::shared_ptr<dt::NetworkEvent> BlobEvent::clone() const {
+    std::shared_ptr<dt::NetworkEvent> ptr(new BlobEvent());
+    return ptr;
+}
+
+void BlobEvent::serialize(dt::IOPacket& p) {
+    p.stream(mData, "data");
+}
+
+bool BlobEvent::isIntact() const {
+    for(uint32_t i = 0; i < mData.size(); ++i) {
+        if(mData[i] != patternAt(i))
+            return false;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////
+
+BlobEventListener::BlobEventListener()
+    : mIsIntact(true) {
+    QObject::connect(dt::NetworkManager::get(), SIGNAL(newEvent(std::shared_ptr<dt::NetworkEvent>)),
+                     this,                      SLOT(_handleEvent(std::shared_ptr<dt::NetworkEvent>)));
+}
+
+void BlobEventListener::_handleEvent(std::shared_ptr<dt::NetworkEvent> e) {
+    std::shared_ptr<BlobEvent> blob = std::dynamic_pointer_cast<BlobEvent>(e);
+    if(blob == nullptr || !blob->isLocalEvent())
+        return;
+
+    mSizes.push_back(blob->mData.size());
+    mIsIntact = mIsIntact && blob->isIntact();
+}
+
+} // namespace FragmentationTest
@@ -0,0 +1,95 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_FRAGMENTATIONTEST
+#define DUCTTAPE_ENGINE_TESTS_FRAGMENTATIONTEST
+
+#define FRAGMENTATION_PORT 20507
+#define FRAGMENTATION_BLOB_SIZE 1000000
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Network/NetworkChannels.hpp>
+#include <Network/NetworkManager.hpp>
+
+#include <QObject>
+
+#include <vector>
+
+/**
+  * @file
+  * A test for the fragmentation of large messages. The NetworkManager connects to itself over loopback,
+  * losing some datagrams, and sends an event of a megabyte followed by a small one on the reliable-ordered
+  * channel. The test checks that both arrive intact and in order, and that the large one is spread over many
+  * flushes instead of being sent at once. Then it feeds fragments to a NetworkChannels directly and checks
+  * that they are reassembled in any order, and that incomplete messages are discarded when they exceed the
+  * memory cap or time out. Forged fragment headers claiming many fragments for every message number must
+  * not make the buffers grow beyond the cap.
+  */
+
+namespace FragmentationTest {
+
+class FragmentationTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+
+private:
+    /**
+      * Checks the reassembly limits of a NetworkChannels without a connection.
+      * @returns True if the test succeeded.
+      */
+    bool _testReassembly();
+
+    /**
+      * Feeds forged fragment headers to a NetworkChannels.
+      * @returns True if the test succeeded.
+      */
+    bool _testForgedFragments();
+};
+
+////////////////////////////////////////////////////////////////
+
+class BlobEvent : public dt::NetworkEvent {
+public:
+    BlobEvent(uint32_t size = 0);
+    const QString getType() const;
+    Channel getChannel() const;
+    std::shared_ptr<dt::NetworkEvent> clone() const;
+    void serialize(dt::IOPacket& p);
+
+    /**
+      * Returns whether the data holds the pattern it was created with.
+      */
+    bool isIntact() const;
+
+public:
+    std::vector<char> mData;
+};
+
+////////////////////////////////////////////////////////////////
+
+class BlobEventListener : public QObject {
+    Q_OBJECT
+public:
+    BlobEventListener();
+
+private slots:
+    void _handleEvent(std::shared_ptr<dt::NetworkEvent> e);
+
+public:
+    std::vector<uint32_t> mSizes;
+    bool mIsIntact;
+};
+
+} // namespace FragmentationTest
+
+#endif
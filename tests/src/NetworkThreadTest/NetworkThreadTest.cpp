@@ -0,0 +1,144 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "NetworkThreadTest/NetworkThreadTest.hpp"
+
+#include <Utils/Utils.hpp>
+
+#include <SFML/System/Sleep.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+namespace NetworkThreadTest {
+
+bool NetworkThreadTest::run(int argc, char** argv) {
+    dt::Root& root = dt::Root::getInstance();
+    root.initialize(argc, argv);
+
+    dt::NetworkManager* nm = root.getNetworkManager();
+    nm->registerNetworkEventPrototype(std::make_shared<NumberEvent>(0));
+
+    if(!nm->bindSocket(NETWORKTHREAD_PORT)) {
+        std::cerr << "Could not bind the socket." << std::endl;
+        return false;
+    }
+    nm->setThreaded(true);
+    if(!nm->isThreaded()) {
+        std::cerr << "The network thread did not start." << std::endl;
+        return false;
+    }
+
+    // talk to ourselves, the connection is both sender and receiver
+    nm->connect(dt::Connection::ConnectionSP(new dt::Connection(sf::IpAddress::LocalHost, NETWORKTHREAD_PORT)));
+
+    NumberEventListener listener;
+    for(uint32_t i = 0; i < NETWORKTHREAD_EVENT_COUNT; ++i) {
+        nm->queueEvent(std::make_shared<NumberEvent>(i));
+    }
+
+    double start = root.getTimeSinceInitialize();
+    while(listener.mNumbers.size() < NETWORKTHREAD_EVENT_COUNT) {
+        nm->sendQueuedEvents();
+        // a slow frame, the datagrams arrive meanwhile
+        sf::sleep(sf::milliseconds(50));
+        nm->handleIncomingEvents();
+
+        if(root.getTimeSinceInitialize() - start > 5.0) {
+            std::cerr << "Only " << listener.mNumbers.size() << " events arrived." << std::endl;
+            return false;
+        }
+    }
+
+    for(uint32_t i = 0; i < NETWORKTHREAD_EVENT_COUNT; ++i) {
+        if(listener.mNumbers[i] != i) {
+            std::cerr << "Event " << listener.mNumbers[i] << " arrived at position " << i << "." << std::endl;
+            return false;
+        }
+    }
+
+    double min_delay = *std::min_element(listener.mDelays.begin(), listener.mDelays.end());
+    double max_delay = *std::max_element(listener.mDelays.begin(), listener.mDelays.end());
+    if(min_delay < 0.0) {
+        std::cerr << "An event was timestamped after it was handled." << std::endl;
+        return false;
+    }
+    if(max_delay < 0.01) {
+        std::cerr << "The events were timestamped when they were handled, not when they arrived." << std::endl;
+        return false;
+    }
+
+    std::cout << "Time between arrival and handling: " << min_delay << "s to " << max_delay << "s" << std::endl;
+
+    // what the thread received but was not handled yet is handled after it stopped
+    nm->queueEvent(std::make_shared<NumberEvent>(NETWORKTHREAD_EVENT_COUNT));
+    nm->sendQueuedEvents();
+    sf::sleep(sf::milliseconds(50));
+
+    nm->setThreaded(false);
+    if(nm->isThreaded()) {
+        std::cerr << "The network thread did not stop." << std::endl;
+        return false;
+    }
+    if(listener.mNumbers.size() != NETWORKTHREAD_EVENT_COUNT) {
+        std::cerr << "Events were handled while the thread stopped." << std::endl;
+        return false;
+    }
+    nm->handleIncomingEvents();
+    if(listener.mNumbers.size() != NETWORKTHREAD_EVENT_COUNT + 1) {
+        std::cerr << "The datagrams received by the thread were lost when it stopped." << std::endl;
+        return false;
+    }
+
+    root.deinitialize();
+    return true;
+}
+
+QString NetworkThreadTest::getTestName() {
+    return "NetworkThread";
+}
+
+////////////////////////////////////////////////////////////////
+
+NumberEvent::NumberEvent(uint32_t number)
+    : mNumber(number) {}
+
+const QString NumberEvent::getType() const {
+    return "NETWORKTHREADTEST_NUMBEREVENT";
+}
+
+dt::NetworkEvent::Channel NumberEvent::getChannel() const {
+    return RELIABLE_ORDERED;
+}
+
+std::shared_ptr<dt::NetworkEvent> NumberEvent::clone() const {
+    std::shared_ptr<dt::NetworkEvent> ptr(new NumberEvent(mNumber));
+    return ptr;
+}
+
+void NumberEvent::serialize(dt::IOPacket& p) {
+    p.stream(mNumber, "number");
+}
+
+////////////////////////////////////////////////////////////////
+
+NumberEventListener::NumberEventListener() {
+    QObject::connect(dt::NetworkManager::get(), SIGNAL(newEvent(std::shared_ptr<dt::NetworkEvent>)),
+                     this,                      SLOT(_handleEvent(std::shared_ptr<dt::NetworkEvent>)));
+}
+
+void NumberEventListener::_handleEvent(std::shared_ptr<dt::NetworkEvent> e) {
+    std::shared_ptr<NumberEvent> n = std::dynamic_pointer_cast<NumberEvent>(e);
+    if(n == nullptr || !n->isLocalEvent())
+        return;
+
+    mNumbers.push_back(n->mNumber);
+    mDelays.push_back(dt::Root::getInstance().getTimeSinceInitialize() - n->getReceiveTime());
+}
+
+} // namespace NetworkThreadTest
@@ -0,0 +1,73 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_NETWORKTHREADTEST
+#define DUCTTAPE_ENGINE_TESTS_NETWORKTHREADTEST
+
+#define NETWORKTHREAD_PORT 20505
+#define NETWORKTHREAD_EVENT_COUNT 50
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Network/NetworkManager.hpp>
+
+#include <QObject>
+
+#include <vector>
+
+/**
+  * @file
+  * A test for the network thread. The NetworkManager connects to itself over loopback with the network
+  * thread running and sends numbered reliable-ordered events, while the main loop takes 50 ms per frame.
+  * It checks that all events arrive in order, and that their receive times were taken when they arrived
+  * during the frame, not when the frame handled them.
+  */
+
+namespace NetworkThreadTest {
+
+class NetworkThreadTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+};
+
+////////////////////////////////////////////////////////////////
+
+class NumberEvent : public dt::NetworkEvent {
+public:
+    NumberEvent(uint32_t number);
+    const QString getType() const;
+    Channel getChannel() const;
+    std::shared_ptr<dt::NetworkEvent> clone() const;
+    void serialize(dt::IOPacket& p);
+
+public:
+    uint32_t mNumber;
+};
+
+////////////////////////////////////////////////////////////////
+
+class NumberEventListener : public QObject {
+    Q_OBJECT
+public:
+    NumberEventListener();
+
+private slots:
+    void _handleEvent(std::shared_ptr<dt::NetworkEvent> e);
+
+public:
+    std::vector<uint32_t> mNumbers;         //!< The numbers received, in the order of handling.
+    std::vector<double> mDelays;            //!< The times between arrival and handling of the events.
+};
+
+} // namespace NetworkThreadTest
+
+#endif
@@ -0,0 +1,115 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "PhysicsRestingTest/PhysicsRestingTest.hpp"
+
+#include <Scene/StateManager.hpp>
+#include <Core/ResourceManager.hpp>
+#include <Graphics/CameraComponent.hpp>
+
+namespace PhysicsRestingTest {
+
+bool PhysicsRestingTest::run(int argc, char** argv) {
+    dt::Game game;
+    game.run(new Main(), argc, argv);
+    return true;
+}
+
+QString PhysicsRestingTest::getTestName() {
+    return "PhysicsResting";
+}
+
+////////////////////////////////////////////////////////////////
+
+Main::Main()
+    : mRuntime(0),
+      mIsChildSleeping(false),
+      mIsChildMoved(false) {}
+
+void Main::updateStateFrame(double simulation_frame_time) {
+    mRuntime += simulation_frame_time;
+
+    auto testscene = getScene("testscene");
+    auto parentnode = testscene->findChildNode("parentnode");
+    auto childnode = parentnode->findChildNode("childnode", false);
+    btRigidBody* body = childnode->findComponent<dt::PhysicsBodyComponent>("child-body")->getRigidBody();
+
+    if(!mIsChildSleeping) {
+        body->setActivationState(ISLAND_SLEEPING);
+        mChildTransform = body->getWorldTransform();
+        mIsChildSleeping = true;
+    } else if(!mIsChildMoved) {
+        if(body->isActive()) {
+            std::cerr << "The child body woke up while only its parent node moved." << std::endl;
+            exit(1);
+        }
+        if(body->getWorldTransform().getOrigin() != mChildTransform.getOrigin()
+           || body->getWorldTransform().getRotation() != mChildTransform.getRotation()) {
+            std::cerr << "The child body moved while only its parent node moved." << std::endl;
+            exit(1);
+        }
+        if(!childnode->getPosition(dt::Node::SCENE).positionEquals(BtOgre::Convert::toOgre(mChildTransform.getOrigin()), 0.01)) {
+            std::cerr << "The child node did not move back to its sleeping body." << std::endl;
+            exit(1);
+        }
+    }
+
+    if(mRuntime < 2.0) {
+        // move the parent around, the child body should not notice
+        parentnode->setPosition(Ogre::Vector3(Ogre::Math::Sin(mRuntime * 4) * 5, 0, 0));
+    } else if(!mIsChildMoved) {
+        // moving the child node itself moves the body along with it
+        childnode->setPosition(Ogre::Vector3(0, 5, 0), dt::Node::SCENE);
+        mIsChildMoved = true;
+
+        if(!BtOgre::Convert::toOgre(body->getWorldTransform().getOrigin()).positionEquals(Ogre::Vector3(0, 5, 0), 0.01)) {
+            std::cerr << "The child body did not follow its node." << std::endl;
+            exit(1);
+        }
+        if(!body->isActive()) {
+            std::cerr << "The child body was not woken up after its node was moved." << std::endl;
+            exit(1);
+        }
+    }
+
+    if(mRuntime > 3.0) {
+        dt::StateManager::get()->pop(1);
+    }
+}
+
+void Main::onInitialize() {
+    auto scene = addScene(new dt::Scene("testscene"));
+
+    dt::ResourceManager::get()->addResourceLocation("","FileSystem");
+    dt::ResourceManager::get()->addResourceLocation("crate","FileSystem");
+    Ogre::ResourceGroupManager::getSingleton().initialiseAllResourceGroups();
+
+    OgreProcedural::Root::getInstance()->sceneManager = scene->getSceneManager();
+
+    OgreProcedural::SphereGenerator().setRadius(1.f).setUTile(.5f).realizeMesh("Sphere");
+
+    Ogre::ResourceGroupManager::getSingleton().initialiseAllResourceGroups();
+
+    auto camnode = scene->addChildNode(new dt::Node("camnode"));
+    camnode->setPosition(Ogre::Vector3(0, 5, 30));
+    camnode->addComponent(new dt::CameraComponent("cam"))->lookAt(Ogre::Vector3(0, 0, 0));
+
+    auto parentnode = scene->addChildNode(new dt::Node("parentnode"));
+    parentnode->setPosition(Ogre::Vector3(0, 0, 0));
+
+    auto childnode = parentnode->addChildNode(new dt::Node("childnode"));
+    childnode->setPosition(Ogre::Vector3(10, 0, 0));
+    childnode->addComponent(new dt::MeshComponent("Sphere", "PrimitivesTest/RedBrick", "child-mesh"));
+    childnode->addComponent(new dt::PhysicsBodyComponent("child-mesh", "child-body"));
+
+    auto lightnode1 = scene->addChildNode(new dt::Node("lightnode1"));
+    lightnode1->addComponent(new dt::LightComponent("light1"));
+    lightnode1->setPosition(Ogre::Vector3(15, 5, 15));
+}
+
+}
@@ -0,0 +1,160 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "PhysicsSnapshotTest/PhysicsSnapshotTest.hpp"
+
+#include <cstring>
+#include <iostream>
+
+namespace PhysicsSnapshotTest {
+
+// compare x, y and z only, the fourth component of a btVector3 is unused padding
+static bool equalBits(const btVector3& a, const btVector3& b) {
+    return memcmp(a.m_floats, b.m_floats, 3 * sizeof(btScalar)) == 0;
+}
+
+static bool equalBits(const btTransform& a, const btTransform& b) {
+    return equalBits(a.getOrigin(), b.getOrigin())
+        && equalBits(a.getBasis()[0], b.getBasis()[0])
+        && equalBits(a.getBasis()[1], b.getBasis()[1])
+        && equalBits(a.getBasis()[2], b.getBasis()[2]);
+}
+
+bool PhysicsSnapshotTest::run(int argc, char** argv) {
+    dt::Root::getInstance().initialize(argc, argv);
+
+    // no scene -> no debug drawer, no display required
+    dt::PhysicsWorld world("snapshot-world", nullptr);
+    world.initialize();
+    btDiscreteDynamicsWorld* bullet_world = world.getBulletWorld();
+
+    // static ground
+    btCollisionShape* ground_shape = new btBoxShape(btVector3(50, 1, 50));
+    mShapes.push_back(ground_shape);
+    btRigidBody* ground = new btRigidBody(0, new btDefaultMotionState(btTransform(btQuaternion::getIdentity(), btVector3(0, -1, 0))),
+                                          ground_shape);
+    bullet_world->addRigidBody(ground);
+    mBodies.push_back(ground);
+
+    // a tumbling pile of boxes
+    btCollisionShape* box_shape = new btBoxShape(btVector3(0.5, 0.5, 0.5));
+    mShapes.push_back(box_shape);
+    btVector3 inertia;
+    box_shape->calculateLocalInertia(1, inertia);
+    for(int i = 0; i < 20; ++i) {
+        btTransform transform(btQuaternion(btVector3(1, 1, 0).normalized(), i * 0.3f), btVector3((i % 4) * 0.6f, 2 + i * 1.1f, (i % 3) * 0.4f));
+        btRigidBody* body = new btRigidBody(1, new btDefaultMotionState(transform), box_shape, inertia);
+        body->setAngularVelocity(btVector3(0, i * 0.1f, 0));
+        bullet_world->addRigidBody(body);
+        mBodies.push_back(body);
+    }
+
+    // a pendulum, to have a constraint in the world
+    btRigidBody* pendulum = mBodies.back();
+    btPoint2PointConstraint* constraint = new btPoint2PointConstraint(*pendulum, btVector3(0, 3, 0));
+    bullet_world->addConstraint(constraint);
+
+    dt::PhysicsSnapshot snapshot;
+    dt::PhysicsSnapshot result1;
+    dt::PhysicsSnapshot result2;
+    snapshot.reserve(mBodies.size(), 1);
+    result1.reserve(mBodies.size(), 1);
+    result2.reserve(mBodies.size(), 1);
+
+    // let the boxes fall and collide, then take the snapshot in the middle of the action
+    for(int i = 0; i < 50; ++i)
+        world.stepSimulation(0.02);
+    world.saveSnapshot(snapshot);
+
+    bool success = true;
+
+    // run 1
+    world.restoreSnapshot(snapshot);
+    world.saveSnapshot(result1);
+    const dt::PhysicsSnapshot::BodyState* buffer = &result1.getBodyState(0);
+    for(int i = 0; i < 100; ++i) {
+        world.stepSimulation(0.02);
+        // this must not reallocate
+        world.saveSnapshot(result1);
+    }
+    if(buffer != &result1.getBodyState(0)) {
+        std::cerr << "Saving a snapshot reallocated the preallocated buffer." << std::endl;
+        success = false;
+    }
+
+    // the world has to be back at the snapshot after a restore
+    world.restoreSnapshot(snapshot);
+    for(uint32_t i = 0; i < mBodies.size(); ++i) {
+        if(!equalBits(mBodies[i]->getWorldTransform(), snapshot.getBodyState(i).mWorldTransform)) {
+            std::cerr << "Body " << i << " was not restored to the snapshot transform." << std::endl;
+            success = false;
+        }
+    }
+
+    // run 2
+    for(int i = 0; i < 100; ++i)
+        world.stepSimulation(0.02);
+    world.saveSnapshot(result2);
+
+    if(!_compare(result1, result2)) {
+        std::cerr << "Re-simulating from the same snapshot is not deterministic." << std::endl;
+        success = false;
+    }
+
+    // clean up
+    bullet_world->removeConstraint(constraint);
+    delete constraint;
+    for(auto iter = mBodies.begin(); iter != mBodies.end(); ++iter) {
+        bullet_world->removeRigidBody(*iter);
+        delete (*iter)->getMotionState();
+        delete *iter;
+    }
+    for(auto iter = mShapes.begin(); iter != mShapes.end(); ++iter) {
+        delete *iter;
+    }
+    world.deinitialize();
+    dt::Root::getInstance().deinitialize();
+
+    return success;
+}
+
+bool PhysicsSnapshotTest::_compare(const dt::PhysicsSnapshot& a, const dt::PhysicsSnapshot& b) {
+    if(a.getBodyCount() != b.getBodyCount() || a.getConstraintCount() != b.getConstraintCount())
+        return false;
+
+    for(uint32_t i = 0; i < a.getBodyCount(); ++i) {
+        const dt::PhysicsSnapshot::BodyState& sa = a.getBodyState(i);
+        const dt::PhysicsSnapshot::BodyState& sb = b.getBodyState(i);
+
+        if(!equalBits(sa.mWorldTransform, sb.mWorldTransform)
+                || !equalBits(sa.mInterpolationWorldTransform, sb.mInterpolationWorldTransform)
+                || !equalBits(sa.mLinearVelocity, sb.mLinearVelocity)
+                || !equalBits(sa.mAngularVelocity, sb.mAngularVelocity)
+                || sa.mActivationState != sb.mActivationState
+                || memcmp(&sa.mDeactivationTime, &sb.mDeactivationTime, sizeof(btScalar)) != 0) {
+            std::cerr << "Body " << i << " differs." << std::endl;
+            return false;
+        }
+    }
+
+    for(uint32_t i = 0; i < a.getConstraintCount(); ++i) {
+        btScalar ia = a.getConstraintImpulse(i);
+        btScalar ib = b.getConstraintImpulse(i);
+        if(memcmp(&ia, &ib, sizeof(btScalar)) != 0) {
+            std::cerr << "Constraint " << i << " differs." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+QString PhysicsSnapshotTest::getTestName() {
+    return "PhysicsSnapshot";
+}
+
+}
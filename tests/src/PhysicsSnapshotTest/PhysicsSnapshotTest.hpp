@@ -0,0 +1,50 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_PHYSICSSNAPSHOTTEST
+#define DUCTTAPE_ENGINE_TESTS_PHYSICSSNAPSHOTTEST
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Physics/PhysicsSnapshot.hpp>
+#include <Physics/PhysicsWorld.hpp>
+
+#include <vector>
+
+/**
+  * @file
+  * A headless test for PhysicsWorld snapshots. A small world is stepped, saved, and then re-simulated
+  * twice from the same snapshot. Both runs have to end in bitwise identical states.
+  */
+
+namespace PhysicsSnapshotTest {
+
+class PhysicsSnapshotTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+
+private:
+    /**
+      * Compares two snapshots bit by bit.
+      * @param a The first snapshot.
+      * @param b The second snapshot.
+      * @returns Whether both snapshots contain the same bits.
+      */
+    bool _compare(const dt::PhysicsSnapshot& a, const dt::PhysicsSnapshot& b);
+
+    std::vector<btRigidBody*> mBodies;
+    std::vector<btCollisionShape*> mShapes;
+};
+
+} // namespace PhysicsSnapshotTest
+
+#endif
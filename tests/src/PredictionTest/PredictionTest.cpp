@@ -0,0 +1,246 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "PredictionTest/PredictionTest.hpp"
+
+#include <Network/ClientPrediction.hpp>
+#include <Network/NetworkManager.hpp>
+
+#include <SFML/System/Sleep.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace PredictionTest {
+
+/**
+  * The length of a fixed step, in seconds.
+  */
+static const double STEP = 0.02;
+
+/**
+  * The speed of the player and the other moving node, in units per second.
+  */
+static const float SPEED = 2.f;
+
+/**
+  * Moves a node along the x axis. Client and server step the player with this.
+  */
+static void move(dt::Node* node, const float& input, double time_diff) {
+    node->setPosition(node->getPosition(dt::Node::SCENE) + Ogre::Vector3(input * SPEED * time_diff, 0, 0), dt::Node::SCENE);
+}
+
+/**
+  * Runs one fixed step of both sides: the server sends its snapshots, the events are exchanged, and
+  * the client moves the interpolated nodes and reconciles its player.
+  */
+static void tick(dt::NodeReplicator& server, dt::NodeReplicator& client, dt::ClientPrediction<float>& prediction,
+                 dt::Node* player) {
+    server.update(STEP);
+    dt::NetworkManager::get()->sendQueuedEvents();
+    dt::NetworkManager::get()->handleIncomingEvents();
+
+    client.interpolate(STEP);
+    Ogre::Vector3 position;
+    Ogre::Quaternion rotation;
+    if(client.getReceivedTransform(player, position, rotation))
+        prediction.reconcile(player, client.getProcessedInput(), position, rotation);
+
+    sf::sleep(sf::milliseconds(20));
+}
+
+bool PredictionTest::run(int argc, char** argv) {
+    dt::Root& root = dt::Root::getInstance();
+    root.initialize(argc, argv);
+
+    dt::NetworkManager* nm = root.getNetworkManager();
+    nm->registerNetworkEventPrototype(std::make_shared<InputEvent>());
+
+    if(!nm->bindSocket(PREDICTION_PORT)) {
+        std::cerr << "Could not bind the socket." << std::endl;
+        return false;
+    }
+
+    // use the conditions given with --netsim, if any
+    dt::NetworkSimulator* simulator = nm->getSimulator();
+    if(!simulator->isEnabled()) {
+        dt::NetworkSimulator::Conditions conditions;
+        conditions.mLatency = 0.05;
+        conditions.mJitter = 0.01;
+        conditions.mPacketLoss = 0.05f;
+
+        simulator->setSeed(3);
+        simulator->setConditions(conditions);
+        simulator->setEnabled(true);
+    }
+
+    // there is only one Root, so the server and the client side share the NetworkManager and a
+    // connection to itself
+    nm->connect(dt::Connection::ConnectionSP(new dt::Connection(sf::IpAddress::LocalHost, PREDICTION_PORT)));
+    dt::ConnectionsManager::ID_t connection = nm->getConnectionsManager()->findConnectionID(sf::IpAddress::LocalHost, PREDICTION_PORT);
+
+    dt::Node::NodeSP server_root(new dt::Node("PredictionServer"));
+    dt::Node* server_player = server_root->addChildNode(new dt::Node("Player")).get();
+    dt::Node* mover = server_root->addChildNode(new dt::Node("Mover")).get();
+
+    // the default position bounds, the received positions are off by up to half a step
+    dt::NodeReplicator server;
+    server.addNode(server_player);
+    uint16_t mover_id = server.addNode(mover);
+    server.addClient(connection, server_player);
+    InputListener listener(&server, server_player);
+
+    dt::Node::NodeSP client_root(new dt::Node("PredictionClient"));
+    dt::Node* client_player = client_root->addChildNode(new dt::Node("Player")).get();
+
+    dt::NodeReplicator client;
+    float precision = client.getPositionPrecision().x;
+    client.setReceiveRoot(client_root.get());
+    client.setMatchNodesByName(true);
+    client.setInterpolationDelay(0.1);
+    client.setPredicted(client_player, true);
+
+    dt::ClientPrediction<float> prediction(&move);
+
+    bool pending = false;
+    bool has_copy = false;
+    float last_x = 0.f;
+    float max_lag = 0.f;
+    for(uint32_t step = 1; step <= 100; ++step) {
+        mover->setPosition(Ogre::Vector3(step * SPEED * STEP, 0, 0));
+
+        // the input moves the player at once, without waiting for the server
+        uint32_t sequence = prediction.applyInput(client_player, 1.f, STEP);
+        nm->queueEvent(std::make_shared<InputEvent>(sequence, 1.f));
+        if(std::abs(client_player->getPosition().x - step * SPEED * STEP) > 0.01f) {
+            std::cerr << "The player is at " << client_player->getPosition().x << " after " << step
+                      << " inputs instead of " << step * SPEED * STEP << "." << std::endl;
+            return false;
+        }
+
+        tick(server, client, prediction, client_player);
+        pending = pending || prediction.getPendingCount() > 1;
+
+        // the copy moves smoothly and stays behind
+        dt::Node* copy = client.getNode(mover_id);
+        if(copy == nullptr)
+            continue;
+
+        float x = copy->getPosition().x;
+        if(has_copy && (x - last_x < -precision || x - last_x > 3 * SPEED * STEP)) {
+            std::cerr << "The copy jumped from " << last_x << " to " << x << "." << std::endl;
+            return false;
+        }
+        if(x > mover->getPosition().x + precision) {
+            std::cerr << "The copy is ahead of the node." << std::endl;
+            return false;
+        }
+        has_copy = true;
+        last_x = x;
+        max_lag = std::max(max_lag, mover->getPosition().x - x);
+    }
+
+    if(!pending) {
+        std::cerr << "No input waited for the server." << std::endl;
+        return false;
+    }
+    if(max_lag < 0.05 * SPEED) {
+        std::cerr << "The copy was only " << max_lag << " behind the node." << std::endl;
+        return false;
+    }
+
+    // once the inputs stop, the server has processed all of them and the copy catches up
+    double start = root.getTimeSinceInitialize();
+    while(prediction.getPendingCount() > 0 || client.getNode(mover_id) == nullptr
+          || client.getNode(mover_id)->getPosition().distance(mover->getPosition()) > precision) {
+        tick(server, client, prediction, client_player);
+
+        if(root.getTimeSinceInitialize() - start > 5.0) {
+            std::cerr << "The server did not process all inputs, or the copy did not catch up." << std::endl;
+            return false;
+        }
+    }
+
+    if(listener.mProcessed != prediction.getSequence()) {
+        std::cerr << "The server processed " << listener.mProcessed << " of " << prediction.getSequence()
+                  << " inputs." << std::endl;
+        return false;
+    }
+    if(client_player->getPosition().distance(server_player->getPosition()) > 0.01f) {
+        std::cerr << "The predicted player is at " << client_player->getPosition().x << ", the server has it at "
+                  << server_player->getPosition().x << "." << std::endl;
+        return false;
+    }
+    if(prediction.getLastCorrection() > 0.01f) {
+        std::cerr << "The last reconciliation moved the player by " << prediction.getLastCorrection() << "." << std::endl;
+        return false;
+    }
+    // client and server step the same way, the quantized snapshots alone must not cause corrections
+    if(prediction.getCorrectionCount() != 0) {
+        std::cerr << "The player was corrected " << prediction.getCorrectionCount() << " times." << std::endl;
+        return false;
+    }
+
+    std::cout << "Largest lag of the copy: " << max_lag << ", corrections: " << prediction.getCorrectionCount() << std::endl;
+
+    root.deinitialize();
+    return true;
+}
+
+QString PredictionTest::getTestName() {
+    return "Prediction";
+}
+
+////////////////////////////////////////////////////////////////
+
+InputEvent::InputEvent(uint32_t sequence, float move)
+    : mSequence(sequence),
+      mMove(move) {}
+
+const QString InputEvent::getType() const {
+    return "PREDICTIONTEST_INPUTEVENT";
+}
+
+dt::NetworkEvent::Channel InputEvent::getChannel() const {
+    // the server has to apply every input the client predicted
+    return RELIABLE_ORDERED;
+}
+
+std::shared_ptr<dt::NetworkEvent> InputEvent::clone() const {
+    std::shared_ptr<dt::NetworkEvent> ptr(new InputEvent(mSequence, mMove));
+    return ptr;
+}
+
+void InputEvent::serialize(dt::IOPacket& p) {
+    p.stream(mSequence, "sequence");
+    p.stream(mMove, "move");
+}
+
+////////////////////////////////////////////////////////////////
+
+InputListener::InputListener(dt::NodeReplicator* replicator, dt::Node* player)
+    : mReplicator(replicator),
+      mPlayer(player),
+      mProcessed(0) {
+    QObject::connect(dt::NetworkManager::get(), SIGNAL(newEvent(std::shared_ptr<dt::NetworkEvent>)),
+                     this,                      SLOT(_handleEvent(std::shared_ptr<dt::NetworkEvent>)));
+}
+
+void InputListener::_handleEvent(std::shared_ptr<dt::NetworkEvent> e) {
+    std::shared_ptr<InputEvent> input = std::dynamic_pointer_cast<InputEvent>(e);
+    if(input == nullptr || !input->isLocalEvent() || input->mSequence <= mProcessed)
+        return;
+
+    // the server steps the player exactly like the client did
+    move(mPlayer, input->mMove, STEP);
+    mProcessed = input->mSequence;
+    mReplicator->setProcessedInput(input->getSenderID(), mProcessed);
+}
+
+} // namespace PredictionTest
@@ -0,0 +1,76 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_PREDICTIONTEST
+#define DUCTTAPE_ENGINE_TESTS_PREDICTIONTEST
+
+#define PREDICTION_PORT 20506
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Network/NetworkEvent.hpp>
+#include <Network/NodeReplicator.hpp>
+#include <Scene/Node.hpp>
+
+#include <QObject>
+
+/**
+  * @file
+  * A test for snapshot interpolation and client-side prediction. The NetworkManager connects to itself over
+  * loopback, with latency and some loss, and runs a server and a client side in fixed steps, as two games
+  * would. The client moves its player with inputs it predicts and sends to the server, which applies them to
+  * its player and replicates it back. The test checks that the predicted player moves at once, that it
+  * ends up where the server has it without ever being corrected for the quantization of the snapshots, and that a node moved by the server is shown smoothly and behind
+  * by the interpolation delay.
+  */
+
+namespace PredictionTest {
+
+class PredictionTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+};
+
+////////////////////////////////////////////////////////////////
+
+class InputEvent : public dt::NetworkEvent {
+public:
+    InputEvent(uint32_t sequence = 0, float move = 0.f);
+    const QString getType() const;
+    Channel getChannel() const;
+    std::shared_ptr<dt::NetworkEvent> clone() const;
+    void serialize(dt::IOPacket& p);
+
+public:
+    uint32_t mSequence;
+    float mMove;
+};
+
+////////////////////////////////////////////////////////////////
+
+class InputListener : public QObject {
+    Q_OBJECT
+public:
+    InputListener(dt::NodeReplicator* replicator, dt::Node* player);
+
+private slots:
+    void _handleEvent(std::shared_ptr<dt::NetworkEvent> e);
+
+public:
+    dt::NodeReplicator* mReplicator;
+    dt::Node* mPlayer;
+    uint32_t mProcessed;
+};
+
+} // namespace PredictionTest
+
+#endif
@@ -0,0 +1,260 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "ReplicationTest/ReplicationTest.hpp"
+
+#include <Network/NetworkManager.hpp>
+#include <Network/PingEvent.hpp>
+#include <Scene/SpatialIndex.hpp>
+#include <Utils/Utils.hpp>
+
+#include <SFML/System/Sleep.hpp>
+
+#include <cmath>
+#include <iostream>
+
+namespace ReplicationTest {
+
+/**
+  * Runs one network tick: the replicator sends its snapshots, then the received ones are applied.
+  */
+static void tick(dt::NodeReplicator& server, double time_diff) {
+    server.update(time_diff);
+    dt::NetworkManager::get()->sendQueuedEvents();
+    dt::NetworkManager::get()->handleIncomingEvents();
+    sf::sleep(sf::milliseconds(10));
+}
+
+/**
+  * Returns whether the copy of a node is where the node is, give or take the quantization error.
+  */
+static bool isReplicated(dt::Node* node, dt::Node* copy) {
+    if(copy == nullptr)
+        return false;
+
+    if(copy->getPosition(dt::Node::SCENE).distance(node->getPosition(dt::Node::SCENE)) > 0.05f)
+        return false;
+
+    return node->getRotation(dt::Node::SCENE).equals(copy->getRotation(dt::Node::SCENE), Ogre::Degree(1.f));
+}
+
+bool ReplicationTest::run(int argc, char** argv) {
+    dt::Root& root = dt::Root::getInstance();
+    root.initialize(argc, argv);
+
+    dt::NetworkManager* nm = root.getNetworkManager();
+    if(!nm->bindSocket(REPLICATION_PORT)) {
+        std::cerr << "Could not bind the socket." << std::endl;
+        return false;
+    }
+
+    // use the conditions given with --netsim, if any
+    dt::NetworkSimulator* simulator = nm->getSimulator();
+    if(!simulator->isEnabled()) {
+        dt::NetworkSimulator::Conditions conditions;
+        conditions.mLatency = 0.02;
+        conditions.mPacketLoss = 0.1f;
+
+        simulator->setSeed(7);
+        simulator->setConditions(conditions);
+        simulator->setEnabled(true);
+    }
+
+    nm->connect(dt::Connection::ConnectionSP(new dt::Connection(sf::IpAddress::LocalHost, REPLICATION_PORT)));
+    dt::ConnectionsManager::ID_t connection = nm->getConnectionsManager()->findConnectionID(sf::IpAddress::LocalHost, REPLICATION_PORT);
+
+    dt::Node::NodeSP server_root(new dt::Node("ReplicationServer"));
+    dt::Node::NodeSP client_root(new dt::Node("ReplicationClient"));
+
+    std::vector<dt::Node*> nodes;
+    for(uint32_t i = 0; i < REPLICATION_NODE_COUNT; ++i) {
+        nodes.push_back(server_root->addChildNode(new dt::Node("Entity-" + dt::Utils::toString(i))).get());
+    }
+    std::shared_ptr<CounterComponent> counter = nodes[0]->addComponent(new CounterComponent("counter"));
+
+    // the receiving side only knows the component of the first node
+    dt::Node* known = client_root->addChildNode(new dt::Node("Entity-0")).get();
+    std::shared_ptr<CounterComponent> counter_copy = known->addComponent(new CounterComponent("counter"));
+    // only direct children of the receive root are matched
+    dt::Node* nested = known->addChildNode(new dt::Node("Entity-1")).get();
+
+    dt::NodeReplicator server;
+    server.setBandwidth(4000);
+    for(auto iter = nodes.begin(); iter != nodes.end(); ++iter) {
+        server.addNode(*iter);
+    }
+    server.addClient(connection, nodes[0]);
+
+    dt::NodeReplicator client;
+    client.setReceiveRoot(client_root.get());
+    client.setMatchNodesByName(true);
+
+    // move everything, more than the budget allows to send
+    bool deferred = false;
+    for(uint32_t step = 0; step < 100; ++step) {
+        for(uint32_t i = 0; i < nodes.size(); ++i) {
+            float angle = step * 0.05f + i;
+            nodes[i]->setPosition(Ogre::Vector3(std::cos(angle) * i, 0.5f * i, std::sin(angle) * i));
+            nodes[i]->setRotation(Ogre::Quaternion(Ogre::Radian(angle), Ogre::Vector3::UNIT_Y));
+        }
+        counter->mCount = step;
+
+        tick(server, 0.02);
+        deferred = deferred || server.getDeferredEntityCount(connection) > 0;
+        if(server.getLastSnapshotEntityCount(connection) > 1 && server.getLastSnapshotSize(connection) > 80) {
+            std::cerr << "A snapshot of " << server.getLastSnapshotSize(connection) << " bytes exceeded the budget." << std::endl;
+            return false;
+        }
+    }
+
+    if(!deferred) {
+        std::cerr << "No entity was deferred, although the budget was exceeded." << std::endl;
+        return false;
+    }
+
+    // once the nodes stop, all copies catch up
+    double start = root.getTimeSinceInitialize();
+    bool replicated = false;
+    while(!replicated) {
+        tick(server, 0.02);
+
+        replicated = (counter_copy->mCount == counter->mCount);
+        for(uint32_t i = 0; i < nodes.size(); ++i) {
+            replicated = replicated && isReplicated(nodes[i], client.getNode(server.getEntityId(nodes[i])));
+        }
+
+        if(root.getTimeSinceInitialize() - start > 5.0) {
+            std::cerr << "The nodes were not replicated." << std::endl;
+            return false;
+        }
+    }
+
+    if(client.getNode(server.getEntityId(nodes[0])) != known) {
+        std::cerr << "The existing node was not used." << std::endl;
+        return false;
+    }
+    if(client.getNode(server.getEntityId(nodes[1])) == nested) {
+        std::cerr << "A nested node was used for an entity." << std::endl;
+        return false;
+    }
+
+    // nothing changes, so nothing is sent once the latest snapshot has been acknowledged
+    for(uint32_t step = 0; step < 20; ++step) {
+        tick(server, 0.02);
+    }
+    if(server.getLastSnapshotEntityCount(connection) != 0) {
+        std::cerr << server.getLastSnapshotEntityCount(connection) << " unchanged entities were sent." << std::endl;
+        return false;
+    }
+
+    // removed nodes are removed from the receiving side
+    uint16_t removed_id = server.getEntityId(nodes[5]);
+    server.removeNode(nodes[5]);
+    start = root.getTimeSinceInitialize();
+    while(client.getNode(removed_id) != nullptr) {
+        tick(server, 0.02);
+
+        if(root.getTimeSinceInitialize() - start > 5.0) {
+            std::cerr << "The removed node was not removed." << std::endl;
+            return false;
+        }
+    }
+
+    client_root->onUpdate(0);
+    if(client_root->findChildNode("Entity-5") != nullptr) {
+        std::cerr << "The copy of the removed node still exists." << std::endl;
+        return false;
+    }
+
+    // with a spatial index, the client only gets the nodes around its focus node
+    dt::SpatialIndex index(4.f);
+    for(uint32_t i = 0; i < nodes.size(); ++i) {
+        if(i == 5)
+            continue;
+        nodes[i]->setPosition(Ogre::Vector3((i < 5) ? i : 10 + i, 0, 0));
+        index.addNode(nodes[i]);
+    }
+    server.setSpatialIndex(&index);
+    server.setInterestRadius(5.5f, 8.5f);
+
+    if(!_waitForInterest(server, client, nodes[7], false))
+        return false;
+    if(server.getInterestSize(connection) != 5) {
+        std::cerr << "The interest set holds " << server.getInterestSize(connection) << " entities instead of 5." << std::endl;
+        return false;
+    }
+
+    // a node has to come within the enter radius, but then stays relevant up to the leave radius
+    nodes[7]->setPosition(Ogre::Vector3(8, 0, 0));
+    for(uint32_t step = 0; step < 10; ++step) {
+        tick(server, 0.02);
+    }
+    if(server.isRelevant(connection, nodes[7])) {
+        std::cerr << "The node entered the interest set outside the enter radius." << std::endl;
+        return false;
+    }
+
+    nodes[7]->setPosition(Ogre::Vector3(5, 0, 0));
+    if(!_waitForInterest(server, client, nodes[7], true))
+        return false;
+
+    nodes[7]->setPosition(Ogre::Vector3(8, 0, 0));
+    for(uint32_t step = 0; step < 10; ++step) {
+        tick(server, 0.02);
+    }
+    if(!server.isRelevant(connection, nodes[7])) {
+        std::cerr << "The node left the interest set within the leave radius." << std::endl;
+        return false;
+    }
+
+    std::shared_ptr<dt::PingEvent> event(new dt::PingEvent(0));
+    event->clearRecipients();
+    server.addInterestedRecipients(*event, nodes[7]);
+    if(event->getRecipients().size() != 1) {
+        std::cerr << "The interested client was not added to the recipients." << std::endl;
+        return false;
+    }
+
+    nodes[7]->setPosition(Ogre::Vector3(9, 0, 0));
+    if(!_waitForInterest(server, client, nodes[7], false))
+        return false;
+
+    root.deinitialize();
+    return true;
+}
+
+bool ReplicationTest::_waitForInterest(dt::NodeReplicator& server, dt::NodeReplicator& client, dt::Node* node, bool relevant) {
+    uint16_t id = server.getEntityId(node);
+    double start = dt::Root::getInstance().getTimeSinceInitialize();
+    while((client.getNode(id) != nullptr) != relevant) {
+        tick(server, 0.02);
+
+        if(dt::Root::getInstance().getTimeSinceInitialize() - start > 5.0) {
+            std::cerr << "The node " << dt::Utils::toStdString(node->getName()) << (relevant ? " did not enter" : " did not leave")
+                      << " the interest set." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+QString ReplicationTest::getTestName() {
+    return "Replication";
+}
+
+////////////////////////////////////////////////////////////////
+
+CounterComponent::CounterComponent(const QString name)
+    : dt::Component(name),
+      mCount(0) {}
+
+void CounterComponent::onSerialize(dt::IOPacket& packet) {
+    packet.stream(mCount, "count");
+}
+
+} // namespace ReplicationTest
@@ -0,0 +1,61 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_REPLICATIONTEST
+#define DUCTTAPE_ENGINE_TESTS_REPLICATIONTEST
+
+#define REPLICATION_PORT 20504
+#define REPLICATION_NODE_COUNT 20
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Network/NodeReplicator.hpp>
+#include <Scene/Component.hpp>
+
+#include <QObject>
+
+/**
+  * @file
+  * A test for the node replication. The NetworkManager connects to itself over loopback, losing some
+  * datagrams. One NodeReplicator sends moving nodes with a small bandwidth budget, another one applies
+  * the snapshots below a second root node. The test checks that the budget defers entities, that the
+  * copies end up at the quantized positions and rotations, that a component is replicated, that nothing
+  * is sent once the copies are up to date and that removed nodes are removed on the receiving side.
+  * Finally, the client only gets the nodes around its focus node, with nodes entering and leaving its
+  * interest set at different distances.
+  */
+
+namespace ReplicationTest {
+
+class ReplicationTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+
+private:
+    bool _waitForInterest(dt::NodeReplicator& server, dt::NodeReplicator& client, dt::Node* node, bool relevant);
+};
+
+////////////////////////////////////////////////////////////////
+
+class CounterComponent : public dt::Component {
+    Q_OBJECT
+public:
+    CounterComponent(const QString name = "");
+    void onSerialize(dt::IOPacket& packet);
+
+public:
+    uint32_t mCount;
+};
+
+} // namespace ReplicationTest
+
+#endif
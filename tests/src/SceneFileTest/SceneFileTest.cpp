@@ -0,0 +1,156 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "SceneFileTest/SceneFileTest.hpp"
+
+#include <Logic/TriggerComponent.hpp>
+#include <Network/IOPacket.hpp>
+#include <Scene/SceneFile.hpp>
+#include <Utils/Utils.hpp>
+
+#include <QFile>
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace SceneFileTest {
+
+/**
+  * The number of areas in the level, and of objects in each area.
+  */
+static const uint32_t AREA_COUNT = 10;
+
+/**
+  * The file the level is saved to.
+  */
+static const QString PATH = "scenefile_test.dts";
+
+/**
+  * Serializes a node with its components and children, including all UUIDs.
+  */
+static std::string serializeNode(dt::Node* node) {
+    sf::Packet packet;
+    dt::IOPacket p(&packet, dt::IOPacket::SERIALIZE);
+    node->serialize(p);
+    return std::string(static_cast<const char*>(packet.getData()), packet.getDataSize());
+}
+
+/**
+  * Returns whether two nodes have the same state, components and children.
+  */
+static bool isEqual(dt::Node* a, dt::Node* b) {
+    if(serializeNode(a) != serializeNode(b)) {
+        std::cerr << "The node " << dt::Utils::toStdString(a->getName()) << " differs." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool SceneFileTest::run(int argc, char** argv) {
+    dt::Root::getInstance().initialize(argc, argv);
+
+    dt::Node level("level");
+    for(uint32_t i = 0; i < AREA_COUNT; ++i) {
+        auto area = level.addChildNode(new dt::Node("area" + dt::Utils::toString(i)));
+        area->setPosition(Ogre::Vector3(i * 100.f, 0, 0));
+        for(uint32_t j = 0; j < AREA_COUNT; ++j) {
+            auto object = area->addChildNode(new dt::Node(area->getName() + "_" + dt::Utils::toString(j)));
+            object->setPosition(Ogre::Vector3(i, j, 1.5f));
+            object->setRotation(Ogre::Quaternion(Ogre::Degree(j * 10.f), Ogre::Vector3::UNIT_Y));
+            object->addComponent(new dt::TriggerComponent("trigger" + object->getName()));
+        }
+    }
+    level.findChildNode("area3_3")->disable();
+
+    if(!dt::SceneFile::save(&level, PATH)) {
+        std::cerr << "The level was not saved." << std::endl;
+        return false;
+    }
+
+    dt::SceneFile file;
+    if(!file.open(PATH)) {
+        std::cerr << "The level was not opened." << std::endl;
+        return false;
+    }
+    if(file.getNodeCount() != 1 + AREA_COUNT + AREA_COUNT * AREA_COUNT || file.getComponentCount() != AREA_COUNT * AREA_COUNT) {
+        std::cerr << "The file holds " << file.getNodeCount() << " nodes and " << file.getComponentCount() << " components." << std::endl;
+        return false;
+    }
+
+    // only the areas, their objects are created when needed
+    std::unique_ptr<dt::Node> partial(file.load(0, 1));
+    dt::Node::NodeSP area = partial->findChildNode("area4", false);
+    if(area == nullptr || area->findChildNode("area4_0") != nullptr || !file.hasPendingChildren(area.get())) {
+        std::cerr << "The level was not loaded down to the areas only." << std::endl;
+        return false;
+    }
+    if(!file.expand(area.get()) || file.hasPendingChildren(area.get()) || file.expand(area.get())) {
+        std::cerr << "The area was not expanded once." << std::endl;
+        return false;
+    }
+    if(!isEqual(level.findChildNode("area4", false).get(), area.get())) {
+        std::cerr << "The expanded area differs." << std::endl;
+        return false;
+    }
+
+    // a deleted node must not leave its pending children to whatever node is created at its address
+    dt::Node* deleted = file.load(0, 0);
+    delete deleted;
+    if(file.hasPendingChildren(deleted)) {
+        std::cerr << "A deleted node still has pending children." << std::endl;
+        return false;
+    }
+
+    std::unique_ptr<dt::Node> loaded(file.load());
+    if(!isEqual(&level, loaded.get()))
+        return false;
+
+    uint32_t record = file.findRecord("area7_2");
+    std::unique_ptr<dt::Node> object(record == dt::SceneFile::NO_RECORD ? nullptr : file.load(record));
+    if(object == nullptr || !isEqual(level.findChildNode("area7_2").get(), object.get())
+       || file.findRecord("missing") != dt::SceneFile::NO_RECORD) {
+        std::cerr << "The records were not found by name." << std::endl;
+        return false;
+    }
+    file.close();
+
+    QFile saved(PATH);
+    saved.open(QIODevice::ReadOnly);
+    QByteArray data = saved.readAll();
+    saved.close();
+
+    std::cout << "Scene file: " << data.size() << " bytes, serialized: " << serializeNode(&level).size() << " bytes." << std::endl;
+
+    // truncated and foreign files
+    QFile broken(PATH);
+    broken.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    broken.write(data.left(data.size() / 2));
+    broken.close();
+    if(file.open(PATH)) {
+        std::cerr << "A truncated file was opened." << std::endl;
+        return false;
+    }
+
+    broken.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    broken.write(QByteArray(data.size(), 'x'));
+    broken.close();
+    if(file.open(PATH)) {
+        std::cerr << "A foreign file was opened." << std::endl;
+        return false;
+    }
+
+    dt::Root::getInstance().deinitialize();
+    return true;
+}
+
+QString SceneFileTest::getTestName() {
+    return "SceneFile";
+}
+
+} // namespace SceneFileTest
@@ -0,0 +1,36 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_SCENEFILETEST
+#define DUCTTAPE_ENGINE_TESTS_SCENEFILETEST
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Scene/Node.hpp>
+
+/**
+  * @file
+  * A test for the SceneFile. It saves a level of areas full of objects with components, loads it only down
+  * to the areas and expands one area later, and checks that a full load gives the same nodes and components.
+  * Records are found by name, and truncated or foreign files are rejected.
+  */
+
+namespace SceneFileTest {
+
+class SceneFileTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+};
+
+} // namespace SceneFileTest
+
+#endif
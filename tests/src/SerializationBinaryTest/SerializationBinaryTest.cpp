@@ -8,16 +8,46 @@
 
 #include "SerializationBinaryTest/SerializationBinaryTest.hpp"
 
+#include <Network/Archive.hpp>
 #include <Scene/Serializer.hpp>
 #include <Scene/Node.hpp>
 #include <Logic/TriggerComponent.hpp>
 
+#include <cstring>
 #include <iostream>
 
 #include <QFile>
 
 namespace SerializationBinaryTest {
 
+/**
+  * Streams the same fields through the IOPacket and through an archive.
+  */
+struct Fields {
+    void serialize(dt::IOPacket& packet) {
+        packet.stream(mName, "name");
+        packet.stream(mId, "uuid");
+        packet.stream(mPosition, "position");
+        packet.stream(mData, "data");
+        packet.stream(mCount, "count");
+    }
+
+    template <typename Archive>
+    void streamFields(Archive& archive) {
+        archive.stream(mName, "name");
+        archive.stream(mId, "uuid");
+        archive.stream(mPosition, "position");
+        archive.stream(mData, "data");
+        archive.stream(mCount, "count");
+    }
+
+    QString mName;
+    QUuid mId;
+    Ogre::Vector3 mPosition;
+    std::vector<char> mData;
+    uint32_t mCount;
+};
+
 bool SerializationBinaryTest::run(int argc, char** argv) {
     dt::Root::getInstance().initialize(argc, argv);
 
@@ -91,6 +121,28 @@ bool SerializationBinaryTest::run(int argc, char** argv) {
 
     file1.close();
     file2.close();
+
+    Fields fields;
+    fields.mName = "fields";
+    fields.mId = QUuid::createUuid();
+    fields.mPosition = Ogre::Vector3(1, 2, 3);
+    fields.mData.assign(5, 'x');
+    fields.mCount = 42;
+
+    sf::Packet packet3;
+    dt::IOPacket p4(&packet3, dt::IOPacket::SERIALIZE);
+    fields.serialize(p4);
+
+    sf::Packet packet4;
+    dt::IOPacket p5(&packet4, dt::IOPacket::SERIALIZE);
+    p5.dispatch(fields);
+
+    if(packet3.getDataSize() != packet4.getDataSize()
+            || memcmp(packet3.getData(), packet4.getData(), packet3.getDataSize()) != 0) {
+        dt::Logger::get().error("The archive wrote different data than the IOPacket.");
+        return false;
+    }
+
     dt::Root::getInstance().deinitialize();
 
     return true;
@@ -0,0 +1,177 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "SpatialIndexTest/SpatialIndexTest.hpp"
+
+#include <Logic/TriggerComponent.hpp>
+#include <Utils/Utils.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+namespace SpatialIndexTest {
+
+bool SpatialIndexTest::run(int argc, char** argv) {
+    dt::Root::getInstance().initialize(argc, argv);
+
+    dt::Node root("root");
+    dt::SpatialIndex index(5.f);
+
+    // a 20x20 grid of nodes, one unit apart, every tenth one with a component
+    std::vector<dt::Node::NodeSP> nodes;
+    for(int x = 0; x < 20; ++x) {
+        for(int z = 0; z < 20; ++z) {
+            auto node = root.addChildNode(new dt::Node("node-" + dt::Utils::toString(x) + "-" + dt::Utils::toString(z)));
+            node->setPosition(Ogre::Vector3(x, 0, z));
+            if((x * 20 + z) % 10 == 0)
+                node->addComponent(new dt::TriggerComponent("trigger"));
+            index.addNode(node.get());
+            nodes.push_back(node);
+        }
+    }
+
+    std::vector<dt::Node*> result;
+
+    index.queryRadius(Ogre::Vector3(10, 0, 10), 1.5f, result);
+    if(result.size() != 9) {
+        std::cerr << "Radius query returned " << result.size() << " nodes instead of 9." << std::endl;
+        return false;
+    }
+
+    result.clear();
+    index.queryBox(Ogre::AxisAlignedBox(Ogre::Vector3(-0.5, -1, -0.5), Ogre::Vector3(4.5, 1, 1.5)), result);
+    if(result.size() != 10) {
+        std::cerr << "Box query returned " << result.size() << " nodes instead of 10." << std::endl;
+        return false;
+    }
+
+    result.clear();
+    index.queryRadius(Ogre::Vector3(0, 0, 0), 100.f, result, dt::SpatialIndex::componentFilter<dt::TriggerComponent>());
+    if(result.size() != 40) {
+        std::cerr << "Filtered query returned " << result.size() << " nodes instead of 40." << std::endl;
+        return false;
+    }
+
+    result.clear();
+    index.queryNearest(Ogre::Vector3(3.1, 0, 7.2), 3, result);
+    if(result.size() != 3 || result[0]->getName() != "node-3-7") {
+        std::cerr << "Nearest query did not find the closest node first." << std::endl;
+        return false;
+    }
+
+    // far away from everything, with a filter
+    result.clear();
+    index.queryNearest(Ogre::Vector3(500, 0, 500), 1, result, dt::SpatialIndex::componentFilter<dt::TriggerComponent>());
+    if(result.size() != 1 || result[0]->getName() != "node-19-10") {
+        std::cerr << "Nearest filtered query failed." << std::endl;
+        return false;
+    }
+
+    // moving a node has to update the index, also when the parent is moved
+    nodes[0]->setPosition(Ogre::Vector3(100, 0, 100));
+    result.clear();
+    index.queryRadius(Ogre::Vector3(100, 0, 100), 0.1f, result);
+    if(result.size() != 1 || result[0] != nodes[0].get()) {
+        std::cerr << "The index was not updated after moving a node." << std::endl;
+        return false;
+    }
+
+    root.setPosition(Ogre::Vector3(0, 0, -1000));
+    result.clear();
+    index.queryRadius(Ogre::Vector3(10, 0, 10), 1.5f, result);
+    if(!result.empty()) {
+        std::cerr << "The index was not updated after moving the parent node." << std::endl;
+        return false;
+    }
+
+    // a far away node must not make later queries walk all the cells up to it
+    auto far = root.addChildNode(new dt::Node("far"));
+    far->setPosition(Ogre::Vector3(1e12, 0, 1e12));
+    index.addNode(far.get());
+    result.clear();
+    index.queryBox(Ogre::AxisAlignedBox(Ogre::Vector3(-1e12, -1, -1e12), Ogre::Vector3(1e12, 1, 1e12)), result);
+    if(result.size() != 401) {
+        std::cerr << "Huge box query returned " << result.size() << " nodes instead of 401." << std::endl;
+        return false;
+    }
+    index.removeNode(far.get());
+
+    // a node larger than a cell is found from anywhere within its radius
+    auto large = root.addChildNode(new dt::Node("large"));
+    large->setPosition(Ogre::Vector3(0, 0, 1000));
+    index.addNode(large.get(), 100.f);
+    result.clear();
+    index.queryRadius(Ogre::Vector3(90, 0, 0), 1.f, result);
+    if(result.size() != 1 || result[0] != large.get()) {
+        std::cerr << "Large node was not found by a radius query." << std::endl;
+        return false;
+    }
+    index.setNodeRadius(large.get(), 1.f);
+    result.clear();
+    index.queryRadius(Ogre::Vector3(90, 0, 0), 1.f, result);
+    if(!result.empty()) {
+        std::cerr << "Shrinking a large node did not update the index." << std::endl;
+        return false;
+    }
+    index.removeNode(large.get());
+
+    index.removeNode(nodes[1].get());
+    if(index.getNodeCount() != 399) {
+        std::cerr << "Removing a node failed." << std::endl;
+        return false;
+    }
+
+    // ten clusters of 100 nodes, each in a cell of its own, 1000 units apart
+    dt::Node sparse("sparse");
+    dt::SpatialIndex sparse_index(5.f);
+    for(int cluster = 0; cluster < 10; ++cluster) {
+        for(int i = 0; i < 100; ++i) {
+            auto node = sparse.addChildNode(new dt::Node("sparse-" + dt::Utils::toString(cluster) + "-" + dt::Utils::toString(i)));
+            node->setPosition(Ogre::Vector3(cluster * 1000 + (i % 10) * 0.4f, 0, (i / 10) * 0.4f));
+            sparse_index.addNode(node.get());
+        }
+    }
+
+    // only the cluster of the query point has to be looked at, not all the nodes in a sparse grid
+    result.clear();
+    sparse_index.queryNearest(Ogre::Vector3(1, 0, 1), 1, result);
+    if(result.size() != 1 || sparse_index.getVisitedCount() > 100) {
+        std::cerr << "Nearest query on a sparse grid tested " << sparse_index.getVisitedCount() << " nodes." << std::endl;
+        return false;
+    }
+
+    result.clear();
+    sparse_index.queryNearest(Ogre::Vector3(1, 0, 1), 150, result);
+    if(result.size() != 150 || result.back()->getName().left(9) != "sparse-1-" || sparse_index.getVisitedCount() > 200) {
+        std::cerr << "Nearest query reaching into the next cluster tested " << sparse_index.getVisitedCount() << " nodes." << std::endl;
+        return false;
+    }
+
+    result.clear();
+    sparse_index.queryNearest(Ogre::Vector3(1, 0, 1), 200, result, nullptr, 10.f);
+    if(result.size() != 100 || sparse_index.getVisitedCount() > 100) {
+        std::cerr << "Nearest query limited by distance tested " << sparse_index.getVisitedCount() << " nodes." << std::endl;
+        return false;
+    }
+    sparse.deinitialize();
+
+    root.deinitialize();
+    if(index.getNodeCount() != 0) {
+        std::cerr << "Deinitialized nodes have to leave the index." << std::endl;
+        return false;
+    }
+
+    dt::Root::getInstance().deinitialize();
+    return true;
+}
+
+QString SpatialIndexTest::getTestName() {
+    return "SpatialIndex";
+}
+
+}
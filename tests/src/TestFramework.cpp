@@ -8,10 +8,19 @@
 
 #include "TestFramework.hpp"
 
+#include "BitStreamTest/BitStreamTest.hpp"
 #include "CamerasTest/CamerasTest.hpp"
+#include "ChannelsTest/ChannelsTest.hpp"
+#include "CharacterControllerTest/CharacterControllerTest.hpp"
+#include "ComponentFactoryTest/ComponentFactoryTest.hpp"
+#include "CompressionTest/CompressionTest.hpp"
+#include "CongestionTest/CongestionTest.hpp"
+#include "ConnectionStatsTest/ConnectionStatsTest.hpp"
 #include "ConnectionsTest/ConnectionsTest.hpp"
 #include "DisplayTest/DisplayTest.hpp"
+#include "EventPoolTest/EventPoolTest.hpp"
 #include "FollowPathTest/FollowPathTest.hpp"
+#include "FragmentationTest/FragmentationTest.hpp"
 #include "GuiTest/GuiTest.hpp"
 #include "InputTest/InputTest.hpp"
 #include "LoggerTest/LoggerTest.hpp"
@@ -20,13 +29,19 @@
 #include "MusicTest/MusicTest.hpp"
 #include "NamesTest/NamesTest.hpp"
 #include "NetworkTest/NetworkTest.hpp"
+#include "NetworkThreadTest/NetworkThreadTest.hpp"
 #include "ParticlesTest/ParticlesTest.hpp"
+#include "PhysicsRestingTest/PhysicsRestingTest.hpp"
 #include "PhysicsSimpleTest/PhysicsSimpleTest.hpp"
+#include "PhysicsSnapshotTest/PhysicsSnapshotTest.hpp"
 #include "PhysicsStressTest/PhysicsStressTest.hpp"
+#include "PredictionTest/PredictionTest.hpp"
 #include "PrimitivesTest/PrimitivesTest.hpp"
 #include "QObjectTest/QObjectTest.hpp"
 #include "RandomTest/RandomTest.hpp"
+#include "ReplicationTest/ReplicationTest.hpp"
 #include "ResourceManagerTest/ResourceManagerTest.hpp"
+#include "SceneFileTest/SceneFileTest.hpp"
 #include "SerializationBinaryTest/SerializationBinaryTest.hpp"
 #include "SerializationYamlTest/SerializationYamlTest.hpp"
 #include "ScriptComponentTest/ScriptComponentTest.hpp"
@@ -35,11 +50,15 @@
 #include "ShadowsTest/ShadowsTest.hpp"
 #include "SignalsTest/SignalsTest.hpp"
 #include "SoundTest/SoundTest.hpp"
+#include "SpatialIndexTest/SpatialIndexTest.hpp"
 #include "StatesTest/StatesTest.hpp"
 #include "TextTest/TextTest.hpp"
 #include "TimerTest/TimerTest.hpp"
 #include "TerrainTest/TerrainTest.hpp"
+#include "YamlLoadTest/YamlLoadTest.hpp"
 #include "Utils/Utils.hpp"
+#include "Core/Root.hpp"
+#include "Network/NetworkManager.hpp"
 #include "BillboardTest/BillboardTest.hpp"
 #include "GuiStateTest/GuiStateTest.hpp"
 #include "TriggerAreaComponentTest/TriggerAreaComponentTest.hpp"
@@ -65,10 +84,19 @@ TestSP getTest(QString name) {
 int main(int argc, char** argv) {
 
     // add all tests
+    addTest(new BitStreamTest::BitStreamTest);
     addTest(new CamerasTest::CamerasTest);
+    addTest(new ChannelsTest::ChannelsTest);
+    addTest(new CharacterControllerTest::CharacterControllerTest);
+    addTest(new ComponentFactoryTest::ComponentFactoryTest);
+    addTest(new CompressionTest::CompressionTest);
+    addTest(new CongestionTest::CongestionTest);
+    addTest(new ConnectionStatsTest::ConnectionStatsTest);
     addTest(new ConnectionsTest::ConnectionsTest);
     addTest(new DisplayTest::DisplayTest);
+    addTest(new EventPoolTest::EventPoolTest);
     addTest(new FollowPathTest::FollowPathTest);
+    addTest(new FragmentationTest::FragmentationTest);
     addTest(new GuiTest::GuiTest);
     addTest(new InputTest::InputTest);
     addTest(new LoggerTest::LoggerTest);
@@ -77,13 +105,19 @@ int main(int argc, char** argv) {
     addTest(new MusicTest::MusicTest);
     addTest(new NamesTest::NamesTest);
     addTest(new NetworkTest::NetworkTest);
+    addTest(new NetworkThreadTest::NetworkThreadTest);
     addTest(new ParticlesTest::ParticlesTest);
+    addTest(new PhysicsRestingTest::PhysicsRestingTest);
     addTest(new PhysicsSimpleTest::PhysicsSimpleTest);
+    addTest(new PhysicsSnapshotTest::PhysicsSnapshotTest);
     addTest(new PhysicsStressTest::PhysicsStressTest);
+    addTest(new PredictionTest::PredictionTest);
     addTest(new PrimitivesTest::PrimitivesTest);
     addTest(new QObjectTest::QObjectTest);
     addTest(new RandomTest::RandomTest);
+    addTest(new ReplicationTest::ReplicationTest);
     addTest(new ResourceManagerTest::ResourceManagerTest);
+    addTest(new SceneFileTest::SceneFileTest);
     addTest(new SerializationBinaryTest::SerializationBinaryTest);
     addTest(new SerializationYamlTest::SerializationYamlTest);
     addTest(new ScriptComponentTest::ScriptComponentTest);
@@ -91,17 +125,19 @@ int main(int argc, char** argv) {
     addTest(new ShadowsTest::ShadowsTest);
     addTest(new SignalsTest::SignalsTest);
     addTest(new SoundTest::SoundTest);
+    addTest(new SpatialIndexTest::SpatialIndexTest);
     addTest(new StatesTest::StatesTest);
     addTest(new TextTest::TextTest);
     addTest(new TimerTest::TimerTest);
     addTest(new TerrainTest::TerrainTest);
+    addTest(new YamlLoadTest::YamlLoadTest);
     addTest(new BillboardTest::BillboardTest);
     addTest(new GuiStateTest::GuiStateTest);
     addTest(new TriggerAreaComponentTest::TriggerAreaComponentTest);
 
     if(argc < 2) {
         std::cout << "TestFramework usage: " << std::endl;
-        std::cout << "  ./TestFramework <test name>" << std::endl;
+        std::cout << "  ./TestFramework <test name> [--netsim=<options>]" << std::endl;
         std::cout << std::endl << "Available tests:" << std::endl;
         for(auto iter = Tests.begin(); iter != Tests.end(); ++iter) {
             std::cout << "  - " << dt::Utils::toStdString(iter->first) << std::endl;
@@ -109,9 +145,16 @@ int main(int argc, char** argv) {
     } else {
         bool failure = false;
 
+        // simulate a bad network for the network tests, see dt::NetworkSimulator::configure
+        for(int i = 1; i < argc; ++i) {
+            QString option(argv[i]);
+            if(option.startsWith("--netsim="))
+                dt::Root::getInstance().getNetworkManager()->getSimulator()->configure(option.section("=", 1));
+        }
+
         for(int i = 1; i < argc; ++i) {
             QString name(argv[i]);
-            if(name == "client" || name == "server") // ignore parameters of network
+            if(name == "client" || name == "server" || name.startsWith("--")) // ignore parameters of network
                 continue;
             std::cout << "Running test " + dt::Utils::toStdString(name) + "..." << std::endl;
             TestSP test = getTest(name);
@@ -0,0 +1,123 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#include "YamlLoadTest/YamlLoadTest.hpp"
+
+#include <Logic/TriggerComponent.hpp>
+#include <Network/IOPacket.hpp>
+#include <Network/YamlDocument.hpp>
+#include <Scene/Node.hpp>
+#include <Utils/Utils.hpp>
+
+#include <SFML/System/Clock.hpp>
+
+#include <sstream>
+#include <string>
+
+namespace YamlLoadTest {
+
+/**
+  * The number of areas in the scene, and of nodes in each area.
+  */
+static const uint32_t AREA_COUNT = 50;
+static const uint32_t NODES_PER_AREA = 1000;
+
+/**
+  * Writes a node into a YAML document.
+  */
+static std::string emitNode(dt::Node& node) {
+    YAML::Emitter emitter;
+    dt::IOPacket packet(&emitter);
+    emitter << YAML::BeginMap;
+    node.serialize(packet);
+    emitter << YAML::EndMap;
+    return emitter.c_str();
+}
+
+bool YamlLoadTest::run(int argc, char** argv) {
+    dt::Root::getInstance().initialize(argc, argv);
+
+    dt::Node scene("scene");
+    for(uint32_t i = 0; i < AREA_COUNT; ++i) {
+        auto area = scene.addChildNode(new dt::Node("area" + dt::Utils::toString(i)));
+        for(uint32_t j = 0; j < NODES_PER_AREA; ++j) {
+            auto node = area->addChildNode(new dt::Node(area->getName() + "_" + dt::Utils::toString(j)));
+            node->setPosition(Ogre::Vector3(i, j, 0.5f));
+            node->addComponent(new dt::TriggerComponent("trigger"));
+        }
+    }
+    std::string text = emitNode(scene);
+
+    // the whole document as YAML::Nodes
+    sf::Clock clock;
+    std::istringstream node_input(text);
+    YAML::Parser parser(node_input);
+    YAML::Node document;
+    if(!parser.GetNextDocument(document)) {
+        dt::Logger::get().error("Cannot read the YAML document.");
+        return false;
+    }
+    dt::IOPacket node_packet(&document);
+    dt::Node node_scene("node_scene");
+    node_scene.serialize(node_packet);
+    double node_time = clock.getElapsedTime().asSeconds();
+
+    // the events of the document, without exceptions
+    clock.restart();
+    std::istringstream event_input(text);
+    dt::YamlDocument event_document;
+    if(!event_document.load(event_input)) {
+        dt::Logger::get().error("Cannot parse the YAML document.");
+        return false;
+    }
+    dt::IOPacket event_packet(&event_document);
+    dt::Node event_scene("event_scene");
+    event_scene.serialize(event_packet);
+    double event_time = clock.getElapsedTime().asSeconds();
+
+    dt::Logger::get().info("Loaded " + dt::Utils::toString(1 + AREA_COUNT + AREA_COUNT * NODES_PER_AREA) + " nodes ("
+                           + dt::Utils::toString(text.size() / 1024) + " KB)");
+    dt::Logger::get().info("YAML::Node: " + dt::Utils::toString(node_time) + " s");
+    dt::Logger::get().info("YamlDocument: " + dt::Utils::toString(event_time) + " s");
+
+    if(emitNode(node_scene) != text || emitNode(event_scene) != text) {
+        dt::Logger::get().error("The loaded scenes differ.");
+        return false;
+    }
+
+    // missing fields get their defaults
+    std::istringstream partial_input("{name: partial, position: [1, 2, 3], children: [{name: child}]}");
+    dt::YamlDocument partial_document;
+    if(!partial_document.load(partial_input)) {
+        dt::Logger::get().error("Cannot parse the partial document.");
+        return false;
+    }
+    dt::IOPacket partial_packet(&partial_document);
+    dt::Node partial;
+    partial.serialize(partial_packet);
+    if(partial.getName() != "partial" || partial.getPosition() != Ogre::Vector3(1, 2, 3)
+       || partial.getScale() != Ogre::Vector3::UNIT_SCALE || partial.findChildNode("child") == nullptr) {
+        dt::Logger::get().error("The partial document was not loaded with defaults.");
+        return false;
+    }
+
+    std::istringstream malformed_input("{name: [malformed");
+    if(partial_document.load(malformed_input)) {
+        dt::Logger::get().error("A malformed document was loaded.");
+        return false;
+    }
+
+    dt::Root::getInstance().deinitialize();
+    return true;
+}
+
+QString YamlLoadTest::getTestName() {
+    return "YamlLoad";
+}
+
+} // namespace YamlLoadTest
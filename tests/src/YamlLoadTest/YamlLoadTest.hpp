@@ -0,0 +1,36 @@
+
+// ----------------------------------------------------------------------------
+// This file is part of the Ducttape Project (http://ducttape-dev.org) and is
+// licensed under the GNU LESSER PUBLIC LICENSE version 3. For the full license
+// text, please see the LICENSE file in the root of this project or at
+// http://www.gnu.org/licenses/lgpl.html
+// ----------------------------------------------------------------------------
+
+#ifndef DUCTTAPE_ENGINE_TESTS_YAMLLOADTEST
+#define DUCTTAPE_ENGINE_TESTS_YAMLLOADTEST
+
+#include <Config.hpp>
+
+#include "Test.hpp"
+
+#include <Core/Root.hpp>
+#include <Utils/Logger.hpp>
+
+/**
+  * @file
+  * A benchmark for loading scenes from YAML. A generated scene of 50000 nodes is written and loaded once
+  * through YAML::Nodes and once through a YamlDocument, which have to give the same scene. It also checks
+  * that missing fields get their defaults and malformed documents are rejected.
+  */
+
+namespace YamlLoadTest {
+
+class YamlLoadTest : public Test {
+public:
+    bool run(int argc, char** argv);
+    QString getTestName();
+};
+
+} // namespace YamlLoadTest
+
+#endif